@@ -0,0 +1,703 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "access/btree.h"
+#include "global/config.h"
+#include "system/sysextent.h"
+
+extern Config* conf;
+
+/**
+ * @brief Orders entries by key, then by rid. Usable with qsort.
+ */
+int btree_entry_compare(const void* a, const void* b) {
+  const BTreeEntry* ea = a;
+  const BTreeEntry* eb = b;
+
+  if (ea->key != eb->key) return ea->key < eb->key ? -1 : 1;
+  if (ea->rid.pageId != eb->rid.pageId) return ea->rid.pageId < eb->rid.pageId ? -1 : 1;
+  if (ea->rid.slotId != eb->rid.slotId) return ea->rid.slotId < eb->rid.slotId ? -1 : 1;
+
+  return 0;
+}
+
+static BTreeEntry* btree_get_entry(Page pg, int slotId) {
+  return (BTreeEntry*)page_get_record(pg, slotId);
+}
+
+/**
+ * @brief Returns the value of the key column of a table row. Clustered index
+ * keys are NOT NULL integer columns, so the column is always there.
+ */
+int64_t btree_record_key(IndexDesc* idx, Record r) {
+  Record data = r + compute_offset_to_column(idx->rd, r, idx->colnum);
+
+  switch (idx->rd->cols[idx->colnum].dataType) {
+    case DT_TINYINT:
+    case DT_BOOL:
+      return *(uint8_t*)data;
+    case DT_SMALLINT: {
+      int16_t v;
+      memcpy(&v, data, sizeof(int16_t));
+      return v;
+    }
+    case DT_INT: {
+      int32_t v;
+      memcpy(&v, data, sizeof(int32_t));
+      return v;
+    }
+    case DT_BIGINT: {
+      int64_t v;
+      memcpy(&v, data, sizeof(int64_t));
+      return v;
+    }
+    default:
+      return 0;
+  }
+}
+
+/**
+ * @brief Copies the entry at `slotId` into `e`. The leaf pages of a clustered
+ * index hold table rows instead of entries, so there we build the entry from
+ * the row's key, with an empty rid.
+ */
+static void btree_read_entry(IndexDesc* idx, Page pg, int slotId, BTreeEntry* e) {
+  if (idx->type == 'c' && ((PageHeader*)pg)->indexLevel == 0) {
+    e->key = btree_record_key(idx, page_get_record(pg, slotId));
+    e->rid.pageId = 0;
+    e->rid.slotId = 0;
+    e->childPageId = 0;
+  } else {
+    *e = *btree_get_entry(pg, slotId);
+  }
+}
+
+/* position of the first entry that is >= e */
+static int btree_lower_bound(IndexDesc* idx, Page pg, BTreeEntry* e) {
+  int lo = 0;
+  int hi = ((PageHeader*)pg)->numRecords;
+  BTreeEntry cur;
+
+  while (lo < hi) {
+    int mid = lo + (hi - lo) / 2;
+    btree_read_entry(idx, pg, mid, &cur);
+    if (btree_entry_compare(&cur, e) < 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+
+  return lo;
+}
+
+/**
+ * position of the first entry that is > e, which is also where e gets inserted.
+ * On internal pages the first entry stands for negative infinity, so its key is
+ * never compared. It goes stale as soon as a smaller key is added to the
+ * leftmost child, which is fine because nothing is ever inserted in front of it.
+ */
+static int btree_upper_bound(IndexDesc* idx, Page pg, BTreeEntry* e) {
+  PageHeader* pgHdr = (PageHeader*)pg;
+  int lo = (pgHdr->indexLevel > 0 && pgHdr->numRecords > 0) ? 1 : 0;
+  int hi = pgHdr->numRecords;
+  BTreeEntry cur;
+
+  while (lo < hi) {
+    int mid = lo + (hi - lo) / 2;
+    btree_read_entry(idx, pg, mid, &cur);
+    if (btree_entry_compare(&cur, e) <= 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+
+  return lo;
+}
+
+static uint32_t btree_child_pageid(IndexDesc* idx, Page pg, BTreeEntry* e) {
+  int slotId = btree_upper_bound(idx, pg, e) - 1;
+
+  return btree_get_entry(pg, slotId)->childPageId;
+}
+
+/**
+ * @brief Walks from the root down to the leaf page that covers `e`.
+ * `path[0]` is the root and `path[depth]` is the leaf.
+ *
+ * @param buf
+ * @param idx
+ * @param e
+ * @param path
+ * @return int depth of the leaf, or -1 if a page could not be read
+ */
+static int btree_descend(BufMgr* buf, IndexDesc* idx, BTreeEntry* e, uint32_t* path) {
+  BufTag* tag = bufdesc_new_buftag(FILE_DATA, idx->rootPageId);
+  int depth = 0;
+
+  while (depth < BTREE_MAX_LEVELS) {
+    int32_t bufId = bufmgr_request_bufId_readonly(buf, tag);
+    if (bufId < 0) break;
+
+    Page pg = buf->bp->pages[bufId];
+    PageHeader* pgHdr = (PageHeader*)pg;
+    path[depth] = tag->pageId;
+
+    if (pgHdr->pageType != 1) {
+      printf("Page %d is not an index page\n", tag->pageId);
+      bufmgr_release_bufId(buf, bufId);
+      break;
+    }
+
+    if (pgHdr->indexLevel == 0 || pgHdr->numRecords == 0) {
+      bufmgr_release_bufId(buf, bufId);
+      bufdesc_free_buftag(tag);
+      return depth;
+    }
+
+    tag->pageId = btree_child_pageid(idx, pg, e);
+    bufmgr_release_bufId(buf, bufId);
+    depth++;
+  }
+
+  bufdesc_free_buftag(tag);
+  return -1;
+}
+
+/**
+ * @brief Allocates a new index page at `indexLevel`, from the newest extent of
+ * the index when possible. The page is pinned - caller is responsible for
+ * unpinning it.
+ */
+static int32_t btree_allocate_page(BufMgr* buf, IndexDesc* idx, uint8_t indexLevel) {
+  uint32_t lastExtent = sysextent_get_last_extent(buf, idx->objectId);
+  int32_t newBufId = bufmgr_allocate_page_after(buf, FILE_DATA, lastExtent);
+  if (newBufId < 0) return -1;
+
+  pageheader_init_indexpage(buf->bp->pages[newBufId], indexLevel);
+  sysextent_track_object_page(buf, idx->objectId, buf->bd->descArr[newBufId]->tag->pageId);
+
+  return newBufId;
+}
+
+/**
+ * @brief Splits the full page in slot `bufId` and inserts record `r`, whose
+ * entry is `e`, into the half that covers it. Returns the separator entry for
+ * the new right page in `sep`, which the caller inserts into the parent.
+ * Releases `bufId`.
+ *
+ * @details The split itself is a regular insert page split (see
+ * `bufmgr_page_split_insert`), which keeps both halves sorted. A large table
+ * row on the leaf level of a clustered index may still not fit in its half,
+ * in which case `inserted` is false and the caller has to split that half
+ * as well once the separator is in the parent.
+ *
+ * @param buf
+ * @param idx
+ * @param bufId
+ * @param e
+ * @param r the entry itself, or a table row on the leaf level of a clustered index
+ * @param len
+ * @param sep
+ * @param inserted whether `r` made it onto one of the halves
+ * @return true
+ * @return false if the page can't be split, in which case nothing has changed
+ */
+static bool btree_split(BufMgr* buf, IndexDesc* idx, int32_t bufId, BTreeEntry* e, Record r, uint16_t len, BTreeEntry* sep, bool* inserted) {
+  /* both halves need at least one record to get a separator */
+  if (((PageHeader*)buf->bp->pages[bufId])->numRecords < 2) {
+    printf("Entry of %u bytes doesn't fit in index %s\n", len, idx->indexname);
+    bufmgr_release_bufId(buf, bufId);
+    return false;
+  }
+
+  uint32_t lastExtent = sysextent_get_last_extent(buf, idx->objectId);
+  int32_t rightBufId = bufmgr_page_split_insert(buf, bufId, lastExtent);
+  if (rightBufId < 0) {
+    bufmgr_release_bufId(buf, bufId);
+    return false;
+  }
+
+  Page pg = buf->bp->pages[bufId];
+  Page right = buf->bp->pages[rightBufId];
+  uint32_t rightPageId = buf->bd->descArr[rightBufId]->tag->pageId;
+
+  btree_read_entry(idx, right, 0, sep);
+  Page target = btree_entry_compare(e, sep) < 0 ? pg : right;
+  *inserted = page_insert_at(target, r, len, btree_upper_bound(idx, target, e));
+
+  btree_read_entry(idx, right, 0, sep);
+  sep->childPageId = rightPageId;
+
+  bufdesc_set_dirty(buf->bd->descArr[bufId]);
+  bufdesc_set_dirty(buf->bd->descArr[rightBufId]);
+  bufmgr_release_bufId(buf, bufId);
+  bufmgr_release_bufId(buf, rightBufId);
+
+  sysextent_track_object_page(buf, idx->objectId, rightPageId);
+
+  return true;
+}
+
+/**
+ * @brief Moves the contents of the full root page into a new child page and
+ * turns the root into that child's parent, one level up. Returns the child's
+ * buffer_id (pinned). The root stays pinned as well.
+ */
+static int32_t btree_grow_root(BufMgr* buf, IndexDesc* idx, int32_t rootBufId) {
+  Page root = buf->bp->pages[rootBufId];
+  uint8_t indexLevel = ((PageHeader*)root)->indexLevel;
+
+  int32_t childBufId = btree_allocate_page(buf, idx, indexLevel);
+  if (childBufId < 0) return -1;
+
+  Page child = buf->bp->pages[childBufId];
+  uint32_t childPageId = buf->bd->descArr[childBufId]->tag->pageId;
+
+  memcpy(child, root, conf->pageSize);
+  pageheader_set_pageid(child, childPageId);
+
+  BTreeEntry first;
+  btree_read_entry(idx, child, 0, &first);
+  first.childPageId = childPageId;
+
+  page_zero(root);
+  pageheader_set_pageid(root, buf->bd->descArr[rootBufId]->tag->pageId);
+  pageheader_init_indexpage(root, indexLevel + 1);
+  page_insert(root, (Record)&first, sizeof(BTreeEntry));
+
+  bufdesc_set_dirty(buf->bd->descArr[rootBufId]);
+  bufdesc_set_dirty(buf->bd->descArr[childBufId]);
+
+  return childBufId;
+}
+
+/**
+ * @brief Inserts record `r`, whose entry is `e`, into the page at `path[depth]`.
+ * If the page is full, it gets split and the separator for the new page goes
+ * into the parent at `path[depth - 1]`, all the way up to the root if necessary.
+ */
+static bool btree_insert_at_depth(BufMgr* buf, IndexDesc* idx, uint32_t* path, int depth, BTreeEntry* e, Record r, uint16_t len) {
+  BufTag* tag = bufdesc_new_buftag(FILE_DATA, path[depth]);
+  int32_t bufId = bufmgr_request_bufId(buf, tag);
+  bufdesc_free_buftag(tag);
+
+  if (bufId < 0) return false;
+
+  Page pg = buf->bp->pages[bufId];
+  if (page_insert_at(pg, r, len, btree_upper_bound(idx, pg, e))) {
+    bufdesc_set_dirty(buf->bd->descArr[bufId]);
+    bufmgr_release_bufId(buf, bufId);
+    return true;
+  }
+
+  if (depth == 0) {
+    int32_t childBufId = btree_grow_root(buf, idx, bufId);
+    bufmgr_release_bufId(buf, bufId);
+    if (childBufId < 0) return false;
+
+    /* the entries we need to split now live one level below the root */
+    bufId = childBufId;
+    path[1] = buf->bd->descArr[childBufId]->tag->pageId;
+    depth = 1;
+  }
+
+  BTreeEntry sep;
+  bool inserted;
+  if (!btree_split(buf, idx, bufId, e, r, len, &sep, &inserted)) return false;
+
+  if (!btree_insert_at_depth(buf, idx, path, depth - 1, &sep, (Record)&sep, sizeof(BTreeEntry))) return false;
+  if (inserted) return true;
+
+  /*
+   * Only a table row can be too large for half a page, never a separator, so
+   * the page to split again is a leaf. The tree may have grown a level, so
+   * find it from the root.
+   */
+  depth = btree_descend(buf, idx, e, path);
+  if (depth < 0) return false;
+
+  return btree_insert_at_depth(buf, idx, path, depth, e, r, len);
+}
+
+/**
+ * @brief Glues the payload (if any) to the end of a leaf entry. Returns the
+ * entry itself when there is no payload, so only free the result if it's not `e`.
+ */
+static Record btree_leaf_record(BTreeEntry* e, Record payload, uint16_t payloadLen, uint16_t* len) {
+  *len = sizeof(BTreeEntry) + payloadLen;
+  if (payloadLen == 0) return (Record)e;
+
+  Record r = malloc(*len);
+  memcpy(r, e, sizeof(BTreeEntry));
+  memcpy(r + sizeof(BTreeEntry), payload, payloadLen);
+
+  return r;
+}
+
+/**
+ * @brief Inserts a leaf entry into the index. A covering index also stores
+ * the values of its INCLUDE columns in the entry, serialized as `payload`.
+ *
+ * @param buf
+ * @param idx
+ * @param e
+ * @param payload NULL if the index has no INCLUDE columns
+ * @param payloadLen
+ * @return true
+ * @return false
+ */
+bool btree_insert(BufMgr* buf, IndexDesc* idx, BTreeEntry* e, Record payload, uint16_t payloadLen) {
+  uint32_t path[BTREE_MAX_LEVELS];
+
+  e->childPageId = 0;
+
+  int depth = btree_descend(buf, idx, e, path);
+  if (depth < 0) return false;
+
+  uint16_t len;
+  Record r = btree_leaf_record(e, payload, payloadLen, &len);
+  bool success = btree_insert_at_depth(buf, idx, path, depth, e, r, len);
+  if (r != (Record)e) free(r);
+
+  return success;
+}
+
+/**
+ * @brief Inserts a table row into the leaf level of a clustered index. The
+ * key is the table's primary key, so rows with a key that already exists are
+ * rejected.
+ *
+ * @param buf
+ * @param idx
+ * @param r
+ * @param len
+ * @return true
+ * @return false
+ */
+bool btree_insert_record(BufMgr* buf, IndexDesc* idx, Record r, uint16_t len) {
+  uint32_t path[BTREE_MAX_LEVELS];
+  BTreeEntry e = { .key = btree_record_key(idx, r), .rid = { .pageId = 0, .slotId = 0 }, .childPageId = 0 };
+
+  int depth = btree_descend(buf, idx, &e, path);
+  if (depth < 0) return false;
+
+  BufTag* tag = bufdesc_new_buftag(FILE_DATA, path[depth]);
+  int32_t bufId = bufmgr_request_bufId_readonly(buf, tag);
+  bufdesc_free_buftag(tag);
+  if (bufId < 0) return false;
+
+  Page pg = buf->bp->pages[bufId];
+  int slotId = btree_lower_bound(idx, pg, &e);
+  BTreeEntry cur;
+  bool exists = false;
+
+  if (slotId < ((PageHeader*)pg)->numRecords) {
+    btree_read_entry(idx, pg, slotId, &cur);
+    exists = cur.key == e.key;
+  }
+  bufmgr_release_bufId(buf, bufId);
+
+  if (exists) {
+    printf("Duplicate key %ld in clustered index %s\n", e.key, idx->indexname);
+    return false;
+  }
+
+  return btree_insert_at_depth(buf, idx, path, depth, &e, r, len);
+}
+
+/**
+ * @brief Starts a range scan over every leaf entry with `lowKey` <= key <= `highKey`.
+ * Entries are returned in (key, rid) order by `btree_scan_next`.
+ *
+ * @param buf
+ * @param idx
+ * @param lowKey
+ * @param highKey
+ * @return BTreeScan*
+ */
+BTreeScan* btree_scan_begin(BufMgr* buf, IndexDesc* idx, int64_t lowKey, int64_t highKey) {
+  BTreeScan* scan = malloc(sizeof(BTreeScan));
+  scan->buf = buf;
+  scan->idx = idx;
+  scan->highKey = highKey;
+  scan->pageId = 0;
+  scan->slotId = 0;
+  scan->payload = NULL;
+  scan->payloadLen = 0;
+
+  BTreeEntry low = { .key = lowKey, .rid = { .pageId = 0, .slotId = 0 }, .childPageId = 0 };
+  uint32_t path[BTREE_MAX_LEVELS];
+
+  int depth = btree_descend(buf, idx, &low, path);
+  if (depth < 0) return scan;
+
+  BufTag* tag = bufdesc_new_buftag(FILE_DATA, path[depth]);
+  int32_t bufId = bufmgr_request_bufId_readonly(buf, tag);
+  bufdesc_free_buftag(tag);
+
+  if (bufId >= 0) {
+    scan->pageId = path[depth];
+    scan->slotId = btree_lower_bound(idx, buf->bp->pages[bufId], &low);
+    bufmgr_release_bufId(buf, bufId);
+  }
+
+  return scan;
+}
+
+/**
+ * @brief Returns the next entry of the scan in `e`. Follows `nextPageId`
+ * along the leaf level until it passes the scan's high key.
+ *
+ * The INCLUDE column values of the entry are copied to `scan->payload`, which
+ * stays valid until the next call. `scan->payloadLen` is 0 if there are none.
+ *
+ * @param scan
+ * @param e
+ * @return true if an entry was returned
+ * @return false if the scan is done
+ */
+static void btree_scan_copy_payload(BTreeScan* scan, Page pg) {
+  scan->payloadLen = page_get_slot(pg, scan->slotId)->length - sizeof(BTreeEntry);
+  if (scan->payloadLen == 0) return;
+
+  if (scan->payload == NULL) scan->payload = malloc(conf->pageSize);
+  memcpy(scan->payload, page_get_record(pg, scan->slotId) + sizeof(BTreeEntry), scan->payloadLen);
+}
+
+bool btree_scan_next(BTreeScan* scan, BTreeEntry* e) {
+  BufTag* tag = bufdesc_new_buftag(FILE_DATA, 0);
+  bool found = false;
+
+  while (scan->pageId != 0 && !found) {
+    tag->pageId = scan->pageId;
+    int32_t bufId = bufmgr_request_bufId_readonly(scan->buf, tag);
+    if (bufId < 0) {
+      scan->pageId = 0;
+      break;
+    }
+
+    Page pg = scan->buf->bp->pages[bufId];
+    PageHeader* pgHdr = (PageHeader*)pg;
+
+    if (scan->slotId < pgHdr->numRecords) {
+      btree_read_entry(scan->idx, pg, scan->slotId, e);
+
+      /* a clustered index returns where the row itself lives */
+      if (scan->idx->type == 'c') {
+        e->rid.pageId = scan->pageId;
+        e->rid.slotId = scan->slotId;
+      } else {
+        btree_scan_copy_payload(scan, pg);
+      }
+      scan->slotId++;
+
+      if (e->key > scan->highKey) {
+        scan->pageId = 0;
+      } else {
+        found = true;
+      }
+    } else {
+      scan->pageId = pgHdr->nextPageId;
+      scan->slotId = 0;
+    }
+
+    bufmgr_release_bufId(scan->buf, bufId);
+  }
+
+  bufdesc_free_buftag(tag);
+
+  return found;
+}
+
+void btree_scan_end(BTreeScan* scan) {
+  if (scan == NULL) return;
+
+  if (scan->payload != NULL) free(scan->payload);
+  free(scan);
+}
+
+/**
+ * @brief Starts building a new index from a stream of entries. The index gets
+ * a brand new extent and starts out as a single empty leaf page.
+ *
+ * @details A clustered index also gets a root page right away, with a single
+ * entry pointing at the leaf. That way the leftmost leaf, which is the table's
+ * `first_page_id` in `_tables`, is never the root, so it never moves when the
+ * root grows.
+ *
+ * @param buf
+ * @param idx
+ * @return BTreeBuild*
+ */
+BTreeBuild* btree_build_begin(BufMgr* buf, IndexDesc* idx) {
+  int32_t bufId = bufmgr_allocate_new_extent(buf, FILE_DATA);
+  if (bufId < 0) {
+    printf("Unable to allocate new page btree\n");
+    return NULL;
+  }
+
+  pageheader_init_indexpage(buf->bp->pages[bufId], 0);
+  uint32_t pageId = buf->bd->descArr[bufId]->tag->pageId;
+  bufmgr_release_bufId(buf, bufId);
+
+  sysextent_track_object_page(buf, idx->objectId, pageId);
+
+  BTreeBuild* b = malloc(sizeof(BTreeBuild));
+  b->buf = buf;
+  b->idx = idx;
+  b->numLevels = 1;
+  b->pageIds[0] = pageId;
+  b->firstLeafPageId = pageId;
+
+  if (idx->type == 'c') {
+    int32_t rootBufId = btree_allocate_page(buf, idx, 1);
+    if (rootBufId < 0) {
+      free(b);
+      return NULL;
+    }
+
+    BTreeEntry first = { .key = INT64_MIN, .rid = { .pageId = 0, .slotId = 0 }, .childPageId = pageId };
+    page_insert(buf->bp->pages[rootBufId], (Record)&first, sizeof(BTreeEntry));
+
+    b->pageIds[1] = buf->bd->descArr[rootBufId]->tag->pageId;
+    b->numLevels = 2;
+    bufmgr_release_bufId(buf, rootBufId);
+  }
+
+  return b;
+}
+
+static bool btree_build_page_is_full(Page pg, uint16_t len) {
+  uint32_t usable = conf->pageSize - sizeof(PageHeader);
+  uint32_t used = usable - ((PageHeader*)pg)->freeBytes;
+
+  /* an empty page takes the record no matter what, or it would never fit anywhere */
+  if (used == 0) return false;
+
+  return used + len + sizeof(SlotPointer) > (usable / 100) * BTREE_FILL_FACTOR;
+}
+
+/**
+ * @brief Appends record `r`, whose entry is `e`, to the rightmost page on
+ * `level`. Once a page reaches the fill factor, we start a new page to its
+ * right and add a separator for it to the level above, creating that level if
+ * it doesn't exist yet.
+ */
+static bool btree_build_add_at_level(BTreeBuild* b, int level, BTreeEntry* e, Record r, uint16_t len) {
+  BufMgr* buf = b->buf;
+  BufTag* tag = bufdesc_new_buftag(FILE_DATA, b->pageIds[level]);
+  int32_t bufId = bufmgr_request_bufId(buf, tag);
+  bufdesc_free_buftag(tag);
+
+  if (bufId < 0) return false;
+
+  Page pg = buf->bp->pages[bufId];
+  bufdesc_set_dirty(buf->bd->descArr[bufId]);
+
+  if (!btree_build_page_is_full(pg, len)) {
+    page_insert(pg, r, len);
+    bufmgr_release_bufId(buf, bufId);
+    return true;
+  }
+
+  if (level + 1 == b->numLevels && b->numLevels == BTREE_MAX_LEVELS) {
+    bufmgr_release_bufId(buf, bufId);
+    return false;
+  }
+
+  int32_t newBufId = btree_allocate_page(buf, b->idx, level);
+  if (newBufId < 0) {
+    bufmgr_release_bufId(buf, bufId);
+    return false;
+  }
+
+  Page newPg = buf->bp->pages[newBufId];
+  uint32_t oldPageId = b->pageIds[level];
+  uint32_t newPageId = buf->bd->descArr[newBufId]->tag->pageId;
+
+  pageheader_set_prevpageid(newPg, oldPageId);
+  pageheader_set_nextpageid(pg, newPageId);
+  page_insert(newPg, r, len);
+  b->pageIds[level] = newPageId;
+
+  /* the level only had a single page until now, so it needs a parent */
+  if (level + 1 == b->numLevels) {
+    int32_t parentBufId = btree_allocate_page(buf, b->idx, level + 1);
+    if (parentBufId < 0) {
+      bufmgr_release_bufId(buf, bufId);
+      bufmgr_release_bufId(buf, newBufId);
+      return false;
+    }
+
+    BTreeEntry first;
+    btree_read_entry(b->idx, pg, 0, &first);
+    first.childPageId = oldPageId;
+    page_insert(buf->bp->pages[parentBufId], (Record)&first, sizeof(BTreeEntry));
+
+    b->pageIds[level + 1] = buf->bd->descArr[parentBufId]->tag->pageId;
+    b->numLevels++;
+    bufmgr_release_bufId(buf, parentBufId);
+  }
+
+  bufmgr_release_bufId(buf, bufId);
+  bufmgr_release_bufId(buf, newBufId);
+
+  BTreeEntry sep = *e;
+  sep.childPageId = newPageId;
+
+  return btree_build_add_at_level(b, level + 1, &sep, (Record)&sep, sizeof(BTreeEntry));
+}
+
+/**
+ * @brief Adds the next leaf entry to the index being built. Entries must be
+ * added in ascending (key, rid) order, see `btree_entry_compare`.
+ *
+ * @param b
+ * @param e
+ * @param payload serialized INCLUDE columns, NULL if the index has none
+ * @param payloadLen
+ * @return true
+ * @return false
+ */
+bool btree_build_add(BTreeBuild* b, BTreeEntry* e, Record payload, uint16_t payloadLen) {
+  e->childPageId = 0;
+
+  uint16_t len;
+  Record r = btree_leaf_record(e, payload, payloadLen, &len);
+  bool success = btree_build_add_at_level(b, 0, e, r, len);
+  if (r != (Record)e) free(r);
+
+  return success;
+}
+
+/**
+ * @brief Adds the next table row to the clustered index being built. Rows
+ * must be added in ascending key order.
+ *
+ * @param b
+ * @param r
+ * @param len
+ * @return true
+ * @return false
+ */
+bool btree_build_add_record(BTreeBuild* b, Record r, uint16_t len) {
+  BTreeEntry e = { .key = btree_record_key(b->idx, r), .rid = { .pageId = 0, .slotId = 0 }, .childPageId = 0 };
+  return btree_build_add_at_level(b, 0, &e, r, len);
+}
+
+/**
+ * @brief Finishes the build. The topmost page becomes the root and its pageId
+ * is returned (and stored in the IndexDesc).
+ *
+ * @param b
+ * @return int32_t
+ */
+int32_t btree_build_end(BTreeBuild* b) {
+  int32_t rootPageId = b->pageIds[b->numLevels - 1];
+  b->idx->rootPageId = rootPageId;
+  free(b);
+
+  return rootPageId;
+}
\ No newline at end of file
@@ -0,0 +1,529 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "access/hash.h"
+#include "global/config.h"
+#include "system/sysextent.h"
+
+extern Config* conf;
+
+/* bytes consumed on a page by a single entry, including its SlotPointer */
+#define HASH_ENTRY_SPACE   (sizeof(HashEntry) + sizeof(SlotPointer))
+
+/**
+ * @brief Mixes the bits of `key` (the murmur3 finalizer), so sequential keys
+ * spread out over all the buckets
+ */
+static uint64_t hash_key(int64_t key) {
+  uint64_t h = (uint64_t)key;
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+
+  return h;
+}
+
+/**
+ * @brief Number of buckets a single directory page keeps track of. The
+ * directory is one record, so it can't be larger than 64KB on big pages.
+ */
+static uint32_t hash_dir_page_entries() {
+  uint32_t numEntries = (conf->pageSize - sizeof(PageHeader) - sizeof(SlotPointer)) / sizeof(uint32_t);
+  uint32_t maxEntries = UINT16_MAX / sizeof(uint32_t);
+
+  return numEntries < maxEntries ? numEntries : maxEntries;
+}
+
+static uint64_t hash_split_threshold(HashMeta* m) {
+  uint64_t pageEntries = (conf->pageSize - sizeof(PageHeader)) / HASH_ENTRY_SPACE;
+  return (uint64_t)m->numBuckets * pageEntries * HASH_FILL_FACTOR / 100;
+}
+
+static HashMeta* hash_get_meta(Page pg) {
+  return (HashMeta*)page_get_record(pg, 0);
+}
+
+static HashEntry* hash_get_entry(Page pg, int slotId) {
+  return (HashEntry*)page_get_record(pg, slotId);
+}
+
+/**
+ * @brief Returns the bucket `key` belongs to
+ */
+static uint32_t hash_bucket_of(HashMeta* m, int64_t key) {
+  uint64_t h = hash_key(key);
+  uint64_t roundBuckets = (uint64_t)HASH_INITIAL_BUCKETS << m->level;
+
+  uint32_t bucket = h % roundBuckets;
+  if (bucket < m->splitBucket) bucket = h % (roundBuckets << 1);
+
+  return bucket;
+}
+
+/**
+ * @brief Allocates a new hash page from the newest extent of the index. The
+ * page is pinned - caller is responsible for unpinning it.
+ */
+static int32_t hash_allocate_extent_page(BufMgr* buf, IndexDesc* idx) {
+  uint32_t lastExtent = sysextent_get_last_extent(buf, idx->objectId);
+  int32_t bufId = bufmgr_allocate_page_after(buf, FILE_DATA, lastExtent);
+  if (bufId < 0) return -1;
+
+  pageheader_init_hashpage(buf->bp->pages[bufId]);
+  sysextent_track_object_page(buf, idx->objectId, buf->bd->descArr[bufId]->tag->pageId);
+
+  return bufId;
+}
+
+/**
+ * @brief Allocates a new hash page, either from the free list or from the
+ * newest extent of the index. The page is pinned - caller is responsible for
+ * unpinning it.
+ */
+static int32_t hash_allocate_page(BufMgr* buf, IndexDesc* idx, HashMeta* m) {
+  if (m->freePageId != 0) {
+    BufTag* tag = bufdesc_new_buftag(FILE_DATA, m->freePageId);
+    int32_t bufId = bufmgr_request_bufId(buf, tag);
+    bufdesc_free_buftag(tag);
+    if (bufId < 0) return -1;
+
+    Page pg = buf->bp->pages[bufId];
+    m->freePageId = ((PageHeader*)pg)->nextPageId;
+
+    page_zero(pg);
+    pageheader_set_pageid(pg, buf->bd->descArr[bufId]->tag->pageId);
+    pageheader_init_hashpage(pg);
+    bufdesc_set_dirty(buf->bd->descArr[bufId]);
+
+    return bufId;
+  }
+
+  return hash_allocate_extent_page(buf, idx);
+}
+
+/**
+ * @brief Makes sure the free list holds at least `numPages` pages, adding new
+ * pages from the newest extent of the index when it is shorter than that
+ */
+static bool hash_reserve_pages(BufMgr* buf, IndexDesc* idx, HashMeta* m, int numPages) {
+  BufTag* tag = bufdesc_new_buftag(FILE_DATA, m->freePageId);
+  while (numPages > 0 && tag->pageId != 0) {
+    int32_t bufId = bufmgr_request_bufId_readonly(buf, tag);
+    if (bufId < 0) break;
+
+    tag->pageId = ((PageHeader*)buf->bp->pages[bufId])->nextPageId;
+    bufmgr_release_bufId(buf, bufId);
+    numPages--;
+  }
+  bufdesc_free_buftag(tag);
+
+  for (; numPages > 0; numPages--) {
+    int32_t bufId = hash_allocate_extent_page(buf, idx);
+    if (bufId < 0) return false;
+
+    Page pg = buf->bp->pages[bufId];
+    pageheader_set_nextpageid(pg, m->freePageId);
+    m->freePageId = ((PageHeader*)pg)->pageId;
+
+    bufdesc_set_dirty(buf->bd->descArr[bufId]);
+    bufmgr_release_bufId(buf, bufId);
+  }
+
+  return true;
+}
+
+/**
+ * @brief Returns the pageId of the primary page of `bucket`, or 0 if the
+ * directory page can't be read
+ */
+static uint32_t hash_get_bucket_pageid(BufMgr* buf, HashMeta* m, uint32_t bucket) {
+  uint32_t dirEntries = hash_dir_page_entries();
+
+  BufTag* tag = bufdesc_new_buftag(FILE_DATA, m->dirPageIds[bucket / dirEntries]);
+  int32_t bufId = bufmgr_request_bufId_readonly(buf, tag);
+  bufdesc_free_buftag(tag);
+  if (bufId < 0) return 0;
+
+  uint32_t pageId;
+  Record dir = page_get_record(buf->bp->pages[bufId], 0);
+  memcpy(&pageId, dir + (bucket % dirEntries) * sizeof(uint32_t), sizeof(uint32_t));
+
+  bufmgr_release_bufId(buf, bufId);
+
+  return pageId;
+}
+
+/**
+ * @brief Adds a new bucket at the end of the directory and returns the pageId
+ * of its (empty) primary page, or 0 on failure. The directory gets a new page
+ * whenever the last one is full.
+ */
+static uint32_t hash_add_bucket(BufMgr* buf, IndexDesc* idx, HashMeta* m) {
+  uint32_t dirEntries = hash_dir_page_entries();
+  uint32_t bucket = m->numBuckets;
+  uint32_t dirPage = bucket / dirEntries;
+
+  if (dirPage >= HASH_MAX_DIR_PAGES) return 0;
+
+  int32_t dirBufId;
+  if (dirPage == m->numDirPages) {
+    dirBufId = hash_allocate_page(buf, idx, m);
+    if (dirBufId < 0) return 0;
+
+    Record dir = calloc(dirEntries, sizeof(uint32_t));
+    page_insert(buf->bp->pages[dirBufId], dir, dirEntries * sizeof(uint32_t));
+    free(dir);
+
+    m->dirPageIds[m->numDirPages++] = buf->bd->descArr[dirBufId]->tag->pageId;
+  } else {
+    BufTag* tag = bufdesc_new_buftag(FILE_DATA, m->dirPageIds[dirPage]);
+    dirBufId = bufmgr_request_bufId(buf, tag);
+    bufdesc_free_buftag(tag);
+    if (dirBufId < 0) return 0;
+  }
+
+  int32_t bufId = hash_allocate_page(buf, idx, m);
+  if (bufId < 0) {
+    bufmgr_release_bufId(buf, dirBufId);
+    return 0;
+  }
+
+  uint32_t pageId = buf->bd->descArr[bufId]->tag->pageId;
+  Record dir = page_get_record(buf->bp->pages[dirBufId], 0);
+  memcpy(dir + (bucket % dirEntries) * sizeof(uint32_t), &pageId, sizeof(uint32_t));
+  m->numBuckets++;
+
+  bufdesc_set_dirty(buf->bd->descArr[dirBufId]);
+  bufmgr_release_bufId(buf, dirBufId);
+  bufmgr_release_bufId(buf, bufId);
+
+  return pageId;
+}
+
+/**
+ * @brief Adds `e` to the bucket whose primary page is `pageId`. Only the
+ * primary page and the last page of the chain can have room, since every page
+ * in between filled up before the next one was added. If neither has room, a
+ * new overflow page goes at the end of the chain.
+ */
+static bool hash_chain_insert(BufMgr* buf, IndexDesc* idx, HashMeta* m, uint32_t pageId, HashEntry* e) {
+  BufTag* tag = bufdesc_new_buftag(FILE_DATA, pageId);
+  int32_t bufId = bufmgr_request_bufId(buf, tag);
+  if (bufId < 0) {
+    bufdesc_free_buftag(tag);
+    return false;
+  }
+
+  Page primary = buf->bp->pages[bufId];
+  uint32_t lastPageId = ((PageHeader*)primary)->prevPageId;
+
+  if (page_insert(primary, (Record)e, sizeof(HashEntry))) {
+    bufdesc_set_dirty(buf->bd->descArr[bufId]);
+    bufmgr_release_bufId(buf, bufId);
+    bufdesc_free_buftag(tag);
+    return true;
+  }
+
+  int32_t lastBufId = bufId;
+  if (lastPageId != 0) {
+    tag->pageId = lastPageId;
+    lastBufId = bufmgr_request_bufId(buf, tag);
+  }
+  bufdesc_free_buftag(tag);
+
+  if (lastBufId < 0) {
+    bufmgr_release_bufId(buf, bufId);
+    return false;
+  }
+
+  bool success = true;
+  if (lastBufId == bufId || !page_insert(buf->bp->pages[lastBufId], (Record)e, sizeof(HashEntry))) {
+    int32_t overflowBufId = hash_allocate_page(buf, idx, m);
+
+    if (overflowBufId < 0) {
+      success = false;
+    } else {
+      Page last = buf->bp->pages[lastBufId];
+      Page overflow = buf->bp->pages[overflowBufId];
+      uint32_t overflowPageId = buf->bd->descArr[overflowBufId]->tag->pageId;
+
+      pageheader_set_prevpageid(overflow, ((PageHeader*)last)->pageId);
+      pageheader_set_nextpageid(last, overflowPageId);
+      pageheader_set_prevpageid(primary, overflowPageId);
+      page_insert(overflow, (Record)e, sizeof(HashEntry));
+
+      bufdesc_set_dirty(buf->bd->descArr[overflowBufId]);
+      bufmgr_release_bufId(buf, overflowBufId);
+    }
+  }
+
+  bufdesc_set_dirty(buf->bd->descArr[bufId]);
+  if (lastBufId != bufId) {
+    bufdesc_set_dirty(buf->bd->descArr[lastBufId]);
+    bufmgr_release_bufId(buf, lastBufId);
+  }
+  bufmgr_release_bufId(buf, bufId);
+
+  return success;
+}
+
+/**
+ * @brief Splits the bucket at the split pointer. A new bucket is added at the
+ * end of the directory, and every entry of the old bucket either stays or
+ * moves to the new one, depending on the next bit of its hash.
+ *
+ * @details Nothing is changed until every page the split needs is on the
+ * free list: the new bucket's primary page, possibly a new directory page,
+ * and enough overflow pages for both chains. Only then is the old chain
+ * emptied (its overflow pages go to the free list too) and the entries
+ * inserted back into the two buckets, so running out of pages leaves the
+ * index the way it was.
+ */
+static bool hash_split_bucket(BufMgr* buf, IndexDesc* idx, HashMeta* m) {
+  uint32_t oldBucket = m->splitBucket;
+  uint64_t newRoundBuckets = (uint64_t)HASH_INITIAL_BUCKETS << (m->level + 1);
+
+  uint32_t oldPageId = hash_get_bucket_pageid(buf, m, oldBucket);
+  if (oldPageId == 0) return false;
+
+  int numEntries = 0;
+  int maxEntries = 64;
+  HashEntry* entries = malloc(sizeof(HashEntry) * maxEntries);
+  int numOldPages = 0;
+  int numMoving = 0;
+  bool success = true;
+
+  BufTag* tag = bufdesc_new_buftag(FILE_DATA, oldPageId);
+  while (tag->pageId != 0) {
+    int32_t bufId = bufmgr_request_bufId_readonly(buf, tag);
+    if (bufId < 0) {
+      success = false;
+      break;
+    }
+
+    Page pg = buf->bp->pages[bufId];
+    PageHeader* pgHdr = (PageHeader*)pg;
+
+    for (int i = 0; i < pgHdr->numRecords; i++) {
+      if (numEntries == maxEntries) {
+        maxEntries *= 2;
+        entries = realloc(entries, sizeof(HashEntry) * maxEntries);
+      }
+      entries[numEntries] = *hash_get_entry(pg, i);
+      if (hash_key(entries[numEntries].key) % newRoundBuckets != oldBucket) numMoving++;
+      numEntries++;
+    }
+
+    numOldPages++;
+    tag->pageId = pgHdr->nextPageId;
+    bufmgr_release_bufId(buf, bufId);
+  }
+
+  /* both chains fill their pages in order, so each needs ceil(n / pageEntries) pages, at least one */
+  int pageEntries = (conf->pageSize - sizeof(PageHeader)) / HASH_ENTRY_SPACE;
+  int stayPages = (numEntries - numMoving + pageEntries - 1) / pageEntries;
+  int movePages = (numMoving + pageEntries - 1) / pageEntries;
+  int needPages = (stayPages > 1 ? stayPages : 1) + (movePages > 1 ? movePages : 1);
+  if (m->numBuckets / hash_dir_page_entries() == m->numDirPages) needPages++;
+
+  /* the old chain's pages are reused, only the difference has to be reserved */
+  success = success && hash_reserve_pages(buf, idx, m, needPages - numOldPages);
+
+  uint32_t newPageId = success ? hash_add_bucket(buf, idx, m) : 0;
+  if (newPageId == 0) {
+    bufdesc_free_buftag(tag);
+    free(entries);
+    return false;
+  }
+
+  m->splitBucket++;
+  if (m->splitBucket == (uint64_t)HASH_INITIAL_BUCKETS << m->level) {
+    m->level++;
+    m->splitBucket = 0;
+  }
+
+  tag->pageId = oldPageId;
+  while (tag->pageId != 0) {
+    int32_t bufId = bufmgr_request_bufId(buf, tag);
+    if (bufId < 0) break;
+
+    Page pg = buf->bp->pages[bufId];
+    PageHeader* pgHdr = (PageHeader*)pg;
+
+    page_truncate(pg, 0);
+    tag->pageId = pgHdr->nextPageId;
+
+    if (pgHdr->pageId == oldPageId) {
+      pageheader_set_prevpageid(pg, 0);
+      pageheader_set_nextpageid(pg, 0);
+    } else {
+      pageheader_set_nextpageid(pg, m->freePageId);
+      m->freePageId = pgHdr->pageId;
+    }
+
+    bufdesc_set_dirty(buf->bd->descArr[bufId]);
+    bufmgr_release_bufId(buf, bufId);
+  }
+  bufdesc_free_buftag(tag);
+
+  for (int i = 0; i < numEntries && success; i++) {
+    uint32_t pageId = hash_key(entries[i].key) % newRoundBuckets == oldBucket ? oldPageId : newPageId;
+    success = hash_chain_insert(buf, idx, m, pageId, &entries[i]);
+  }
+
+  free(entries);
+
+  return success;
+}
+
+/**
+ * @brief Creates an empty hash index with HASH_INITIAL_BUCKETS buckets in a
+ * brand new extent and sets `idx->rootPageId` to its meta page
+ *
+ * @param buf
+ * @param idx
+ * @return true
+ * @return false
+ */
+bool hash_create(BufMgr* buf, IndexDesc* idx) {
+  int32_t bufId = bufmgr_allocate_new_extent(buf, FILE_DATA);
+  if (bufId < 0) {
+    printf("Unable to allocate new page hash\n");
+    return false;
+  }
+
+  Page pg = buf->bp->pages[bufId];
+  pageheader_init_hashpage(pg);
+  idx->rootPageId = buf->bd->descArr[bufId]->tag->pageId;
+
+  sysextent_track_object_page(buf, idx->objectId, idx->rootPageId);
+
+  HashMeta meta;
+  memset(&meta, 0, sizeof(HashMeta));
+  page_insert(pg, (Record)&meta, sizeof(HashMeta));
+
+  HashMeta* m = hash_get_meta(pg);
+  bool success = true;
+  for (int i = 0; i < HASH_INITIAL_BUCKETS && success; i++) {
+    success = hash_add_bucket(buf, idx, m) != 0;
+  }
+
+  bufdesc_set_dirty(buf->bd->descArr[bufId]);
+  bufmgr_release_bufId(buf, bufId);
+
+  return success;
+}
+
+/**
+ * @brief Inserts `e` into its bucket, then splits the next bucket if the
+ * index got too full
+ *
+ * @param buf
+ * @param idx
+ * @param e
+ * @return true
+ * @return false
+ */
+bool hash_insert(BufMgr* buf, IndexDesc* idx, HashEntry* e) {
+  BufTag* tag = bufdesc_new_buftag(FILE_DATA, idx->rootPageId);
+  int32_t metaBufId = bufmgr_request_bufId(buf, tag);
+  bufdesc_free_buftag(tag);
+  if (metaBufId < 0) return false;
+
+  HashMeta* m = hash_get_meta(buf->bp->pages[metaBufId]);
+
+  uint32_t pageId = hash_get_bucket_pageid(buf, m, hash_bucket_of(m, e->key));
+  bool success = pageId != 0 && hash_chain_insert(buf, idx, m, pageId, e);
+
+  if (success) {
+    m->numEntries++;
+
+    /* once the directory can't grow anymore, buckets just get longer overflow chains */
+    if (m->numEntries > hash_split_threshold(m) && m->numBuckets < HASH_MAX_DIR_PAGES * hash_dir_page_entries()) {
+      success = hash_split_bucket(buf, idx, m);
+    }
+  }
+
+  bufdesc_set_dirty(buf->bd->descArr[metaBufId]);
+  bufmgr_release_bufId(buf, metaBufId);
+
+  return success;
+}
+
+/**
+ * @brief Starts a scan over every entry whose key equals `key`. Only the one
+ * bucket `key` hashes to is read.
+ *
+ * @param buf
+ * @param idx
+ * @param key
+ * @return HashScan*
+ */
+HashScan* hash_scan_begin(BufMgr* buf, IndexDesc* idx, int64_t key) {
+  HashScan* scan = malloc(sizeof(HashScan));
+  scan->buf = buf;
+  scan->key = key;
+  scan->pageId = 0;
+  scan->slotId = 0;
+
+  BufTag* tag = bufdesc_new_buftag(FILE_DATA, idx->rootPageId);
+  int32_t metaBufId = bufmgr_request_bufId_readonly(buf, tag);
+  bufdesc_free_buftag(tag);
+
+  if (metaBufId >= 0) {
+    HashMeta* m = hash_get_meta(buf->bp->pages[metaBufId]);
+    scan->pageId = hash_get_bucket_pageid(buf, m, hash_bucket_of(m, key));
+    bufmgr_release_bufId(buf, metaBufId);
+  }
+
+  return scan;
+}
+
+/**
+ * @brief Returns the next matching entry of the scan in `e`. Follows the
+ * bucket's overflow chain until it runs out.
+ *
+ * @param scan
+ * @param e
+ * @return true if an entry was returned
+ * @return false if the scan is done
+ */
+bool hash_scan_next(HashScan* scan, HashEntry* e) {
+  BufTag* tag = bufdesc_new_buftag(FILE_DATA, 0);
+  bool found = false;
+
+  while (scan->pageId != 0 && !found) {
+    tag->pageId = scan->pageId;
+    int32_t bufId = bufmgr_request_bufId_readonly(scan->buf, tag);
+    if (bufId < 0) {
+      scan->pageId = 0;
+      break;
+    }
+
+    Page pg = scan->buf->bp->pages[bufId];
+    PageHeader* pgHdr = (PageHeader*)pg;
+
+    while (scan->slotId < pgHdr->numRecords && !found) {
+      *e = *hash_get_entry(pg, scan->slotId);
+      scan->slotId++;
+      found = e->key == scan->key;
+    }
+
+    if (!found) {
+      scan->pageId = pgHdr->nextPageId;
+      scan->slotId = 0;
+    }
+
+    bufmgr_release_bufId(scan->buf, bufId);
+  }
+
+  bufdesc_free_buftag(tag);
+
+  return found;
+}
+
+void hash_scan_end(HashScan* scan) {
+  if (scan != NULL) free(scan);
+}
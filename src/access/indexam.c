@@ -0,0 +1,753 @@
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "access/indexam.h"
+#include "access/btree.h"
+#include "access/hash.h"
+#include "access/tableam.h"
+#include "access/visibilitymap.h"
+#include "global/config.h"
+#include "system/systable.h"
+#include "system/syssequence.h"
+#include "system/sysindex.h"
+
+/**
+ * @brief Index keys are 64-bit integers, so only integer columns can be indexed
+ */
+bool indexam_is_indexable(DataType dataType) {
+  switch (dataType) {
+    case DT_TINYINT:
+    case DT_SMALLINT:
+    case DT_INT:
+    case DT_BIGINT:
+    case DT_BOOL:
+      return true;
+    default:
+      return false;
+  }
+}
+
+int64_t indexam_datum_to_key(DataType dataType, Datum d) {
+  switch (dataType) {
+    case DT_TINYINT:
+    case DT_BOOL:
+      return datumGetUInt8(d);
+    case DT_SMALLINT:
+      return datumGetInt16(d);
+    case DT_INT:
+      return datumGetInt32(d);
+    case DT_BIGINT:
+      return datumGetInt64(d);
+    default:
+      return 0;
+  }
+}
+
+extern Config* conf;
+
+static Datum indexam_key_to_datum(DataType dataType, int64_t key) {
+  switch (dataType) {
+    case DT_TINYINT:
+    case DT_BOOL:
+      return uint8GetDatum(key);
+    case DT_SMALLINT:
+      return int16GetDatum(key);
+    case DT_INT:
+      return int32GetDatum(key);
+    default:
+      return int64GetDatum(key);
+  }
+}
+
+static Column* indexam_get_column(RecordDescriptor* rd, char* colname) {
+  for (int i = 0; i < rd->ncols; i++) {
+    if (strcasecmp(rd->cols[i].colname, colname) == 0) return &rd->cols[i];
+  }
+
+  return NULL;
+}
+
+/**
+ * @brief Builds a RecordDescriptor with only the INCLUDE columns of an index.
+ * The columns keep their table colnums, so the serialized INCLUDE columns
+ * can be read straight into (and written from) the Datum array of a table row.
+ * Returns NULL if the index has no INCLUDE columns.
+ */
+static RecordDescriptor* indexam_get_include_desc(RecordDescriptor* rd, uint64_t includedCols) {
+  if (includedCols == 0) return NULL;
+
+  RecordDescriptor* ird = malloc(sizeof(RecordDescriptor) + (__builtin_popcountll(includedCols) * sizeof(Column)));
+  ird->ncols = 0;
+  ird->nfixed = 0;
+  ird->hasNullableColumns = false;
+
+  for (int i = 0; i < rd->ncols && i < 64; i++) {
+    if (!(includedCols & (1ULL << i))) continue;
+
+    Column* col = &rd->cols[i];
+    construct_column_desc(&ird->cols[ird->ncols++], col->colname, col->dataType, col->colnum, col->len, col->isNotNull);
+    if (col->dataType != DT_VARCHAR) ird->nfixed++;
+    if (!col->isNotNull) ird->hasNullableColumns = true;
+  }
+
+  return ird;
+}
+
+/**
+ * @brief Length of the longest possible serialized INCLUDE columns, i.e.
+ * with every column present and every VARCHAR at its max length
+ */
+static int indexam_include_max_len(RecordDescriptor* ird) {
+  int len = sizeof(RecordHeader) + compute_null_bitmap_length(ird);
+
+  for (int i = 0; i < ird->ncols; i++) {
+    switch (ird->cols[i].dataType) {
+      case DT_TINYINT:
+      case DT_BOOL:
+        len += 1;
+        break;
+      case DT_SMALLINT:
+        len += 2;
+        break;
+      case DT_INT:
+        len += 4;
+        break;
+      case DT_BIGINT:
+        len += 8;
+        break;
+      case DT_VARCHAR:
+        len += ird->cols[i].len + 2;
+        break;
+      default:
+        len += ird->cols[i].len;
+    }
+  }
+
+  return len;
+}
+
+/**
+ * @brief An index entry and the serialized INCLUDE columns that go with it,
+ * collected while building an index. `e` has to come first so the array can
+ * be sorted with `btree_entry_compare`.
+ */
+typedef struct IndexBuildEntry {
+  BTreeEntry e;
+  Record payload;
+  uint16_t payloadLen;
+} IndexBuildEntry;
+
+static void indexam_free_build_entries(IndexBuildEntry* entries, int numEntries) {
+  for (int i = 0; i < numEntries; i++) {
+    if (entries[i].payload != NULL) free(entries[i].payload);
+  }
+  free(entries);
+}
+
+/**
+ * @brief Reads every record in the table and collects an index entry for each
+ * non-null value of `col`. NULLs are not indexed.
+ *
+ * @param buf
+ * @param td
+ * @param col
+ * @param numEntries
+ * @return BTreeEntry* array of `numEntries` entries
+ */
+static IndexBuildEntry* indexam_collect_entries(BufMgr* buf, TableDesc* td, Column* col, RecordDescriptor* ird, int* numEntries) {
+  int maxEntries = 64;
+  IndexBuildEntry* entries = malloc(sizeof(IndexBuildEntry) * maxEntries);
+  *numEntries = 0;
+
+  int32_t pageId = systable_get_first_pageid(buf, td->tablename);
+  if (pageId <= 0) return entries;
+
+  BufTag* tag = bufdesc_new_buftag(FILE_DATA, pageId);
+  int32_t bufId = bufmgr_request_bufId_readonly(buf, tag);
+
+  Datum* values = malloc(sizeof(Datum) * td->rd->ncols);
+  bool* isnull = malloc(sizeof(bool) * td->rd->ncols);
+
+  while (bufId >= 0) {
+    Page pg = buf->bp->pages[bufId];
+    PageHeader* pgHdr = (PageHeader*)pg;
+
+    for (int i = 0; i < pgHdr->numRecords; i++) {
+      defill_record(td->rd, page_get_record(pg, i), values, isnull);
+
+      if (!isnull[col->colnum]) {
+        if (*numEntries == maxEntries) {
+          maxEntries *= 2;
+          entries = realloc(entries, sizeof(IndexBuildEntry) * maxEntries);
+        }
+
+        IndexBuildEntry* be = &entries[(*numEntries)++];
+        be->e.key = indexam_datum_to_key(col->dataType, values[col->colnum]);
+        be->e.rid.pageId = tag->pageId;
+        be->e.rid.slotId = i;
+        be->e.childPageId = 0;
+        be->payload = NULL;
+        be->payloadLen = 0;
+
+        if (ird != NULL) be->payload = record_serialize(ird, values, isnull, &be->payloadLen);
+      }
+
+      for (int j = 0; j < td->rd->ncols; j++) {
+        if (!isnull[j] && (td->rd->cols[j].dataType == DT_CHAR || td->rd->cols[j].dataType == DT_VARCHAR)) {
+          free(datumGetString(values[j]));
+        }
+      }
+    }
+
+    tag->pageId = pgHdr->nextPageId;
+    bufmgr_release_bufId(buf, bufId);
+    bufId = bufmgr_request_bufId_readonly(buf, tag);
+  }
+
+  free(values);
+  free(isnull);
+  bufdesc_free_buftag(tag);
+
+  return entries;
+}
+
+/**
+ * @brief Sorts the entries and bulk-builds the B+tree bottom-up (see
+ * `btree_build_add`) instead of inserting one entry at a time
+ */
+static bool indexam_build_btree(BufMgr* buf, IndexDesc* idx, IndexBuildEntry* entries, int numEntries) {
+  qsort(entries, numEntries, sizeof(IndexBuildEntry), btree_entry_compare);
+
+  BTreeBuild* b = btree_build_begin(buf, idx);
+  if (b == NULL) return false;
+
+  bool success = true;
+  for (int i = 0; i < numEntries && success; i++) {
+    success = btree_build_add(b, &entries[i].e, entries[i].payload, entries[i].payloadLen);
+  }
+  btree_build_end(b);
+
+  return success;
+}
+
+/**
+ * @brief Creates an empty hash index and inserts the entries one at a time,
+ * letting the buckets split as it fills up
+ */
+static bool indexam_build_hash(BufMgr* buf, IndexDesc* idx, IndexBuildEntry* entries, int numEntries) {
+  if (!hash_create(buf, idx)) return false;
+
+  bool success = true;
+  for (int i = 0; i < numEntries && success; i++) {
+    HashEntry e = { .key = entries[i].e.key, .rid = entries[i].e.rid };
+    success = hash_insert(buf, idx, &e);
+  }
+
+  return success;
+}
+
+/**
+ * @brief A copy of a table row, read while building a clustered index
+ */
+typedef struct ClusteredRow {
+  int64_t key;
+  Record r;
+  uint16_t len;
+} ClusteredRow;
+
+static int indexam_clustered_row_compare(const void* a, const void* b) {
+  const ClusteredRow* ra = a;
+  const ClusteredRow* rb = b;
+
+  if (ra->key != rb->key) return ra->key < rb->key ? -1 : 1;
+  return 0;
+}
+
+/**
+ * @brief Turns the table into an index-organized table. Every row is copied
+ * out of the heap, the rows are sorted by key, and they are bulk-built into the
+ * leaf pages of the clustered index. The first and last leaf pages are
+ * returned in `firstPageId` and `lastPageId`.
+ *
+ * @details The old heap pages stay allocated to the table, but nothing points
+ * to them anymore once `_tables` is pointed at the leaf level.
+ */
+static bool indexam_build_clustered(BufMgr* buf, TableDesc* td, IndexDesc* idx, int32_t* firstPageId, int32_t* lastPageId) {
+  int numRows = 0;
+  int maxRows = 64;
+  ClusteredRow* rows = malloc(sizeof(ClusteredRow) * maxRows);
+
+  BufTag* tag = bufdesc_new_buftag(FILE_DATA, systable_get_first_pageid(buf, td->tablename));
+  int32_t bufId = tag->pageId > 0 ? bufmgr_request_bufId_readonly(buf, tag) : -1;
+
+  while (bufId >= 0) {
+    Page pg = buf->bp->pages[bufId];
+    PageHeader* pgHdr = (PageHeader*)pg;
+
+    for (int i = 0; i < pgHdr->numRecords; i++) {
+      if (numRows == maxRows) {
+        maxRows *= 2;
+        rows = realloc(rows, sizeof(ClusteredRow) * maxRows);
+      }
+
+      ClusteredRow* row = &rows[numRows++];
+      row->len = page_get_slot(pg, i)->length;
+      row->r = malloc(row->len);
+      memcpy(row->r, page_get_record(pg, i), row->len);
+      row->key = btree_record_key(idx, row->r);
+    }
+
+    tag->pageId = pgHdr->nextPageId;
+    bufmgr_release_bufId(buf, bufId);
+    bufId = bufmgr_request_bufId_readonly(buf, tag);
+  }
+  bufdesc_free_buftag(tag);
+
+  qsort(rows, numRows, sizeof(ClusteredRow), indexam_clustered_row_compare);
+
+  bool success = true;
+  for (int i = 1; i < numRows && success; i++) {
+    if (rows[i].key == rows[i - 1].key) {
+      printf("Duplicate key %ld, a clustered index key must be unique\n", rows[i].key);
+      success = false;
+    }
+  }
+
+  BTreeBuild* b = success ? btree_build_begin(buf, idx) : NULL;
+  if (b == NULL) success = false;
+
+  if (b != NULL) {
+    for (int i = 0; i < numRows && success; i++) {
+      success = btree_build_add_record(b, rows[i].r, rows[i].len);
+    }
+
+    *firstPageId = b->firstLeafPageId;
+    *lastPageId = b->pageIds[0];
+    btree_build_end(b);
+  }
+
+  for (int i = 0; i < numRows; i++) {
+    free(rows[i].r);
+  }
+  free(rows);
+
+  return success;
+}
+
+/**
+ * @brief Maps the method name from `USING` to the index type stored in
+ * `_indexes`. No method means a B+tree. Returns 0 for an unknown method.
+ */
+static char indexam_get_type(char* method, bool clustered) {
+  if (method == NULL || strcasecmp(method, "btree") == 0) return clustered ? 'c' : 'b';
+  if (strcasecmp(method, "hash") == 0) return 'h';
+
+  return 0;
+}
+
+/**
+ * @brief Executes a CREATE INDEX statement
+ *
+ * @details The index gets a new objectId from the `sys_object_id` sequence.
+ * Then we read the whole table and build either a B+tree or a hash index from
+ * the entries. Lastly, the index and its root page are recorded in `_indexes`.
+ *
+ * The values of the INCLUDE columns are copied into the leaf entries of a
+ * B+tree, which turns it into a covering index: a query that only needs the
+ * key and those columns can be answered without reading the table (see
+ * `indexam_lookup`).
+ *
+ * A clustered index instead takes over the table's rows (see
+ * `indexam_build_clustered`). Secondary indexes point at rows by rid, and rows
+ * of a clustered table move whenever a leaf page splits, so a clustered index
+ * can only be created on a table without indexes, and it stays the table's
+ * only index.
+ *
+ * @param buf
+ * @param td
+ * @param indexname
+ * @param colname
+ * @param method "btree", "hash", or NULL for the default (btree)
+ * @param clustered
+ * @param includeNames names of the INCLUDE columns
+ * @param numIncluded
+ * @return true
+ * @return false
+ */
+bool indexam_create(
+  BufMgr* buf,
+  TableDesc* td,
+  char* indexname,
+  char* colname,
+  char* method,
+  bool clustered,
+  char** includeNames,
+  int numIncluded
+) {
+  int64_t tableId = systable_get_objectId(buf, td->tablename);
+  if (tableId < 0) {
+    printf("Table %s does not exist\n", td->tablename);
+    return false;
+  }
+
+  Column* col = indexam_get_column(td->rd, colname);
+  if (col == NULL) {
+    printf("Column %s does not exist\n", colname);
+    return false;
+  }
+
+  if (!indexam_is_indexable(col->dataType)) {
+    printf("Only integer columns can be indexed\n");
+    return false;
+  }
+
+  char type = indexam_get_type(method, clustered);
+  if (type == 0) {
+    printf("Unknown index method %s\n", method);
+    return false;
+  }
+
+  if (clustered && type != 'c') {
+    printf("Clustered indexes can only be B+trees\n");
+    return false;
+  }
+
+  if (clustered && !col->isNotNull) {
+    printf("Column %s is nullable, it can't be a clustered index key\n", colname);
+    return false;
+  }
+
+  if (numIncluded > 0 && type != 'b') {
+    printf("Only non-clustered B+tree indexes can have INCLUDE columns\n");
+    return false;
+  }
+
+  uint64_t includedCols = 0;
+  for (int i = 0; i < numIncluded; i++) {
+    Column* inc = indexam_get_column(td->rd, includeNames[i]);
+
+    if (inc == NULL) {
+      printf("Column %s does not exist\n", includeNames[i]);
+      return false;
+    }
+
+    if (inc->colnum == col->colnum || (inc->colnum < 64 && (includedCols & (1ULL << inc->colnum)))) {
+      printf("Column %s is already part of the index\n", includeNames[i]);
+      return false;
+    }
+
+    /* includedCols is a 64-bit mask */
+    if (inc->colnum >= 64) {
+      printf("Column %s can't be included, only the first 64 columns can\n", includeNames[i]);
+      return false;
+    }
+
+    includedCols |= 1ULL << inc->colnum;
+  }
+
+  RecordDescriptor* ird = indexam_get_include_desc(td->rd, includedCols);
+
+  /* with at least 4 entries per page, a page split always makes room */
+  if (ird != NULL && (int)sizeof(BTreeEntry) + indexam_include_max_len(ird) > (int)(conf->pageSize - sizeof(PageHeader)) / 4) {
+    printf("INCLUDE columns are too large for index %s\n", indexname);
+    free_record_desc(ird);
+    return false;
+  }
+
+  LinkedList* indexes = sysindex_get_table_indexes(buf, tableId);
+  bool valid = true;
+  ListItem* li = indexes->head;
+  while (li != NULL && valid) {
+    IndexDesc* existing = li->ptr;
+
+    if (strcasecmp(existing->indexname, indexname) == 0) {
+      printf("Index %s already exists\n", indexname);
+      valid = false;
+    } else if (existing->type == 'c') {
+      printf("Table %s is clustered, it can't have other indexes\n", td->tablename);
+      valid = false;
+    } else if (clustered) {
+      printf("Table %s already has indexes, it can't be clustered\n", td->tablename);
+      valid = false;
+    }
+
+    li = li->next;
+  }
+  sysindex_free_index_list(indexes);
+
+  int64_t objectId = valid ? syssequence_next_value(buf, "sys_object_id") : -1;
+  if (objectId < 0) {
+    if (ird != NULL) free_record_desc(ird);
+    return false;
+  }
+
+  IndexDesc* idx = new_indexdesc(objectId, indexname, col->colnum, type, 0, includedCols);
+  idx->rd = td->rd;
+
+  bool success;
+  int32_t firstPageId = 0;
+  int32_t lastPageId = 0;
+
+  if (type == 'c') {
+    success = indexam_build_clustered(buf, td, idx, &firstPageId, &lastPageId);
+  } else {
+    int numEntries;
+    IndexBuildEntry* entries = indexam_collect_entries(buf, td, col, ird, &numEntries);
+
+    success = type == 'h'
+      ? indexam_build_hash(buf, idx, entries, numEntries)
+      : indexam_build_btree(buf, idx, entries, numEntries);
+
+    indexam_free_build_entries(entries, numEntries);
+  }
+
+  if (ird != NULL) free_record_desc(ird);
+
+  if (success) {
+    char typeStr[2] = { type, '\0' };
+
+    SysIndex* si = malloc(sizeof(SysIndex));
+    si->objectId = idx->objectId;
+    si->tableId = tableId;
+    si->name = idx->indexname;
+    si->colnum = idx->colnum;
+    si->type = typeStr;
+    si->rootPageId = idx->rootPageId;
+    si->includedCols = idx->includedCols;
+
+    success = sysindexinit_insert_record(buf, si);
+    free(si);
+  }
+
+  /* from now on, the table lives on the leaf level of the clustered index, which has no zone map */
+  if (success && type == 'c') {
+    success = systable_set_first_pageid(buf, td->tablename, firstPageId)
+      && systable_set_last_pageid(buf, td->tablename, lastPageId)
+      && systable_set_zonemap_pageid(buf, td->tablename, 0);
+  }
+
+  free_indexdesc(idx);
+
+  return success;
+}
+
+/**
+ * @brief Adds the record that was just inserted at `rid` to every index on
+ * the table
+ *
+ * @param buf
+ * @param td
+ * @param r
+ * @param rid
+ * @return true
+ * @return false
+ */
+bool indexam_insert(BufMgr* buf, TableDesc* td, Record r, RecordId* rid) {
+  return indexam_insert_batch(buf, td, &r, rid, 1);
+}
+
+/**
+ * @brief Adds the records that were just inserted at `rids` to every index
+ * on the table. The table's indexes are only looked up once for the batch,
+ * and not at all if the TableDesc has them cached.
+ *
+ * @param buf
+ * @param td
+ * @param records
+ * @param rids
+ * @param numRecords
+ * @return true
+ * @return false
+ */
+bool indexam_insert_batch(BufMgr* buf, TableDesc* td, Record* records, RecordId* rids, int numRecords) {
+  LinkedList* indexes = td->indexes;
+  if (indexes == NULL) indexes = sysindex_get_table_indexes(buf, systable_get_objectId(buf, td->tablename));
+
+  if (indexes->numItems == 0) {
+    if (indexes != td->indexes) sysindex_free_index_list(indexes);
+    return true;
+  }
+
+  Datum* values = malloc(sizeof(Datum) * td->rd->ncols);
+  bool* isnull = malloc(sizeof(bool) * td->rd->ncols);
+  bool success = true;
+
+  /* the INCLUDE columns of each B+tree, NULL for none */
+  RecordDescriptor** irds = calloc(indexes->numItems, sizeof(RecordDescriptor*));
+  int n = 0;
+  for (ListItem* li = indexes->head; li != NULL; li = li->next, n++) {
+    IndexDesc* idx = li->ptr;
+    if (idx->type == 'b') irds[n] = indexam_get_include_desc(td->rd, idx->includedCols);
+  }
+
+  for (int i = 0; i < numRecords && success; i++) {
+    defill_record(td->rd, records[i], values, isnull);
+
+    ListItem* li = indexes->head;
+    for (n = 0; li != NULL && success; li = li->next, n++) {
+      IndexDesc* idx = li->ptr;
+
+      /* the clustered index is the table itself, the row is already in it */
+      if (idx->type != 'c' && !isnull[idx->colnum]) {
+        int64_t key = indexam_datum_to_key(td->rd->cols[idx->colnum].dataType, values[idx->colnum]);
+
+        if (idx->type == 'h') {
+          HashEntry e = { .key = key, .rid = rids[i] };
+          success = hash_insert(buf, idx, &e);
+        } else {
+          BTreeEntry e = { .key = key, .rid = rids[i], .childPageId = 0 };
+          Record payload = NULL;
+          uint16_t payloadLen = 0;
+
+          if (irds[n] != NULL) payload = record_serialize(irds[n], values, isnull, &payloadLen);
+          success = btree_insert(buf, idx, &e, payload, payloadLen);
+          free(payload);
+        }
+      }
+    }
+
+    for (int c = 0; c < td->rd->ncols; c++) {
+      DataType dataType = td->rd->cols[c].dataType;
+      if (dataType == DT_CHAR || dataType == DT_VARCHAR) free(datumGetString(values[c]));
+    }
+  }
+
+  for (n = 0; n < indexes->numItems; n++) {
+    if (irds[n] != NULL) free_record_desc(irds[n]);
+  }
+
+  free(irds);
+  free(values);
+  free(isnull);
+  if (indexes != td->indexes) sysindex_free_index_list(indexes);
+
+  return success;
+}
+
+/**
+ * @brief Returns true if the index can answer a query that reads the columns
+ * in `neededCols` (bit n set for colnum n) on its own, i.e. it's a B+tree and
+ * every one of them is either its key or one of its INCLUDE columns
+ */
+bool indexam_covers(IndexDesc* idx, uint64_t neededCols) {
+  if (idx->type != 'b') return false;
+
+  uint64_t covered = idx->includedCols;
+  if (idx->colnum < 64) covered |= 1ULL << idx->colnum;
+
+  return (neededCols & ~covered) == 0;
+}
+
+/**
+ * @brief Returns an index on the table that is keyed on `colnum`, or NULL if
+ * there is none. Caller is responsible for freeing it.
+ *
+ * @details An index that covers the query wins, because it never reads the
+ * table. Otherwise, for a single key, a hash index wins over a B+tree on the
+ * same column: it probes one bucket instead of descending the tree. Hash
+ * indexes can't answer range lookups though, so those only consider B+trees.
+ *
+ * @param buf
+ * @param td
+ * @param colnum
+ * @param isRange true if the lookup will cover more than a single key
+ * @param neededCols every column the query reads, see `indexam_covers`
+ * @return IndexDesc*
+ */
+IndexDesc* indexam_find_index(BufMgr* buf, TableDesc* td, int colnum, bool isRange, uint64_t neededCols) {
+  int64_t tableId = systable_get_objectId(buf, td->tablename);
+  LinkedList* indexes = sysindex_get_table_indexes(buf, tableId);
+
+  IndexDesc* found = NULL;
+  ListItem* li = indexes->head;
+  while (li != NULL) {
+    IndexDesc* idx = li->ptr;
+    if (idx->colnum == colnum && !(isRange && idx->type == 'h')) {
+      if (found == NULL || indexam_covers(idx, neededCols)) {
+        found = idx;
+      } else if (idx->type == 'h' && !indexam_covers(found, neededCols)) {
+        found = idx;
+      }
+    }
+    li = li->next;
+  }
+
+  if (found != NULL) {
+    found = new_indexdesc(found->objectId, found->indexname, found->colnum, found->type, found->rootPageId, found->includedCols);
+  }
+
+  sysindex_free_index_list(indexes);
+
+  return found;
+}
+
+/**
+ * @brief Appends the row of an index-only scan to the RecordSet. The row only
+ * has the key and the INCLUDE columns, every other column is NULL.
+ */
+static void indexam_append_index_row(TableDesc* td, IndexDesc* idx, RecordDescriptor* ird, BTreeScan* scan, BTreeEntry* e, RecordSet* rs) {
+  RecordSetRow* row = new_recordset_row(rs->rows, td->rd->ncols);
+
+  for (int i = 0; i < td->rd->ncols; i++) {
+    row->values[i] = (Datum)NULL;
+    row->isnull[i] = true;
+  }
+
+  row->values[idx->colnum] = indexam_key_to_datum(td->rd->cols[idx->colnum].dataType, e->key);
+  row->isnull[idx->colnum] = false;
+
+  if (ird != NULL && scan->payloadLen > 0) defill_record(ird, scan->payload, row->values, row->isnull);
+}
+
+/**
+ * @brief Appends every record whose indexed column is between `lowKey` and
+ * `highKey` (inclusive) to the RecordSet, by probing the index and fetching
+ * each matching rid from the table. B+tree lookups return the records in key
+ * order and only read the leaf pages that cover the range.
+ *
+ * @details If the index covers `neededCols`, this is an index-only scan: the
+ * rows are built from the index entries alone and only have the key and the
+ * INCLUDE columns. The table is still read for an entry whose heap page is not
+ * all-visible in the visibility map, since the entry might not match the row.
+ *
+ * @param buf
+ * @param td
+ * @param idx
+ * @param lowKey
+ * @param highKey must be equal to `lowKey` for hash indexes
+ * @param neededCols every column the query reads, see `indexam_covers`
+ * @param rs
+ */
+void indexam_lookup(BufMgr* buf, TableDesc* td, IndexDesc* idx, int64_t lowKey, int64_t highKey, uint64_t neededCols, RecordSet* rs) {
+  if (idx->type == 'h') {
+    HashScan* scan = hash_scan_begin(buf, idx, lowKey);
+    HashEntry e;
+
+    while (hash_scan_next(scan, &e)) {
+      tableam_fetch(buf, td, &e.rid, rs);
+    }
+
+    hash_scan_end(scan);
+    return;
+  }
+
+  if (idx->type == 'c') idx->rd = td->rd;
+
+  bool indexOnly = indexam_covers(idx, neededCols);
+  RecordDescriptor* ird = indexOnly ? indexam_get_include_desc(td->rd, idx->includedCols) : NULL;
+
+  BTreeScan* scan = btree_scan_begin(buf, idx, lowKey, highKey);
+  BTreeEntry e;
+
+  while (btree_scan_next(scan, &e)) {
+    if (indexOnly && visibilitymap_test(buf, e.rid.pageId)) {
+      indexam_append_index_row(td, idx, ird, scan, &e, rs);
+    } else {
+      tableam_fetch(buf, td, &e.rid, rs);
+    }
+  }
+
+  btree_scan_end(scan);
+  if (ird != NULL) free_record_desc(ird);
+}
\ No newline at end of file
@@ -1,10 +1,331 @@
 #include <stdlib.h>
+#include <pthread.h>
 
 #include "access/tableam.h"
+#include "access/btree.h"
+#include "access/visibilitymap.h"
+#include "access/zonemap.h"
+#include "executor/scheduler.h"
 #include "global/config.h"
 #include "system/systable.h"
+#include "system/sysextent.h"
+#include "system/sysindex.h"
 
 extern Config* conf;
+extern Scheduler* sched;
+
+/* pages of the table a scan task reads, give or take a zone map range */
+#define TABLEAM_MORSEL_PAGES 64
+
+/* morsels per worker that are read before their rows are handed on */
+#define TABLEAM_WAVE_MORSELS 4
+
+/**
+ * @brief A run of pages of the table's page chain that a scan reads
+ *
+ * firstPageId    | first page of the run
+ * numPages       | pages in the run, UINT32_MAX to read to the end of the chain
+ * expectedNextId | page the zone map says follows the run, 0 for none
+ * nextPageId     | returns the page that actually follows it in the chain
+ */
+typedef struct ScanRange {
+  uint32_t firstPageId;
+  uint32_t numPages;
+  uint32_t expectedNextId;
+  uint32_t nextPageId;
+} ScanRange;
+
+/**
+ * @brief A table scan, shared by its tasks
+ *
+ * lock    | held around every call into the buffer manager, which isn't
+ *         | thread-safe, while the tasks run
+ * fn, arg | where the rows go, see tableam_scan_rows
+ * stopped | `fn` asked for no more rows
+ */
+typedef struct ScanState {
+  pthread_mutex_t lock;
+  BufMgr* buf;
+  TableDesc* td;
+  Qual* qual;
+  int numRanges;
+  ScanRange* ranges;
+  TableamRowFunc fn;
+  void* arg;
+  bool stopped;
+} ScanState;
+
+/* a scan task: the ranges it reads and the rows it found in them */
+typedef struct ScanMorsel {
+  ScanState* scan;
+  int firstRange;
+  int numRanges;
+  LinkedList* rows;
+} ScanMorsel;
+
+/**
+ * @brief Picks a comparison that every row satisfying the Qual also
+ * satisfies, to check the zone map with. Returns false if there is none,
+ * e.g. for an OR.
+ */
+static bool tableam_get_scan_key(Qual* qual, ScanKey* key) {
+  if (qual == NULL) return false;
+
+  switch (qual->type) {
+    case QUAL_COMPARE:
+      if (qual->neverTrue) return false;
+      key->colnum = qual->col->colnum;
+      key->op = qual->op;
+      key->intVal = qual->intVal;
+      key->str = qual->str;
+      return true;
+    case QUAL_AND:
+      return tableam_get_scan_key(qual->lhs, key) || tableam_get_scan_key(qual->rhs, key);
+    default:
+      return false;
+  }
+}
+
+/**
+ * @brief Returns the table's first page, from the TableDesc when it has it
+ * cached. <= 0 if the table doesn't exist or has no pages yet.
+ */
+static int32_t tableam_first_pageid(BufMgr* buf, TableDesc* td) {
+  if (td->firstPageId > 0) return td->firstPageId;
+
+  return systable_get_first_pageid(buf, td->tablename);
+}
+
+/**
+ * @brief Returns the pageId of the page that follows `pageId` in its chain
+ */
+static uint32_t tableam_next_pageid(BufMgr* buf, uint32_t pageId) {
+  BufTag* tag = bufdesc_new_buftag(FILE_DATA, pageId);
+  int32_t bufId = bufmgr_request_bufId_readonly(buf, tag);
+  bufdesc_free_buftag(tag);
+
+  if (bufId < 0) return 0;
+
+  uint32_t nextPageId = ((PageHeader*)buf->bp->pages[bufId])->nextPageId;
+  bufmgr_release_bufId(buf, bufId);
+
+  return nextPageId;
+}
+
+static void tableam_add_range(ScanState* scan, int* maxRanges, uint32_t firstPageId, uint32_t numPages) {
+  if (scan->numRanges == *maxRanges) {
+    *maxRanges *= 2;
+    scan->ranges = realloc(scan->ranges, sizeof(ScanRange) * *maxRanges);
+  }
+
+  ScanRange* r = &scan->ranges[scan->numRanges++];
+  r->firstPageId = firstPageId;
+  r->numPages = numPages;
+  r->expectedNextId = 0;
+  r->nextPageId = 0;
+}
+
+/**
+ * @brief Lists the page ranges the scan has to read: the ranges of the
+ * table's zone map that may have a row satisfying one of the Qual's
+ * comparisons (see zonemap.h), then whatever pages of the chain the zone
+ * map doesn't know about. Without a zone map, that's the whole chain.
+ *
+ * @details A parallel scan splits the table up by the zone map's ranges
+ * even when it has nothing to check them against.
+ */
+static void tableam_plan_ranges(ScanState* scan, uint32_t firstPageId) {
+  int maxRanges = 16;
+  scan->ranges = malloc(sizeof(ScanRange) * maxRanges);
+  scan->numRanges = 0;
+
+  ScanKey key;
+  bool hasKey = tableam_get_scan_key(scan->qual, &key);
+  ZoneMapScan* zs = hasKey || sched->numWorkers > 1 ? zonemap_scan_begin(scan->buf, scan->td) : NULL;
+  uint32_t tailPageId = firstPageId;
+
+  if (zs != NULL) {
+    ZoneRange range;
+    bool mayMatch;
+    uint32_t lastPageId = 0;
+    int prevRange = -1;
+
+    while (zonemap_scan_next(zs, hasKey ? &key : NULL, &range, &mayMatch)) {
+      /* the zone map doesn't start where the chain does, so don't trust it */
+      if (lastPageId == 0 && range.firstPageId != firstPageId) break;
+
+      if (prevRange >= 0) scan->ranges[prevRange].expectedNextId = range.firstPageId;
+      prevRange = -1;
+
+      if (mayMatch) {
+        tableam_add_range(scan, &maxRanges, range.firstPageId, range.numPages);
+        prevRange = scan->numRanges - 1;
+      }
+
+      lastPageId = range.lastPageId;
+    }
+
+    zonemap_scan_end(zs);
+
+    if (lastPageId != 0) tailPageId = tableam_next_pageid(scan->buf, lastPageId);
+    if (prevRange >= 0) scan->ranges[prevRange].expectedNextId = tailPageId;
+  }
+
+  if (tailPageId != 0) tableam_add_range(scan, &maxRanges, tailPageId, UINT32_MAX);
+}
+
+/**
+ * @brief Returns false if a range of the morsel isn't followed in the page
+ * chain by the page the zone map says follows it
+ */
+static bool tableam_morsel_follows_chain(ScanMorsel* m) {
+  for (int i = 0; i < m->numRanges; i++) {
+    ScanRange* r = &m->scan->ranges[m->firstRange + i];
+    if (r->numPages != UINT32_MAX && r->nextPageId != r->expectedNextId) return false;
+  }
+
+  return true;
+}
+
+/**
+ * @brief Hands the rows to the scan's callback, in order, and empties the
+ * list. Once the callback stops the scan, the rest of the rows are freed.
+ */
+static void tableam_deliver_rows(ScanState* scan, LinkedList* rows) {
+  ListItem* li = rows->head;
+
+  while (li != NULL) {
+    ListItem* next = li->next;
+
+    if (scan->stopped) {
+      free_recordset_row(li->ptr, scan->td->rd);
+    } else {
+      scan->stopped = !scan->fn(scan->arg, li->ptr);
+    }
+
+    free(li);
+    li = next;
+  }
+
+  rows->head = NULL;
+  rows->tail = NULL;
+  rows->numItems = 0;
+}
+
+/**
+ * @brief Appends every row of the range's pages that satisfies the scan's
+ * Qual to `rows`. The Qual is checked against all the records of a page at
+ * once, before any of them is materialized (see qual.h).
+ *
+ * @param deliver hand the rows to the scan's callback after every page,
+ * only on the thread that started the scan
+ */
+static void tableam_scan_range(ScanState* scan, ScanRange* range, LinkedList* rows, bool deliver) {
+  RecordDescriptor* rd = scan->td->rd;
+  BufTag* tag = bufdesc_new_buftag(FILE_DATA, range->firstPageId);
+  int maxRecords = 0;
+  Record* records = NULL;
+  uint8_t* sel = NULL;
+  QualScratch* scratch = scan->qual != NULL ? qual_new_scratch(scan->qual) : NULL;
+
+  for (uint32_t n = 0; n < range->numPages && tag->pageId != 0; n++) {
+    pthread_mutex_lock(&scan->lock);
+    int32_t bufId = bufmgr_request_bufId_readonly(scan->buf, tag);
+    pthread_mutex_unlock(&scan->lock);
+
+    if (bufId < 0) {
+      tag->pageId = 0;
+      break;
+    }
+
+    Page pg = (Page)scan->buf->bp->pages[bufId];
+    PageHeader* pgHdr = (PageHeader*)pg;
+    int numRecords = pgHdr->numRecords;
+
+    if (numRecords > maxRecords) {
+      maxRecords = numRecords;
+      records = realloc(records, sizeof(Record) * maxRecords);
+      sel = realloc(sel, maxRecords);
+      if (scratch != NULL) qual_scratch_reserve(scratch, maxRecords);
+    }
+
+    for (int i = 0; i < numRecords; i++) {
+      int slotPointerOffset = conf->pageSize - (sizeof(SlotPointer) * (i + 1));
+      SlotPointer* sp = (SlotPointer*)(pg + slotPointerOffset);
+      records[i] = pg + sp->offset;
+      sel[i] = 1;
+    }
+
+    if (scan->qual != NULL) qual_eval_batch(scan->qual, rd, records, numRecords, sel, scratch);
+
+    for (int i = 0; i < numRecords; i++) {
+      if (!sel[i]) continue;
+
+      RecordSetRow* row = new_recordset_row(rows, rd->ncols);
+      defill_record(rd, records[i], row->values, row->isnull);
+    }
+
+    tag->pageId = pgHdr->nextPageId;
+
+    pthread_mutex_lock(&scan->lock);
+    bufmgr_release_bufId(scan->buf, bufId);
+    pthread_mutex_unlock(&scan->lock);
+
+    if (deliver) {
+      tableam_deliver_rows(scan, rows);
+      if (scan->stopped) break;
+    }
+  }
+
+  range->nextPageId = tag->pageId;
+  bufdesc_free_buftag(tag);
+  free(records);
+  free(sel);
+  if (scratch != NULL) free_qual_scratch(scratch);
+}
+
+static void tableam_scan_morsel(void* arg, int workerId) {
+  (void)workerId;
+
+  ScanMorsel* m = arg;
+  m->rows = new_linkedlist();
+
+  for (int i = 0; i < m->numRanges; i++) {
+    tableam_scan_range(m->scan, &m->scan->ranges[m->firstRange + i], m->rows, false);
+  }
+}
+
+/**
+ * @brief Splits the scan's ranges into morsels of about
+ * TABLEAM_MORSEL_PAGES pages each. The range that reads to the end of the
+ * chain, if any, is the last morsel, on its own.
+ *
+ * @return int the number of morsels in `*morsels`
+ */
+static int tableam_plan_morsels(ScanState* scan, ScanMorsel** morsels) {
+  *morsels = malloc(sizeof(ScanMorsel) * (scan->numRanges + 1));
+  int numMorsels = 0;
+
+  for (int i = 0; i < scan->numRanges; numMorsels++) {
+    ScanMorsel* m = &(*morsels)[numMorsels];
+    uint32_t numPages = 0;
+
+    m->scan = scan;
+    m->firstRange = i;
+    m->rows = NULL;
+
+    while (i < scan->numRanges && numPages < TABLEAM_MORSEL_PAGES) {
+      /* the rest of the chain is a morsel of its own */
+      if (scan->ranges[i].numPages == UINT32_MAX && numPages > 0) break;
+
+      numPages += scan->ranges[i++].numPages;
+    }
+
+    m->numRanges = i - m->firstRange;
+  }
+
+  return numMorsels;
+}
 
 /**
  * @brief 
@@ -14,63 +335,358 @@ extern Config* conf;
  * @param rs 
  */
 void tableam_fullscan(BufMgr* buf, TableDesc* td, RecordSet* rs) {
-  int32_t pageId = systable_get_first_pageid(buf, td->tablename);
-  BufTag* tag = bufdesc_new_buftag(FILE_DATA, pageId);
-  int32_t bufId = bufmgr_request_bufId(buf, tag);
+  tableam_scan(buf, td, NULL, rs);
+}
+
+/**
+ * @brief Reads the rows of the table that satisfy `qual` into the
+ * RecordSet, see tableam_scan_rows
+ * 
+ * @param buf 
+ * @param td 
+ * @param qual compiled WHERE clause, NULL to read every row
+ * @param rs 
+ */
+void tableam_scan(BufMgr* buf, TableDesc* td, Qual* qual, RecordSet* rs) {
+  tableam_scan_rows(buf, td, qual, recordset_append_row, rs);
+}
+
+/**
+ * @brief Hands the rows of the table that satisfy `qual` to `fn`, one at a
+ * time, in page chain order
+ * 
+ * @details Every page range the table's zone map rules out for one of the
+ * Qual's comparisons is skipped without being read (see zonemap.h). The
+ * Qual is checked against every row of the other pages. Without a Qual,
+ * that's every row of the table.
+ * 
+ * The pages to read are split into morsels of about TABLEAM_MORSEL_PAGES
+ * pages, which the worker threads read in parallel (see scheduler.h), a
+ * wave of TABLEAM_WAVE_MORSELS morsels per worker at a time. The rows of a
+ * wave go to `fn` before the next wave is read, so a scan never holds more
+ * than a wave's worth of rows whatever the size of the table. The pages the
+ * zone map doesn't know about are read last, a page at a time.
+ * 
+ * The ranges follow the table's page chain, so if a morsel ever disagrees
+ * with it, the rest of the table is read by following the chain alone,
+ * from the first page of that morsel.
+ * 
+ * @param buf 
+ * @param td 
+ * @param qual compiled WHERE clause, NULL to read every row
+ * @param fn 
+ * @param arg passed on to `fn`
+ * @return bool false if `fn` stopped the scan
+ */
+bool tableam_scan_rows(BufMgr* buf, TableDesc* td, Qual* qual, TableamRowFunc fn, void* arg) {
+  int32_t firstPageId = tableam_first_pageid(buf, td);
+
+  /* the table doesn't exist or has no pages yet */
+  if (firstPageId <= 0) return true;
+
+  ScanState scan;
+  pthread_mutex_init(&scan.lock, NULL);
+  scan.buf = buf;
+  scan.td = td;
+  scan.qual = qual;
+  scan.fn = fn;
+  scan.arg = arg;
+  scan.stopped = false;
+  tableam_plan_ranges(&scan, firstPageId);
+
+  ScanMorsel* morsels;
+  int numMorsels = tableam_plan_morsels(&scan, &morsels);
+  int waveMorsels = sched->numWorkers * TABLEAM_WAVE_MORSELS;
+  uint32_t tailPageId = 0;
+
+  /* the morsel that reads to the end of the chain is read by this thread */
+  if (numMorsels > 0 && scan.ranges[scan.numRanges - 1].numPages == UINT32_MAX) {
+    tailPageId = scan.ranges[scan.numRanges - 1].firstPageId;
+    numMorsels--;
+  }
+
+  for (int first = 0; first < numMorsels && !scan.stopped; first += waveMorsels) {
+    int n = numMorsels - first < waveMorsels ? numMorsels - first : waveMorsels;
+    int numGood = 0;
+
+    scheduler_run(sched, tableam_scan_morsel, &morsels[first], sizeof(ScanMorsel), n);
+
+    while (numGood < n && tableam_morsel_follows_chain(&morsels[first + numGood])) numGood++;
+
+    for (int i = 0; i < n; i++) {
+      LinkedList* rows = morsels[first + i].rows;
+
+      if (i < numGood) {
+        tableam_deliver_rows(&scan, rows);
+      } else {
+        for (ListItem* li = rows->head; li != NULL; li = li->next) free_recordset_row(li->ptr, td->rd);
+      }
+      free_linkedlist(rows, NULL);
+    }
+
+    if (numGood < n) {
+      tailPageId = scan.ranges[morsels[first + numGood].firstRange].firstPageId;
+      break;
+    }
+  }
+
+  if (tailPageId != 0 && !scan.stopped) {
+    ScanRange tail = { tailPageId, UINT32_MAX, 0, 0 };
+    LinkedList* rows = new_linkedlist();
+
+    tableam_scan_range(&scan, &tail, rows, true);
+    free_linkedlist(rows, NULL);
+  }
+
+  free(morsels);
+  free(scan.ranges);
+  pthread_mutex_destroy(&scan.lock);
+
+  return !scan.stopped;
+}
+
+/**
+ * @brief Hands the records of each page of the table to `fn`, one page at
+ * a time in page chain order. The records point into the page, which is
+ * only pinned until `fn` returns, so nothing is copied.
+ * 
+ * @param buf 
+ * @param td 
+ * @param fn 
+ * @param arg passed on to `fn`
+ */
+void tableam_scan_pages(BufMgr* buf, TableDesc* td, TableamPageFunc fn, void* arg) {
+  int32_t firstPageId = tableam_first_pageid(buf, td);
+  BufTag* tag = bufdesc_new_buftag(FILE_DATA, firstPageId > 0 ? firstPageId : 0);
+  int maxRecords = 0;
+  Record* records = NULL;
+
+  while (tag->pageId != 0) {
+    int32_t bufId = bufmgr_request_bufId_readonly(buf, tag);
+    if (bufId < 0) break;
 
-  while (bufId >= 0) {
     Page pg = (Page)buf->bp->pages[bufId];
     PageHeader* pgHdr = (PageHeader*)pg;
-    int numRecords = pgHdr->numRecords;
 
-    for (int i = 0; i < numRecords; i++) {
-      RecordSetRow* row = new_recordset_row(rs->rows, td->rd->ncols);
-      int slotPointerOffset = conf->pageSize - (sizeof(SlotPointer) * (i + 1));
-      SlotPointer* sp = (SlotPointer*)(pg + slotPointerOffset);
-      defill_record(td->rd, pg + sp->offset, row->values, row->isnull);
+    if (pgHdr->numRecords > maxRecords) {
+      maxRecords = pgHdr->numRecords;
+      records = realloc(records, sizeof(Record) * maxRecords);
     }
 
+    for (int i = 0; i < pgHdr->numRecords; i++) records[i] = page_get_record(pg, i);
+
+    fn(arg, records, pgHdr->numRecords);
+
     tag->pageId = pgHdr->nextPageId;
     bufmgr_release_bufId(buf, bufId);
-    bufId = bufmgr_request_bufId(buf, tag);
   }
 
   bufdesc_free_buftag(tag);
+  free(records);
 }
 
 /**
- * @brief Inserts a record into a table
+ * @brief Returns the number of pages of the table. The zone map knows it
+ * without reading a single heap page; tables without one have their page
+ * chain walked.
+ */
+uint32_t tableam_count_pages(BufMgr* buf, TableDesc* td) {
+  uint32_t numPages = 0;
+  ZoneMapScan* zs = zonemap_scan_begin(buf, td);
+
+  if (zs != NULL) {
+    ZoneRange range;
+    bool mayMatch;
+
+    while (zonemap_scan_next(zs, NULL, &range, &mayMatch)) numPages += range.numPages;
+    zonemap_scan_end(zs);
+    return numPages;
+  }
+
+  int32_t firstPageId = tableam_first_pageid(buf, td);
+
+  for (uint32_t pageId = firstPageId > 0 ? firstPageId : 0; pageId != 0; pageId = tableam_next_pageid(buf, pageId)) {
+    numPages++;
+  }
+
+  return numPages;
+}
+
+/**
+ * @brief Fetches the record at `rid` and appends it to the RecordSet
  * 
- * Loops through all pages until it finds enough empty space to insert the record
+ * @param buf 
+ * @param td 
+ * @param rid 
+ * @param rs 
+ * @return true 
+ * @return false if the record does not exist
+ */
+bool tableam_fetch(BufMgr* buf, TableDesc* td, RecordId* rid, RecordSet* rs) {
+  BufTag* tag = bufdesc_new_buftag(FILE_DATA, rid->pageId);
+  int32_t bufId = bufmgr_request_bufId_readonly(buf, tag);
+  bufdesc_free_buftag(tag);
+
+  if (bufId < 0) return false;
+
+  Page pg = buf->bp->pages[bufId];
+  bool found = rid->slotId < ((PageHeader*)pg)->numRecords;
+
+  if (found) {
+    RecordSetRow* row = new_recordset_row(rs->rows, td->rd->ncols);
+    defill_record(td->rd, page_get_record(pg, rid->slotId), row->values, row->isnull);
+  }
+
+  bufmgr_release_bufId(buf, bufId);
+
+  return found;
+}
+
+/**
+ * @brief Inserts a record into a table
  * 
- * @hardcode - we're hard-coding pageId = 1 for now
+ * See tableam_insert_batch.
  * 
  * @param buf 
- * @param td (currently unused)
- * @param values 
+ * @param td 
+ * @param r 
+ * @param recordLen 
+ * @param rid returns the location of the new record, pageId 0 for clustered tables
  * @return true 
  * @return false 
  */
-bool tableam_insert(BufMgr* buf, TableDesc* td, Record r, uint16_t recordLen) {
-  BufTag* tag = malloc(sizeof(BufTag));
-  tag->fileId = FILE_DATA;
-  tag->pageId = 1;
-  int32_t bufId = bufmgr_request_bufId(buf, tag);
+bool tableam_insert(BufMgr* buf, TableDesc* td, Record r, uint16_t recordLen, RecordId* rid) {
+  return tableam_insert_batch(buf, td, &r, &recordLen, 1, rid) == 1;
+}
 
-  if (bufId < 0) return false;
+/**
+ * @brief Returns a copy of the table's clustered index, NULL if the table is
+ * a heap. The TableDesc's cached indexes are used when it has them.
+ */
+static IndexDesc* tableam_get_clustered_index(BufMgr* buf, TableDesc* td) {
+  if (td->indexes == NULL) return sysindex_get_clustered_index(buf, systable_get_objectId(buf, td->tablename));
+
+  for (ListItem* li = td->indexes->head; li != NULL; li = li->next) {
+    IndexDesc* idx = li->ptr;
+    if (idx->type == 'c') return new_indexdesc(idx->objectId, idx->indexname, idx->colnum, idx->type, idx->rootPageId, idx->includedCols);
+  }
+
+  return NULL;
+}
+
+/**
+ * @brief Inserts records into a table, in order
+ * 
+ * Records are always appended to the table's last page. When it is full,
+ * we split it and the new page becomes the table's last page. The catalog
+ * is only looked up once per batch, and every page is pinned once while it
+ * gets as many of the records as fit. Each record is added to the summary
+ * of its page range in the table's zone map. The all-visible bit of the
+ * pages that get records is cleared, the caller sets it again once the
+ * whole statement succeeded (see visibilitymap.h).
+ * 
+ * Clustered tables are the exception: their rows live on the leaf pages of
+ * the clustered index, so each record goes wherever its key belongs. Rows
+ * move around as leaf pages split, so there is no rid to hand back for them.
+ * 
+ * @param buf 
+ * @param td 
+ * @param records 
+ * @param recordLens 
+ * @param numRecords 
+ * @param rids returns the location of each new record, pageId 0 for clustered tables
+ * @return int how many of the records were inserted, all of them unless
+ * something went wrong
+ */
+int tableam_insert_batch(BufMgr* buf, TableDesc* td, Record* records, uint16_t* recordLens, int numRecords, RecordId* rids) {
+  int32_t lastPageId = systable_get_last_pageid(buf, td->tablename);
+  int32_t bufId;
+  int numInserted = 0;
+
+  if (lastPageId < 0) {
+    printf("Table %s does not exist\n", td->tablename);
+    return 0;
+  }
+
+  for (int i = 0; i < numRecords; i++) {
+    if (recordLens[i] + sizeof(SlotPointer) > conf->pageSize - sizeof(PageHeader)) {
+      printf("Record is too large for a single page\n");
+      return 0;
+    }
+  }
+
+  IndexDesc* clustered = tableam_get_clustered_index(buf, td);
+  if (clustered != NULL) {
+    clustered->rd = td->rd;
+    while (numInserted < numRecords && btree_insert_record(buf, clustered, records[numInserted], recordLens[numInserted])) {
+      rids[numInserted].pageId = 0;
+      rids[numInserted].slotId = 0;
+      numInserted++;
+    }
+    free_indexdesc(clustered);
+
+    return numInserted;
+  }
+
+  if (lastPageId == 0) {
+    bufId = bufmgr_allocate_new_extent(buf, FILE_DATA);
+    if (bufId < 0) {
+      printf("Unable to allocate new page tableam\n");
+      return 0;
+    }
+    pageheader_init_datapage(buf->bp->pages[bufId]);
+    int32_t firstPageId = buf->bd->descArr[bufId]->tag->pageId;
+    systable_set_first_pageid(buf, td->tablename, firstPageId);
+    systable_set_last_pageid(buf, td->tablename, firstPageId);
+    sysextent_track_page(buf, td->tablename, firstPageId);
+
+    if (systable_get_zonemap_pageid(buf, td->tablename) == 0 && !zonemap_create(buf, td)) {
+      printf("Unable to create the zone map of table %s, scans will read every page\n", td->tablename);
+    }
+  } else {
+    BufTag* tag = bufdesc_new_buftag(FILE_DATA, lastPageId);
+    bufId = bufmgr_request_bufId(buf, tag);
+    bufdesc_free_buftag(tag);
+  }
 
   while (bufId >= 0) {
     Page pg = buf->bp->pages[bufId];
-    if (page_insert(pg, r, recordLen)) {
-      free(tag);
-      return true;
+    uint32_t pageId = buf->bd->descArr[bufId]->tag->pageId;
+    int firstOnPage = numInserted;
+
+    while (numInserted < numRecords && page_insert(pg, records[numInserted], recordLens[numInserted])) {
+      rids[numInserted].pageId = pageId;
+      rids[numInserted].slotId = ((PageHeader*)pg)->numRecords - 1;
+      numInserted++;
     }
 
-    tag->pageId = ((PageHeader*)pg)->nextPageId;
-    bufId = bufmgr_request_bufId(buf, tag);
+    if (numInserted > firstOnPage) {
+      visibilitymap_clear(buf, pageId);
+      bufdesc_set_dirty(buf->bd->descArr[bufId]);
+    }
+
+    if (numInserted == numRecords) {
+      bufmgr_release_bufId(buf, bufId);
+      break;
+    }
+
+    /* bufmgr_page_split releases the old page for us */
+    bufId = bufmgr_page_split(buf, bufId);
+    if (bufId < 0) break;
+
+    int32_t newPageId = buf->bd->descArr[bufId]->tag->pageId;
+    systable_set_last_pageid(buf, td->tablename, newPageId);
+    sysextent_track_page(buf, td->tablename, newPageId);
   }
 
-  free(tag);
+  /* a zone map that misses a row could hide it from scans, so drop it instead */
+  for (int i = 0; i < numInserted; i++) {
+    if (!zonemap_add_row(buf, td, rids[i].pageId, records[i])) {
+      printf("Unable to update the zone map of table %s, dropping it\n", td->tablename);
+      systable_set_zonemap_pageid(buf, td->tablename, 0);
+      break;
+    }
+  }
 
-  return false;
-}
\ No newline at end of file
+  return numInserted;
+}
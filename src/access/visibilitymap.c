@@ -0,0 +1,149 @@
+#include "access/visibilitymap.h"
+#include "global/config.h"
+#include "system/boot.h"
+#include "system/sysextent.h"
+
+extern Config* conf;
+
+static uint32_t visibilitymap_bits_per_page() {
+  return (conf->pageSize - sizeof(PageHeader)) * 8;
+}
+
+/**
+ * @brief Allocates a new map page after `prevPageId` (or in a new extent if
+ * it's 0) and returns its buffer_id, pinned
+ */
+static int32_t visibilitymap_allocate_page(BufMgr* buf, uint32_t prevPageId) {
+  int32_t bufId = prevPageId == 0
+    ? bufmgr_allocate_new_extent(buf, FILE_DATA)
+    : bufmgr_allocate_page_after(buf, FILE_DATA, prevPageId);
+  if (bufId < 0) {
+    printf("Unable to allocate new page visibilitymap\n");
+    return -1;
+  }
+
+  pageheader_init_vismappage(buf->bp->pages[bufId]);
+  sysextent_track_object_page(buf, VISIBILITYMAP_OBJECT_ID, buf->bd->descArr[bufId]->tag->pageId);
+
+  return bufId;
+}
+
+/**
+ * @brief Returns the buffer_id (pinned) of the map page that covers `pageId`.
+ *
+ * @details Returns -1 if the map doesn't reach that far, unless `extend` is
+ * true, in which case the missing map pages are created.
+ *
+ * @param buf
+ * @param pageId heap page
+ * @param readOnly pin the map page with `bufmgr_request_bufId_readonly`
+ * @param extend
+ * @return int32_t
+ */
+static int32_t visibilitymap_get_page(BufMgr* buf, uint32_t pageId, bool readOnly, bool extend) {
+  BufTag* tag = bufdesc_new_buftag(FILE_DATA, get_vismap_page_id(buf));
+  int32_t bufId = -1;
+
+  if (tag->pageId != 0) {
+    bufId = readOnly ? bufmgr_request_bufId_readonly(buf, tag) : bufmgr_request_bufId(buf, tag);
+  } else if (extend) {
+    bufId = visibilitymap_allocate_page(buf, 0);
+    if (bufId >= 0) set_vismap_page_id(buf, buf->bd->descArr[bufId]->tag->pageId);
+  }
+
+  uint32_t mapPageNum = pageId / visibilitymap_bits_per_page();
+
+  for (uint32_t i = 0; i < mapPageNum && bufId >= 0; i++) {
+    Page pg = buf->bp->pages[bufId];
+    tag->pageId = ((PageHeader*)pg)->nextPageId;
+
+    if (tag->pageId != 0) {
+      bufmgr_release_bufId(buf, bufId);
+      bufId = readOnly ? bufmgr_request_bufId_readonly(buf, tag) : bufmgr_request_bufId(buf, tag);
+    } else if (extend) {
+      int32_t nextBufId = visibilitymap_allocate_page(buf, buf->bd->descArr[bufId]->tag->pageId);
+      if (nextBufId >= 0) {
+        pageheader_set_nextpageid(pg, buf->bd->descArr[nextBufId]->tag->pageId);
+        bufdesc_set_dirty(buf->bd->descArr[bufId]);
+      }
+      bufmgr_release_bufId(buf, bufId);
+      bufId = nextBufId;
+    } else {
+      bufmgr_release_bufId(buf, bufId);
+      bufId = -1;
+    }
+  }
+
+  bufdesc_free_buftag(tag);
+
+  return bufId;
+}
+
+static uint8_t* visibilitymap_get_byte(BufMgr* buf, int32_t bufId, uint32_t pageId) {
+  uint32_t bit = pageId % visibilitymap_bits_per_page();
+
+  return (uint8_t*)(buf->bp->pages[bufId] + sizeof(PageHeader)) + (bit >> 3);
+}
+
+/**
+ * @brief Returns true if every row on heap page `pageId` is visible
+ *
+ * @param buf
+ * @param pageId
+ * @return true
+ * @return false if the page may have changes in flight, or the map doesn't cover it
+ */
+bool visibilitymap_test(BufMgr* buf, uint32_t pageId) {
+  int32_t bufId = visibilitymap_get_page(buf, pageId, true, false);
+  if (bufId < 0) return false;
+
+  bool isSet = *visibilitymap_get_byte(buf, bufId, pageId) & (1 << (pageId & 0x07));
+  bufmgr_release_bufId(buf, bufId);
+
+  return isSet;
+}
+
+/**
+ * @brief Marks heap page `pageId` as all-visible, extending the map if needed
+ *
+ * @param buf
+ * @param pageId
+ * @return true
+ * @return false if the map could not be extended
+ */
+bool visibilitymap_set(BufMgr* buf, uint32_t pageId) {
+  int32_t bufId = visibilitymap_get_page(buf, pageId, false, true);
+  if (bufId < 0) return false;
+
+  uint8_t* byte = visibilitymap_get_byte(buf, bufId, pageId);
+  uint8_t mask = 1 << (pageId & 0x07);
+
+  if (!(*byte & mask)) {
+    *byte |= mask;
+    bufdesc_set_dirty(buf->bd->descArr[bufId]);
+  }
+  bufmgr_release_bufId(buf, bufId);
+
+  return true;
+}
+
+/**
+ * @brief Clears the all-visible bit of heap page `pageId`. Pages the map
+ * doesn't cover yet are never all-visible, so there's nothing to do for them.
+ *
+ * @param buf
+ * @param pageId
+ */
+void visibilitymap_clear(BufMgr* buf, uint32_t pageId) {
+  int32_t bufId = visibilitymap_get_page(buf, pageId, false, false);
+  if (bufId < 0) return;
+
+  uint8_t* byte = visibilitymap_get_byte(buf, bufId, pageId);
+  uint8_t mask = 1 << (pageId & 0x07);
+
+  if (*byte & mask) {
+    *byte &= ~mask;
+    bufdesc_set_dirty(buf->bd->descArr[bufId]);
+  }
+  bufmgr_release_bufId(buf, bufId);
+}
@@ -0,0 +1,398 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "access/zonemap.h"
+#include "access/indexam.h"
+#include "global/config.h"
+#include "system/systable.h"
+#include "system/sysextent.h"
+
+extern Config* conf;
+
+static bool zonemap_is_string(DataType dataType) {
+  return dataType == DT_CHAR || dataType == DT_VARCHAR;
+}
+
+static int zonemap_num_strings(RecordDescriptor* rd) {
+  int numStrings = 0;
+
+  for (int i = 0; i < rd->ncols; i++) {
+    if (zonemap_is_string(rd->cols[i].dataType)) numStrings++;
+  }
+
+  return numStrings;
+}
+
+/**
+ * @brief Bytes of the record that come before the bloom filters. Returns -1
+ * if even that doesn't fit on a page.
+ */
+static int zonemap_fixed_len(RecordDescriptor* rd) {
+  int fixedLen = sizeof(ZoneRange) + rd->ncols * sizeof(ZoneColumn);
+  int avail = conf->pageSize - sizeof(PageHeader) - sizeof(SlotPointer);
+
+  return fixedLen <= avail && fixedLen <= UINT16_MAX ? fixedLen : -1;
+}
+
+/**
+ * @brief Size of the bloom filter of each string column: ZONEMAP_BLOOM_BYTES,
+ * or less if a record with all of them would not fit on a page. 0 means the
+ * string columns are not summarized at all.
+ */
+static int zonemap_bloom_bytes(RecordDescriptor* rd) {
+  int numStrings = zonemap_num_strings(rd);
+  int fixedLen = zonemap_fixed_len(rd);
+  if (numStrings == 0 || fixedLen < 0) return 0;
+
+  int avail = conf->pageSize - sizeof(PageHeader) - sizeof(SlotPointer) - fixedLen;
+  if (avail > UINT16_MAX - fixedLen) avail = UINT16_MAX - fixedLen;
+
+  int bloomBytes = avail / numStrings;
+  if (bloomBytes > ZONEMAP_BLOOM_BYTES) bloomBytes = ZONEMAP_BLOOM_BYTES;
+
+  return bloomBytes & ~0x07;
+}
+
+static uint16_t zonemap_record_len(RecordDescriptor* rd) {
+  return zonemap_fixed_len(rd) + zonemap_num_strings(rd) * zonemap_bloom_bytes(rd);
+}
+
+static ZoneColumn* zonemap_get_column(Record zr, int colnum) {
+  return (ZoneColumn*)(zr + sizeof(ZoneRange)) + colnum;
+}
+
+/**
+ * @brief Returns the bloom filter of string column `colnum`
+ */
+static uint8_t* zonemap_get_bloom(RecordDescriptor* rd, Record zr, int colnum) {
+  int bloomNum = 0;
+
+  for (int i = 0; i < colnum; i++) {
+    if (zonemap_is_string(rd->cols[i].dataType)) bloomNum++;
+  }
+
+  return (uint8_t*)zr + zonemap_fixed_len(rd) + bloomNum * zonemap_bloom_bytes(rd);
+}
+
+/**
+ * @brief 64-bit FNV-1a hash of a string
+ */
+static uint64_t zonemap_hash_string(char* str) {
+  uint64_t h = 0xcbf29ce484222325ULL;
+
+  for (unsigned char* c = (unsigned char*)str; *c != '\0'; c++) {
+    h ^= *c;
+    h *= 0x100000001b3ULL;
+  }
+
+  return h;
+}
+
+/**
+ * @brief Returns the ZONEMAP_BLOOM_HASHES bits of `str` in a bloom filter of
+ * `numBits` bits. The bits are derived from a single hash (double hashing).
+ */
+static void zonemap_bloom_bits(char* str, uint32_t numBits, uint32_t* bits) {
+  uint64_t h = zonemap_hash_string(str);
+  uint32_t h1 = (uint32_t)h;
+  uint32_t h2 = (uint32_t)(h >> 32) | 1;
+
+  for (int i = 0; i < ZONEMAP_BLOOM_HASHES; i++) {
+    bits[i] = (h1 + i * h2) % numBits;
+  }
+}
+
+static void zonemap_bloom_add(uint8_t* bloom, int bloomBytes, char* str) {
+  uint32_t bits[ZONEMAP_BLOOM_HASHES];
+  zonemap_bloom_bits(str, bloomBytes * 8, bits);
+
+  for (int i = 0; i < ZONEMAP_BLOOM_HASHES; i++) {
+    bloom[bits[i] >> 3] |= 1 << (bits[i] & 0x07);
+  }
+}
+
+static bool zonemap_bloom_test(uint8_t* bloom, int bloomBytes, char* str) {
+  uint32_t bits[ZONEMAP_BLOOM_HASHES];
+  zonemap_bloom_bits(str, bloomBytes * 8, bits);
+
+  for (int i = 0; i < ZONEMAP_BLOOM_HASHES; i++) {
+    if (!(bloom[bits[i] >> 3] & (1 << (bits[i] & 0x07)))) return false;
+  }
+
+  return true;
+}
+
+/**
+ * @brief Adds every column of heap record `r` to the summary `zr`
+ */
+static void zonemap_merge_row(RecordDescriptor* rd, Record zr, Record r) {
+  Datum* values = malloc(sizeof(Datum) * rd->ncols);
+  bool* isnull = malloc(sizeof(bool) * rd->ncols);
+  int bloomBytes = zonemap_bloom_bytes(rd);
+
+  defill_record(rd, r, values, isnull);
+
+  for (int i = 0; i < rd->ncols; i++) {
+    Column* col = &rd->cols[i];
+    ZoneColumn* zc = zonemap_get_column(zr, col->colnum);
+
+    if (isnull[col->colnum]) {
+      zc->flags |= ZONE_HAS_NULLS;
+      continue;
+    }
+
+    if (zonemap_is_string(col->dataType)) {
+      if (bloomBytes > 0) {
+        zonemap_bloom_add(zonemap_get_bloom(rd, zr, col->colnum), bloomBytes, datumGetString(values[col->colnum]));
+      }
+    } else {
+      int64_t v = indexam_datum_to_key(col->dataType, values[col->colnum]);
+      if (!(zc->flags & ZONE_HAS_VALUES) || v < zc->min) zc->min = v;
+      if (!(zc->flags & ZONE_HAS_VALUES) || v > zc->max) zc->max = v;
+    }
+
+    zc->flags |= ZONE_HAS_VALUES;
+  }
+
+  free_datum_array(rd, values);
+  free(isnull);
+}
+
+/**
+ * @brief Allocates a new zone map page after `prevPageId` (or in a new extent
+ * if it's 0) and returns its buffer_id, pinned
+ */
+static int32_t zonemap_allocate_page(BufMgr* buf, TableDesc* td, uint32_t prevPageId) {
+  int32_t bufId = prevPageId == 0
+    ? bufmgr_allocate_new_extent(buf, FILE_DATA)
+    : bufmgr_allocate_page_after(buf, FILE_DATA, prevPageId);
+  if (bufId < 0) {
+    printf("Unable to allocate new page zonemap\n");
+    return -1;
+  }
+
+  pageheader_init_zonemappage(buf->bp->pages[bufId]);
+  sysextent_track_page(buf, td->tablename, buf->bd->descArr[bufId]->tag->pageId);
+
+  return bufId;
+}
+
+/**
+ * @brief Creates an empty zone map for the table and records it in `_tables`.
+ * Tables with too many columns to summarize on a single page get none.
+ *
+ * @param buf
+ * @param td
+ * @return true
+ * @return false if the zone map could not be created
+ */
+bool zonemap_create(BufMgr* buf, TableDesc* td) {
+  if (zonemap_fixed_len(td->rd) < 0) return false;
+
+  int32_t bufId = zonemap_allocate_page(buf, td, 0);
+  if (bufId < 0) return false;
+
+  Page pg = buf->bp->pages[bufId];
+  uint32_t pageId = buf->bd->descArr[bufId]->tag->pageId;
+
+  /* the first page points at the last one, which is itself for now */
+  pageheader_set_prevpageid(pg, pageId);
+  bufdesc_set_dirty(buf->bd->descArr[bufId]);
+  bufmgr_release_bufId(buf, bufId);
+
+  return systable_set_zonemap_pageid(buf, td->tablename, pageId);
+}
+
+/**
+ * @brief Adds record `r`, which was just inserted on heap page `pageId`, to
+ * the summary of its range. Does nothing if the table has no zone map.
+ *
+ * @details Rows are only ever appended to the last page of the table, so
+ * `pageId` is either the last page of the last range, or the page that comes
+ * right after it. In the second case the page joins the last range, unless it
+ * already has ZONEMAP_RANGE_PAGES pages and a new range has to be started.
+ *
+ * @param buf
+ * @param td
+ * @param pageId
+ * @param r
+ * @return true
+ * @return false if the zone map could not be updated
+ */
+bool zonemap_add_row(BufMgr* buf, TableDesc* td, uint32_t pageId, Record r) {
+  int32_t rootPageId = systable_get_zonemap_pageid(buf, td->tablename);
+  if (rootPageId <= 0) return rootPageId == 0;
+
+  BufTag* tag = bufdesc_new_buftag(FILE_DATA, rootPageId);
+  int32_t rootBufId = bufmgr_request_bufId(buf, tag);
+  if (rootBufId < 0) {
+    bufdesc_free_buftag(tag);
+    return false;
+  }
+
+  Page rootPg = buf->bp->pages[rootBufId];
+  int32_t bufId = rootBufId;
+
+  tag->pageId = ((PageHeader*)rootPg)->prevPageId;
+  if (tag->pageId != rootPageId) {
+    bufId = bufmgr_request_bufId(buf, tag);
+  }
+  bufdesc_free_buftag(tag);
+
+  bool success = false;
+
+  if (bufId >= 0) {
+    Page pg = buf->bp->pages[bufId];
+    int numRecords = ((PageHeader*)pg)->numRecords;
+    Record zr = numRecords > 0 ? page_get_record(pg, numRecords - 1) : NULL;
+    ZoneRange* range = (ZoneRange*)zr;
+
+    if (range != NULL && range->lastPageId != pageId && range->numPages < ZONEMAP_RANGE_PAGES) {
+      range->lastPageId = pageId;
+      range->numPages++;
+    }
+
+    if (range != NULL && range->lastPageId == pageId) {
+      zonemap_merge_row(td->rd, zr, r);
+      bufdesc_set_dirty(buf->bd->descArr[bufId]);
+      success = true;
+    } else {
+      uint16_t recordLen = zonemap_record_len(td->rd);
+      Record newZr = calloc(1, recordLen);
+      ZoneRange* newRange = (ZoneRange*)newZr;
+
+      newRange->firstPageId = pageId;
+      newRange->lastPageId = pageId;
+      newRange->numPages = 1;
+      zonemap_merge_row(td->rd, newZr, r);
+
+      success = page_insert(pg, newZr, recordLen);
+
+      /* the last page is full, chain a new one after it */
+      if (!success) {
+        int32_t newBufId = zonemap_allocate_page(buf, td, buf->bd->descArr[bufId]->tag->pageId);
+
+        if (newBufId >= 0) {
+          uint32_t newPageId = buf->bd->descArr[newBufId]->tag->pageId;
+
+          pageheader_set_prevpageid(buf->bp->pages[newBufId], buf->bd->descArr[bufId]->tag->pageId);
+          pageheader_set_nextpageid(pg, newPageId);
+          pageheader_set_prevpageid(rootPg, newPageId);
+          bufdesc_set_dirty(buf->bd->descArr[rootBufId]);
+
+          success = page_insert(buf->bp->pages[newBufId], newZr, recordLen);
+          bufdesc_set_dirty(buf->bd->descArr[newBufId]);
+          bufmgr_release_bufId(buf, newBufId);
+        }
+      }
+
+      bufdesc_set_dirty(buf->bd->descArr[bufId]);
+      free(newZr);
+    }
+
+    if (bufId != rootBufId) bufmgr_release_bufId(buf, bufId);
+  }
+
+  bufmgr_release_bufId(buf, rootBufId);
+
+  return success;
+}
+
+/**
+ * @brief Returns false if no row of the range summarized by `zr` can
+ * satisfy `key`
+ */
+static bool zonemap_range_may_match(RecordDescriptor* rd, Record zr, ScanKey* key) {
+  Column* col = &rd->cols[key->colnum];
+  ZoneColumn* zc = zonemap_get_column(zr, key->colnum);
+
+  /* NULLs never satisfy a comparison */
+  if (!(zc->flags & ZONE_HAS_VALUES)) return false;
+
+  if (zonemap_is_string(col->dataType)) {
+    int bloomBytes = zonemap_bloom_bytes(rd);
+    if (key->str == NULL || key->op != EXPR_EQ || bloomBytes == 0) return true;
+
+    return zonemap_bloom_test(zonemap_get_bloom(rd, zr, key->colnum), bloomBytes, key->str);
+  }
+
+  switch (key->op) {
+    case EXPR_EQ:
+      return zc->min <= key->intVal && key->intVal <= zc->max;
+    case EXPR_LT:
+      return zc->min < key->intVal;
+    case EXPR_LE:
+      return zc->min <= key->intVal;
+    case EXPR_GT:
+      return zc->max > key->intVal;
+    case EXPR_GE:
+      return zc->max >= key->intVal;
+  }
+
+  return true;
+}
+
+/**
+ * @brief Starts reading the table's zone map from its first range. Returns
+ * NULL if the table has none.
+ *
+ * @param buf
+ * @param td
+ * @return ZoneMapScan*
+ */
+ZoneMapScan* zonemap_scan_begin(BufMgr* buf, TableDesc* td) {
+  int32_t rootPageId = systable_get_zonemap_pageid(buf, td->tablename);
+  if (rootPageId <= 0) return NULL;
+
+  ZoneMapScan* scan = malloc(sizeof(ZoneMapScan));
+  scan->buf = buf;
+  scan->td = td;
+  scan->pageId = rootPageId;
+  scan->slotId = 0;
+
+  return scan;
+}
+
+/**
+ * @brief Moves to the next range of the table
+ *
+ * @param scan
+ * @param key predicate to check the range against, NULL for none
+ * @param range returns the pages of the range
+ * @param mayMatch returns false if no row of the range can satisfy `key`
+ * @return true
+ * @return false if there are no more ranges
+ */
+bool zonemap_scan_next(ZoneMapScan* scan, ScanKey* key, ZoneRange* range, bool* mayMatch) {
+  BufTag* tag = bufdesc_new_buftag(FILE_DATA, scan->pageId);
+
+  while (tag->pageId != 0) {
+    int32_t bufId = bufmgr_request_bufId_readonly(scan->buf, tag);
+    if (bufId < 0) break;
+
+    Page pg = scan->buf->bp->pages[bufId];
+
+    if (scan->slotId < ((PageHeader*)pg)->numRecords) {
+      Record zr = page_get_record(pg, scan->slotId++);
+      memcpy(range, zr, sizeof(ZoneRange));
+      *mayMatch = key == NULL || zonemap_range_may_match(scan->td->rd, zr, key);
+
+      bufmgr_release_bufId(scan->buf, bufId);
+      bufdesc_free_buftag(tag);
+      return true;
+    }
+
+    tag->pageId = ((PageHeader*)pg)->nextPageId;
+    scan->pageId = tag->pageId;
+    scan->slotId = 0;
+    bufmgr_release_bufId(scan->buf, bufId);
+  }
+
+  bufdesc_free_buftag(tag);
+
+  return false;
+}
+
+void zonemap_scan_end(ZoneMapScan* scan) {
+  free(scan);
+}
@@ -1,13 +1,19 @@
+#define _GNU_SOURCE
+
 #include <stdlib.h>
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <string.h>
 #include <stdio.h>
 #include <unistd.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/sysmacros.h>
 
 #include "buffer/buffile.h"
 #include "utility/linkedlist.h"
 #include "global/config.h"
+#include "storage/page.h"
 
 extern Config* conf;
 
@@ -17,6 +23,7 @@ FileDescList* buffile_init() {
 
 static void buffile_cleanup(void* fdesc) {
   FileDesc* f = (FileDesc*)fdesc;
+  if (f->map != NULL) munmap(f->map, (size_t)f->mapPages * conf->pageSize);
   close(f->fd);
   free(f->filename);
   free(f);
@@ -41,6 +48,158 @@ FileDesc* buffile_search(FileDescList* fdl, uint32_t fileId) {
   return (FileDesc*)li->ptr;
 }
 
+/**
+ * @brief In mmap mode, maps every page that exists when the file is opened
+ * into memory as read-only. We only ever read through the mapping, so pages
+ * added to the file later are simply read through the buffer pool as usual.
+ * 
+ * @param fdesc 
+ */
+static void buffile_map(FileDesc* fdesc) {
+  fdesc->map = NULL;
+  fdesc->mapPages = 0;
+
+  if (!conf->mmapMode || fdesc->nextPageId <= 1) return;
+
+  size_t len = (size_t)(fdesc->nextPageId - 1) * conf->pageSize;
+  char* map = mmap(NULL, len, PROT_READ, MAP_SHARED, fdesc->fd, 0);
+
+  if (map == MAP_FAILED) {
+    printf("Unable to map %s, falling back to buffered reads\n", fdesc->filename);
+    return;
+  }
+
+  /* tables are laid out in contiguous extents, so scans read the file front to back */
+  madvise(map, len, MADV_SEQUENTIAL);
+
+  fdesc->map = map;
+  fdesc->mapPages = fdesc->nextPageId - 1;
+}
+
+/**
+ * @brief Returns a pointer to the requested page inside the file's read-only
+ * mapping, or NULL if the page is not mapped. Whenever a page at the
+ * start of an extent is handed out, we ask the kernel to start reading the
+ * rest of the extent.
+ * 
+ * @param fdl 
+ * @param fileId 
+ * @param pageId 
+ * @return char* 
+ */
+char* buffile_get_mapped_page(FileDescList* fdl, uint32_t fileId, uint32_t pageId) {
+  FileDesc* fdesc = buffile_open(fdl, fileId);
+
+  if (fdesc == NULL || fdesc->map == NULL) return NULL;
+  if (pageId == 0 || pageId > fdesc->mapPages) return NULL;
+
+  char* pg = fdesc->map + (size_t)(pageId - 1) * conf->pageSize;
+
+  if (is_extent_first_pageid(pageId)) {
+    uint32_t numPages = EXTENT_SIZE;
+    if (pageId + numPages - 1 > fdesc->mapPages) numPages = fdesc->mapPages - pageId + 1;
+    madvise(pg, (size_t)numPages * conf->pageSize, MADV_WILLNEED);
+  }
+
+  return pg;
+}
+
+/**
+ * @brief Finds the alignment O_DIRECT needs on this file: `offsetAlign` for
+ * the file offset and transfer size, `memAlign` for the memory buffer. Kernels
+ * without STATX_DIOALIGN fall back to the logical block size of the device the
+ * file lives on (for a partition, the queue is on its parent disk).
+ *
+ * @param fdesc
+ * @param offsetAlign
+ * @param memAlign
+ * @return true, with offsetAlign 0 if the file doesn't support O_DIRECT
+ * @return false if the alignment can't be found out
+ */
+static bool buffile_get_dio_alignment(FileDesc* fdesc, uint32_t* offsetAlign, uint32_t* memAlign) {
+  *offsetAlign = 0;
+  *memAlign = 0;
+
+#ifdef STATX_DIOALIGN
+  struct statx stx;
+
+  if (statx(fdesc->fd, "", AT_EMPTY_PATH, STATX_DIOALIGN, &stx) == 0 && (stx.stx_mask & STATX_DIOALIGN)) {
+    *offsetAlign = stx.stx_dio_offset_align;
+    *memAlign = stx.stx_dio_mem_align;
+    return true;
+  }
+#endif
+
+  struct stat st;
+  if (fstat(fdesc->fd, &st) != 0) return false;
+
+  const char* paths[] = {
+    "/sys/dev/block/%u:%u/queue/logical_block_size",
+    "/sys/dev/block/%u:%u/../queue/logical_block_size"
+  };
+
+  for (int i = 0; i < 2; i++) {
+    char path[128];
+    snprintf(path, sizeof(path), paths[i], major(st.st_dev), minor(st.st_dev));
+
+    FILE* fp = fopen(path, "r");
+    if (fp == NULL) continue;
+
+    bool found = fscanf(fp, "%u", offsetAlign) == 1 && *offsetAlign > 0;
+    fclose(fp);
+
+    if (found) {
+      *memAlign = *offsetAlign;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/**
+ * @brief Switches the file to O_DIRECT so reads and writes bypass the OS page
+ * cache - the buffer pool is already caching the pages. O_DIRECT requires the
+ * memory buffer to be aligned to the device's DIO memory alignment, and the
+ * file offset and transfer size to the DIO offset alignment (usually the
+ * logical block size). Every transfer is one full page at a page boundary
+ * from a PAGE_ALIGNMENT-aligned frame, so we check the frame alignment and the
+ * page size against them. If anything doesn't line up, we stay on buffered I/O.
+ * 
+ * @param fdesc 
+ */
+static void buffile_set_direct_io(FileDesc* fdesc) {
+  uint32_t offsetAlign, memAlign;
+
+  if (!buffile_get_dio_alignment(fdesc, &offsetAlign, &memAlign)) {
+    printf("Unable to find the O_DIRECT alignment of %s, DIRECT_IO disabled\n", conf->dataFile);
+    return;
+  }
+
+  if (offsetAlign == 0) {
+    printf("Filesystem does not support O_DIRECT, DIRECT_IO disabled\n");
+    return;
+  }
+
+  if (memAlign > PAGE_ALIGNMENT || PAGE_ALIGNMENT % memAlign != 0) {
+    printf("Buffer frames are not aligned to the %u-byte O_DIRECT memory alignment, DIRECT_IO disabled\n", memAlign);
+    return;
+  }
+
+  if (conf->pageSize % offsetAlign != 0) {
+    printf("PAGE_SIZE is not a multiple of the %u-byte O_DIRECT alignment, DIRECT_IO disabled\n", offsetAlign);
+    return;
+  }
+
+  int flags = fcntl(fdesc->fd, F_GETFL);
+  if (fcntl(fdesc->fd, F_SETFL, flags | O_DIRECT) != 0) {
+    printf("Filesystem does not support O_DIRECT, DIRECT_IO disabled\n");
+    return;
+  }
+
+  fdesc->directIO = true;
+}
+
 FileDesc* buffile_open(FileDescList* fdl, uint32_t fileId) {
   FileDesc* fdesc = buffile_search(fdl, fileId);
 
@@ -48,6 +207,7 @@ FileDesc* buffile_open(FileDescList* fdl, uint32_t fileId) {
 
   fdesc = malloc(sizeof(FileDesc));
   fdesc->fileId = fileId;
+  fdesc->directIO = false;
 
   if (fileId == FILE_DATA) {
     fdesc->fd = open(conf->dataFile,
@@ -56,6 +216,7 @@ FileDesc* buffile_open(FileDescList* fdl, uint32_t fileId) {
               S_IWUSR |   // User write permission
                 S_IRUSR   // User read permission
     );
+    if (conf->directIO) buffile_set_direct_io(fdesc);
     fdesc->filename = malloc(strlen(conf->dataFile) + 1);
     strcpy(fdesc->filename, conf->dataFile);
   } else if (fileId == FILE_LOG) {
@@ -69,32 +230,73 @@ FileDesc* buffile_open(FileDescList* fdl, uint32_t fileId) {
     return NULL;
   }
 
-  int length = lseek(fdesc->fd, 0, SEEK_END);
+  off_t length = lseek(fdesc->fd, 0, SEEK_END);
   fdesc->nextPageId = (length / conf->pageSize) + 1;
 
+  buffile_map(fdesc);
+
   linkedlist_append(fdl, fdesc);
 
   return fdesc;
 }
 
 /**
- * @brief Claims the nextPageId for the calling process. The caller is
- * responsible for writing the page to disk then releasing the lock on
- * the file
+ * @brief Makes sure the file has disk space reserved for `numPages` pages
+ * starting at `firstPageId`. We prefer `fallocate` because it reserves
+ * contiguous blocks without writing them. Filesystems that don't support
+ * it get a sparse extension via `ftruncate` instead.
+ * 
+ * @param fdesc 
+ * @param firstPageId 
+ * @param numPages 
+ * @return true 
+ * @return false 
+ */
+static bool buffile_preallocate(FileDesc* fdesc, uint32_t firstPageId, uint32_t numPages) {
+  off_t offset = (off_t)(firstPageId - 1) * conf->pageSize;
+  off_t len = (off_t)numPages * conf->pageSize;
+
+  if (fallocate(fdesc->fd, 0, offset, len) == 0) return true;
+
+  if (errno != EOPNOTSUPP && errno != ENOSYS) {
+    printf("Unable to preallocate pages %d - %d\n", firstPageId, firstPageId + numPages - 1);
+    return false;
+  }
+
+  if (lseek(fdesc->fd, 0, SEEK_END) >= offset + len) return true;
+
+  return ftruncate(fdesc->fd, offset + len) == 0;
+}
+
+/**
+ * @brief Claims the next unused extent for the calling process and
+ * preallocates its space in the file. Returns the pageId of the first
+ * page in the extent, or 0 if the space could not be reserved.
+ * 
+ * Every page in a freshly claimed extent reads back as zeros, so a page
+ * with `pageId = 0` in its header is unused.
  * 
  * @param fdl 
  * @param fileId 
  * @return uint32_t 
  */
-uint32_t buffile_get_new_pageid(FileDescList* fdl, uint32_t fileId) {
+uint32_t buffile_get_new_extent(FileDescList* fdl, uint32_t fileId) {
   /**
    * @todo This is where we take a brief lock on the file to ensure
-   * the caller is the only one that can claim the nextPageId
+   * the caller is the only one that can claim the extent
    */
   FileDesc* fdesc = buffile_open(fdl, fileId);
-  uint32_t newPageId = fdesc->nextPageId;
-  fdesc->nextPageId++;
-  return newPageId;
+  if (fdesc == NULL) return 0;
+
+  uint32_t firstPageId = fdesc->nextPageId;
+  if (!is_extent_first_pageid(firstPageId)) {
+    firstPageId = extent_last_pageid(firstPageId) + 1;
+  }
+
+  if (!buffile_preallocate(fdesc, firstPageId, EXTENT_SIZE)) return 0;
+
+  fdesc->nextPageId = firstPageId + EXTENT_SIZE;
+  return firstPageId;
 }
 
 void buffile_diag_summary(FileDescList* fdl) {
@@ -108,6 +310,8 @@ void buffile_diag_summary(FileDescList* fdl) {
     FileDesc* fdesc = (FileDesc*)li->ptr;
     printf("= Filename: %s\n", fdesc->filename);
     printf("= FileId:   %d\n", fdesc->fileId);
+    printf("= Extents:  %d\n", (fdesc->nextPageId - 1) / EXTENT_SIZE);
+    printf("= DirectIO: %d\n", fdesc->directIO);
     printf("----------------------------------\n");
 
     li = li->next;
@@ -1,5 +1,6 @@
 #include <unistd.h>
 #include <stdlib.h>
+#include <stdio.h>
 
 #include "buffer/bufmgr.h"
 #include "global/config.h"
@@ -28,6 +29,8 @@ BufMgr* bufmgr_init() {
   buf->global = bufmgr_globals_init();
   buf->bd = bufdesc_init(buf->size);
   buf->bp = bufpool_init(buf->size);
+
+  return buf;
 }
 
 void bufmgr_destroy(BufMgr* buf) {
@@ -67,18 +70,24 @@ static int32_t bufmgr_evict_page(BufMgr* buf) {
  * The caller is responsible for ensuring the requested page is not already in
  * the buffer pool
  * 
+ * In mmap mode, read-only requests skip the copy and point the slot straight
+ * at the page in the file's mapping.
+ * 
  * @param buf 
  * @param pageId 
+ * @param readOnly 
  * @return int32_t 
  */
-static int32_t bufmgr_load_page(BufMgr* buf, BufTag* tag) {
+static int32_t bufmgr_load_page(BufMgr* buf, BufTag* tag, bool readOnly) {
   int32_t bufId = bufdesc_find_empty_slot(buf->bd);
 
   if (bufId < 0) {
     bufId = bufmgr_evict_page(buf);
   }
 
-  if (!bufpool_read_page(buf->fdl, buf->bp, bufId, tag)) {
+  bool mapped = readOnly && conf->mmapMode && bufpool_map_page(buf->fdl, buf->bp, bufId, tag);
+
+  if (!mapped && !bufpool_read_page(buf->fdl, buf->bp, bufId, tag)) {
     return -1;
   }
 
@@ -113,7 +122,33 @@ int32_t bufmgr_request_bufId(BufMgr* buf, BufTag* tag) {
   int32_t bufId = bufdesc_find_slot(buf->bd, tag);
 
   if (bufId < 0) {
-    bufId = bufmgr_load_page(buf, tag);
+    bufId = bufmgr_load_page(buf, tag, false);
+  } else {
+    /* the caller may modify the page, so it can't stay in the read-only mapping */
+    bufpool_unmap_page(buf->bp, bufId);
+  }
+
+  if (bufId >= 0) bufdesc_pin(buf->bd->descArr[bufId]);
+
+  return bufId;
+}
+
+/**
+ * @brief Same as bufmgr_request_bufId, except the caller promises not to
+ * modify the page. In mmap mode this lets us hand out pages straight from the
+ * data file's mapping without copying them into the buffer pool.
+ * 
+ * @param buf 
+ * @param tag 
+ * @return int32_t 
+ */
+int32_t bufmgr_request_bufId_readonly(BufMgr* buf, BufTag* tag) {
+  if (tag->pageId <= 0) return -1;
+
+  int32_t bufId = bufdesc_find_slot(buf->bd, tag);
+
+  if (bufId < 0) {
+    bufId = bufmgr_load_page(buf, tag, true);
   }
 
   if (bufId >= 0) bufdesc_pin(buf->bd->descArr[bufId]);
@@ -125,8 +160,35 @@ void bufmgr_release_bufId(BufMgr* buf, int32_t bufId) {
   bufdesc_unpin(buf->bd->descArr[bufId]);
 }
 
-int32_t bufmgr_allocate_new_page(BufMgr* buf, uint32_t fileId) {
-  uint32_t pageId = buffile_get_new_pageid(buf->fdl, fileId);
+/**
+ * @brief Turns the page in slot `bufId` into a brand new, empty page
+ * with the provided pageId. The slot must already be pinned by the caller.
+ * 
+ * @param buf 
+ * @param bufId 
+ * @param pageId 
+ */
+static void bufmgr_init_new_page(BufMgr* buf, int32_t bufId, uint32_t pageId) {
+  bufdesc_start_io(buf->bd->descArr[bufId]);
+  bufpool_use_frame(buf->bp, bufId);
+  page_zero(buf->bp->pages[bufId]);
+  pageheader_set_pageid(buf->bp->pages[bufId], pageId);
+  bufdesc_set_dirty(buf->bd->descArr[bufId]);
+  bufdesc_end_io(buf->bd->descArr[bufId]);
+}
+
+/**
+ * @brief Claims a brand new extent in the file and returns the buffer_id
+ * of its first page. The page is pinned - caller is responsible for
+ * unpinning it.
+ * 
+ * @param buf 
+ * @param fileId 
+ * @return int32_t 
+ */
+int32_t bufmgr_allocate_new_extent(BufMgr* buf, uint32_t fileId) {
+  uint32_t pageId = buffile_get_new_extent(buf->fdl, fileId);
+  if (pageId == 0) return -1;
 
   // claim a slot in the buffer pool
   int32_t bufId = bufdesc_find_empty_slot(buf->bd);
@@ -135,18 +197,80 @@ int32_t bufmgr_allocate_new_page(BufMgr* buf, uint32_t fileId) {
     bufId = bufmgr_evict_page(buf);
   }
 
-  bufdesc_start_io(buf->bd->descArr[bufId]);
+  if (bufId < 0) return -1;
+
   bufdesc_pin(buf->bd->descArr[bufId]);
   buf->bd->descArr[bufId]->tag->fileId = fileId;
   buf->bd->descArr[bufId]->tag->pageId = pageId;
 
-  page_zero(buf->bp->pages[bufId]);
-  pageheader_set_pageid(buf->bp->pages[bufId], pageId);
-  bufdesc_end_io(buf->bd->descArr[bufId]);
+  bufmgr_init_new_page(buf, bufId, pageId);
 
   return bufId;
 }
 
+/**
+ * @brief Returns the buffer_id (pinned) of the first unused page after `pageId`
+ * in its extent, or -1 if the rest of the extent is in use
+ */
+static int32_t bufmgr_find_unused_page(BufMgr* buf, uint32_t fileId, uint32_t pageId) {
+  BufTag* tag = bufdesc_new_buftag(fileId, 0);
+  int32_t lastPageId = extent_last_pageid(pageId);
+
+  for (tag->pageId = pageId + 1; tag->pageId <= lastPageId; tag->pageId++) {
+    int32_t newBufId = bufmgr_request_bufId(buf, tag);
+    if (newBufId < 0) break;
+
+    if (((PageHeader*)buf->bp->pages[newBufId])->pageId == 0) {
+      bufmgr_init_new_page(buf, newBufId, tag->pageId);
+      bufdesc_free_buftag(tag);
+      return newBufId;
+    }
+
+    bufmgr_release_bufId(buf, newBufId);
+  }
+
+  bufdesc_free_buftag(tag);
+
+  return -1;
+}
+
+/**
+ * @brief Allocates a new page for the same table or index as the page in
+ * slot `bufId` and returns its buffer_id (pinned).
+ * 
+ * @details Every extent belongs to exactly one object, so we hand out the
+ * first unused page that follows `bufId` in its extent. That keeps the
+ * object's pages physically contiguous on disk. If the extent is full, we
+ * claim a new one. The caller can detect the latter case with
+ * `is_extent_first_pageid` and record the extent in the catalog.
+ * 
+ * @param buf 
+ * @param bufId 
+ * @return int32_t 
+ */
+int32_t bufmgr_allocate_next_page(BufMgr* buf, int32_t bufId) {
+  uint32_t fileId = buf->bd->descArr[bufId]->tag->fileId;
+  return bufmgr_allocate_page_after(buf, fileId, buf->bd->descArr[bufId]->tag->pageId);
+}
+
+/**
+ * @brief Same as bufmgr_allocate_next_page, but starts looking after `pageId`
+ * instead of a pinned page. Objects that split pages in the middle of their
+ * chain (i.e. indexes) pass a page from their newest extent here, because the
+ * extent of the page being split is usually full already.
+ * 
+ * @param buf 
+ * @param fileId 
+ * @param pageId 
+ * @return int32_t 
+ */
+int32_t bufmgr_allocate_page_after(BufMgr* buf, uint32_t fileId, uint32_t pageId) {
+  int32_t bufId = bufmgr_find_unused_page(buf, fileId, pageId);
+  if (bufId >= 0) return bufId;
+
+  return bufmgr_allocate_new_extent(buf, fileId);
+}
+
 void bufmgr_flush_page(BufMgr* buf, BufTag* tag) {
   int32_t bufId = bufmgr_request_bufId(buf, tag);
   bufpool_flush_page(buf->fdl, buf->bd, buf->bp, bufId);
@@ -166,55 +290,117 @@ void bufmgr_flush_all(BufMgr* buf) {
   }
 }
 
-static int32_t bufmgrinit_page_split_append(BufMgr* buf, int32_t prevBufId) {
-  int32_t bufId = bufmgr_allocate_new_page(buf, FILE_DATA);
-  if (bufId < 0) return -1;
-  pageheader_init_datapage(buf->bp->pages[bufId]);
-  pageheader_set_prevpageid(buf->bp->pages[bufId], buf->bd->descArr[prevBufId]->tag->pageId);
-  int32_t newPageId = buf->bd->descArr[bufId]->tag->pageId;
+/**
+ * @brief Allocates a new page and links it into the chain right after the page
+ * in slot `prevBufId`, fixing the `prevPageId` of the old next page if there
+ * is one. The new page gets the same page type and index level as the page it
+ * follows. Returns its buffer_id (pinned).
+ *
+ * The new page comes from the extent of `allocPageId`, or from the extent of the
+ * previous page when `allocPageId` is 0 (see bufmgr_allocate_page_after).
+ */
+static int32_t bufmgr_page_split_new_page(BufMgr* buf, int32_t prevBufId, uint32_t allocPageId) {
+  Page prevPg = buf->bp->pages[prevBufId];
+  PageHeader* prevHdr = (PageHeader*)prevPg;
+  int32_t nextBufId = -1;
+
+  /* make sure we can reach the old next page before we change anything */
+  if (prevHdr->nextPageId != 0) {
+    BufTag* tag = bufdesc_new_buftag(buf->bd->descArr[prevBufId]->tag->fileId, prevHdr->nextPageId);
+    nextBufId = bufmgr_request_bufId(buf, tag);
+    bufdesc_free_buftag(tag);
+    if (nextBufId < 0) return -1;
+  }
 
-  pageheader_set_nextpageid(buf->bp->pages[prevBufId], newPageId);
-  bufmgr_release_bufId(buf, prevBufId);
+  int32_t bufId = allocPageId == 0
+    ? bufmgr_allocate_next_page(buf, prevBufId)
+    : bufmgr_allocate_page_after(buf, buf->bd->descArr[prevBufId]->tag->fileId, allocPageId);
+  if (bufId < 0) {
+    if (nextBufId >= 0) bufmgr_release_bufId(buf, nextBufId);
+    return -1;
+  }
+
+  Page pg = buf->bp->pages[bufId];
+  if (prevHdr->pageType == 1) {
+    pageheader_init_indexpage(pg, prevHdr->indexLevel);
+  } else {
+    pageheader_init_datapage(pg);
+  }
+
+  int32_t newPageId = buf->bd->descArr[bufId]->tag->pageId;
+  pageheader_set_prevpageid(pg, prevHdr->pageId);
+  pageheader_set_nextpageid(pg, prevHdr->nextPageId);
+  pageheader_set_nextpageid(prevPg, newPageId);
+  bufdesc_set_dirty(buf->bd->descArr[prevBufId]);
+
+  if (nextBufId >= 0) {
+    pageheader_set_prevpageid(buf->bp->pages[nextBufId], newPageId);
+    bufdesc_set_dirty(buf->bd->descArr[nextBufId]);
+    bufmgr_release_bufId(buf, nextBufId);
+  }
 
   return bufId;
 }
 
+static int32_t bufmgr_page_split_append(BufMgr* buf, int32_t prevBufId) {
+  return bufmgr_page_split_new_page(buf, prevBufId, 0);
+}
+
 /**
- * @brief Same as bufmgr_page_split, except we don't synchronize
- * the `lastPageId` column in the system tables because during
- * init, there might not be an entry for the object we're splitting
+ * @brief Splits the page in slot `bufId` in the middle of its chain. The new
+ * page is linked in right after it and the upper half of the records (by
+ * bytes, in slot order) move over to it. Returns the new page's buffer_id.
+ * Both pages stay pinned.
+ * 
+ * @details Because the records keep their slot order, a page whose slot array
+ * is sorted (e.g. a B+tree page) splits into two sorted pages, and every
+ * record on the new page sorts after every record left on the old one.
  * 
  * @param buf 
- * @param tag 
- * @return int32_t 
+ * @param bufId 
+ * @param allocPageId page to allocate the new page after, 0 for the old page
+ * @return int32_t -1 if the split fails, in which case neither page has
+ * changed. The old page stays pinned either way.
  */
-int32_t bufmgrinit_page_split(BufMgr* buf, BufTag* tag) {
-  int32_t bufId = bufmgr_request_bufId(buf, tag);
-  if (bufId < 0) return -1;
+int32_t bufmgr_page_split_insert(BufMgr* buf, int32_t bufId, uint32_t allocPageId) {
+  Page pg = buf->bp->pages[bufId];
+  int splitSlotId = page_get_split_slotid(pg);
 
-  PageHeader* pgHdr = (PageHeader*)buf->bp->pages[bufId];
+  /* check before the chain changes, so a failed split leaves nothing behind */
+  if (page_get_records_size(pg, splitSlotId) > (int)(conf->pageSize - sizeof(PageHeader))) {
+    printf("Unable to move records to the new page\n");
+    return -1;
+  }
 
-  if (pgHdr->nextPageId == 0) {
-    bufId = bufmgrinit_page_split_append(buf, bufId);
-  } else {
-    printf("Implement an insert page split\n");
+  int32_t newBufId = bufmgr_page_split_new_page(buf, bufId, allocPageId);
+  if (newBufId < 0) return -1;
+
+  if (!page_move_records(pg, buf->bp->pages[newBufId], splitSlotId)) {
+    printf("Unable to move records to the new page\n");
+    bufmgr_release_bufId(buf, newBufId);
     return -1;
   }
 
-  return bufId;
+  bufdesc_set_dirty(buf->bd->descArr[bufId]);
+  bufdesc_set_dirty(buf->bd->descArr[newBufId]);
+
+  return newBufId;
 }
 
-static int32_t bufmgr_page_split_append(BufMgr* buf, int32_t prevBufId) {
-  int32_t bufId = bufmgr_allocate_new_page(buf, FILE_DATA);
+/**
+ * @brief Same as bufmgr_page_split, except we don't synchronize
+ * the `lastPageId` column in the system tables because during
+ * init, there might not be an entry for the object we're splitting
+ * 
+ * @param buf 
+ * @param tag 
+ * @return int32_t 
+ */
+int32_t bufmgrinit_page_split(BufMgr* buf, BufTag* tag) {
+  int32_t bufId = bufmgr_request_bufId(buf, tag);
   if (bufId < 0) return -1;
-  pageheader_init_datapage(buf->bp->pages[bufId]);
-  pageheader_set_prevpageid(buf->bp->pages[bufId], buf->bd->descArr[prevBufId]->tag->pageId);
-  int32_t newPageId = buf->bd->descArr[bufId]->tag->pageId;
-
-  pageheader_set_nextpageid(buf->bp->pages[prevBufId], newPageId);
-  bufmgr_release_bufId(buf, prevBufId);
 
-  return bufId;
+  return bufmgr_page_split(buf, bufId);
 }
 
 /**
@@ -227,20 +413,24 @@ static int32_t bufmgr_page_split_append(BufMgr* buf, int32_t prevBufId) {
  * have an append-only page split. Any other value means we need to perform
  * an insert page split.
  * 
- * For the append-only case, we simply need to allocate a new page, then
- * update the old page's `nextPageId` header field with the new pageId.
+ * For the append-only case, we simply need to allocate a new page (from the
+ * same extent as the old page when possible), then update the old page's
+ * `nextPageId` header field with the new pageId.
  * And when setting the header fields for the new page, we make sure to
  * set `prevPageId` appropriately.
  * 
- * Lastly, we update the `lastPageId` column in the appropriate system table.
+ * For the insert case, the new page is linked in between the old page and its
+ * next page, and the upper half of the old page's records move to the new page
+ * (see bufmgr_page_split_insert).
+ * 
+ * Lastly, the caller updates the `lastPageId` column in the appropriate system
+ * table and, if the new page starts a new extent, records it in `_extents`.
  * 
- * @todo Implement the "insert" page split code path. Including moving
- * the necessary data from the old page to the new page - to maintain
- * the sort-order of whatever key the data are physically sorted by.
+ * The old page is always released, even if the split fails.
  * 
  * @param buf 
  * @param tag 
- * @return int32_t 
+ * @return int32_t
  */
 int32_t bufmgr_page_split(BufMgr* buf, int32_t bufId) {
   if (bufId < 0) return -1;
@@ -251,10 +441,11 @@ int32_t bufmgr_page_split(BufMgr* buf, int32_t bufId) {
   if (pgHdr->nextPageId == 0) {
     newBufId = bufmgr_page_split_append(buf, bufId);
   } else {
-    printf("Implement an insert page split\n");
-    return -1;
+    newBufId = bufmgr_page_split_insert(buf, bufId, 0);
   }
 
+  bufmgr_release_bufId(buf, bufId);
+
   return newBufId;
 }
 
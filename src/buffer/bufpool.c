@@ -14,10 +14,12 @@ BufPool* bufpool_init(int size) {
   BufPool* bp = malloc(sizeof(BufPool));
   bp->size = size;
   bp->pages = calloc(size, sizeof(Page));
+  bp->frames = calloc(size, sizeof(Page));
 
   // initialize each slot with a blank page
   for (int i = 0; i < size; i++) {
-    bp->pages[i] = new_page();
+    bp->frames[i] = new_page();
+    bp->pages[i] = bp->frames[i];
   }
 
   return bp;
@@ -26,14 +28,16 @@ BufPool* bufpool_init(int size) {
 void bufpool_destroy(BufPool* bp) {
   if (bp == NULL) return;
 
-  if (bp->pages != NULL) {
+  if (bp->frames != NULL) {
     for (int i = 0; i < bp->size; i++) {
-      if (bp->pages[i] != NULL) free_page(bp->pages[i]);
+      if (bp->frames[i] != NULL) free_page(bp->frames[i]);
     }
 
-    free(bp->pages);
+    free(bp->frames);
   }
 
+  if (bp->pages != NULL) free(bp->pages);
+
   free(bp);
 }
 
@@ -53,10 +57,17 @@ bool bufpool_read_page(FileDescList* fdl, BufPool* bp, int32_t bufId, BufTag* ta
 
   if (fdesc == NULL) return false;
 
-  lseek(fdesc->fd, (tag->pageId - 1) * conf->pageSize, SEEK_SET);
-  int bytes_read = read(fdesc->fd, bp->pages[bufId], conf->pageSize);
+  bufpool_use_frame(bp, bufId);
+
+  off_t offset = (off_t)(tag->pageId - 1) * conf->pageSize;
+  ssize_t bytes_read = pread(fdesc->fd, bp->pages[bufId], conf->pageSize, offset);
+
+  if (bytes_read != (ssize_t)conf->pageSize) {
+    return false;
+  }
 
-  if (bytes_read != conf->pageSize) {
+  if (!page_verify_checksum(bp->pages[bufId])) {
+    printf("Checksum mismatch on page %d, the page is corrupt\n", tag->pageId);
     return false;
   }
 
@@ -66,13 +77,73 @@ bool bufpool_read_page(FileDescList* fdl, BufPool* bp, int32_t bufId, BufTag* ta
 bool bufpool_flush_page(FileDescList* fdl, BufDescArr* bd, BufPool* bp, int32_t bufId) {
   BufDesc* bdesc = (BufDesc*)bd->descArr[bufId];
   if (bdesc->tag->fileId == 0 || bdesc->tag->pageId == 0) return true;
+
+  /* mapped pages are never written to, the file already has their contents */
+  if (bufpool_is_mapped(bp, bufId)) return true;
   
   FileDesc* fdesc = buffile_open(fdl, bdesc->tag->fileId);
 
-  lseek(fdesc->fd, (bdesc->tag->pageId - 1) * conf->pageSize, SEEK_SET);
-  int bytes_written = write(fdesc->fd, bp->pages[bufId], conf->pageSize);
+  page_set_checksum(bp->pages[bufId]);
+
+  off_t offset = (off_t)(bdesc->tag->pageId - 1) * conf->pageSize;
+  ssize_t bytes_written = pwrite(fdesc->fd, bp->pages[bufId], conf->pageSize, offset);
+
+  if (bytes_written != (ssize_t)conf->pageSize) return false;
+
+  return true;
+}
+
+/**
+ * @brief Points slot `bufId` at the page described by `tag` inside the data
+ * file's read-only mapping instead of copying it into the slot's frame.
+ * Returns false if the page is not mapped.
+ * 
+ * @param fdl 
+ * @param bp 
+ * @param bufId 
+ * @param tag 
+ * @return true 
+ * @return false 
+ */
+bool bufpool_map_page(FileDescList* fdl, BufPool* bp, int32_t bufId, BufTag* tag) {
+  char* pg = buffile_get_mapped_page(fdl, tag->fileId, tag->pageId);
+
+  if (pg == NULL) return false;
 
-  if (bytes_written != conf->pageSize) return false;
+  if (!page_verify_checksum(pg)) {
+    printf("Checksum mismatch on page %d, the page is corrupt\n", tag->pageId);
+    return false;
+  }
 
+  bp->pages[bufId] = pg;
   return true;
+}
+
+bool bufpool_is_mapped(BufPool* bp, int32_t bufId) {
+  return bp->pages[bufId] != bp->frames[bufId];
+}
+
+/**
+ * @brief Copies a mapped page into the slot's own frame so the caller
+ * can modify it
+ * 
+ * @param bp 
+ * @param bufId 
+ */
+void bufpool_unmap_page(BufPool* bp, int32_t bufId) {
+  if (!bufpool_is_mapped(bp, bufId)) return;
+
+  memcpy(bp->frames[bufId], bp->pages[bufId], conf->pageSize);
+  bp->pages[bufId] = bp->frames[bufId];
+}
+
+/**
+ * @brief Detaches the slot from the mapping without copying anything. Used
+ * when the slot's contents are about to be overwritten.
+ * 
+ * @param bp 
+ * @param bufId 
+ */
+void bufpool_use_frame(BufPool* bp, int32_t bufId) {
+  bp->pages[bufId] = bp->frames[bufId];
 }
\ No newline at end of file
@@ -0,0 +1,825 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "executor/agg.h"
+#include "access/indexam.h"
+#include "global/config.h"
+
+extern Config* conf;
+
+/* slots the hash table starts out with, always a power of two */
+#define AGG_INITIAL_SLOTS 1024
+
+/**
+ * @brief Running state of one aggregate of a group
+ *
+ * count | rows seen (COUNT(*)) or non-NULL values seen (everything else)
+ * sum   | SUM and AVG
+ * value | MIN and MAX of an integer column
+ * str   | MIN and MAX of a string column, NULL until the first value
+ */
+typedef struct AggState {
+  int64_t count;
+  int64_t sum;
+  int64_t value;
+  char* str;
+} AggState;
+
+typedef struct AggGroup {
+  uint64_t hash;
+  uint32_t keyLen;
+  char* key;          /* GROUP BY values, see agg_encode_key */
+  AggState states[];  /* one per target */
+} AggGroup;
+
+/* an entry of the open-addressing table, groupId -1 if the slot is empty */
+typedef struct AggSlot {
+  uint32_t hashTag;
+  int32_t groupId;
+} AggSlot;
+
+typedef struct AggHashTable {
+  AggSlot* slots;
+  uint32_t numSlots;
+  AggGroup** groups;
+  int32_t numGroups;
+  int32_t maxGroups;
+  size_t memUsed;
+} AggHashTable;
+
+static Column* agg_get_column(RecordDescriptor* rd, char* colname) {
+  for (int i = 0; i < rd->ncols; i++) {
+    if (strcasecmp(rd->cols[i].colname, colname) == 0) return &rd->cols[i];
+  }
+
+  return NULL;
+}
+
+static bool agg_is_string(DataType dataType) {
+  return dataType == DT_CHAR || dataType == DT_VARCHAR;
+}
+
+static bool agg_is_integer(DataType dataType) {
+  return dataType == DT_TINYINT || dataType == DT_SMALLINT || dataType == DT_INT || dataType == DT_BIGINT;
+}
+
+static AggFunc agg_parse_func(char* funcname) {
+  if (strcasecmp(funcname, "count") == 0) return AGG_COUNT;
+  if (strcasecmp(funcname, "sum") == 0) return AGG_SUM;
+  if (strcasecmp(funcname, "min") == 0) return AGG_MIN;
+  if (strcasecmp(funcname, "max") == 0) return AGG_MAX;
+  if (strcasecmp(funcname, "avg") == 0) return AGG_AVG;
+
+  return AGG_NONE;
+}
+
+static Datum agg_int_to_datum(DataType dataType, int64_t v) {
+  switch (dataType) {
+    case DT_TINYINT:
+    case DT_BOOL:
+      return uint8GetDatum(v);
+    case DT_SMALLINT:
+      return int16GetDatum(v);
+    case DT_INT:
+      return int32GetDatum(v);
+    default:
+      return int64GetDatum(v);
+  }
+}
+
+/**
+ * @brief Returns true if the SELECT has aggregates or a GROUP BY clause
+ */
+bool agg_is_needed(SelectStmt* s) {
+  if (s->groupClause != NULL) return true;
+
+  for (int i = 0; i < s->targetList->length; i++) {
+    if (((ResTarget*)s->targetList->elements[i].ptr)->funcname != NULL) return true;
+  }
+
+  return false;
+}
+
+/**
+ * @brief Writes the name of a target's result column into `name`: the
+ * column name, or e.g. `count(*)` for an aggregate
+ */
+void agg_target_name(ResTarget* r, char* name, size_t size) {
+  if (r->funcname == NULL) {
+    snprintf(name, size, "%s", r->name);
+    return;
+  }
+
+  snprintf(name, size, "%s(%s)", r->funcname, r->name == NULL ? "*" : r->name);
+  for (char* c = name; *c != '\0' && *c != '('; c++) {
+    if (*c >= 'A' && *c <= 'Z') *c += 'a' - 'A';
+  }
+}
+
+static bool agg_init_target(Agg* agg, ResTarget* r, int i) {
+  AggTarget* t = &agg->targets[i];
+  char name[128];
+
+  t->func = AGG_NONE;
+  t->col = NULL;
+  t->groupIdx = -1;
+
+  if (r->name != NULL) {
+    t->col = agg_get_column(agg->rd, r->name);
+    if (t->col == NULL) {
+      printf("Column %s does not exist\n", r->name);
+      return false;
+    }
+  }
+
+  if (r->funcname == NULL) {
+    for (int g = 0; g < agg->numGroupCols; g++) {
+      if (agg->groupCols[g] == t->col) t->groupIdx = g;
+    }
+
+    if (t->groupIdx < 0) {
+      printf("Column %s must be in the GROUP BY clause or in an aggregate function\n", r->name);
+      return false;
+    }
+
+    construct_column_desc(&agg->outRd->cols[i], t->col->colname, t->col->dataType, i, t->col->len, false);
+    return true;
+  }
+
+  t->func = agg_parse_func(r->funcname);
+  if (t->func == AGG_NONE) {
+    printf("Unknown aggregate function %s\n", r->funcname);
+    return false;
+  }
+
+  if (t->col == NULL && t->func != AGG_COUNT) {
+    printf("Only COUNT can take *\n");
+    return false;
+  }
+
+  if ((t->func == AGG_SUM || t->func == AGG_AVG) && !agg_is_integer(t->col->dataType)) {
+    printf("%s needs an integer column, %s isn't one\n", r->funcname, t->col->colname);
+    return false;
+  }
+
+  agg_target_name(r, name, sizeof(name));
+
+  if (t->func == AGG_MIN || t->func == AGG_MAX) {
+    construct_column_desc(&agg->outRd->cols[i], name, t->col->dataType, i, t->col->len, false);
+  } else {
+    construct_column_desc(&agg->outRd->cols[i], name, DT_BIGINT, i, 8, false);
+  }
+
+  return true;
+}
+
+/**
+ * @brief Resolves the targets and GROUP BY columns of a SELECT against the
+ * input columns. Every column in the target list that isn't aggregated has
+ * to be in the GROUP BY clause.
+ *
+ * @param rd input rows
+ * @param targetList
+ * @param groupClause NULL if there's no GROUP BY
+ * @return Agg* NULL if the query is invalid
+ */
+Agg* agg_create(RecordDescriptor* rd, ParseList* targetList, ParseList* groupClause) {
+  Agg* agg = malloc(sizeof(Agg));
+  agg->rd = rd;
+  agg->numGroupCols = groupClause == NULL ? 0 : groupClause->length;
+  agg->groupCols = malloc(sizeof(Column*) * (agg->numGroupCols + 1));
+  agg->numTargets = targetList->length;
+  agg->targets = malloc(sizeof(AggTarget) * agg->numTargets);
+  agg->outRd = malloc(sizeof(RecordDescriptor) + (agg->numTargets * sizeof(Column)));
+  agg->outRd->ncols = 0;
+  agg->outRd->nfixed = 0;
+  agg->outRd->hasNullableColumns = true;
+  agg->ht = NULL;
+  agg->key = NULL;
+  agg->runs = NULL;
+  agg->numRuns = 0;
+  agg->failed = false;
+
+  for (int i = 0; i < agg->numGroupCols; i++) {
+    char* colname = ((ColumnRef*)groupClause->elements[i].ptr)->name;
+    agg->groupCols[i] = agg_get_column(rd, colname);
+
+    if (agg->groupCols[i] == NULL) {
+      printf("Column %s does not exist\n", colname);
+      free_agg(agg);
+      return NULL;
+    }
+  }
+
+  for (int i = 0; i < agg->numTargets; i++) {
+    if (!agg_init_target(agg, (ResTarget*)targetList->elements[i].ptr, i)) {
+      free_agg(agg);
+      return NULL;
+    }
+    agg->outRd->ncols++;
+  }
+
+  return agg;
+}
+
+void free_agg(Agg* agg) {
+  if (agg == NULL) return;
+
+  free_record_desc(agg->outRd);
+  free(agg->groupCols);
+  free(agg->targets);
+  free(agg);
+}
+
+/**
+ * @brief Largest key agg_encode_key can produce
+ */
+static uint32_t agg_max_key_len(Agg* agg) {
+  uint32_t maxLen = 0;
+
+  for (int i = 0; i < agg->numGroupCols; i++) {
+    Column* col = agg->groupCols[i];
+    maxLen += 1 + (agg_is_string(col->dataType) ? 2 + (uint32_t)col->len : sizeof(int64_t));
+  }
+
+  return maxLen;
+}
+
+/**
+ * @brief Encodes the GROUP BY values of a row into `key`. Each column is a
+ * NULL flag, followed by the value if there is one: 8 bytes for integers, a
+ * 2-byte length and the characters for strings. Two rows belong to the same
+ * group if and only if their keys are the same bytes.
+ */
+static uint32_t agg_encode_key(Agg* agg, RecordSetRow* row, char* key) {
+  uint32_t len = 0;
+
+  for (int i = 0; i < agg->numGroupCols; i++) {
+    Column* col = agg->groupCols[i];
+    bool isnull = row->isnull[col->colnum];
+
+    key[len++] = isnull;
+    if (isnull) continue;
+
+    if (agg_is_string(col->dataType)) {
+      char* str = datumGetString(row->values[col->colnum]);
+      uint16_t strLen = strnlen(str, col->len);
+      memcpy(key + len, &strLen, sizeof(uint16_t));
+      memcpy(key + len + sizeof(uint16_t), str, strLen);
+      len += sizeof(uint16_t) + strLen;
+    } else {
+      int64_t v = indexam_datum_to_key(col->dataType, row->values[col->colnum]);
+      memcpy(key + len, &v, sizeof(int64_t));
+      len += sizeof(int64_t);
+    }
+  }
+
+  return len;
+}
+
+/**
+ * @brief 64-bit FNV-1a of the key, with the bits mixed (murmur3 finalizer)
+ * so that the low bits used for the slot are as good as the high ones
+ */
+static uint64_t agg_hash_key(char* key, uint32_t keyLen) {
+  uint64_t h = 0xcbf29ce484222325ULL;
+
+  for (uint32_t i = 0; i < keyLen; i++) {
+    h ^= (uint8_t)key[i];
+    h *= 0x100000001b3ULL;
+  }
+
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+
+  return h;
+}
+
+static int agg_key_compare(char* a, uint32_t aLen, char* b, uint32_t bLen) {
+  int cmp = memcmp(a, b, aLen < bLen ? aLen : bLen);
+  if (cmp != 0) return cmp;
+
+  return aLen < bLen ? -1 : (aLen > bLen ? 1 : 0);
+}
+
+static int agg_group_compare(const void* a, const void* b) {
+  AggGroup* ga = *(AggGroup**)a;
+  AggGroup* gb = *(AggGroup**)b;
+
+  return agg_key_compare(ga->key, ga->keyLen, gb->key, gb->keyLen);
+}
+
+static size_t agg_group_size(Agg* agg) {
+  return sizeof(AggGroup) + agg->numTargets * sizeof(AggState);
+}
+
+static AggGroup* agg_new_group(Agg* agg, uint64_t hash, char* key, uint32_t keyLen) {
+  AggGroup* g = calloc(1, agg_group_size(agg));
+  g->hash = hash;
+  g->keyLen = keyLen;
+  g->key = malloc(keyLen + 1);
+  memcpy(g->key, key, keyLen);
+
+  return g;
+}
+
+static void free_agg_group(Agg* agg, AggGroup* g) {
+  for (int i = 0; i < agg->numTargets; i++) {
+    free(g->states[i].str);
+  }
+
+  free(g->key);
+  free(g);
+}
+
+static void agg_table_init(AggHashTable* ht) {
+  ht->numSlots = AGG_INITIAL_SLOTS;
+  ht->slots = malloc(sizeof(AggSlot) * ht->numSlots);
+  memset(ht->slots, 0xFF, sizeof(AggSlot) * ht->numSlots);
+  ht->maxGroups = AGG_INITIAL_SLOTS / 2;
+  ht->groups = malloc(sizeof(AggGroup*) * ht->maxGroups);
+  ht->numGroups = 0;
+  ht->memUsed = sizeof(AggSlot) * ht->numSlots + sizeof(AggGroup*) * ht->maxGroups;
+}
+
+static void agg_table_insert_slot(AggHashTable* ht, uint64_t hash, int32_t groupId) {
+  uint32_t mask = ht->numSlots - 1;
+  uint32_t slot = hash & mask;
+
+  while (ht->slots[slot].groupId >= 0) slot = (slot + 1) & mask;
+
+  ht->slots[slot].hashTag = hash >> 32;
+  ht->slots[slot].groupId = groupId;
+}
+
+/**
+ * @brief Doubles the table, keeping it at most half full
+ */
+static void agg_table_grow(AggHashTable* ht) {
+  ht->memUsed -= sizeof(AggSlot) * ht->numSlots + sizeof(AggGroup*) * ht->maxGroups;
+
+  free(ht->slots);
+  ht->numSlots *= 2;
+  ht->slots = malloc(sizeof(AggSlot) * ht->numSlots);
+  memset(ht->slots, 0xFF, sizeof(AggSlot) * ht->numSlots);
+
+  ht->maxGroups *= 2;
+  ht->groups = realloc(ht->groups, sizeof(AggGroup*) * ht->maxGroups);
+
+  for (int32_t i = 0; i < ht->numGroups; i++) {
+    agg_table_insert_slot(ht, ht->groups[i]->hash, i);
+  }
+
+  ht->memUsed += sizeof(AggSlot) * ht->numSlots + sizeof(AggGroup*) * ht->maxGroups;
+}
+
+/**
+ * @brief Returns the group with the given key, adding it if it's new
+ */
+static AggGroup* agg_table_lookup(Agg* agg, AggHashTable* ht, char* key, uint32_t keyLen) {
+  uint64_t hash = agg_hash_key(key, keyLen);
+  uint32_t hashTag = hash >> 32;
+  uint32_t mask = ht->numSlots - 1;
+  uint32_t slot = hash & mask;
+
+  while (ht->slots[slot].groupId >= 0) {
+    if (ht->slots[slot].hashTag == hashTag) {
+      AggGroup* g = ht->groups[ht->slots[slot].groupId];
+      if (g->hash == hash && agg_key_compare(g->key, g->keyLen, key, keyLen) == 0) return g;
+    }
+    slot = (slot + 1) & mask;
+  }
+
+  if (ht->numGroups == ht->maxGroups) {
+    agg_table_grow(ht);
+    return agg_table_lookup(agg, ht, key, keyLen);
+  }
+
+  AggGroup* g = agg_new_group(agg, hash, key, keyLen);
+  ht->slots[slot].hashTag = hashTag;
+  ht->slots[slot].groupId = ht->numGroups;
+  ht->groups[ht->numGroups++] = g;
+  ht->memUsed += agg_group_size(agg) + keyLen;
+
+  return g;
+}
+
+static void agg_table_clear(Agg* agg, AggHashTable* ht, bool freeGroups) {
+  for (int32_t i = 0; i < ht->numGroups && freeGroups; i++) {
+    free_agg_group(agg, ht->groups[i]);
+  }
+
+  ht->numGroups = 0;
+  ht->memUsed = sizeof(AggSlot) * ht->numSlots + sizeof(AggGroup*) * ht->maxGroups;
+  memset(ht->slots, 0xFF, sizeof(AggSlot) * ht->numSlots);
+}
+
+/**
+ * @brief Adds a row to the states of its group. Returns the number of bytes
+ * the states grew by.
+ */
+static size_t agg_advance(Agg* agg, AggGroup* g, RecordSetRow* row) {
+  size_t grown = 0;
+
+  for (int i = 0; i < agg->numTargets; i++) {
+    AggTarget* t = &agg->targets[i];
+    AggState* st = &g->states[i];
+
+    if (t->func == AGG_NONE) continue;
+
+    if (t->col == NULL) {
+      st->count++;
+      continue;
+    }
+
+    if (row->isnull[t->col->colnum]) continue;
+
+    Datum d = row->values[t->col->colnum];
+    st->count++;
+
+    if (agg_is_string(t->col->dataType)) {
+      if (t->func != AGG_MIN && t->func != AGG_MAX) continue;
+
+      char* str = datumGetString(d);
+      int cmp = st->str == NULL ? 0 : strcmp(str, st->str);
+
+      if (st->str == NULL || (t->func == AGG_MIN ? cmp < 0 : cmp > 0)) {
+        grown += strlen(str) + 1;
+        free(st->str);
+        st->str = strdup(str);
+      }
+      continue;
+    }
+
+    int64_t v = indexam_datum_to_key(t->col->dataType, d);
+
+    switch (t->func) {
+      case AGG_SUM:
+      case AGG_AVG:
+        st->sum += v;
+        break;
+      case AGG_MIN:
+        if (st->count == 1 || v < st->value) st->value = v;
+        break;
+      case AGG_MAX:
+        if (st->count == 1 || v > st->value) st->value = v;
+        break;
+      default:
+        break;
+    }
+  }
+
+  return grown;
+}
+
+/**
+ * @brief Merges the states of `src` into `dst`, for two partial groups of
+ * the same key
+ */
+static void agg_combine(Agg* agg, AggGroup* dst, AggGroup* src) {
+  for (int i = 0; i < agg->numTargets; i++) {
+    AggTarget* t = &agg->targets[i];
+    AggState* d = &dst->states[i];
+    AggState* s = &src->states[i];
+
+    if (t->func == AGG_NONE || s->count == 0) continue;
+
+    if (t->func == AGG_MIN || t->func == AGG_MAX) {
+      if (s->str != NULL) {
+        int cmp = d->str == NULL ? 0 : strcmp(s->str, d->str);
+        if (d->str == NULL || (t->func == AGG_MIN ? cmp < 0 : cmp > 0)) {
+          free(d->str);
+          d->str = s->str;
+          s->str = NULL;
+        }
+      } else if (d->count == 0 || (t->func == AGG_MIN ? s->value < d->value : s->value > d->value)) {
+        d->value = s->value;
+      }
+    }
+
+    d->count += s->count;
+    d->sum += s->sum;
+  }
+}
+
+static bool agg_write_group(Agg* agg, FILE* fp, AggGroup* g) {
+  bool success = fwrite(&g->keyLen, sizeof(uint32_t), 1, fp) == 1
+    && fwrite(g->key, 1, g->keyLen, fp) == g->keyLen;
+
+  for (int i = 0; i < agg->numTargets && success; i++) {
+    AggState* st = &g->states[i];
+    int32_t strLen = st->str == NULL ? -1 : (int32_t)strlen(st->str);
+
+    success = fwrite(&st->count, sizeof(int64_t), 1, fp) == 1
+      && fwrite(&st->sum, sizeof(int64_t), 1, fp) == 1
+      && fwrite(&st->value, sizeof(int64_t), 1, fp) == 1
+      && fwrite(&strLen, sizeof(int32_t), 1, fp) == 1
+      && (strLen <= 0 || fwrite(st->str, 1, strLen, fp) == (size_t)strLen);
+  }
+
+  return success;
+}
+
+/**
+ * @brief Reads the next group of a sorted run. Returns NULL at the end of it.
+ */
+static AggGroup* agg_read_group(Agg* agg, FILE* fp) {
+  uint32_t keyLen;
+  if (fread(&keyLen, sizeof(uint32_t), 1, fp) != 1) return NULL;
+
+  AggGroup* g = calloc(1, agg_group_size(agg));
+  g->keyLen = keyLen;
+  g->key = malloc(keyLen + 1);
+  bool success = fread(g->key, 1, keyLen, fp) == keyLen;
+
+  for (int i = 0; i < agg->numTargets && success; i++) {
+    AggState* st = &g->states[i];
+    int32_t strLen;
+
+    success = fread(&st->count, sizeof(int64_t), 1, fp) == 1
+      && fread(&st->sum, sizeof(int64_t), 1, fp) == 1
+      && fread(&st->value, sizeof(int64_t), 1, fp) == 1
+      && fread(&strLen, sizeof(int32_t), 1, fp) == 1;
+
+    if (success && strLen >= 0) {
+      st->str = malloc(strLen + 1);
+      success = fread(st->str, 1, strLen, fp) == (size_t)strLen;
+      st->str[strLen] = '\0';
+    }
+  }
+
+  if (!success) {
+    printf("Unable to read a GROUP BY spill file\n");
+    free_agg_group(agg, g);
+    return NULL;
+  }
+
+  return g;
+}
+
+/**
+ * @brief Writes every group of the table to a new temporary file, sorted by
+ * key, and empties the table. Returns the file, rewound, or NULL on failure.
+ */
+static FILE* agg_spill(Agg* agg, AggHashTable* ht) {
+  FILE* fp = tmpfile();
+  if (fp == NULL) {
+    printf("Unable to create a GROUP BY spill file\n");
+    return NULL;
+  }
+
+  qsort(ht->groups, ht->numGroups, sizeof(AggGroup*), agg_group_compare);
+
+  bool success = true;
+  for (int32_t i = 0; i < ht->numGroups && success; i++) {
+    success = agg_write_group(agg, fp, ht->groups[i]);
+  }
+
+  agg_table_clear(agg, ht, true);
+
+  if (!success) {
+    printf("Unable to write a GROUP BY spill file\n");
+    fclose(fp);
+    return NULL;
+  }
+
+  rewind(fp);
+  return fp;
+}
+
+/**
+ * @brief Appends the final values of a group to the result
+ */
+static void agg_emit_group(Agg* agg, AggGroup* g, RecordSet* out) {
+  RecordSetRow* row = new_recordset_row(out->rows, agg->numTargets);
+  Datum keyVals[agg->numGroupCols + 1];
+  bool keyNulls[agg->numGroupCols + 1];
+  uint32_t offset = 0;
+
+  for (int i = 0; i < agg->numGroupCols; i++) {
+    Column* col = agg->groupCols[i];
+    keyNulls[i] = g->key[offset++];
+    keyVals[i] = 0;
+    if (keyNulls[i]) continue;
+
+    if (agg_is_string(col->dataType)) {
+      uint16_t strLen;
+      memcpy(&strLen, g->key + offset, sizeof(uint16_t));
+      keyVals[i] = charGetDatum(strndup(g->key + offset + sizeof(uint16_t), strLen));
+      offset += sizeof(uint16_t) + strLen;
+    } else {
+      int64_t v;
+      memcpy(&v, g->key + offset, sizeof(int64_t));
+      keyVals[i] = agg_int_to_datum(col->dataType, v);
+      offset += sizeof(int64_t);
+    }
+  }
+
+  for (int i = 0; i < agg->numTargets; i++) {
+    AggTarget* t = &agg->targets[i];
+    AggState* st = &g->states[i];
+
+    row->isnull[i] = false;
+    row->values[i] = 0;
+
+    switch (t->func) {
+      case AGG_NONE:
+        row->isnull[i] = keyNulls[t->groupIdx];
+        row->values[i] = keyVals[t->groupIdx];
+        if (agg_is_string(t->col->dataType) && !keyNulls[t->groupIdx]) {
+          row->values[i] = charGetDatum(strdup(datumGetString(keyVals[t->groupIdx])));
+        }
+        break;
+      case AGG_COUNT:
+        row->values[i] = int64GetDatum(st->count);
+        break;
+      case AGG_SUM:
+        row->isnull[i] = st->count == 0;
+        row->values[i] = int64GetDatum(st->sum);
+        break;
+      case AGG_AVG:
+        row->isnull[i] = st->count == 0;
+        if (st->count > 0) row->values[i] = int64GetDatum(st->sum / st->count);
+        break;
+      case AGG_MIN:
+      case AGG_MAX:
+        row->isnull[i] = st->count == 0;
+        if (st->count == 0) break;
+
+        if (agg_is_string(t->col->dataType)) {
+          row->values[i] = charGetDatum(strdup(st->str));
+        } else {
+          row->values[i] = agg_int_to_datum(t->col->dataType, st->value);
+        }
+    }
+  }
+
+  for (int i = 0; i < agg->numGroupCols; i++) {
+    if (agg_is_string(agg->groupCols[i]->dataType) && !keyNulls[i]) free(datumGetString(keyVals[i]));
+  }
+}
+
+/**
+ * @brief Merges the sorted runs, combining the groups with equal keys, and
+ * appends the final groups to the result
+ */
+static bool agg_merge_runs(Agg* agg, FILE** runs, int numRuns, RecordSet* out) {
+  AggGroup** heads = malloc(sizeof(AggGroup*) * numRuns);
+  AggGroup* current = NULL;
+
+  for (int i = 0; i < numRuns; i++) {
+    heads[i] = agg_read_group(agg, runs[i]);
+  }
+
+  while (true) {
+    int minRun = -1;
+    for (int i = 0; i < numRuns; i++) {
+      if (heads[i] == NULL) continue;
+      if (minRun < 0 || agg_group_compare(&heads[i], &heads[minRun]) < 0) minRun = i;
+    }
+
+    if (minRun < 0) break;
+
+    AggGroup* g = heads[minRun];
+    heads[minRun] = agg_read_group(agg, runs[minRun]);
+
+    if (current != NULL && agg_group_compare(&current, &g) == 0) {
+      agg_combine(agg, current, g);
+      free_agg_group(agg, g);
+    } else {
+      if (current != NULL) {
+        agg_emit_group(agg, current, out);
+        free_agg_group(agg, current);
+      }
+      current = g;
+    }
+  }
+
+  if (current != NULL) {
+    agg_emit_group(agg, current, out);
+    free_agg_group(agg, current);
+  }
+
+  free(heads);
+
+  return true;
+}
+
+/**
+ * @brief Starts grouping rows, which are then added with agg_add_row
+ */
+void agg_begin(Agg* agg) {
+  agg->ht = malloc(sizeof(AggHashTable));
+  agg_table_init(agg->ht);
+  agg->key = malloc(agg_max_key_len(agg) + 1);
+  agg->runs = NULL;
+  agg->numRuns = 0;
+  agg->failed = false;
+
+  /* without GROUP BY, there's exactly one group, even if there are no rows */
+  if (agg->numGroupCols == 0) agg_table_lookup(agg, agg->ht, agg->key, 0);
+}
+
+/**
+ * @brief Adds a row to its group. Once the groups take up more than
+ * WORK_MEM, they're spilled as a sorted run.
+ */
+static void agg_advance_row(Agg* agg, RecordSetRow* row) {
+  AggHashTable* ht = agg->ht;
+
+  if (agg->failed) return;
+
+  uint32_t keyLen = agg_encode_key(agg, row, agg->key);
+  AggGroup* g = agg_table_lookup(agg, ht, agg->key, keyLen);
+
+  ht->memUsed += agg_advance(agg, g, row);
+
+  if (ht->memUsed > (size_t)conf->workMem * 1024 && agg->numGroupCols > 0) {
+    agg->runs = realloc(agg->runs, sizeof(FILE*) * (agg->numRuns + 1));
+    agg->runs[agg->numRuns] = agg_spill(agg, ht);
+    agg->failed = agg->runs[agg->numRuns++] == NULL;
+  }
+}
+
+/**
+ * @brief Adds a row to its group and frees it. Has the signature of a
+ * TableamRowFunc, so a scan can hand its rows straight to the Agg.
+ *
+ * @param agg the Agg, between agg_begin and agg_end
+ * @param row described by `agg->rd`
+ * @return bool false if the groups had to be spilled and that failed
+ */
+bool agg_add_row(void* agg, RecordSetRow* row) {
+  agg_advance_row(agg, row);
+  free_recordset_row(row, ((Agg*)agg)->rd);
+
+  return !((Agg*)agg)->failed;
+}
+
+/**
+ * @brief Computes the aggregates of every group of the rows added since
+ * agg_begin
+ *
+ * @param agg
+ * @return RecordSet* one row per group, described by `agg->outRd`. NULL if
+ * the groups had to be spilled and that failed.
+ */
+RecordSet* agg_end(Agg* agg) {
+  RecordSet* out = new_recordset();
+  AggHashTable* ht = agg->ht;
+  bool success = !agg->failed;
+
+  if (success && agg->numRuns > 0) {
+    /* the groups that are still in memory become the last run */
+    agg->runs = realloc(agg->runs, sizeof(FILE*) * (agg->numRuns + 1));
+    agg->runs[agg->numRuns] = agg_spill(agg, ht);
+    success = agg->runs[agg->numRuns++] != NULL && agg_merge_runs(agg, agg->runs, agg->numRuns, out);
+  } else if (success) {
+    for (int32_t i = 0; i < ht->numGroups; i++) {
+      agg_emit_group(agg, ht->groups[i], out);
+    }
+  }
+
+  for (int i = 0; i < agg->numRuns; i++) {
+    if (agg->runs[i] != NULL) fclose(agg->runs[i]);
+  }
+
+  agg_table_clear(agg, ht, true);
+  free(ht->slots);
+  free(ht->groups);
+  free(ht);
+  free(agg->runs);
+  free(agg->key);
+  agg->ht = NULL;
+  agg->key = NULL;
+  agg->runs = NULL;
+  agg->numRuns = 0;
+
+  if (!success) {
+    free_recordset(out, agg->outRd);
+    return NULL;
+  }
+
+  return out;
+}
+
+/**
+ * @brief Groups the rows and computes the aggregates of every group
+ *
+ * @param agg
+ * @param rs input rows, left untouched
+ * @return RecordSet* one row per group, described by `agg->outRd`. NULL if
+ * the groups had to be spilled and that failed.
+ */
+RecordSet* agg_execute(Agg* agg, RecordSet* rs) {
+  agg_begin(agg);
+
+  for (ListItem* li = rs->rows->head; li != NULL && !agg->failed; li = li->next) {
+    agg_advance_row(agg, li->ptr);
+  }
+
+  return agg_end(agg);
+}
@@ -0,0 +1,699 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/uio.h>
+
+#include "executor/copy.h"
+#include "access/tableam.h"
+#include "access/indexam.h"
+#include "access/visibilitymap.h"
+#include "storage/page.h"
+#include "global/config.h"
+#include "utility/numfmt.h"
+
+extern Config* conf;
+
+/* iovecs gathered before COPY TO calls writev, Linux's IOV_MAX */
+#define COPY_MAX_IOV  1024
+
+/* starts a binary COPY TO file */
+#define COPY_BINARY_SIGNATURE  "BQLCOPY\n"
+
+/**
+ * @brief The state of a COPY TO
+ *
+ * fd          | file being written
+ * binary      | binary format instead of CSV
+ * iov         | pieces of output waiting for writev, in order. They point
+ *             | into `scratch` or into the page being exported.
+ * scratch     | formatted numbers, separators and escaped strings
+ * maxRecords  | records per page the column arrays have room for
+ * ints        | decoded values of each integer column of the page, by colnum
+ * strs        | pointers to the strings of each string column, into the page
+ * lens        | lengths of the strings
+ * nulls       | NULL flags of each column
+ * failed      | a write failed, the rest of the table is skipped
+ */
+typedef struct CopyWriter {
+  int fd;
+  RecordDescriptor* rd;
+  bool binary;
+  struct iovec iov[COPY_MAX_IOV];
+  int numIov;
+  char* scratch;
+  size_t scratchUsed;
+  size_t scratchCap;
+  int maxRecords;
+  int64_t** ints;
+  char*** strs;
+  uint16_t** lens;
+  uint8_t** nulls;
+  int64_t numRows;
+  bool failed;
+} CopyWriter;
+
+static bool copy_is_string(DataType dataType) {
+  return dataType == DT_CHAR || dataType == DT_VARCHAR;
+}
+
+/**
+ * @brief Checks that `v` fits in the integer column and turns it into a Datum
+ */
+static bool copy_int_to_datum(Column* col, int64_t v, Datum* value) {
+  int64_t min = INT64_MIN;
+  int64_t max = INT64_MAX;
+
+  switch (col->dataType) {
+    case DT_TINYINT:
+      min = 0;
+      max = UINT8_MAX;
+      break;
+    case DT_SMALLINT:
+      min = INT16_MIN;
+      max = INT16_MAX;
+      break;
+    case DT_INT:
+      min = INT32_MIN;
+      max = INT32_MAX;
+      break;
+    case DT_BOOL:
+      min = 0;
+      max = 1;
+      break;
+    default:
+      break;
+  }
+
+  if (v < min || v > max) {
+    printf("Value %ld is out of range for column %s\n", v, col->colname);
+    return false;
+  }
+
+  switch (col->dataType) {
+    case DT_TINYINT:
+    case DT_BOOL:
+      *value = uint8GetDatum(v);
+      break;
+    case DT_SMALLINT:
+      *value = int16GetDatum(v);
+      break;
+    case DT_INT:
+      *value = int32GetDatum(v);
+      break;
+    default:
+      *value = int64GetDatum(v);
+  }
+
+  return true;
+}
+
+static bool copy_string_to_datum(Column* col, char* str, Datum* value) {
+  if ((int)strlen(str) > col->len) {
+    printf("Value '%s' is too long for column %s\n", str, col->colname);
+    return false;
+  }
+
+  *value = charGetDatum(str);
+  return true;
+}
+
+/**
+ * @brief Turns a literal of an INSERT into the value of a column
+ *
+ * @param col
+ * @param l
+ * @param value returns the value. Strings point into the Literal.
+ * @param isnull
+ * @return true
+ * @return false if the literal doesn't fit the column
+ */
+bool copy_literal_to_datum(Column* col, Literal* l, Datum* value, bool* isnull) {
+  *value = 0;
+  *isnull = l->isNull;
+
+  if (l->isNull) {
+    if (col->isNotNull) printf("Column %s can't be NULL\n", col->colname);
+    return !col->isNotNull;
+  }
+
+  if (copy_is_string(col->dataType) != (l->str != NULL)) {
+    printf("Column %s needs a %s\n", col->colname, copy_is_string(col->dataType) ? "string" : "number");
+    return false;
+  }
+
+  if (l->str != NULL) return copy_string_to_datum(col, l->str, value);
+
+  return copy_int_to_datum(col, l->intVal, value);
+}
+
+/**
+ * @brief Turns a field of a CSV line into the value of a column
+ *
+ * @param str the field, unquoted. Strings point into it.
+ * @param isEmpty true for an empty unquoted field, i.e. NULL
+ */
+static bool copy_field_to_datum(Column* col, char* str, bool isEmpty, Datum* value, bool* isnull) {
+  *value = 0;
+  *isnull = isEmpty;
+
+  if (isEmpty) {
+    if (col->isNotNull) printf("Column %s can't be NULL\n", col->colname);
+    return !col->isNotNull;
+  }
+
+  if (copy_is_string(col->dataType)) return copy_string_to_datum(col, str, value);
+
+  if (col->dataType == DT_BOOL) {
+    if (strcasecmp(str, "true") == 0 || strcasecmp(str, "t") == 0) return copy_int_to_datum(col, 1, value);
+    if (strcasecmp(str, "false") == 0 || strcasecmp(str, "f") == 0) return copy_int_to_datum(col, 0, value);
+  }
+
+  char* end;
+  errno = 0;
+  int64_t v = strtoll(str, &end, 10);
+
+  if (*str == '\0' || *end != '\0' || errno == ERANGE) {
+    printf("Column %s needs a number, not '%s'\n", col->colname, str);
+    return false;
+  }
+
+  return copy_int_to_datum(col, v, value);
+}
+
+/**
+ * @brief Splits a CSV line into the values of a row. Fields are unquoted in
+ * place, so the strings of the row point into `line`.
+ */
+static bool copy_parse_line(RecordDescriptor* rd, char* line, Datum* values, bool* isnull) {
+  char* p = line;
+
+  for (int i = 0; i < rd->ncols; i++) {
+    Column* col = &rd->cols[i];
+    bool quoted = *p == '"';
+    char* field;
+    char* end;
+
+    if (quoted) {
+      field = end = ++p;
+
+      while (true) {
+        if (*p == '\0') {
+          printf("Unterminated quoted field for column %s\n", col->colname);
+          return false;
+        }
+
+        if (*p == '"') {
+          if (p[1] != '"') break;
+          p++;
+        }
+
+        *end++ = *p++;
+      }
+
+      p++;
+    } else {
+      field = p;
+      while (*p != ',' && *p != '\0') p++;
+      end = p;
+    }
+
+    char separator = *p;
+    if (separator == ',') p++;
+
+    if ((i < rd->ncols - 1 && separator != ',') || (i == rd->ncols - 1 && separator != '\0')) {
+      printf("Expected %d comma-separated fields\n", rd->ncols);
+      return false;
+    }
+
+    *end = '\0';
+
+    if (!copy_field_to_datum(col, field, !quoted && *field == '\0', &values[col->colnum], &isnull[col->colnum])) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/**
+ * @brief Inserts the records into the table and all of its indexes. Pages
+ * are marked all-visible again once their rows are in every index.
+ *
+ * @param buf
+ * @param td
+ * @param records
+ * @param recordLens
+ * @param numRecords
+ * @return true
+ * @return false if any of the records couldn't be inserted
+ */
+bool copy_insert_batch(BufMgr* buf, TableDesc* td, Record* records, uint16_t* recordLens, int numRecords) {
+  RecordId* rids = malloc(sizeof(RecordId) * (numRecords + 1));
+
+  int numInserted = tableam_insert_batch(buf, td, records, recordLens, numRecords, rids);
+  bool success = indexam_insert_batch(buf, td, records, rids, numInserted) && numInserted == numRecords;
+
+  for (int i = 0; i < numInserted && success; i++) {
+    /* clustered tables have no rids, and the rows of a page are next to each other */
+    if (rids[i].pageId == 0 || (i > 0 && rids[i].pageId == rids[i - 1].pageId)) continue;
+    visibilitymap_set(buf, rids[i].pageId);
+  }
+
+  free(rids);
+
+  return success;
+}
+
+/**
+ * @brief Starts a new line of a CSV row that spans lines, or appends the
+ * next line to it. Returns true once the row is complete, i.e. it has an
+ * even number of quotes.
+ */
+static bool copy_append_line(char** row, size_t* rowLen, size_t* rowCap, char* line, ssize_t lineLen) {
+  while (lineLen > 0 && (line[lineLen - 1] == '\n' || line[lineLen - 1] == '\r')) lineLen--;
+
+  if (*rowLen + lineLen + 2 > *rowCap) {
+    *rowCap = (*rowLen + lineLen + 2) * 2;
+    *row = realloc(*row, *rowCap);
+  }
+
+  /* the line break is part of the quoted field */
+  if (*rowLen > 0) (*row)[(*rowLen)++] = '\n';
+
+  memcpy(*row + *rowLen, line, lineLen);
+  *rowLen += lineLen;
+  (*row)[*rowLen] = '\0';
+
+  int numQuotes = 0;
+  for (size_t i = 0; i < *rowLen; i++) numQuotes += (*row)[i] == '"';
+
+  return numQuotes % 2 == 0;
+}
+
+/**
+ * @brief Loads a CSV file into the table (see copy.h). The rows go in a
+ * page's worth of records at a time.
+ *
+ * @param buf
+ * @param td
+ * @param filename
+ * @return true
+ * @return false if the file can't be read, or one of its lines can't be
+ * inserted. The rows before it stay in the table.
+ */
+bool copy_from(BufMgr* buf, TableDesc* td, char* filename) {
+  FILE* fp = fopen(filename, "r");
+  if (fp == NULL) {
+    printf("Unable to open %s\n", filename);
+    return false;
+  }
+
+  RecordDescriptor* rd = td->rd;
+  Datum* values = malloc(sizeof(Datum) * rd->ncols);
+  bool* isnull = malloc(sizeof(bool) * rd->ncols);
+
+  size_t pageSpace = conf->pageSize - sizeof(PageHeader);
+  int maxRecords = 64;
+  Record* records = malloc(sizeof(Record) * maxRecords);
+  uint16_t* recordLens = malloc(sizeof(uint16_t) * maxRecords);
+  int numRecords = 0;
+  size_t batchBytes = 0;
+
+  char* line = NULL;
+  size_t lineCap = 0;
+  ssize_t lineLen;
+  char* row = NULL;
+  size_t rowLen = 0;
+  size_t rowCap = 0;
+  int lineNo = 0;
+  int64_t numRows = 0;
+  bool parsed = true;
+  bool inserted = true;
+
+  while (parsed && inserted && (lineLen = getline(&line, &lineCap, fp)) != -1) {
+    lineNo++;
+
+    if (!copy_append_line(&row, &rowLen, &rowCap, line, lineLen)) continue;
+
+    parsed = copy_parse_line(rd, row, values, isnull);
+    rowLen = 0;
+
+    if (parsed) {
+      if (numRecords == maxRecords) {
+        maxRecords *= 2;
+        records = realloc(records, sizeof(Record) * maxRecords);
+        recordLens = realloc(recordLens, sizeof(uint16_t) * maxRecords);
+      }
+
+      records[numRecords] = record_serialize(rd, values, isnull, &recordLens[numRecords]);
+      batchBytes += recordLens[numRecords] + sizeof(SlotPointer);
+      numRecords++;
+    }
+
+    if (parsed && batchBytes >= pageSpace) {
+      inserted = copy_insert_batch(buf, td, records, recordLens, numRecords);
+      if (inserted) numRows += numRecords;
+
+      for (int i = 0; i < numRecords; i++) free(records[i]);
+      numRecords = 0;
+      batchBytes = 0;
+    }
+  }
+
+  if (parsed && rowLen > 0) {
+    printf("Unterminated quoted field at the end of the file\n");
+    parsed = false;
+  }
+
+  /* the lines before a bad one still go in */
+  if (inserted && numRecords > 0) {
+    inserted = copy_insert_batch(buf, td, records, recordLens, numRecords);
+    if (inserted) numRows += numRecords;
+  }
+
+  for (int i = 0; i < numRecords; i++) free(records[i]);
+
+  if (parsed && inserted) {
+    printf("Copied %ld rows\n", numRows);
+  } else {
+    printf("COPY stopped at line %d of %s, %ld rows were copied before it\n", lineNo, filename, numRows);
+  }
+
+  free(records);
+  free(recordLens);
+  free(values);
+  free(isnull);
+  free(line);
+  free(row);
+  fclose(fp);
+
+  return parsed && inserted;
+}
+
+/**
+ * @brief Writes out every pending piece with writev and starts over with
+ * an empty scratch buffer
+ */
+static void copy_flush(CopyWriter* w) {
+  struct iovec* iov = w->iov;
+  int numIov = w->numIov;
+
+  while (numIov > 0 && !w->failed) {
+    ssize_t written = writev(w->fd, iov, numIov);
+
+    if (written < 0) {
+      if (errno == EINTR) continue;
+      printf("Unable to write the COPY file: %s\n", strerror(errno));
+      w->failed = true;
+      break;
+    }
+
+    /* skip what made it out, writev may stop anywhere */
+    while (numIov > 0 && (size_t)written >= iov->iov_len) {
+      written -= iov->iov_len;
+      iov++;
+      numIov--;
+    }
+
+    if (numIov > 0) {
+      iov->iov_base = (char*)iov->iov_base + written;
+      iov->iov_len -= written;
+    }
+  }
+
+  w->numIov = 0;
+  w->scratchUsed = 0;
+}
+
+/**
+ * @brief Makes sure there's room for the next cell: `bytes` of scratch
+ * space and two iovecs
+ */
+static void copy_reserve(CopyWriter* w, size_t bytes) {
+  if (w->scratchUsed + bytes > w->scratchCap || w->numIov + 2 > COPY_MAX_IOV) copy_flush(w);
+}
+
+/**
+ * @brief Queues `len` bytes at `data`, which must stay put until the next
+ * flush. Pieces that follow each other in memory share an iovec.
+ */
+static void copy_out(CopyWriter* w, const void* data, size_t len) {
+  if (len == 0) return;
+
+  struct iovec* last = w->numIov > 0 ? &w->iov[w->numIov - 1] : NULL;
+
+  if (last != NULL && (char*)last->iov_base + last->iov_len == data) {
+    last->iov_len += len;
+    return;
+  }
+
+  w->iov[w->numIov].iov_base = (void*)data;
+  w->iov[w->numIov].iov_len = len;
+  w->numIov++;
+}
+
+/**
+ * @brief Copies `len` bytes into the scratch buffer and queues them
+ */
+static void copy_out_scratch(CopyWriter* w, const void* data, size_t len) {
+  char* dst = w->scratch + w->scratchUsed;
+  memcpy(dst, data, len);
+  w->scratchUsed += len;
+  copy_out(w, dst, len);
+}
+
+static bool copy_csv_needs_quotes(char* str, uint16_t len) {
+  /* an empty string is quoted, an empty field is NULL */
+  if (len == 0) return true;
+
+  for (uint16_t i = 0; i < len; i++) {
+    if (str[i] == ',' || str[i] == '"' || str[i] == '\n' || str[i] == '\r') return true;
+  }
+
+  return false;
+}
+
+static void copy_csv_cell(CopyWriter* w, Column* col, int n, bool last) {
+  char separator = last ? '\n' : ',';
+
+  if (w->nulls[col->colnum][n]) {
+    copy_reserve(w, 1);
+    copy_out_scratch(w, &separator, 1);
+    return;
+  }
+
+  if (!copy_is_string(col->dataType)) {
+    copy_reserve(w, NUMFMT_MAX_LEN + 1);
+    char* dst = w->scratch + w->scratchUsed;
+    int len = numfmt_int64(dst, w->ints[col->colnum][n]);
+    dst[len++] = separator;
+    w->scratchUsed += len;
+    copy_out(w, dst, len);
+    return;
+  }
+
+  char* str = w->strs[col->colnum][n];
+  uint16_t len = w->lens[col->colnum][n];
+
+  if (!copy_csv_needs_quotes(str, len)) {
+    copy_reserve(w, 1);
+    copy_out(w, str, len);
+    copy_out_scratch(w, &separator, 1);
+    return;
+  }
+
+  copy_reserve(w, len * 2 + 3);
+  char* dst = w->scratch + w->scratchUsed;
+  int quotedLen = 0;
+
+  dst[quotedLen++] = '"';
+  for (uint16_t i = 0; i < len; i++) {
+    if (str[i] == '"') dst[quotedLen++] = '"';
+    dst[quotedLen++] = str[i];
+  }
+  dst[quotedLen++] = '"';
+  dst[quotedLen++] = separator;
+
+  w->scratchUsed += quotedLen;
+  copy_out(w, dst, quotedLen);
+}
+
+static void copy_binary_row(CopyWriter* w, int n) {
+  RecordDescriptor* rd = w->rd;
+  int bitmapLen = (rd->ncols + 7) / 8;
+  uint8_t bitmap[bitmapLen];
+
+  memset(bitmap, 0, bitmapLen);
+  for (int i = 0; i < rd->ncols; i++) {
+    if (w->nulls[rd->cols[i].colnum][n]) bitmap[i / 8] |= 1 << (i % 8);
+  }
+
+  copy_reserve(w, bitmapLen);
+  copy_out_scratch(w, bitmap, bitmapLen);
+
+  for (int i = 0; i < rd->ncols; i++) {
+    Column* col = &rd->cols[i];
+    if (w->nulls[col->colnum][n]) continue;
+
+    int64_t v = w->ints[col->colnum][n];
+
+    switch (col->dataType) {
+      case DT_TINYINT:
+      case DT_BOOL: {
+        uint8_t b = v;
+        copy_reserve(w, sizeof(b));
+        copy_out_scratch(w, &b, sizeof(b));
+        break;
+      }
+      case DT_SMALLINT: {
+        int16_t s = v;
+        copy_reserve(w, sizeof(s));
+        copy_out_scratch(w, &s, sizeof(s));
+        break;
+      }
+      case DT_INT: {
+        int32_t i32 = v;
+        copy_reserve(w, sizeof(i32));
+        copy_out_scratch(w, &i32, sizeof(i32));
+        break;
+      }
+      case DT_BIGINT:
+        copy_reserve(w, sizeof(v));
+        copy_out_scratch(w, &v, sizeof(v));
+        break;
+      default: {
+        uint16_t len = w->lens[col->colnum][n];
+        copy_reserve(w, sizeof(len));
+        copy_out_scratch(w, &len, sizeof(len));
+        copy_out(w, w->strs[col->colnum][n], len);
+      }
+    }
+  }
+}
+
+/**
+ * @brief Writes out the records of one page (see tableam_scan_pages). The
+ * columns are decoded a page at a time, and the strings are handed to
+ * writev straight from the page, so the page is flushed before it's
+ * released.
+ */
+static void copy_to_page(void* arg, Record* records, int numRecords) {
+  CopyWriter* w = arg;
+  RecordDescriptor* rd = w->rd;
+
+  if (w->failed || numRecords == 0) return;
+
+  if (numRecords > w->maxRecords) {
+    w->maxRecords = numRecords;
+
+    for (int i = 0; i < rd->ncols; i++) {
+      w->ints[i] = realloc(w->ints[i], sizeof(int64_t) * numRecords);
+      w->strs[i] = realloc(w->strs[i], sizeof(char*) * numRecords);
+      w->lens[i] = realloc(w->lens[i], sizeof(uint16_t) * numRecords);
+      w->nulls[i] = realloc(w->nulls[i], numRecords);
+    }
+  }
+
+  for (int i = 0; i < rd->ncols; i++) {
+    int colnum = rd->cols[i].colnum;
+
+    if (copy_is_string(rd->cols[i].dataType)) {
+      record_decode_string_column(rd, records, numRecords, colnum, w->strs[colnum], w->lens[colnum], w->nulls[colnum]);
+    } else {
+      record_decode_int_column(rd, records, numRecords, colnum, w->ints[colnum], w->nulls[colnum]);
+    }
+  }
+
+  for (int n = 0; n < numRecords; n++) {
+    if (w->binary) {
+      copy_binary_row(w, n);
+      continue;
+    }
+
+    for (int i = 0; i < rd->ncols; i++) copy_csv_cell(w, &rd->cols[i], n, i == rd->ncols - 1);
+  }
+
+  copy_flush(w);
+  w->numRows += numRecords;
+}
+
+/**
+ * @brief Writes every row of the table to a file (see copy.h), in CSV or
+ * the binary format. The table is streamed a page at a time.
+ *
+ * @param buf
+ * @param td
+ * @param filename created, or truncated if it exists
+ * @param binary
+ * @return true
+ * @return false if the file can't be written
+ */
+bool copy_to(BufMgr* buf, TableDesc* td, char* filename, bool binary) {
+  RecordDescriptor* rd = td->rd;
+  CopyWriter* w = malloc(sizeof(CopyWriter));
+
+  w->fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (w->fd < 0) {
+    printf("Unable to open %s: %s\n", filename, strerror(errno));
+    free(w);
+    return false;
+  }
+
+  w->rd = rd;
+  w->binary = binary;
+  w->numIov = 0;
+  /* room for the longest cell, a string of a page's length with every character escaped */
+  w->scratchCap = conf->pageSize * 4;
+  w->scratch = malloc(w->scratchCap);
+  w->scratchUsed = 0;
+  w->maxRecords = 0;
+  w->ints = calloc(rd->ncols, sizeof(int64_t*));
+  w->strs = calloc(rd->ncols, sizeof(char**));
+  w->lens = calloc(rd->ncols, sizeof(uint16_t*));
+  w->nulls = calloc(rd->ncols, sizeof(uint8_t*));
+  w->numRows = 0;
+  w->failed = false;
+
+  if (binary) {
+    uint16_t ncols = rd->ncols;
+    copy_out_scratch(w, COPY_BINARY_SIGNATURE, strlen(COPY_BINARY_SIGNATURE));
+    copy_out_scratch(w, &ncols, sizeof(ncols));
+
+    for (int i = 0; i < rd->ncols; i++) {
+      uint8_t dataType = rd->cols[i].dataType;
+      copy_out_scratch(w, &dataType, sizeof(dataType));
+    }
+
+    copy_flush(w);
+  }
+
+  tableam_scan_pages(buf, td, copy_to_page, w);
+
+  if (close(w->fd) != 0 && !w->failed) {
+    printf("Unable to write the COPY file: %s\n", strerror(errno));
+    w->failed = true;
+  }
+
+  bool success = !w->failed;
+  if (success) printf("Copied %ld rows\n", w->numRows);
+
+  for (int i = 0; i < rd->ncols; i++) {
+    free(w->ints[i]);
+    free(w->strs[i]);
+    free(w->lens[i]);
+    free(w->nulls[i]);
+  }
+
+  free(w->ints);
+  free(w->strs);
+  free(w->lens);
+  free(w->nulls);
+  free(w->scratch);
+  free(w);
+
+  return success;
+}
@@ -0,0 +1,829 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "executor/join.h"
+#include "access/tableam.h"
+#include "access/indexam.h"
+#include "global/config.h"
+
+extern Config* conf;
+
+/* build rows per in-memory partition, about what fits in a CPU's L2 cache */
+#define JOIN_PARTITION_BYTES (256 * 1024)
+
+#define JOIN_MAX_PARTITIONS 1024
+
+/* each spilled partition takes two temporary files */
+#define JOIN_MAX_SPILL_PARTITIONS 256
+
+typedef struct JoinEntry {
+  uint64_t hash;
+  RecordSetRow* row;
+} JoinEntry;
+
+/**
+ * @brief One of the two tables of the join
+ *
+ * td     | the table
+ * key    | its join column
+ * offset | position of its first column in the joined rows
+ * qual   | the part of the WHERE clause its scan checks, NULL for none
+ */
+typedef struct JoinSide {
+  TableDesc* td;
+  Column* key;
+  int offset;
+  Qual* qual;
+} JoinSide;
+
+/**
+ * @brief The rows of one side of the join, collected as its scan hands them
+ * over
+ *
+ * side          | the table they come from
+ * entries       | the rows hashed and not written out yet, `numEntries` of
+ *                 `maxEntries`
+ * memUsed       | about how many bytes those rows take up
+ * numPartitions | number of spill partitions
+ * files         | temporary file of each spill partition, NULL until the
+ *                 rows first spill
+ * keepHashes    | whether to also write every spilled hash to `hashes`, for
+ *                 the bloom filter of the build side
+ * hashes        | temporary file of the spilled hashes
+ * numSpilled    | number of rows written to `files`
+ * failed        | a spill file couldn't be created or written
+ */
+typedef struct JoinInput {
+  JoinSide* side;
+  JoinEntry* entries;
+  size_t numEntries;
+  size_t maxEntries;
+  size_t memUsed;
+  uint32_t numPartitions;
+  FILE** files;
+  bool keepHashes;
+  FILE* hashes;
+  size_t numSpilled;
+  bool failed;
+} JoinInput;
+
+/**
+ * @brief Hash table of build rows. It's split into partitions that each have
+ * their own buckets, so the buckets a batch of probe rows of one partition
+ * goes through stay in the CPU cache.
+ *
+ * entries       | the build rows, ordered by partition, `numEntries` of them
+ * memUsed       | about how many bytes the rows take up
+ * numPartitions | number of partitions
+ * starts        | index of the first entry of each partition, then
+ *                 `numEntries`
+ * bucketStarts  | index of the first bucket of each partition in `heads`,
+ *                 then the number of buckets
+ * heads         | first entry of each bucket's chain, -1 for none
+ * next          | next entry of each entry's chain, -1 for none
+ */
+typedef struct JoinTable {
+  JoinEntry* entries;
+  size_t numEntries;
+  size_t memUsed;
+  uint32_t numPartitions;
+  size_t* starts;
+  size_t* bucketStarts;
+  int32_t* heads;
+  int32_t* next;
+} JoinTable;
+
+/**
+ * @brief Joins probe rows with a JoinTable, a batch at a time
+ *
+ * join           | the join
+ * sides          | the build side, then the probe side
+ * table          | hash table of the build rows
+ * batch          | the probe rows of the current batch
+ * maxMem         | bytes of probe rows a batch may hold
+ * residual       | the part of the WHERE clause that reads both tables, NULL
+ *                  for none
+ * values, isnull | scratch space for a joined row
+ * fn, arg        | what the joined rows are handed to
+ * stopped        | `fn` asked for no more rows
+ */
+typedef struct JoinProbe {
+  Join* join;
+  JoinSide* sides[2];
+  JoinTable* table;
+  JoinInput batch;
+  size_t maxMem;
+  Qual* residual;
+  Datum* values;
+  bool* isnull;
+  TableamRowFunc fn;
+  void* arg;
+  bool stopped;
+} JoinProbe;
+
+static bool join_is_string(DataType dataType) {
+  return dataType == DT_CHAR || dataType == DT_VARCHAR;
+}
+
+static void join_add_columns(RecordDescriptor* rd, TableDesc* td) {
+  for (int i = 0; i < td->rd->ncols; i++) {
+    Column* col = &td->rd->cols[i];
+    size_t len = strlen(td->tablename) + strlen(col->colname) + 2;
+    char* name = malloc(len);
+
+    snprintf(name, len, "%s.%s", td->tablename, col->colname);
+    construct_column_desc(&rd->cols[rd->ncols], name, col->dataType, rd->ncols, col->len, col->isNotNull);
+    rd->ncols++;
+
+    free(name);
+  }
+}
+
+/**
+ * @brief Sets up the join of two tables. The keys are set with
+ * join_set_keys once the ON clause is resolved.
+ *
+ * @param left the FROM table, borrowed
+ * @param right the JOIN table, borrowed
+ * @return Join*
+ */
+Join* join_create(TableDesc* left, TableDesc* right) {
+  Join* join = malloc(sizeof(Join));
+  join->left = left;
+  join->right = right;
+  join->leftKey = NULL;
+  join->rightKey = NULL;
+
+  join->rd = malloc(sizeof(RecordDescriptor) + (left->rd->ncols + right->rd->ncols) * sizeof(Column));
+  join->rd->ncols = 0;
+  join->rd->nfixed = 0;
+  join->rd->hasNullableColumns = true;
+
+  join_add_columns(join->rd, left);
+  join_add_columns(join->rd, right);
+
+  return join;
+}
+
+void free_join(Join* join) {
+  if (join == NULL) return;
+
+  free_record_desc(join->rd);
+  free(join);
+}
+
+/**
+ * @brief Returns the name of the joined column `name` refers to, either
+ * `table.column` or a column name that only one of the tables has
+ *
+ * @return char* a new string, NULL if there's no such column or it's
+ * ambiguous
+ */
+char* join_resolve_column(Join* join, char* name) {
+  Column* found = NULL;
+  int numFound = 0;
+
+  for (int i = 0; i < join->rd->ncols; i++) {
+    char* colname = join->rd->cols[i].colname;
+    char* unqualified = strchr(colname, '.') + 1;
+
+    if (strcasecmp(colname, name) == 0 || strcasecmp(unqualified, name) == 0) {
+      found = &join->rd->cols[i];
+      numFound++;
+    }
+  }
+
+  if (numFound == 0) {
+    printf("Column %s does not exist\n", name);
+    return NULL;
+  }
+
+  if (numFound > 1) {
+    printf("Column %s is ambiguous\n", name);
+    return NULL;
+  }
+
+  return strdup(found->colname);
+}
+
+static Column* join_get_column(Join* join, char* name) {
+  for (int i = 0; i < join->rd->ncols; i++) {
+    if (strcasecmp(join->rd->cols[i].colname, name) == 0) return &join->rd->cols[i];
+  }
+
+  return NULL;
+}
+
+/**
+ * @brief Sets the columns of `ON lhs = rhs`, one from each table, in either
+ * order. The names must be resolved already (see join_resolve_column).
+ *
+ * @return false if they aren't one column of each table, or can't be
+ * compared
+ */
+bool join_set_keys(Join* join, char* lhs, char* rhs) {
+  Column* a = join_get_column(join, lhs);
+  Column* b = join_get_column(join, rhs);
+  int leftCols = join->left->rd->ncols;
+
+  if (a == NULL || b == NULL) return false;
+
+  if ((a->colnum < leftCols) == (b->colnum < leftCols)) {
+    printf("JOIN ON needs a column of each table\n");
+    return false;
+  }
+
+  if (join_is_string(a->dataType) != join_is_string(b->dataType)) {
+    printf("Can't join %s with %s, one is a string and the other isn't\n", a->colname, b->colname);
+    return false;
+  }
+
+  if (a->colnum > b->colnum) {
+    Column* t = a;
+    a = b;
+    b = t;
+  }
+
+  join->leftKey = &join->left->rd->cols[a->colnum];
+  join->rightKey = &join->right->rd->cols[b->colnum - leftCols];
+
+  return true;
+}
+
+/**
+ * @brief Returns 1 if the Qual only reads columns of the left table, 2 if
+ * it only reads columns of the right one, 3 if it reads both
+ */
+static int join_qual_sides(Join* join, Qual* q) {
+  if (q->type == QUAL_AND || q->type == QUAL_OR) {
+    return join_qual_sides(join, q->lhs) | join_qual_sides(join, q->rhs);
+  }
+
+  return q->col->colnum < join->left->rd->ncols ? 1 : 2;
+}
+
+/**
+ * @brief Splits the WHERE clause on its top-level ANDs into what only
+ * involves the left table, what only involves the right table, and the rest.
+ * The Qual's AND nodes are freed, the other nodes move to `sides`.
+ */
+static void join_split_qual(Join* join, Qual* q, Qual** sides) {
+  if (q->type == QUAL_AND) {
+    join_split_qual(join, q->lhs, sides);
+    join_split_qual(join, q->rhs, sides);
+
+    q->lhs = NULL;
+    q->rhs = NULL;
+    free_qual(q);
+    return;
+  }
+
+  int side = join_qual_sides(join, q) - 1;
+  sides[side] = qual_and(sides[side], q);
+}
+
+/**
+ * @brief Points the columns of a Qual on the joined rows to the same columns
+ * of one of the tables, whose first column is at `offset`
+ */
+static void join_rebase_qual(Qual* q, RecordDescriptor* rd, int offset) {
+  if (q == NULL) return;
+
+  if (q->col != NULL) q->col = &rd->cols[q->col->colnum - offset];
+
+  join_rebase_qual(q->lhs, rd, offset);
+  join_rebase_qual(q->rhs, rd, offset);
+}
+
+static uint64_t join_hash_key(JoinSide* side, RecordSetRow* row) {
+  Datum d = row->values[side->key->colnum];
+
+  if (join_is_string(side->key->dataType)) {
+    char* str = datumGetString(d);
+    return qual_hash_string(str, strlen(str));
+  }
+
+  return qual_hash_int(indexam_datum_to_key(side->key->dataType, d));
+}
+
+static bool join_keys_equal(JoinSide* a, RecordSetRow* ra, JoinSide* b, RecordSetRow* rb) {
+  Datum da = ra->values[a->key->colnum];
+  Datum db = rb->values[b->key->colnum];
+
+  if (join_is_string(a->key->dataType)) {
+    return strcmp(datumGetString(da), datumGetString(db)) == 0;
+  }
+
+  return indexam_datum_to_key(a->key->dataType, da) == indexam_datum_to_key(b->key->dataType, db);
+}
+
+/* spill partitions are picked with bits 32-39 of the hash, in-memory ones
+   with bits 48-57 and buckets with the low half, so a spilled partition
+   still splits into in-memory partitions */
+static uint32_t join_spill_partition_of(uint64_t hash, uint32_t numPartitions) {
+  return (hash >> 32) & (numPartitions - 1);
+}
+
+static uint32_t join_partition_of(uint64_t hash, uint32_t numPartitions) {
+  return (hash >> 48) & (numPartitions - 1);
+}
+
+static void join_input_init(JoinInput* in, JoinSide* side, uint32_t numPartitions, bool keepHashes) {
+  memset(in, 0, sizeof(JoinInput));
+  in->side = side;
+  in->numPartitions = numPartitions;
+  in->keepHashes = keepHashes;
+}
+
+static void free_join_input(JoinInput* in) {
+  for (size_t i = 0; i < in->numEntries; i++) {
+    free_recordset_row(in->entries[i].row, in->side->td->rd);
+  }
+  free(in->entries);
+
+  if (in->files != NULL) {
+    for (uint32_t p = 0; p < in->numPartitions; p++) {
+      if (in->files[p] != NULL) fclose(in->files[p]);
+    }
+    free(in->files);
+  }
+
+  if (in->hashes != NULL) fclose(in->hashes);
+}
+
+static void join_input_append(JoinInput* in, uint64_t hash, RecordSetRow* row) {
+  if (in->numEntries == in->maxEntries) {
+    in->maxEntries = in->maxEntries == 0 ? 64 : in->maxEntries * 2;
+    in->entries = realloc(in->entries, sizeof(JoinEntry) * in->maxEntries);
+  }
+
+  in->entries[in->numEntries].hash = hash;
+  in->entries[in->numEntries].row = row;
+  in->numEntries++;
+  in->memUsed += sizeof(JoinEntry) + recordset_row_size(row, in->side->td->rd);
+}
+
+/**
+ * @brief Hashes the join key of a row and adds it to the input. Rows with a
+ * NULL key are freed instead, they can't match anything.
+ *
+ * @return false if the row was dropped
+ */
+static bool join_input_add(JoinInput* in, RecordSetRow* row) {
+  if (row->isnull[in->side->key->colnum]) {
+    free_recordset_row(row, in->side->td->rd);
+    return false;
+  }
+
+  join_input_append(in, join_hash_key(in->side, row), row);
+  return true;
+}
+
+/**
+ * @brief Writes the rows collected so far to the temporary file of their
+ * partition, creating the files on the first call, and frees them
+ *
+ * @return false if a file couldn't be created or written
+ */
+static bool join_input_spill(JoinInput* in) {
+  if (in->files == NULL) {
+    in->files = calloc(in->numPartitions, sizeof(FILE*));
+
+    for (uint32_t p = 0; p < in->numPartitions && !in->failed; p++) {
+      in->files[p] = tmpfile();
+      in->failed = in->files[p] == NULL;
+    }
+
+    if (in->keepHashes && !in->failed) {
+      in->hashes = tmpfile();
+      in->failed = in->hashes == NULL;
+    }
+  }
+
+  for (size_t i = 0; i < in->numEntries; i++) {
+    JoinEntry* e = &in->entries[i];
+    FILE* fp = in->files[join_spill_partition_of(e->hash, in->numPartitions)];
+
+    if (!in->failed) {
+      in->failed = fwrite(&e->hash, sizeof(uint64_t), 1, fp) != 1
+        || !recordset_row_write(fp, e->row, in->side->td->rd)
+        || (in->hashes != NULL && fwrite(&e->hash, sizeof(uint64_t), 1, in->hashes) != 1);
+    }
+    free_recordset_row(e->row, in->side->td->rd);
+  }
+
+  in->numSpilled += in->numEntries;
+  in->numEntries = 0;
+  in->memUsed = 0;
+
+  return !in->failed;
+}
+
+/**
+ * @brief TableamRowFunc that adds the rows to a JoinInput, spilling them to
+ * its partition files whenever they take up more than WORK_MEM. Stops the
+ * scan if that fails.
+ */
+static bool join_collect_row(void* arg, RecordSetRow* row) {
+  JoinInput* in = arg;
+
+  if (join_input_add(in, row) && in->memUsed > (size_t)conf->workMem * 1024) {
+    return join_input_spill(in);
+  }
+
+  return true;
+}
+
+/**
+ * @brief Reads back the rows of a spilled partition
+ *
+ * @param memUsed returns about how many bytes the rows take up
+ * @return JoinEntry* `*n` entries
+ */
+static JoinEntry* join_read_entries(JoinSide* side, FILE* fp, size_t* n, size_t* memUsed, bool* success) {
+  size_t maxEntries = 64;
+  JoinEntry* entries = malloc(sizeof(JoinEntry) * maxEntries);
+  uint64_t hash;
+  *n = 0;
+  *memUsed = 0;
+
+  rewind(fp);
+
+  while (fread(&hash, sizeof(uint64_t), 1, fp) == 1) {
+    RecordSetRow* row = recordset_row_read(fp, side->td->rd);
+    if (row == NULL) {
+      *success = false;
+      break;
+    }
+
+    if (*n == maxEntries) {
+      maxEntries *= 2;
+      entries = realloc(entries, sizeof(JoinEntry) * maxEntries);
+    }
+
+    entries[*n].hash = hash;
+    entries[*n].row = row;
+    (*n)++;
+    *memUsed += sizeof(JoinEntry) + recordset_row_size(row, side->td->rd);
+  }
+
+  return entries;
+}
+
+/**
+ * @brief Bloom filter of the join keys of the build side, from the rows it
+ * kept in memory and the hashes it spilled
+ */
+static Qual* join_build_bloom(JoinInput* in, Column* key) {
+  Qual* bloom = qual_new_bloom(key, in->numSpilled + in->numEntries);
+  uint64_t hashes[512];
+  size_t n;
+
+  for (size_t i = 0; i < in->numEntries; i++) qual_bloom_add(bloom, in->entries[i].hash);
+
+  if (in->hashes != NULL) {
+    rewind(in->hashes);
+
+    while ((n = fread(hashes, sizeof(uint64_t), 512, in->hashes)) > 0) {
+      for (size_t i = 0; i < n; i++) qual_bloom_add(bloom, hashes[i]);
+    }
+  }
+
+  return bloom;
+}
+
+/**
+ * @brief Reorders the entries by partition. `starts[p]` returns the index
+ * of the first entry of partition p, `starts[numPartitions]` is n.
+ */
+static void join_partition_entries(JoinEntry* entries, size_t n, uint32_t numPartitions, size_t* starts) {
+  JoinEntry* tmp = malloc(sizeof(JoinEntry) * (n + 1));
+  size_t* offsets = calloc(numPartitions + 1, sizeof(size_t));
+
+  for (size_t i = 0; i < n; i++) offsets[join_partition_of(entries[i].hash, numPartitions) + 1]++;
+  for (uint32_t p = 0; p < numPartitions; p++) offsets[p + 1] += offsets[p];
+
+  memcpy(starts, offsets, sizeof(size_t) * (numPartitions + 1));
+
+  for (size_t i = 0; i < n; i++) tmp[offsets[join_partition_of(entries[i].hash, numPartitions)]++] = entries[i];
+
+  /* a side that never got a row has no entries array */
+  if (n > 0) memcpy(entries, tmp, sizeof(JoinEntry) * n);
+
+  free(tmp);
+  free(offsets);
+}
+
+/**
+ * @brief Builds the hash table of the build rows, in partitions of about
+ * JOIN_PARTITION_BYTES. The table takes over the entries.
+ */
+static void join_table_build(JoinTable* t, JoinEntry* entries, size_t n, size_t memUsed) {
+  t->entries = entries;
+  t->numEntries = n;
+  t->memUsed = memUsed;
+
+  t->numPartitions = 1;
+  while (t->numPartitions < JOIN_MAX_PARTITIONS && memUsed / t->numPartitions > JOIN_PARTITION_BYTES) t->numPartitions *= 2;
+
+  t->starts = malloc(sizeof(size_t) * (t->numPartitions + 1));
+  t->bucketStarts = malloc(sizeof(size_t) * (t->numPartitions + 1));
+  join_partition_entries(entries, n, t->numPartitions, t->starts);
+
+  t->bucketStarts[0] = 0;
+  for (uint32_t p = 0; p < t->numPartitions; p++) {
+    size_t numBuckets = 1;
+    while (numBuckets < t->starts[p + 1] - t->starts[p]) numBuckets *= 2;
+    t->bucketStarts[p + 1] = t->bucketStarts[p] + numBuckets;
+  }
+
+  t->heads = malloc(sizeof(int32_t) * t->bucketStarts[t->numPartitions]);
+  t->next = malloc(sizeof(int32_t) * (n + 1));
+  memset(t->heads, 0xFF, sizeof(int32_t) * t->bucketStarts[t->numPartitions]);
+
+  for (uint32_t p = 0; p < t->numPartitions; p++) {
+    int32_t* heads = t->heads + t->bucketStarts[p];
+    size_t mask = t->bucketStarts[p + 1] - t->bucketStarts[p] - 1;
+
+    for (size_t i = t->starts[p]; i < t->starts[p + 1]; i++) {
+      uint32_t bucket = entries[i].hash & mask;
+      t->next[i] = heads[bucket];
+      heads[bucket] = i;
+    }
+  }
+}
+
+static void free_join_table(JoinTable* t, JoinSide* side) {
+  for (size_t i = 0; i < t->numEntries; i++) {
+    free_recordset_row(t->entries[i].row, side->td->rd);
+  }
+
+  free(t->entries);
+  free(t->starts);
+  free(t->bucketStarts);
+  free(t->heads);
+  free(t->next);
+}
+
+static void join_probe_init(JoinProbe* jp, Join* join, JoinSide* build, JoinSide* probe, Qual* residual, TableamRowFunc fn, void* arg) {
+  jp->join = join;
+  jp->sides[0] = build;
+  jp->sides[1] = probe;
+  jp->table = NULL;
+  join_input_init(&jp->batch, probe, 1, false);
+  jp->maxMem = 0;
+  jp->residual = residual;
+  jp->values = malloc(sizeof(Datum) * join->rd->ncols);
+  jp->isnull = malloc(sizeof(bool) * join->rd->ncols);
+  jp->fn = fn;
+  jp->arg = arg;
+  jp->stopped = false;
+}
+
+static void free_join_probe(JoinProbe* jp) {
+  free_join_input(&jp->batch);
+  free(jp->values);
+  free(jp->isnull);
+}
+
+/**
+ * @brief Probes with the build rows of `t` from now on. A batch of probe
+ * rows gets what's left of WORK_MEM, and at least a partition's worth.
+ */
+static void join_probe_set_table(JoinProbe* jp, JoinTable* t) {
+  size_t workMem = (size_t)conf->workMem * 1024;
+
+  jp->table = t;
+  jp->maxMem = workMem > t->memUsed + JOIN_PARTITION_BYTES ? workMem - t->memUsed : JOIN_PARTITION_BYTES;
+}
+
+/**
+ * @brief Hands the joined row of a build row and a probe row to `jp->fn`,
+ * if it satisfies the rest of the WHERE clause
+ *
+ * @return false if `fn` wants no more rows
+ */
+static bool join_emit(JoinProbe* jp, RecordSetRow* rows[2]) {
+  Join* join = jp->join;
+
+  for (int s = 0; s < 2; s++) {
+    RecordDescriptor* rd = jp->sides[s]->td->rd;
+    memcpy(jp->values + jp->sides[s]->offset, rows[s]->values, rd->ncols * sizeof(Datum));
+    memcpy(jp->isnull + jp->sides[s]->offset, rows[s]->isnull, rd->ncols * sizeof(bool));
+  }
+
+  if (jp->residual != NULL && !qual_eval_row(jp->residual, jp->values, jp->isnull)) return true;
+
+  RecordSetRow* row = new_recordset_row(NULL, join->rd->ncols);
+  for (int i = 0; i < join->rd->ncols; i++) {
+    row->isnull[i] = jp->isnull[i];
+    row->values[i] = jp->values[i];
+
+    /* the joined row owns its strings */
+    if (join_is_string(join->rd->cols[i].dataType)) {
+      row->values[i] = jp->isnull[i] || jp->values[i] == 0 ? 0 : charGetDatum(strdup(datumGetString(jp->values[i])));
+    }
+  }
+
+  return jp->fn(jp->arg, row);
+}
+
+/**
+ * @brief Joins the current batch of probe rows with the hash table, one
+ * partition at a time, and frees them
+ */
+static void join_probe_batch(JoinProbe* jp) {
+  JoinTable* t = jp->table;
+  JoinInput* batch = &jp->batch;
+  size_t* starts = malloc(sizeof(size_t) * (t->numPartitions + 1));
+  RecordSetRow* rows[2];
+
+  join_partition_entries(batch->entries, batch->numEntries, t->numPartitions, starts);
+
+  for (uint32_t p = 0; p < t->numPartitions && !jp->stopped; p++) {
+    int32_t* heads = t->heads + t->bucketStarts[p];
+    size_t mask = t->bucketStarts[p + 1] - t->bucketStarts[p] - 1;
+
+    if (t->starts[p] == t->starts[p + 1]) continue;
+
+    for (size_t i = starts[p]; i < starts[p + 1] && !jp->stopped; i++) {
+      uint64_t hash = batch->entries[i].hash;
+      rows[1] = batch->entries[i].row;
+
+      for (int32_t b = heads[hash & mask]; b >= 0 && !jp->stopped; b = t->next[b]) {
+        if (t->entries[b].hash != hash) continue;
+        if (!join_keys_equal(jp->sides[0], t->entries[b].row, jp->sides[1], rows[1])) continue;
+
+        rows[0] = t->entries[b].row;
+        jp->stopped = !join_emit(jp, rows);
+      }
+    }
+  }
+
+  for (size_t i = 0; i < batch->numEntries; i++) {
+    free_recordset_row(batch->entries[i].row, jp->sides[1]->td->rd);
+  }
+  batch->numEntries = 0;
+  batch->memUsed = 0;
+
+  free(starts);
+}
+
+/**
+ * @brief TableamRowFunc that joins the probe rows with the hash table as
+ * they come, a batch at a time
+ */
+static bool join_probe_row(void* arg, RecordSetRow* row) {
+  JoinProbe* jp = arg;
+
+  if (join_input_add(&jp->batch, row) && jp->batch.memUsed > jp->maxMem) {
+    join_probe_batch(jp);
+  }
+
+  return !jp->stopped;
+}
+
+/**
+ * @brief Joins the probe rows of a spilled partition with the hash table,
+ * reading them back a batch at a time
+ */
+static bool join_probe_file(JoinProbe* jp, FILE* fp) {
+  uint64_t hash;
+
+  rewind(fp);
+
+  while (!jp->stopped && fread(&hash, sizeof(uint64_t), 1, fp) == 1) {
+    RecordSetRow* row = recordset_row_read(fp, jp->sides[1]->td->rd);
+    if (row == NULL) return false;
+
+    join_input_append(&jp->batch, hash, row);
+    if (jp->batch.memUsed > jp->maxMem) join_probe_batch(jp);
+  }
+
+  join_probe_batch(jp);
+
+  return true;
+}
+
+/**
+ * @brief Second half of a Grace hash join, once the build side has spilled:
+ * the probe side is spilled to the same partitions, then each pair of
+ * partitions is joined in memory
+ */
+static bool join_grace(BufMgr* buf, JoinProbe* jp, JoinInput* build) {
+  JoinSide* probe = jp->sides[1];
+  JoinInput in;
+  bool success = true;
+
+  join_input_init(&in, probe, build->numPartitions, false);
+  tableam_scan_rows(buf, probe->td, probe->qual, join_collect_row, &in);
+
+  if (!join_input_spill(&in)) {
+    printf("Unable to write a JOIN spill file\n");
+    free_join_input(&in);
+    return false;
+  }
+
+  for (uint32_t p = 0; p < build->numPartitions && success && !jp->stopped; p++) {
+    JoinTable table;
+    size_t n, memUsed;
+    JoinEntry* entries = join_read_entries(build->side, build->files[p], &n, &memUsed, &success);
+
+    join_table_build(&table, entries, n, memUsed);
+    join_probe_set_table(jp, &table);
+
+    if (success && n > 0) success = join_probe_file(jp, in.files[p]);
+    if (!success) printf("Unable to read a JOIN spill file\n");
+
+    free_join_table(&table, build->side);
+  }
+
+  free_join_input(&in);
+
+  return success;
+}
+
+/**
+ * @brief Runs the join, handing the joined rows to `fn` as they're made
+ *
+ * @details The build side is hashed as its scan hands the rows over. Once
+ * they take up more than WORK_MEM they're written to the temporary files of
+ * their partitions, and so is every row that comes after. If the build side
+ * fits, the probe rows are joined with it as their scan hands them over, a
+ * batch at a time. If it doesn't, the probe side is spilled to the same
+ * partitions and the partitions are joined one pair at a time. Either way,
+ * neither table is ever held in memory past WORK_MEM.
+ *
+ * @param buf
+ * @param join
+ * @param qual WHERE clause compiled against `join->rd`, NULL for none. The
+ * join takes it over.
+ * @param fn gets each joined row, described by `join->rd`. Returning false
+ * stops the join.
+ * @param arg the first argument of `fn`
+ * @return false if the join had to spill and that failed
+ */
+bool join_execute(BufMgr* buf, Join* join, Qual* qual, TableamRowFunc fn, void* arg) {
+  Qual* sideQuals[3] = { NULL, NULL, NULL };
+  if (qual != NULL) join_split_qual(join, qual, sideQuals);
+
+  JoinSide left = { join->left, join->leftKey, 0, sideQuals[0] };
+  JoinSide right = { join->right, join->rightKey, join->left->rd->ncols, sideQuals[1] };
+  join_rebase_qual(left.qual, left.td->rd, left.offset);
+  join_rebase_qual(right.qual, right.td->rd, right.offset);
+
+  uint32_t leftPages = tableam_count_pages(buf, join->left);
+  uint32_t rightPages = tableam_count_pages(buf, join->right);
+  JoinSide* build = leftPages <= rightPages ? &left : &right;
+  JoinSide* probe = leftPages <= rightPages ? &right : &left;
+
+  /* enough spill partitions for each one's build rows to fit in half of
+     WORK_MEM, going by the size of the table on disk */
+  size_t buildBytes = (size_t)(leftPages <= rightPages ? leftPages : rightPages) * conf->pageSize;
+  size_t workMem = (size_t)conf->workMem * 1024;
+  uint32_t numPartitions = 2;
+  while (numPartitions < JOIN_MAX_SPILL_PARTITIONS && buildBytes / numPartitions > workMem / 2) numPartitions *= 2;
+
+  JoinInput in;
+  join_input_init(&in, build, numPartitions, true);
+  tableam_scan_rows(buf, build->td, build->qual, join_collect_row, &in);
+
+  /* once part of the build side has spilled, all of it goes to disk */
+  if (in.files != NULL) join_input_spill(&in);
+
+  /* only the probe rows whose key may be on the build side come out of the scan */
+  probe->qual = qual_and(probe->qual, join_build_bloom(&in, probe->key));
+
+  JoinProbe jp;
+  join_probe_init(&jp, join, build, probe, sideQuals[2], fn, arg);
+  bool success = !in.failed;
+
+  if (!success) {
+    printf("Unable to write a JOIN spill file\n");
+  } else if (in.files == NULL) {
+    JoinTable table;
+    join_table_build(&table, in.entries, in.numEntries, in.memUsed);
+    join_probe_set_table(&jp, &table);
+
+    /* the table owns the rows now */
+    in.entries = NULL;
+    in.numEntries = 0;
+
+    tableam_scan_rows(buf, probe->td, probe->qual, join_probe_row, &jp);
+    join_probe_batch(&jp);
+
+    free_join_table(&table, build);
+  } else {
+    success = join_grace(buf, &jp, &in);
+  }
+
+  free_join_probe(&jp);
+  free_join_input(&in);
+  free_qual(left.qual);
+  free_qual(right.qual);
+  free_qual(sideQuals[2]);
+
+  return success;
+}
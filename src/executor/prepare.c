@@ -0,0 +1,195 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "executor/prepare.h"
+
+/* the prepared statements of the session */
+static PreparedStmt** prepared = NULL;
+static int numPrepared = 0;
+static int maxPrepared = 0;
+
+/**
+ * @brief Finds the parameters ($n) of a statement or expression
+ *
+ * @param n
+ * @param params if not NULL, returns the parameter Literals in the order
+ * they appear
+ * @return int the number of parameters found
+ */
+int prepare_collect_params(Node* n, Literal** params) {
+  int numRefs = 0;
+
+  if (n == NULL) return 0;
+
+  switch (n->type) {
+    case T_Literal:
+      if (((Literal*)n)->paramNum == 0) return 0;
+      if (params != NULL) params[0] = (Literal*)n;
+      return 1;
+    case T_BinaryExpr:
+      return prepare_collect_params(((BinaryExpr*)n)->rhs, params);
+    case T_BoolExpr:
+      numRefs = prepare_collect_params(((BoolExpr*)n)->lhs, params);
+      return numRefs + prepare_collect_params(((BoolExpr*)n)->rhs, params == NULL ? NULL : params + numRefs);
+    case T_ParseList: {
+      ParseList* l = (ParseList*)n;
+      for (int i = 0; i < l->length; i++) {
+        numRefs += prepare_collect_params(l->elements[i].ptr, params == NULL ? NULL : params + numRefs);
+      }
+      return numRefs;
+    }
+    case T_SelectStmt:
+      return prepare_collect_params(((SelectStmt*)n)->whereClause, params);
+    case T_InsertStmt:
+      return prepare_collect_params((Node*)((InsertStmt*)n)->rows, params);
+    case T_ExecuteStmt:
+      return prepare_collect_params((Node*)((ExecuteStmt*)n)->params, params);
+    default:
+      return 0;
+  }
+}
+
+/**
+ * @brief Creates a prepared statement that is yet to be planned, taking
+ * over `name` and `stmt`
+ */
+PreparedStmt* new_preparedstmt(char* name, Node* stmt) {
+  PreparedStmt* p = malloc(sizeof(PreparedStmt));
+  p->name = name;
+  p->stmt = stmt;
+  p->numRefs = prepare_collect_params(stmt, NULL);
+  p->params = malloc(sizeof(Literal*) * (p->numRefs + 1));
+  prepare_collect_params(stmt, p->params);
+
+  p->numParams = 0;
+  for (int i = 0; i < p->numRefs; i++) {
+    if (p->params[i]->paramNum > p->numParams) p->numParams = p->params[i]->paramNum;
+  }
+
+  p->td = NULL;
+  p->joinTd = NULL;
+  p->join = NULL;
+  p->idx = NULL;
+  p->planned = false;
+
+  return p;
+}
+
+void free_preparedstmt(PreparedStmt* p) {
+  if (p == NULL) return;
+
+  free(p->name);
+  free_node(p->stmt);
+  free(p->params);
+  free_indexdesc(p->idx);
+  free_join(p->join);
+  free_tabledesc(p->joinTd);
+  free_tabledesc(p->td);
+  free(p);
+}
+
+static int prepare_index_of(char* name) {
+  for (int i = 0; i < numPrepared; i++) {
+    if (strcasecmp(prepared[i]->name, name) == 0) return i;
+  }
+
+  return -1;
+}
+
+/**
+ * @brief Keeps `p` for EXECUTE
+ *
+ * @param p
+ * @return true
+ * @return false if there already is a prepared statement with its name
+ */
+bool prepare_add(PreparedStmt* p) {
+  if (prepare_index_of(p->name) >= 0) return false;
+
+  if (numPrepared == maxPrepared) {
+    maxPrepared = maxPrepared == 0 ? 8 : maxPrepared * 2;
+    prepared = realloc(prepared, sizeof(PreparedStmt*) * maxPrepared);
+  }
+
+  prepared[numPrepared++] = p;
+
+  return true;
+}
+
+PreparedStmt* prepare_find(char* name) {
+  int i = prepare_index_of(name);
+
+  return i < 0 ? NULL : prepared[i];
+}
+
+/**
+ * @brief Frees the prepared statement called `name`. Returns false if
+ * there is none.
+ */
+bool prepare_drop(char* name) {
+  int i = prepare_index_of(name);
+  if (i < 0) return false;
+
+  free_preparedstmt(prepared[i]);
+  prepared[i] = prepared[--numPrepared];
+
+  return true;
+}
+
+void prepare_drop_all() {
+  for (int i = 0; i < numPrepared; i++) free_preparedstmt(prepared[i]);
+
+  free(prepared);
+  prepared = NULL;
+  numPrepared = 0;
+  maxPrepared = 0;
+}
+
+/**
+ * @brief Marks the plans that read or insert into `tablename` as stale,
+ * e.g. because it has a new index
+ */
+void prepare_invalidate(char* tablename) {
+  for (int i = 0; i < numPrepared; i++) {
+    PreparedStmt* p = prepared[i];
+
+    if ((p->td != NULL && strcasecmp(p->td->tablename, tablename) == 0)
+        || (p->joinTd != NULL && strcasecmp(p->joinTd->tablename, tablename) == 0)) {
+      p->planned = false;
+    }
+  }
+}
+
+/**
+ * @brief Binds the values of an EXECUTE to the parameters of `p`, $n
+ * taking the n-th value. The values must be constants.
+ *
+ * @param p
+ * @param values Literals, NULL if there are none
+ * @return true
+ * @return false if the number of values doesn't match the parameters
+ */
+bool prepare_bind(PreparedStmt* p, ParseList* values) {
+  int numValues = values == NULL ? 0 : values->length;
+
+  if (numValues != p->numParams) {
+    printf("%s takes %d parameters, %d given\n", p->name, p->numParams, numValues);
+    return false;
+  }
+
+  for (int i = 0; i < p->numRefs; i++) {
+    Literal* param = p->params[i];
+    Literal* value = (Literal*)values->elements[param->paramNum - 1].ptr;
+
+    if (param->str != NULL) free(param->str);
+
+    param->isNull = value->isNull;
+    param->intVal = value->intVal;
+    param->boolVal = value->boolVal;
+    param->str = value->str == NULL ? NULL : strdup(value->str);
+  }
+
+  return true;
+}
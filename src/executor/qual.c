@@ -0,0 +1,444 @@
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdio.h>
+
+#include "executor/qual.h"
+#include "access/indexam.h"
+
+/* bits set in a QUAL_BLOOM filter for each value */
+#define QUAL_BLOOM_HASHES 3
+
+/* bits per value in a QUAL_BLOOM filter, for about 0.5% false positives */
+#define QUAL_BLOOM_BITS_PER_VALUE 16
+
+/* largest QUAL_BLOOM filter, in bits (16MB) */
+#define QUAL_BLOOM_MAX_BITS (1U << 27)
+
+static Column* qual_get_column(RecordDescriptor* rd, char* colname) {
+  for (int i = 0; i < rd->ncols; i++) {
+    if (strcasecmp(rd->cols[i].colname, colname) == 0) return &rd->cols[i];
+  }
+
+  return NULL;
+}
+
+static Qual* qual_compile_compare(RecordDescriptor* rd, BinaryExpr* e) {
+  Column* col = qual_get_column(rd, ((ColumnRef*)e->lhs)->name);
+  if (col == NULL) {
+    printf("Column %s does not exist\n", ((ColumnRef*)e->lhs)->name);
+    return NULL;
+  }
+
+  Literal* l = (Literal*)e->rhs;
+  bool isString = col->dataType == DT_CHAR || col->dataType == DT_VARCHAR;
+
+  if (!l->isNull && isString && l->str == NULL) {
+    printf("Can't compare %s with a value that isn't a string, %s is a string column\n", col->colname, col->colname);
+    return NULL;
+  }
+
+  if (!l->isNull && !isString && l->str != NULL) {
+    printf("Can't compare %s with '%s', %s isn't a string column\n", col->colname, l->str, col->colname);
+    return NULL;
+  }
+
+  Qual* q = calloc(1, sizeof(Qual));
+  q->type = QUAL_COMPARE;
+  q->col = col;
+  q->op = e->op;
+
+  switch (col->dataType) {
+    case DT_CHAR:
+    case DT_VARCHAR:
+      q->neverTrue = l->isNull;
+      q->str = l->str;
+      q->strLen = l->str == NULL ? 0 : strlen(l->str);
+      break;
+    case DT_BOOL:
+      q->neverTrue = l->isNull;
+      q->intVal = l->boolVal;
+      break;
+    default:
+      q->neverTrue = l->isNull;
+      q->intVal = l->intVal;
+  }
+
+  return q;
+}
+
+/**
+ * @brief Compiles the expression tree of a WHERE clause against the columns
+ * of a table
+ *
+ * @param rd
+ * @param expr
+ * @return Qual* NULL if the expression refers to a column that doesn't exist
+ * or compares a column with a value of the wrong type, which is printed
+ */
+Qual* qual_compile(RecordDescriptor* rd, Node* expr) {
+  switch (expr->type) {
+    case T_BinaryExpr:
+      return qual_compile_compare(rd, (BinaryExpr*)expr);
+    case T_BoolExpr: {
+      BoolExpr* b = (BoolExpr*)expr;
+      Qual* lhs = qual_compile(rd, b->lhs);
+      Qual* rhs = lhs == NULL ? NULL : qual_compile(rd, b->rhs);
+
+      if (rhs == NULL) {
+        free_qual(lhs);
+        return NULL;
+      }
+
+      Qual* q = calloc(1, sizeof(Qual));
+      q->type = b->boolop == BOOL_AND ? QUAL_AND : QUAL_OR;
+      q->lhs = lhs;
+      q->rhs = rhs;
+      return q;
+    }
+    default:
+      printf("qual_compile() | unhandled node type\n");
+  }
+
+  return NULL;
+}
+
+/**
+ * @brief Returns a Qual that is true where both are, either of them if the
+ * other one is NULL
+ */
+Qual* qual_and(Qual* lhs, Qual* rhs) {
+  if (lhs == NULL) return rhs;
+  if (rhs == NULL) return lhs;
+
+  Qual* q = calloc(1, sizeof(Qual));
+  q->type = QUAL_AND;
+  q->lhs = lhs;
+  q->rhs = rhs;
+  return q;
+}
+
+void free_qual(Qual* q) {
+  if (q == NULL) return;
+
+  free_qual(q->lhs);
+  free_qual(q->rhs);
+  free(q->bloom);
+  free(q);
+}
+
+/**
+ * @brief Hash of an integer value for a QUAL_BLOOM (murmur3 finalizer)
+ */
+uint64_t qual_hash_int(int64_t v) {
+  uint64_t h = (uint64_t)v;
+
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+
+  return h;
+}
+
+/**
+ * @brief Hash of a string value for a QUAL_BLOOM (64-bit FNV-1a, then mixed
+ * like qual_hash_int)
+ */
+uint64_t qual_hash_string(char* str, size_t len) {
+  uint64_t h = 0xcbf29ce484222325ULL;
+
+  for (size_t i = 0; i < len; i++) {
+    h ^= (uint8_t)str[i];
+    h *= 0x100000001b3ULL;
+  }
+
+  return qual_hash_int(h);
+}
+
+/**
+ * @brief Creates an empty QUAL_BLOOM on `col`, sized for `numValues`
+ */
+Qual* qual_new_bloom(Column* col, uint32_t numValues) {
+  uint64_t wanted = (uint64_t)numValues * QUAL_BLOOM_BITS_PER_VALUE;
+  uint32_t numBits = 512;
+  while (numBits < wanted && numBits < QUAL_BLOOM_MAX_BITS) numBits *= 2;
+
+  Qual* q = calloc(1, sizeof(Qual));
+  q->type = QUAL_BLOOM;
+  q->col = col;
+  q->bloom = calloc(numBits / 8, 1);
+  q->bloomMask = numBits - 1;
+
+  return q;
+}
+
+/**
+ * @brief The QUAL_BLOOM_HASHES bits of a value, from its hash (double hashing)
+ */
+static void qual_bloom_bits(Qual* q, uint64_t hash, uint32_t* bits) {
+  uint32_t h1 = hash;
+  uint32_t h2 = (hash >> 32) | 1;
+
+  for (int i = 0; i < QUAL_BLOOM_HASHES; i++) {
+    bits[i] = (h1 + i * h2) & q->bloomMask;
+  }
+}
+
+/**
+ * @brief Adds the value with the given hash (qual_hash_int or
+ * qual_hash_string) to the filter
+ */
+void qual_bloom_add(Qual* q, uint64_t hash) {
+  uint32_t bits[QUAL_BLOOM_HASHES];
+  qual_bloom_bits(q, hash, bits);
+
+  for (int i = 0; i < QUAL_BLOOM_HASHES; i++) {
+    q->bloom[bits[i] / 8] |= 1 << (bits[i] % 8);
+  }
+}
+
+static bool qual_bloom_test(Qual* q, uint64_t hash) {
+  uint32_t bits[QUAL_BLOOM_HASHES];
+  qual_bloom_bits(q, hash, bits);
+
+  for (int i = 0; i < QUAL_BLOOM_HASHES; i++) {
+    if (!(q->bloom[bits[i] / 8] & (1 << (bits[i] % 8)))) return false;
+  }
+
+  return true;
+}
+
+/**
+ * @brief sel[i] = values[i] <op> value, 0 where the value is NULL. Each case
+ * is a branch-free loop over plain arrays, so the compiler can vectorize it.
+ */
+static void qual_compare_ints(int64_t* values, uint8_t* isnull, int numRecords, ExprOp op, int64_t value, uint8_t* sel) {
+  switch (op) {
+    case EXPR_EQ:
+      for (int i = 0; i < numRecords; i++) sel[i] = (values[i] == value) & !isnull[i];
+      break;
+    case EXPR_LT:
+      for (int i = 0; i < numRecords; i++) sel[i] = (values[i] < value) & !isnull[i];
+      break;
+    case EXPR_LE:
+      for (int i = 0; i < numRecords; i++) sel[i] = (values[i] <= value) & !isnull[i];
+      break;
+    case EXPR_GT:
+      for (int i = 0; i < numRecords; i++) sel[i] = (values[i] > value) & !isnull[i];
+      break;
+    case EXPR_GE:
+      for (int i = 0; i < numRecords; i++) sel[i] = (values[i] >= value) & !isnull[i];
+      break;
+  }
+}
+
+/**
+ * @brief Same as qual_compare_ints, for strings. Compares like strcmp does.
+ */
+static void qual_compare_strings(char** data, uint16_t* lens, uint8_t* isnull, int numRecords, ExprOp op, char* str, size_t strLen, uint8_t* sel) {
+  for (int i = 0; i < numRecords; i++) {
+    if (isnull[i]) {
+      sel[i] = 0;
+      continue;
+    }
+
+    size_t len = lens[i] < strLen ? lens[i] : strLen;
+    int cmp = memcmp(data[i], str, len);
+    if (cmp == 0) cmp = lens[i] < strLen ? -1 : (lens[i] > strLen ? 1 : 0);
+
+    switch (op) {
+      case EXPR_EQ:
+        sel[i] = cmp == 0;
+        break;
+      case EXPR_LT:
+        sel[i] = cmp < 0;
+        break;
+      case EXPR_LE:
+        sel[i] = cmp <= 0;
+        break;
+      case EXPR_GT:
+        sel[i] = cmp > 0;
+        break;
+      case EXPR_GE:
+        sel[i] = cmp >= 0;
+        break;
+    }
+  }
+}
+
+/**
+ * @brief Number of selection arrays needed to evaluate `q`. The left side of
+ * an AND (OR) writes straight into the caller's array, only the right side
+ * needs one of its own, and that one has to outlive everything below it.
+ */
+static int qual_num_levels(Qual* q) {
+  if (q->type != QUAL_AND && q->type != QUAL_OR) return 0;
+
+  int lhsLevels = qual_num_levels(q->lhs);
+  int rhsLevels = 1 + qual_num_levels(q->rhs);
+
+  return lhsLevels > rhsLevels ? lhsLevels : rhsLevels;
+}
+
+QualScratch* qual_new_scratch(Qual* q) {
+  QualScratch* scratch = malloc(sizeof(QualScratch));
+  scratch->maxRecords = 0;
+  scratch->numLevels = qual_num_levels(q);
+  scratch->isnull = NULL;
+  scratch->values = NULL;
+  scratch->data = NULL;
+  scratch->lens = NULL;
+  scratch->sels = NULL;
+
+  return scratch;
+}
+
+/**
+ * @brief Makes room for batches of up to `numRecords` records
+ */
+void qual_scratch_reserve(QualScratch* scratch, size_t numRecords) {
+  if (numRecords <= scratch->maxRecords) return;
+
+  scratch->maxRecords = numRecords;
+  scratch->isnull = realloc(scratch->isnull, numRecords);
+  scratch->values = realloc(scratch->values, sizeof(int64_t) * numRecords);
+  scratch->data = realloc(scratch->data, sizeof(char*) * numRecords);
+  scratch->lens = realloc(scratch->lens, sizeof(uint16_t) * numRecords);
+  scratch->sels = realloc(scratch->sels, numRecords * scratch->numLevels);
+}
+
+void free_qual_scratch(QualScratch* scratch) {
+  free(scratch->isnull);
+  free(scratch->values);
+  free(scratch->data);
+  free(scratch->lens);
+  free(scratch->sels);
+  free(scratch);
+}
+
+static void qual_eval_bloom(Qual* q, RecordDescriptor* rd, Record* records, int numRecords, uint8_t* sel, QualScratch* scratch) {
+  uint8_t* isnull = scratch->isnull;
+
+  if (q->col->dataType == DT_CHAR || q->col->dataType == DT_VARCHAR) {
+    char** data = scratch->data;
+    uint16_t* lens = scratch->lens;
+
+    record_decode_string_column(rd, records, numRecords, q->col->colnum, data, lens, isnull);
+    for (int i = 0; i < numRecords; i++) {
+      sel[i] = !isnull[i] && qual_bloom_test(q, qual_hash_string(data[i], lens[i]));
+    }
+  } else {
+    int64_t* values = scratch->values;
+
+    record_decode_int_column(rd, records, numRecords, q->col->colnum, values, isnull);
+    for (int i = 0; i < numRecords; i++) {
+      sel[i] = !isnull[i] && qual_bloom_test(q, qual_hash_int(values[i]));
+    }
+  }
+}
+
+static void qual_eval_compare(Qual* q, RecordDescriptor* rd, Record* records, int numRecords, uint8_t* sel, QualScratch* scratch) {
+  if (q->neverTrue) {
+    memset(sel, 0, numRecords);
+    return;
+  }
+
+  if (q->col->dataType == DT_CHAR || q->col->dataType == DT_VARCHAR) {
+    record_decode_string_column(rd, records, numRecords, q->col->colnum, scratch->data, scratch->lens, scratch->isnull);
+    qual_compare_strings(scratch->data, scratch->lens, scratch->isnull, numRecords, q->op, q->str, q->strLen, sel);
+  } else {
+    record_decode_int_column(rd, records, numRecords, q->col->colnum, scratch->values, scratch->isnull);
+    qual_compare_ints(scratch->values, scratch->isnull, numRecords, q->op, q->intVal, sel);
+  }
+}
+
+/**
+ * @brief qual_eval_batch for a node whose right side (if any) may use the
+ * selection arrays from `level` on
+ */
+static void qual_eval_level(Qual* q, RecordDescriptor* rd, Record* records, int numRecords, uint8_t* sel, QualScratch* scratch, int level) {
+  if (q->type == QUAL_COMPARE) {
+    qual_eval_compare(q, rd, records, numRecords, sel, scratch);
+    return;
+  }
+
+  if (q->type == QUAL_BLOOM) {
+    qual_eval_bloom(q, rd, records, numRecords, sel, scratch);
+    return;
+  }
+
+  qual_eval_level(q->lhs, rd, records, numRecords, sel, scratch, level);
+
+  int numSelected = 0;
+  for (int i = 0; i < numRecords; i++) numSelected += sel[i];
+
+  if (q->type == QUAL_AND && numSelected == 0) return;
+  if (q->type == QUAL_OR && numSelected == numRecords) return;
+
+  uint8_t* rhsSel = scratch->sels + scratch->maxRecords * level;
+  qual_eval_level(q->rhs, rd, records, numRecords, rhsSel, scratch, level + 1);
+
+  if (q->type == QUAL_AND) {
+    for (int i = 0; i < numRecords; i++) sel[i] &= rhsSel[i];
+  } else {
+    for (int i = 0; i < numRecords; i++) sel[i] |= rhsSel[i];
+  }
+}
+
+/**
+ * @brief Evaluates the Qual against every record in `records`
+ *
+ * @details The right side of an AND (OR) is skipped when the left side
+ * already rejected (accepted) every record of the batch.
+ *
+ * @param q
+ * @param rd
+ * @param records
+ * @param numRecords
+ * @param sel returns 1 for each record that satisfies the Qual, 0 otherwise
+ * @param scratch from qual_new_scratch(q), with room for `numRecords` records
+ */
+void qual_eval_batch(Qual* q, RecordDescriptor* rd, Record* records, int numRecords, uint8_t* sel, QualScratch* scratch) {
+  if (numRecords == 0) return;
+
+  qual_eval_level(q, rd, records, numRecords, sel, scratch, 0);
+}
+
+/**
+ * @brief Evaluates the Qual against a single materialized row, e.g. a row
+ * that a join put together. `q->col->colnum` indexes `values` and `isnull`.
+ */
+bool qual_eval_row(Qual* q, Datum* values, bool* isnull) {
+  switch (q->type) {
+    case QUAL_AND:
+      return qual_eval_row(q->lhs, values, isnull) && qual_eval_row(q->rhs, values, isnull);
+    case QUAL_OR:
+      return qual_eval_row(q->lhs, values, isnull) || qual_eval_row(q->rhs, values, isnull);
+    default:
+      break;
+  }
+
+  int colnum = q->col->colnum;
+  bool isString = q->col->dataType == DT_CHAR || q->col->dataType == DT_VARCHAR;
+  uint8_t sel = 0;
+  uint8_t null = 0;
+
+  if (isnull[colnum] || (q->type == QUAL_COMPARE && q->neverTrue)) return false;
+
+  if (isString) {
+    char* str = datumGetString(values[colnum]);
+    uint16_t len = strnlen(str, q->col->len);
+
+    if (q->type == QUAL_BLOOM) return qual_bloom_test(q, qual_hash_string(str, len));
+    qual_compare_strings(&str, &len, &null, 1, q->op, q->str, q->strLen, &sel);
+  } else {
+    int64_t v = indexam_datum_to_key(q->col->dataType, values[colnum]);
+
+    if (q->type == QUAL_BLOOM) return qual_bloom_test(q, qual_hash_int(v));
+    qual_compare_ints(&v, &null, 1, q->op, q->intVal, &sel);
+  }
+
+  return sel;
+}
@@ -0,0 +1,207 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "executor/scheduler.h"
+
+typedef struct SchedThread {
+  Scheduler* sched;
+  int workerId;
+} SchedThread;
+
+static void scheduler_push(SchedDeque* dq, SchedTask task) {
+  pthread_mutex_lock(&dq->lock);
+
+  if (dq->head == dq->tail) {
+    dq->head = 0;
+    dq->tail = 0;
+  }
+
+  if (dq->tail == dq->capacity) {
+    dq->capacity = dq->capacity == 0 ? 16 : dq->capacity * 2;
+    dq->tasks = realloc(dq->tasks, sizeof(SchedTask) * dq->capacity);
+  }
+
+  dq->tasks[dq->tail++] = task;
+
+  pthread_mutex_unlock(&dq->lock);
+}
+
+/**
+ * @brief Takes a task off the bottom of the deque if `own`, off the top
+ * otherwise. Returns false if the deque is empty.
+ */
+static bool scheduler_pop(SchedDeque* dq, bool own, SchedTask* task) {
+  bool found = false;
+
+  pthread_mutex_lock(&dq->lock);
+
+  if (dq->head < dq->tail) {
+    *task = own ? dq->tasks[--dq->tail] : dq->tasks[dq->head++];
+    found = true;
+  }
+
+  pthread_mutex_unlock(&dq->lock);
+
+  return found;
+}
+
+/**
+ * @brief Finds a task for the worker: the next one of its own deque, or
+ * the oldest one of the first other deque that has any
+ */
+static bool scheduler_take(Scheduler* sched, int workerId, SchedTask* task) {
+  bool found = false;
+
+  for (int i = 0; i < sched->numWorkers && !found; i++) {
+    int victim = (workerId + i) % sched->numWorkers;
+    found = scheduler_pop(&sched->deques[victim], i == 0, task);
+  }
+
+  if (found) {
+    pthread_mutex_lock(&sched->lock);
+    sched->queued--;
+    pthread_mutex_unlock(&sched->lock);
+  }
+
+  return found;
+}
+
+/**
+ * @brief Runs tasks until there are none left to take
+ */
+static void scheduler_work(Scheduler* sched, int workerId) {
+  SchedTask task;
+
+  while (scheduler_take(sched, workerId, &task)) {
+    task.fn(task.arg, workerId);
+
+    pthread_mutex_lock(&sched->lock);
+    if (--sched->pending == 0) pthread_cond_broadcast(&sched->done);
+    pthread_mutex_unlock(&sched->lock);
+  }
+}
+
+static void* scheduler_thread_main(void* arg) {
+  Scheduler* sched = ((SchedThread*)arg)->sched;
+  int workerId = ((SchedThread*)arg)->workerId;
+  free(arg);
+
+  while (true) {
+    scheduler_work(sched, workerId);
+
+    pthread_mutex_lock(&sched->lock);
+    while (sched->queued == 0 && !sched->shutdown) pthread_cond_wait(&sched->wake, &sched->lock);
+    bool stop = sched->shutdown;
+    pthread_mutex_unlock(&sched->lock);
+
+    if (stop) break;
+  }
+
+  return NULL;
+}
+
+/**
+ * @brief Starts the pool threads. If some of them can't be started, the
+ * scheduler makes do with fewer workers.
+ *
+ * @param numWorkers including the thread that will call scheduler_run
+ * @return Scheduler*
+ */
+Scheduler* scheduler_create(int numWorkers) {
+  Scheduler* sched = malloc(sizeof(Scheduler));
+  sched->numWorkers = numWorkers < 1 ? 1 : numWorkers;
+  sched->threads = calloc(sched->numWorkers, sizeof(pthread_t));
+  sched->deques = calloc(sched->numWorkers, sizeof(SchedDeque));
+  pthread_mutex_init(&sched->lock, NULL);
+  pthread_cond_init(&sched->wake, NULL);
+  pthread_cond_init(&sched->done, NULL);
+  sched->queued = 0;
+  sched->pending = 0;
+  sched->shutdown = false;
+
+  for (int i = 0; i < sched->numWorkers; i++) {
+    pthread_mutex_init(&sched->deques[i].lock, NULL);
+  }
+
+  for (int i = 1; i < sched->numWorkers; i++) {
+    SchedThread* t = malloc(sizeof(SchedThread));
+    t->sched = sched;
+    t->workerId = i;
+
+    if (pthread_create(&sched->threads[i], NULL, scheduler_thread_main, t) != 0) {
+      printf("Unable to start worker thread %d, running with %d workers\n", i, i);
+      free(t);
+
+      /* no task has been queued yet, so no worker looks at numWorkers */
+      pthread_mutex_lock(&sched->lock);
+      sched->numWorkers = i;
+      pthread_mutex_unlock(&sched->lock);
+      break;
+    }
+  }
+
+  return sched;
+}
+
+void scheduler_destroy(Scheduler* sched) {
+  if (sched == NULL) return;
+
+  pthread_mutex_lock(&sched->lock);
+  sched->shutdown = true;
+  pthread_cond_broadcast(&sched->wake);
+  pthread_mutex_unlock(&sched->lock);
+
+  for (int i = 1; i < sched->numWorkers; i++) {
+    pthread_join(sched->threads[i], NULL);
+  }
+
+  for (int i = 0; i < sched->numWorkers; i++) {
+    pthread_mutex_destroy(&sched->deques[i].lock);
+    free(sched->deques[i].tasks);
+  }
+
+  pthread_mutex_destroy(&sched->lock);
+  pthread_cond_destroy(&sched->wake);
+  pthread_cond_destroy(&sched->done);
+  free(sched->deques);
+  free(sched->threads);
+  free(sched);
+}
+
+/**
+ * @brief Runs `fn` once for each of the `numTasks` arguments in `args`, an
+ * array of `argSize`-byte elements, and waits for all of them to finish
+ *
+ * @param sched
+ * @param fn
+ * @param args
+ * @param argSize
+ * @param numTasks
+ */
+void scheduler_run(Scheduler* sched, SchedTaskFunc fn, void* args, size_t argSize, int numTasks) {
+  if (sched->numWorkers == 1 || numTasks <= 1) {
+    for (int i = 0; i < numTasks; i++) fn((char*)args + i * argSize, 0);
+    return;
+  }
+
+  /* counted before they're pushed, so a worker that takes one right away never drives them below zero */
+  pthread_mutex_lock(&sched->lock);
+  sched->queued += numTasks;
+  sched->pending += numTasks;
+  pthread_mutex_unlock(&sched->lock);
+
+  for (int i = 0; i < numTasks; i++) {
+    SchedTask task = { fn, (char*)args + i * argSize };
+    scheduler_push(&sched->deques[i % sched->numWorkers], task);
+  }
+
+  pthread_mutex_lock(&sched->lock);
+  pthread_cond_broadcast(&sched->wake);
+  pthread_mutex_unlock(&sched->lock);
+
+  scheduler_work(sched, 0);
+
+  pthread_mutex_lock(&sched->lock);
+  while (sched->pending > 0) pthread_cond_wait(&sched->done, &sched->lock);
+  pthread_mutex_unlock(&sched->lock);
+}
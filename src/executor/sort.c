@@ -0,0 +1,530 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "executor/sort.h"
+#include "executor/agg.h"
+#include "access/indexam.h"
+#include "global/config.h"
+
+extern Config* conf;
+
+/* buckets smaller than this are insertion sorted instead of split further */
+#define SORT_INSERTION_THRESHOLD 32
+
+typedef struct SortItem {
+  RecordSetRow* row;
+  uint8_t key[];    /* normalized key, sort->keyWidth bytes */
+} SortItem;
+
+static bool sort_is_string(DataType dataType) {
+  return dataType == DT_CHAR || dataType == DT_VARCHAR;
+}
+
+static uint32_t sort_key_col_width(Column* col) {
+  return 1 + (sort_is_string(col->dataType) ? (uint32_t)col->len + 1 : sizeof(uint64_t));
+}
+
+/**
+ * @brief Resolves the ORDER BY list against the columns of the rows to sort.
+ * An aggregate is looked up by its result column name, e.g. `count(*)`.
+ *
+ * @param rd rows to sort
+ * @param sortClause SortBys, NULL if there's only a LIMIT
+ * @param limit negative if there is no LIMIT
+ * @return Sort* NULL if a sort key isn't a column of `rd`
+ */
+Sort* sort_create(RecordDescriptor* rd, ParseList* sortClause, int64_t limit) {
+  Sort* sort = malloc(sizeof(Sort));
+  sort->rd = rd;
+  sort->numKeys = sortClause == NULL ? 0 : sortClause->length;
+  sort->keys = malloc(sizeof(SortKey) * (sort->numKeys + 1));
+  sort->keyWidth = 0;
+  sort->limit = limit;
+  sort->items = NULL;
+  sort->numItems = 0;
+  sort->maxItems = 0;
+  sort->memUsed = 0;
+  sort->spare = NULL;
+  sort->topN = false;
+  sort->runs = NULL;
+  sort->numRuns = 0;
+  sort->failed = false;
+
+  for (int i = 0; i < sort->numKeys; i++) {
+    SortBy* sb = (SortBy*)sortClause->elements[i].ptr;
+    char name[128];
+
+    agg_target_name(sb->target, name, sizeof(name));
+
+    sort->keys[i].col = NULL;
+    sort->keys[i].descending = sb->descending;
+
+    for (int c = 0; c < rd->ncols; c++) {
+      if (strcasecmp(rd->cols[c].colname, name) == 0) sort->keys[i].col = &rd->cols[c];
+    }
+
+    if (sort->keys[i].col == NULL) {
+      printf("Can't ORDER BY %s, it isn't a column of the result\n", name);
+      free_sort(sort);
+      return NULL;
+    }
+
+    sort->keyWidth += sort_key_col_width(sort->keys[i].col);
+  }
+
+  return sort;
+}
+
+void free_sort(Sort* sort) {
+  if (sort == NULL) return;
+
+  free(sort->keys);
+  free(sort);
+}
+
+/**
+ * @brief Writes the normalized key of a row, see sort.h
+ */
+static void sort_normalize_key(Sort* sort, RecordSetRow* row, uint8_t* key) {
+  for (int i = 0; i < sort->numKeys; i++) {
+    Column* col = sort->keys[i].col;
+    uint32_t width = sort_key_col_width(col);
+    bool isnull = row->isnull[col->colnum];
+
+    memset(key, 0, width);
+    key[0] = isnull;
+
+    if (!isnull && sort_is_string(col->dataType)) {
+      char* str = datumGetString(row->values[col->colnum]);
+      if (str != NULL) memcpy(key + 1, str, strnlen(str, col->len));
+    } else if (!isnull) {
+      uint64_t v = (uint64_t)indexam_datum_to_key(col->dataType, row->values[col->colnum]) ^ (1ULL << 63);
+      for (int b = 0; b < 8; b++) key[1 + b] = v >> (56 - 8 * b);
+    }
+
+    if (sort->keys[i].descending) {
+      for (uint32_t b = 0; b < width; b++) key[b] = ~key[b];
+    }
+
+    key += width;
+  }
+}
+
+static size_t sort_item_size(Sort* sort) {
+  return sizeof(SortItem) + sort->keyWidth;
+}
+
+static SortItem* sort_new_item(Sort* sort, RecordSetRow* row) {
+  SortItem* item = malloc(sort_item_size(sort));
+  item->row = row;
+  sort_normalize_key(sort, row, item->key);
+
+  return item;
+}
+
+/**
+ * @brief Rough number of bytes a row and its sort item take up
+ */
+static size_t sort_row_mem(Sort* sort, RecordSetRow* row) {
+  return sort_item_size(sort) + sizeof(SortItem*) + recordset_row_size(row, sort->rd);
+}
+
+static void sort_insertion(SortItem** items, size_t n, uint32_t depth, uint32_t keyWidth) {
+  for (size_t i = 1; i < n; i++) {
+    SortItem* item = items[i];
+    size_t j = i;
+
+    while (j > 0 && memcmp(items[j - 1]->key + depth, item->key + depth, keyWidth - depth) > 0) {
+      items[j] = items[j - 1];
+      j--;
+    }
+    items[j] = item;
+  }
+}
+
+/**
+ * @brief MSD radix sort of the items on their keys, from byte `depth` on.
+ * Every item agrees on the bytes before `depth`.
+ *
+ * @param tmp scratch space for n items
+ */
+static void sort_radix(SortItem** items, SortItem** tmp, size_t n, uint32_t depth, uint32_t keyWidth) {
+  size_t counts[256];
+
+  while (depth < keyWidth) {
+    if (n < SORT_INSERTION_THRESHOLD) {
+      sort_insertion(items, n, depth, keyWidth);
+      return;
+    }
+
+    memset(counts, 0, sizeof(counts));
+    for (size_t i = 0; i < n; i++) counts[items[i]->key[depth]]++;
+
+    /* every item has the same byte here, move on to the next one */
+    if (counts[items[0]->key[depth]] == n) {
+      depth++;
+      continue;
+    }
+
+    size_t offsets[256];
+    size_t offset = 0;
+    for (int b = 0; b < 256; b++) {
+      offsets[b] = offset;
+      offset += counts[b];
+    }
+
+    for (size_t i = 0; i < n; i++) tmp[offsets[items[i]->key[depth]]++] = items[i];
+    memcpy(items, tmp, n * sizeof(SortItem*));
+
+    offset = 0;
+    for (int b = 0; b < 256; b++) {
+      if (counts[b] > 1) sort_radix(items + offset, tmp, counts[b], depth + 1, keyWidth);
+      offset += counts[b];
+    }
+    return;
+  }
+}
+
+static void sort_items(Sort* sort, SortItem** items, size_t n) {
+  SortItem** tmp = malloc(sizeof(SortItem*) * (n + 1));
+  sort_radix(items, tmp, n, 0, sort->keyWidth);
+  free(tmp);
+}
+
+/**
+ * @brief Writes a sorted item to a run: its key, then the row
+ */
+static bool sort_write_item(Sort* sort, FILE* fp, SortItem* item) {
+  return fwrite(item->key, 1, sort->keyWidth, fp) == sort->keyWidth && recordset_row_write(fp, item->row, sort->rd);
+}
+
+/**
+ * @brief Reads the next item of a run, with a row that isn't in any list
+ * yet. Returns NULL at the end of the run.
+ */
+static SortItem* sort_read_item(Sort* sort, FILE* fp) {
+  SortItem* item = malloc(sort_item_size(sort));
+
+  if (fread(item->key, 1, sort->keyWidth, fp) != sort->keyWidth) {
+    free(item);
+    return NULL;
+  }
+
+  item->row = recordset_row_read(fp, sort->rd);
+  if (item->row == NULL) {
+    printf("Unable to read an ORDER BY spill file\n");
+    free(item);
+    return NULL;
+  }
+
+  return item;
+}
+
+/**
+ * @brief Sorts a batch of items and writes it to a new temporary file. Only
+ * the first `limit` items are written, none past them can make the cut. The
+ * rows and items are freed either way. Returns the file, rewound, or NULL on
+ * failure.
+ */
+static FILE* sort_spill(Sort* sort, SortItem** items, size_t n) {
+  FILE* fp = tmpfile();
+  bool success = fp != NULL;
+
+  if (success) sort_items(sort, items, n);
+
+  for (size_t i = 0; i < n; i++) {
+    if (success && (sort->limit < 0 || i < (size_t)sort->limit)) success = sort_write_item(sort, fp, items[i]);
+    free_recordset_row(items[i]->row, sort->rd);
+    free(items[i]);
+  }
+
+  if (!success) {
+    printf("Unable to write an ORDER BY spill file\n");
+    if (fp != NULL) fclose(fp);
+    return NULL;
+  }
+
+  rewind(fp);
+  return fp;
+}
+
+/**
+ * @brief Restores the max-heap property below `i`, for ORDER BY ... LIMIT
+ */
+static void sort_sift_down(SortItem** heap, size_t n, size_t i, uint32_t keyWidth) {
+  while (true) {
+    size_t largest = i;
+    size_t l = 2 * i + 1;
+    size_t r = l + 1;
+
+    if (l < n && memcmp(heap[l]->key, heap[largest]->key, keyWidth) > 0) largest = l;
+    if (r < n && memcmp(heap[r]->key, heap[largest]->key, keyWidth) > 0) largest = r;
+    if (largest == i) return;
+
+    SortItem* t = heap[i];
+    heap[i] = heap[largest];
+    heap[largest] = t;
+    i = largest;
+  }
+}
+
+static void sort_sift_up(SortItem** heap, size_t i, uint32_t keyWidth) {
+  while (i > 0) {
+    size_t parent = (i - 1) / 2;
+    if (memcmp(heap[i]->key, heap[parent]->key, keyWidth) <= 0) return;
+
+    SortItem* t = heap[i];
+    heap[i] = heap[parent];
+    heap[parent] = t;
+    i = parent;
+  }
+}
+
+/* the next item of a run, while the runs are merged */
+typedef struct SortRunHead {
+  SortItem* item;
+  FILE* fp;
+} SortRunHead;
+
+/**
+ * @brief Restores the min-heap property of the run heads below `i`
+ */
+static void sort_merge_sift_down(SortRunHead* heap, size_t n, size_t i, uint32_t keyWidth) {
+  while (true) {
+    size_t smallest = i;
+    size_t l = 2 * i + 1;
+    size_t r = l + 1;
+
+    if (l < n && memcmp(heap[l].item->key, heap[smallest].item->key, keyWidth) < 0) smallest = l;
+    if (r < n && memcmp(heap[r].item->key, heap[smallest].item->key, keyWidth) < 0) smallest = r;
+    if (smallest == i) return;
+
+    SortRunHead t = heap[i];
+    heap[i] = heap[smallest];
+    heap[smallest] = t;
+    i = smallest;
+  }
+}
+
+/**
+ * @brief k-way merge of the runs into `rows`, through a min-heap of the
+ * first item of every run. Stops once `limit` rows were merged.
+ */
+static void sort_merge_runs(Sort* sort, FILE** runs, int numRuns, LinkedList* rows) {
+  SortRunHead* heap = malloc(sizeof(SortRunHead) * numRuns);
+  size_t n = 0;
+
+  for (int i = 0; i < numRuns; i++) {
+    heap[n].item = sort_read_item(sort, runs[i]);
+    heap[n].fp = runs[i];
+    if (heap[n].item != NULL) n++;
+  }
+
+  for (size_t i = n / 2; i-- > 0;) {
+    sort_merge_sift_down(heap, n, i, sort->keyWidth);
+  }
+
+  for (size_t merged = 0; n > 0 && (sort->limit < 0 || merged < (size_t)sort->limit); merged++) {
+    linkedlist_append(rows, heap[0].item->row);
+    free(heap[0].item);
+
+    heap[0].item = sort_read_item(sort, heap[0].fp);
+    if (heap[0].item == NULL) heap[0] = heap[--n];
+
+    sort_merge_sift_down(heap, n, 0, sort->keyWidth);
+  }
+
+  for (size_t i = 0; i < n; i++) {
+    free_recordset_row(heap[i].item->row, sort->rd);
+    free(heap[i].item);
+  }
+
+  free(heap);
+}
+
+/**
+ * @brief Starts sorting rows, which are then added with sort_add_row
+ */
+void sort_begin(Sort* sort) {
+  sort->maxItems = 64;
+  sort->items = malloc(sizeof(SortItem*) * sort->maxItems);
+  sort->numItems = 0;
+  sort->memUsed = 0;
+  sort->spare = malloc(sort_item_size(sort));
+  sort->topN = sort->numKeys > 0 && sort->limit >= 0;
+  sort->runs = NULL;
+  sort->numRuns = 0;
+  sort->failed = false;
+}
+
+static void sort_push_item(Sort* sort, SortItem* item) {
+  if (sort->numItems == sort->maxItems) {
+    sort->maxItems *= 2;
+    sort->items = realloc(sort->items, sizeof(SortItem*) * sort->maxItems);
+  }
+
+  sort->items[sort->numItems++] = item;
+}
+
+/**
+ * @brief ORDER BY ... LIMIT: keeps the `limit` smallest items in a max-heap,
+ * replacing the largest one whenever a smaller row comes in
+ */
+static void sort_top_n_add(Sort* sort, RecordSetRow* row) {
+  SortItem** heap = sort->items;
+  size_t n = sort->numItems;
+
+  if (n < (size_t)sort->limit) {
+    sort->memUsed += sort_row_mem(sort, row);
+    sort_push_item(sort, sort_new_item(sort, row));
+    sort_sift_up(sort->items, n, sort->keyWidth);
+    return;
+  }
+
+  SortItem* item = sort->spare;
+  item->row = row;
+  sort_normalize_key(sort, row, item->key);
+
+  if (n == 0 || memcmp(item->key, heap[0]->key, sort->keyWidth) >= 0) {
+    free_recordset_row(row, sort->rd);
+    return;
+  }
+
+  /* the row replaces the largest one of the heap */
+  SortItem* largest = heap[0];
+  sort->memUsed += sort_row_mem(sort, row) - sort_row_mem(sort, largest->row);
+  free_recordset_row(largest->row, sort->rd);
+  heap[0] = item;
+  sort->spare = largest;
+  sort_sift_down(heap, n, 0, sort->keyWidth);
+}
+
+/**
+ * @brief Adds a row to the sort, which takes it over. Has the signature of
+ * a TableamRowFunc, so a scan can hand its rows straight to the Sort.
+ *
+ * @param sort the Sort, between sort_begin and sort_end
+ * @param row described by `sort->rd`
+ * @return bool false once no more rows are needed: LIMIT 0, LIMIT without
+ * ORDER BY has all of its rows, or a spill failed
+ */
+bool sort_add_row(void* arg, RecordSetRow* row) {
+  Sort* sort = arg;
+
+  if (sort->failed || sort->limit == 0 || (sort->numKeys == 0 && sort->limit >= 0 && sort->numItems >= (size_t)sort->limit)) {
+    free_recordset_row(row, sort->rd);
+    return false;
+  }
+
+  if (sort->numKeys == 0) {
+    sort_push_item(sort, sort_new_item(sort, row));
+    return sort->limit < 0 || sort->numItems < (size_t)sort->limit;
+  }
+
+  /* the heap only pays off while `limit` rows like this one fit in WORK_MEM, past that it's a regular external sort */
+  if (sort->topN && sort->numItems < (size_t)sort->limit &&
+      sort->memUsed + (sort->limit - sort->numItems) * sort_row_mem(sort, row) > (size_t)conf->workMem * 1024) {
+    sort->topN = false;
+  }
+
+  if (sort->topN) {
+    sort_top_n_add(sort, row);
+    return true;
+  }
+
+  sort_push_item(sort, sort_new_item(sort, row));
+  sort->memUsed += sort_row_mem(sort, row);
+
+  if (sort->memUsed > (size_t)conf->workMem * 1024) {
+    sort->runs = realloc(sort->runs, sizeof(FILE*) * (sort->numRuns + 1));
+    sort->runs[sort->numRuns] = sort_spill(sort, sort->items, sort->numItems);
+    sort->failed = sort->runs[sort->numRuns++] == NULL;
+    sort->numItems = 0;
+    sort->memUsed = 0;
+  }
+
+  return !sort->failed;
+}
+
+/**
+ * @brief Appends the rows added since sort_begin to `rs`, in ORDER BY order
+ * and without the ones past the LIMIT
+ *
+ * @param sort
+ * @param rs
+ * @return bool false if the rows had to be spilled and that failed, nothing
+ * is appended then
+ */
+bool sort_end(Sort* sort, RecordSet* rs) {
+  bool success = !sort->failed;
+
+  if (success && sort->numRuns == 0) {
+    /* without ORDER BY, the rows stay in the order they came in */
+    if (sort->numKeys > 0) sort_items(sort, sort->items, sort->numItems);
+
+    for (size_t i = 0; i < sort->numItems; i++) {
+      if (sort->limit < 0 || i < (size_t)sort->limit) {
+        linkedlist_append(rs->rows, sort->items[i]->row);
+      } else {
+        free_recordset_row(sort->items[i]->row, sort->rd);
+      }
+      free(sort->items[i]);
+    }
+  } else if (success) {
+    /* the rows that are still in memory become the last run */
+    if (sort->numItems > 0) {
+      sort->runs = realloc(sort->runs, sizeof(FILE*) * (sort->numRuns + 1));
+      sort->runs[sort->numRuns] = sort_spill(sort, sort->items, sort->numItems);
+      success = sort->runs[sort->numRuns++] != NULL;
+    }
+
+    if (success) sort_merge_runs(sort, sort->runs, sort->numRuns, rs->rows);
+  } else {
+    for (size_t i = 0; i < sort->numItems; i++) {
+      free_recordset_row(sort->items[i]->row, sort->rd);
+      free(sort->items[i]);
+    }
+  }
+
+  for (int i = 0; i < sort->numRuns; i++) {
+    if (sort->runs[i] != NULL) fclose(sort->runs[i]);
+  }
+
+  free(sort->runs);
+  free(sort->items);
+  free(sort->spare);
+  sort->runs = NULL;
+  sort->numRuns = 0;
+  sort->items = NULL;
+  sort->numItems = 0;
+  sort->spare = NULL;
+
+  return success;
+}
+
+/**
+ * @brief Puts the rows of `rs` in ORDER BY order and drops the ones past
+ * the LIMIT
+ *
+ * @param sort
+ * @param rs rows described by `sort->rd`, sorted in place
+ * @return bool false if the rows had to be spilled and that failed, `rs`
+ * is empty then
+ */
+bool sort_execute(Sort* sort, RecordSet* rs) {
+  LinkedList* in = rs->rows;
+  rs->rows = new_linkedlist();
+
+  sort_begin(sort);
+
+  /* sort_add_row frees the rows it doesn't need, even once it says it's done */
+  for (ListItem* li = in->head; li != NULL; li = li->next) {
+    sort_add_row(sort, li->ptr);
+  }
+
+  free_linkedlist(in, NULL);
+
+  return sort_end(sort, rs);
+}
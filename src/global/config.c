@@ -4,9 +4,15 @@
 #include <string.h>
 
 #include "global/config.h"
+#include "storage/page.h"
+#include "system/boot.h"
 
 Config* new_config() {
   Config* conf = malloc(sizeof(Config));
+  conf->mmapMode = false;
+  conf->directIO = false;
+  conf->workMem = DEFAULT_WORK_MEM;
+  conf->workerThreads = DEFAULT_WORKER_THREADS;
   return conf;
 }
 
@@ -20,12 +26,20 @@ void print_config(Config* conf) {
   printf("= DATA_FILE:    %s\n", conf->dataFile);
   printf("= PAGE_SIZE:    %d\n", conf->pageSize);
   printf("= BUFPOOL_SIZE: %d\n", conf->bufpoolSize);
+  printf("= MMAP_MODE:    %d\n", conf->mmapMode);
+  printf("= DIRECT_IO:    %d\n", conf->directIO);
+  printf("= WORK_MEM:     %d\n", conf->workMem);
+  printf("= WORKER_THREADS: %d\n", conf->workerThreads);
 }
 
 static ConfigParameter parse_config_param(char* p) {
   if (strcmp(p, "DATA_FILE") == 0) return CONF_DATA_FILE;
   if (strcmp(p, "PAGE_SIZE") == 0) return CONF_PAGE_SIZE;
   if (strcmp(p, "BUFPOOL_SIZE") == 0) return CONF_BUFPOOL_SIZE;
+  if (strcmp(p, "MMAP_MODE") == 0) return CONF_MMAP_MODE;
+  if (strcmp(p, "DIRECT_IO") == 0) return CONF_DIRECT_IO;
+  if (strcmp(p, "WORK_MEM") == 0) return CONF_WORK_MEM;
+  if (strcmp(p, "WORKER_THREADS") == 0) return CONF_WORKER_THREADS;
 
   return CONF_UNRECOGNIZED;
 }
@@ -41,6 +55,18 @@ static void set_config_value(Config* conf, ConfigParameter p, char* v) {
       break;
     case CONF_BUFPOOL_SIZE:
       conf->bufpoolSize = atoi(v);
+      break;
+    case CONF_MMAP_MODE:
+      conf->mmapMode = atoi(v) != 0;
+      break;
+    case CONF_DIRECT_IO:
+      conf->directIO = atoi(v) != 0;
+      break;
+    case CONF_WORK_MEM:
+      conf->workMem = atoi(v);
+      break;
+    case CONF_WORKER_THREADS:
+      conf->workerThreads = atoi(v);
   }
 }
 
@@ -54,6 +80,73 @@ static void close_config_file(FILE* fp) {
   fclose(fp);
 }
 
+/**
+ * @brief Sets the number of worker threads. Every worker of a table scan
+ * pins a page of the buffer pool at a time, so there can be at most half as
+ * many workers as buffer pool slots. Without a WORKER_THREADS setting,
+ * there's one worker per core, up to that limit.
+ * 
+ * @param conf 
+ * @return true 
+ * @return false 
+ */
+static bool set_config_worker_threads(Config* conf) {
+  int maxWorkers = conf->bufpoolSize / 2 < 1 ? 1 : conf->bufpoolSize / 2;
+
+  if (conf->workerThreads == 0) {
+    long numCores = sysconf(_SC_NPROCESSORS_ONLN);
+    conf->workerThreads = numCores < 1 ? 1 : numCores > maxWorkers ? maxWorkers : numCores;
+  }
+
+  if (conf->workerThreads < 1 || conf->workerThreads > maxWorkers) {
+    printf("WORKER_THREADS must be between 1 and %d (half of BUFPOOL_SIZE)\n", maxWorkers);
+    return false;
+  }
+
+  return true;
+}
+
+static bool is_valid_page_size(int pageSize) {
+  if (pageSize < MIN_PAGE_SIZE || pageSize > MAX_PAGE_SIZE) return false;
+
+  return (pageSize & (pageSize - 1)) == 0;
+}
+
+/**
+ * @brief Sets the page size the database runs with. A database that has
+ * already been initialized keeps the page size stored in its boot page, no
+ * matter what burkeql.conf says. Otherwise the PAGE_SIZE setting is used for
+ * the new database.
+ * 
+ * @param conf 
+ * @return true 
+ * @return false 
+ */
+static bool set_config_page_size(Config* conf) {
+  int bootPageSize;
+
+  if (boot_read_page_size(conf->dataFile, &bootPageSize)) {
+    if (!is_valid_page_size(bootPageSize)) {
+      printf("Data file has an unsupported page size: %d\n", bootPageSize);
+      return false;
+    }
+
+    if (bootPageSize != conf->pageSize) {
+      printf("Using the data file's page size (%d) instead of PAGE_SIZE (%d)\n", bootPageSize, conf->pageSize);
+      conf->pageSize = bootPageSize;
+    }
+
+    return true;
+  }
+
+  if (!is_valid_page_size(conf->pageSize)) {
+    printf("PAGE_SIZE must be a power of two between %d and %d\n", MIN_PAGE_SIZE, MAX_PAGE_SIZE);
+    return false;
+  }
+
+  return true;
+}
+
 /**
  * @brief Set the global config object
  * 
@@ -98,5 +191,12 @@ bool set_global_config(Config* conf) {
 
   close_config_file(fp);
 
-  return true;
+  if (conf->workMem < MIN_WORK_MEM) {
+    printf("WORK_MEM must be at least %d\n", MIN_WORK_MEM);
+    return false;
+  }
+
+  if (!set_config_worker_threads(conf)) return false;
+
+  return set_config_page_size(conf);
 }
\ No newline at end of file
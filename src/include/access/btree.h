@@ -0,0 +1,103 @@
+/**
+ * @file btree.h
+ * @brief B+tree index access method
+ *
+ * Index pages are regular slotted pages with `pageType` = 1. Leaf pages have
+ * `indexLevel` = 0 and each level above them adds one. Every page links to its
+ * neighbors on the same level through `prevPageId` and `nextPageId`, so range
+ * scans walk the leaf level without going back through the parents.
+ *
+ * Every entry on a page starts with a BTreeEntry and the slot array is kept
+ * sorted by (key, rid). Adding the rid to the key makes every entry unique,
+ * which lets duplicate keys spill across pages without any special handling.
+ *
+ * Internal entries point at a child page whose entries are all >= the internal
+ * entry. The first entry of an internal page acts as negative infinity, i.e.
+ * descending follows the last entry that is <= the search entry, or the first
+ * entry if there is none.
+ *
+ * The root page never moves. When it fills up, its contents are moved to a new
+ * child page and the root becomes that child's parent. This way the
+ * `root_page_id` column in `_indexes` is written once, when the index is built.
+ *
+ * Leaf entries of a covering index are followed by the values of the index's
+ * INCLUDE columns, serialized as a Record that only has those columns. That
+ * makes leaf entries variable-length, but nothing above the leaf level cares:
+ * internal entries are always plain BTreeEntry records and every comparison
+ * only looks at the BTreeEntry at the start of a record.
+ *
+ * A clustered index (type 'c') is the storage of an index-organized table: its
+ * leaf pages hold the table rows themselves, sorted by the key column, instead
+ * of BTreeEntry records. The key is the table's primary key, so it must be
+ * unique and NOT NULL. Its internal pages are the same as any other index.
+ * Because the leaf level is an ordinary chain of pages holding table rows,
+ * the table's `first_page_id` points at the leftmost leaf and a full scan
+ * reads the rows in key order.
+ */
+
+#ifndef BTREE_H
+#define BTREE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "buffer/bufmgr.h"
+#include "storage/page.h"
+#include "storage/table.h"
+
+/* percentage of each page filled by a bulk build, leaving room for later inserts */
+#define BTREE_FILL_FACTOR 90
+
+/* deepest tree we support. Even with 4KB pages, that's far more entries than a data file can hold */
+#define BTREE_MAX_LEVELS 16
+
+/**
+ * @brief the 18-byte index entry
+ *
+ * key         | value of the indexed column
+ * rid         | location of the heap record the entry points to. Internal entries
+ *               keep the rid of the first entry in their child, for ordering only
+ * childPageId | (internal pages only) pageId of the child page. 0 on leaf pages
+ */
+#pragma pack(push, 1) /* disabling memory alignment because I don't want to deal with it */
+typedef struct BTreeEntry {
+  int64_t key;
+  RecordId rid;
+  uint32_t childPageId;
+} BTreeEntry;
+#pragma pack(pop)
+
+typedef struct BTreeScan {
+  BufMgr* buf;
+  IndexDesc* idx;
+  int64_t highKey;
+  uint32_t pageId;
+  int slotId;
+  Record payload;         /* INCLUDE columns of the last entry returned */
+  uint16_t payloadLen;
+} BTreeScan;
+
+typedef struct BTreeBuild {
+  BufMgr* buf;
+  IndexDesc* idx;
+  int numLevels;
+  uint32_t pageIds[BTREE_MAX_LEVELS];   /* rightmost page on each level */
+  uint32_t firstLeafPageId;
+} BTreeBuild;
+
+int btree_entry_compare(const void* a, const void* b);
+int64_t btree_record_key(IndexDesc* idx, Record r);
+
+bool btree_insert(BufMgr* buf, IndexDesc* idx, BTreeEntry* e, Record payload, uint16_t payloadLen);
+bool btree_insert_record(BufMgr* buf, IndexDesc* idx, Record r, uint16_t len);
+
+BTreeScan* btree_scan_begin(BufMgr* buf, IndexDesc* idx, int64_t lowKey, int64_t highKey);
+bool btree_scan_next(BTreeScan* scan, BTreeEntry* e);
+void btree_scan_end(BTreeScan* scan);
+
+BTreeBuild* btree_build_begin(BufMgr* buf, IndexDesc* idx);
+bool btree_build_add(BTreeBuild* b, BTreeEntry* e, Record payload, uint16_t payloadLen);
+bool btree_build_add_record(BTreeBuild* b, Record r, uint16_t len);
+int32_t btree_build_end(BTreeBuild* b);
+
+#endif /* BTREE_H */
\ No newline at end of file
@@ -0,0 +1,96 @@
+/**
+ * @file hash.h
+ * @brief Linear hashing index access method
+ *
+ * Hash index pages are regular slotted pages with `pageType` = 2. There are
+ * three kinds of them:
+ *
+ * - the meta page holds a single HashMeta record. Its pageId is the index's
+ *   `root_page_id` in `_indexes`, so it never moves
+ * - directory pages hold a single record each: an array with the pageId of
+ *   the primary page of every bucket, in bucket order
+ * - bucket pages hold unsorted HashEntry records. When every page of a bucket
+ *   is full, a new overflow page is chained to the last one through
+ *   `nextPageId`. The `prevPageId` of a bucket's primary page points at the
+ *   last page of its chain, so inserts never have to walk the chain
+ *
+ * Keys are assigned to buckets with linear hashing. With `level` = L and
+ * N = HASH_INITIAL_BUCKETS, a key goes to bucket `h mod (N * 2^L)`, unless
+ * that bucket was already split during the current round, in which case it
+ * goes to `h mod (N * 2^(L+1))`. Whenever the buckets are more than
+ * HASH_FILL_FACTOR percent full on average, the bucket at `splitBucket` is
+ * split in two and the split pointer moves on. The directory grows one bucket
+ * at a time and doubles over the course of each round, instead of doubling
+ * all at once.
+ */
+
+#ifndef HASH_H
+#define HASH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "buffer/bufmgr.h"
+#include "storage/page.h"
+#include "storage/table.h"
+
+/* buckets in a brand new index */
+#define HASH_INITIAL_BUCKETS 4
+
+/* average bucket fill (percentage of one page) that triggers a bucket split */
+#define HASH_FILL_FACTOR 75
+
+/* the meta page can point to this many directory pages */
+#define HASH_MAX_DIR_PAGES 256
+
+/**
+ * @brief the 14-byte index entry
+ *
+ * key | value of the indexed column
+ * rid | location of the heap record the entry points to
+ */
+#pragma pack(push, 1) /* disabling memory alignment because I don't want to deal with it */
+typedef struct HashEntry {
+  int64_t key;
+  RecordId rid;
+} HashEntry;
+
+/**
+ * @brief the record on the meta page
+ *
+ * level       | number of completed split rounds
+ * splitBucket | next bucket to split in the current round
+ * numBuckets  | count of buckets, always N * 2^level + splitBucket
+ * numEntries  | count of entries in the index
+ * numDirPages | count of directory pages in use
+ * freePageId  | first overflow page that was emptied by a bucket split, 0 if
+ *               none. Free pages are linked through `nextPageId` and get
+ *               reused before any new page is allocated
+ * dirPageIds  | pageIds of the directory pages
+ */
+typedef struct HashMeta {
+  uint32_t level;
+  uint32_t splitBucket;
+  uint32_t numBuckets;
+  uint64_t numEntries;
+  uint32_t numDirPages;
+  uint32_t freePageId;
+  uint32_t dirPageIds[HASH_MAX_DIR_PAGES];
+} HashMeta;
+#pragma pack(pop)
+
+typedef struct HashScan {
+  BufMgr* buf;
+  int64_t key;
+  uint32_t pageId;
+  int slotId;
+} HashScan;
+
+bool hash_create(BufMgr* buf, IndexDesc* idx);
+bool hash_insert(BufMgr* buf, IndexDesc* idx, HashEntry* e);
+
+HashScan* hash_scan_begin(BufMgr* buf, IndexDesc* idx, int64_t key);
+bool hash_scan_next(HashScan* scan, HashEntry* e);
+void hash_scan_end(HashScan* scan);
+
+#endif /* HASH_H */
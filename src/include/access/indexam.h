@@ -0,0 +1,28 @@
+#ifndef INDEXAM_H
+#define INDEXAM_H
+
+#include "storage/table.h"
+#include "buffer/bufmgr.h"
+#include "resultset/recordset.h"
+
+bool indexam_create(
+  BufMgr* buf,
+  TableDesc* td,
+  char* indexname,
+  char* colname,
+  char* method,
+  bool clustered,
+  char** includeNames,
+  int numIncluded
+);
+bool indexam_insert(BufMgr* buf, TableDesc* td, Record r, RecordId* rid);
+bool indexam_insert_batch(BufMgr* buf, TableDesc* td, Record* records, RecordId* rids, int numRecords);
+
+bool indexam_covers(IndexDesc* idx, uint64_t neededCols);
+IndexDesc* indexam_find_index(BufMgr* buf, TableDesc* td, int colnum, bool isRange, uint64_t neededCols);
+void indexam_lookup(BufMgr* buf, TableDesc* td, IndexDesc* idx, int64_t lowKey, int64_t highKey, uint64_t neededCols, RecordSet* rs);
+
+bool indexam_is_indexable(DataType dataType);
+int64_t indexam_datum_to_key(DataType dataType, Datum d);
+
+#endif /* INDEXAM_H */
\ No newline at end of file
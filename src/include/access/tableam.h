@@ -6,8 +6,44 @@
 #include "utility/linkedlist.h"
 #include "resultset/recordset.h"
 #include "parser/parsetree.h"  // remove this when there's no dependency on ParseList*
+#include "executor/qual.h"
+
+/**
+ * @brief A `column <op> value` predicate the table scan checks against the
+ * table's zone map, to skip the page ranges that can't have a matching row.
+ * It's taken from the scan's Qual, which still filters every row it reads.
+ *
+ * colnum | column the predicate is on
+ * op     | comparison operator
+ * intVal | value for integer and BOOL columns
+ * str    | value for CHAR and VARCHAR columns, NULL otherwise
+ */
+typedef struct ScanKey {
+  int colnum;
+  ExprOp op;
+  int64_t intVal;
+  char* str;
+} ScanKey;
+
+/**
+ * @brief Called by tableam_scan_pages with the records of one page
+ */
+typedef void (*TableamPageFunc)(void* arg, Record* records, int numRecords);
+
+/**
+ * @brief Called by tableam_scan_rows with each row the scan finds, in page
+ * chain order. The row belongs to `fn` from then on. Returning false stops
+ * the scan.
+ */
+typedef bool (*TableamRowFunc)(void* arg, RecordSetRow* row);
 
 void tableam_fullscan(BufMgr* buf, TableDesc* td, RecordSet* rs);
-bool tableam_insert(BufMgr* buf, TableDesc* td, Record r, uint16_t recordLen);
+void tableam_scan(BufMgr* buf, TableDesc* td, Qual* qual, RecordSet* rs);
+bool tableam_scan_rows(BufMgr* buf, TableDesc* td, Qual* qual, TableamRowFunc fn, void* arg);
+void tableam_scan_pages(BufMgr* buf, TableDesc* td, TableamPageFunc fn, void* arg);
+uint32_t tableam_count_pages(BufMgr* buf, TableDesc* td);
+bool tableam_fetch(BufMgr* buf, TableDesc* td, RecordId* rid, RecordSet* rs);
+bool tableam_insert(BufMgr* buf, TableDesc* td, Record r, uint16_t recordLen, RecordId* rid);
+int tableam_insert_batch(BufMgr* buf, TableDesc* td, Record* records, uint16_t* recordLens, int numRecords, RecordId* rids);
 
 #endif /* TABLEAM_H */
\ No newline at end of file
@@ -0,0 +1,39 @@
+/**
+ * @file visibilitymap.h
+ * @brief Tracks which heap pages only hold rows that every query can see
+ *
+ * The visibility map is a bitmap with one bit per page of the data file, set
+ * when every row on the page is visible. Index-only scans check it before
+ * trusting the INCLUDE columns of an index entry: if the heap page's bit is
+ * set, the entry is as good as the row and the heap page is never read.
+ *
+ * The map lives on its own pages (`pageType` = 3), chained through
+ * `nextPageId`. Each one holds a bitmap right after the page header, so with
+ * B bits per page, the n-th page of the chain covers pageIds n * B up to
+ * (n + 1) * B - 1. The first page is recorded on the boot page and the map
+ * is only created (and extended) when a bit has to be set.
+ *
+ * Every statement commits as soon as it's done, so a page is all-visible
+ * whenever no statement is in the middle of modifying it. An INSERT clears
+ * the bit of the heap page it writes to and sets it again once the row made
+ * it into every index. If the statement fails halfway, the bit stays
+ * clear and index-only scans fall back to the heap for that page.
+ */
+
+#ifndef VISIBILITYMAP_H
+#define VISIBILITYMAP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "buffer/bufmgr.h"
+#include "storage/page.h"
+
+/* visibility map extents are recorded in `_extents` under this objectId, no catalog object uses it */
+#define VISIBILITYMAP_OBJECT_ID 0
+
+bool visibilitymap_test(BufMgr* buf, uint32_t pageId);
+bool visibilitymap_set(BufMgr* buf, uint32_t pageId);
+void visibilitymap_clear(BufMgr* buf, uint32_t pageId);
+
+#endif /* VISIBILITYMAP_H */
@@ -0,0 +1,95 @@
+/**
+ * @file zonemap.h
+ * @brief Per page range summaries of a heap table, used to skip page ranges
+ * that can't match a scan's predicate
+ *
+ * The heap pages of a table are grouped in ranges of ZONEMAP_RANGE_PAGES
+ * consecutive pages of its page chain. For each range, the zone map keeps
+ * one record that summarizes every row on those pages:
+ *
+ * - integer and BOOL columns keep the min and max value
+ * - CHAR and VARCHAR columns keep a bloom filter of their values, which can
+ *   rule out equality predicates
+ * - every column remembers whether it had any values or NULLs at all
+ *
+ * Zone map pages are regular slotted pages with `pageType` = 4, holding the
+ * records in the same order as the ranges appear in the table's page chain.
+ * They are chained through `nextPageId` and the `prevPageId` of the first one
+ * points at the last one, where new records get appended. The first page is
+ * the table's `zonemap_page_id` in `_tables`.
+ *
+ * Tables are append-only, so the zone map is kept up to date on every insert:
+ * the new row is merged into the summary of the last range, or starts a new
+ * range once the last one is full. A summary never shrinks, which is fine as
+ * long as rows are never deleted or updated.
+ */
+
+#ifndef ZONEMAP_H
+#define ZONEMAP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "access/tableam.h"
+#include "buffer/bufmgr.h"
+#include "storage/page.h"
+#include "storage/table.h"
+
+/* heap pages summarized by each zone map record */
+#define ZONEMAP_RANGE_PAGES 8
+
+/* largest bloom filter per string column. Smaller if the record would not fit on a page */
+#define ZONEMAP_BLOOM_BYTES 512
+
+/* bits set in a bloom filter for each value */
+#define ZONEMAP_BLOOM_HASHES 3
+
+/* ZoneColumn flags */
+#define ZONE_HAS_VALUES 0x01
+#define ZONE_HAS_NULLS 0x02
+
+/**
+ * @brief the header of every zone map record. It's followed by a ZoneColumn
+ * for each column of the table, in colnum order, then by a bloom filter for
+ * each string column, also in colnum order
+ *
+ * firstPageId | first heap page of the range
+ * lastPageId  | last heap page of the range
+ * numPages    | number of heap pages in the range so far
+ */
+#pragma pack(push, 1) /* disabling memory alignment because I don't want to deal with it */
+typedef struct ZoneRange {
+  uint32_t firstPageId;
+  uint32_t lastPageId;
+  uint16_t numPages;
+} ZoneRange;
+
+/**
+ * @brief summary of a single column over a range
+ *
+ * flags | ZONE_HAS_VALUES and/or ZONE_HAS_NULLS
+ * min   | smallest value (integer and BOOL columns only)
+ * max   | largest value (integer and BOOL columns only)
+ */
+typedef struct ZoneColumn {
+  uint8_t flags;
+  int64_t min;
+  int64_t max;
+} ZoneColumn;
+#pragma pack(pop)
+
+typedef struct ZoneMapScan {
+  BufMgr* buf;
+  TableDesc* td;
+  uint32_t pageId;
+  int slotId;
+} ZoneMapScan;
+
+bool zonemap_create(BufMgr* buf, TableDesc* td);
+bool zonemap_add_row(BufMgr* buf, TableDesc* td, uint32_t pageId, Record r);
+
+ZoneMapScan* zonemap_scan_begin(BufMgr* buf, TableDesc* td);
+bool zonemap_scan_next(ZoneMapScan* scan, ScanKey* key, ZoneRange* range, bool* mayMatch);
+void zonemap_scan_end(ZoneMapScan* scan);
+
+#endif /* ZONEMAP_H */
@@ -35,6 +35,7 @@ typedef struct BufDescArr {
   int size;
   BufDesc** descArr;
 } BufDescArr;
+#pragma pack(pop)
 
 BufDescArr* bufdesc_init(int size);
 void bufdesc_destroy(BufDescArr* bd);
@@ -9,11 +9,25 @@
 #define FILE_DATA 1
 #define FILE_LOG 2
 
+/**
+ * Pages are handed out to tables and indexes in extents of EXTENT_SIZE
+ * contiguous pages. Extents are aligned on EXTENT_SIZE boundaries, so the
+ * first extent in a file is pageId 1 through EXTENT_SIZE.
+ */
+#define EXTENT_SIZE 64
+
+#define extent_first_pageid(pageId)   ((((pageId) - 1) / EXTENT_SIZE) * EXTENT_SIZE + 1)
+#define extent_last_pageid(pageId)    (extent_first_pageid(pageId) + EXTENT_SIZE - 1)
+#define is_extent_first_pageid(pageId)    (((pageId) - 1) % EXTENT_SIZE == 0)
+
 typedef struct FileDesc {
   char* filename;
   uint32_t fileId;
   uint32_t nextPageId;
   int fd;
+  bool directIO;      /* file was opened with O_DIRECT */
+  char* map;          /* read-only mapping of the file when running in mmap mode */
+  uint32_t mapPages;  /* number of pages covered by `map` */
 } FileDesc;
 
 typedef struct LinkedList FileDescList;
@@ -25,7 +39,9 @@ FileDesc* buffile_open(FileDescList* fdl, uint32_t fileId);
 // void buffile_close(FileDescList* fdl, uint32_t fileId);
 FileDesc* buffile_search(FileDescList* fdl, uint32_t fileId);
 
-uint32_t buffile_get_new_pageid(FileDescList* fdl, uint32_t fileId);
+char* buffile_get_mapped_page(FileDescList* fdl, uint32_t fileId, uint32_t pageId);
+
+uint32_t buffile_get_new_extent(FileDescList* fdl, uint32_t fileId);
 
 void buffile_diag_summary(FileDescList* fdl);
 
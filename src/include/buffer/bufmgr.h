@@ -19,6 +19,10 @@
  * page in the buffer pool.
  * 
  * 
+ * When `MMAP_MODE` is enabled, read-only requests are served straight from a
+ * read-only mapping of the data file. Those slots hold no copy of the page; if a
+ * writer later requests the same page, it is copied into the slot's own frame.
+ * 
  * Common buffer manager workflows:
  *    - accessing a page already in the buffer pool
  *    - loading a page from storage into an empty slot
@@ -51,8 +55,11 @@ BufMgr* bufmgr_init();
 void bufmgr_destroy(BufMgr* buf);
 
 int32_t bufmgr_request_bufId(BufMgr* buf, BufTag* tag);
+int32_t bufmgr_request_bufId_readonly(BufMgr* buf, BufTag* tag);
 void bufmgr_release_bufId(BufMgr* buf, int32_t bufId);
-int32_t bufmgr_allocate_new_page(BufMgr* buf, uint32_t fileId);
+int32_t bufmgr_allocate_new_extent(BufMgr* buf, uint32_t fileId);
+int32_t bufmgr_allocate_next_page(BufMgr* buf, int32_t bufId);
+int32_t bufmgr_allocate_page_after(BufMgr* buf, uint32_t fileId, uint32_t pageId);
 
 void bufmgr_flush_page(BufMgr* buf, BufTag* tag);
 void bufmgr_flush_all(BufMgr* buf);
@@ -66,7 +73,8 @@ void bufmgr_flush_all(BufMgr* buf);
  * of pageId's in the page header. If this is an "append" page split, 
  * then we only update the previous page's header fields. If this is an
  * "insert" page split, then we need to update both the previous page
- * and the next page.
+ * and the next page, and move the upper half of the records to the new
+ * page. The old page is released either way.
  * 
  * @param buf 
  * @param tag 
@@ -75,6 +83,8 @@ void bufmgr_flush_all(BufMgr* buf);
 int32_t bufmgr_page_split(BufMgr* buf, int32_t bufId);
 /* Same as the above, but it does not synchronize the `lastPageId` column */
 int32_t bufmgrinit_page_split(BufMgr* buf, BufTag* tag);
+/* Always moves the upper half of the records to the new page, even at the end of the chain */
+int32_t bufmgr_page_split_insert(BufMgr* buf, int32_t bufId, uint32_t allocPageId);
 
 /**
  * @brief System command functions for printing diagnostic information to the terminal
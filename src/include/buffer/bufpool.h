@@ -18,9 +18,15 @@
 #include "buffer/bufdesc.h"
 #include "buffer/buffile.h"
 
+/**
+ * `frames` holds the memory owned by each slot. `pages` is what everyone
+ * else reads and writes: normally it points at the slot's frame, but in mmap
+ * mode a read-only slot can point straight into the data file's mapping.
+ */
 typedef struct BufPool {
   int size;
   Page* pages;
+  Page* frames;
 } BufPool;
 
 BufPool* bufpool_init(int size);
@@ -29,4 +35,9 @@ void bufpool_destroy(BufPool* bp);
 bool bufpool_read_page(FileDescList* fdl, BufPool* bp, int32_t bufId, BufTag* tag);
 bool bufpool_flush_page(FileDescList* fdl, BufDescArr* bd, BufPool* bp, int32_t bufId);
 
+bool bufpool_map_page(FileDescList* fdl, BufPool* bp, int32_t bufId, BufTag* tag);
+bool bufpool_is_mapped(BufPool* bp, int32_t bufId);
+void bufpool_unmap_page(BufPool* bp, int32_t bufId);
+void bufpool_use_frame(BufPool* bp, int32_t bufId);
+
 #endif /* BUFPOOL_H */
\ No newline at end of file
@@ -0,0 +1,88 @@
+/**
+ * @file agg.h
+ * @brief Aggregate functions (COUNT, SUM, MIN, MAX, AVG) and GROUP BY
+ *
+ * The rows are added one at a time, as the scan that produces them reads
+ * them (agg_begin, agg_add_row, agg_end), so it's only the groups that take
+ * up memory, never the input.
+ *
+ * Rows are grouped with a hash table: the values of the GROUP BY columns are
+ * encoded into a flat key, which is hashed into an open-addressing table of
+ * small (hash, group) entries, so a probe rarely has to look at the group
+ * itself. Every group keeps a running state for each aggregate.
+ *
+ * When the groups no longer fit in WORK_MEM, they're sorted by key and
+ * written to a temporary file as a sorted run, and the table starts over
+ * empty. Once every row has been read, the runs are merged and the states of
+ * equal keys are combined, so only one group per run is in memory at a time.
+ *
+ * Without GROUP BY, every row belongs to a single group, which exists even
+ * when there are no rows: `SELECT COUNT(*)` on an empty table returns 0.
+ *
+ * COUNT(*) counts rows, the other aggregates ignore NULLs and return NULL
+ * when there's nothing to aggregate (COUNT returns 0). SUM and AVG take
+ * integer columns and return a BIGINT; like integer division, AVG truncates.
+ * MIN and MAX take integer and string columns and return the column's type.
+ */
+
+#ifndef AGG_H
+#define AGG_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "parser/parsetree.h"
+#include "storage/record.h"
+#include "resultset/recordset.h"
+
+typedef enum AggFunc {
+  AGG_NONE,     /* a GROUP BY column */
+  AGG_COUNT,
+  AGG_SUM,
+  AGG_MIN,
+  AGG_MAX,
+  AGG_AVG
+} AggFunc;
+
+/**
+ * @brief One column of the result
+ *
+ * func     | aggregate function, AGG_NONE for a GROUP BY column
+ * col      | input column, NULL for COUNT(*)
+ * groupIdx | position in the GROUP BY list (AGG_NONE only)
+ */
+typedef struct AggTarget {
+  AggFunc func;
+  Column* col;
+  int groupIdx;
+} AggTarget;
+
+typedef struct Agg {
+  RecordDescriptor* rd;       /* input rows */
+  int numGroupCols;
+  Column** groupCols;
+  int numTargets;
+  AggTarget* targets;
+  RecordDescriptor* outRd;    /* result rows, one column per target */
+  struct AggHashTable* ht;    /* groups in memory, from agg_begin to agg_end */
+  char* key;                  /* scratch space for the key of a row */
+  FILE** runs;                /* sorted runs spilled so far */
+  int numRuns;
+  bool failed;                /* a spill failed, rows are ignored from then on */
+} Agg;
+
+bool agg_is_needed(SelectStmt* s);
+void agg_target_name(ResTarget* r, char* name, size_t size);
+
+Agg* agg_create(RecordDescriptor* rd, ParseList* targetList, ParseList* groupClause);
+void free_agg(Agg* agg);
+
+void agg_begin(Agg* agg);
+bool agg_add_row(void* agg, RecordSetRow* row);
+RecordSet* agg_end(Agg* agg);
+
+RecordSet* agg_execute(Agg* agg, RecordSet* rs);
+
+#endif /* AGG_H */
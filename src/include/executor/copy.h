@@ -0,0 +1,54 @@
+/**
+ * @file copy.h
+ * @brief Bulk loading and export: multi-row INSERT, `COPY table FROM 'file'`
+ * and `COPY table TO 'file' [BINARY]`
+ *
+ * Rows are inserted a batch at a time: the table's catalog entries and
+ * indexes are looked up once per batch instead of once per row, and the
+ * table's last page is filled with as many records as fit before it's split
+ * (see tableam_insert_batch).
+ *
+ * COPY FROM reads a CSV file line by line, so the file never has to fit in
+ * memory. Every line holds the columns of one row in table order, separated
+ * by commas. A field may be quoted with `"`, with `""` standing for a quote
+ * inside it; quoted fields may span lines. An empty unquoted field is NULL,
+ * `""` is an empty string. BOOL columns take true/false, t/f or 1/0.
+ *
+ * There are no transactions: when COPY runs into a bad line, the rows of
+ * the lines before it stay in the table.
+ *
+ * COPY TO writes the table in the same CSV format, one page of rows at a
+ * time. Strings are only quoted when they have to be, and BOOLs are written
+ * as 1/0. Nothing is allocated per row: the numbers are formatted into a
+ * scratch buffer, the strings are taken straight from the page, and each
+ * page's worth of pieces goes out in a single writev.
+ *
+ * The binary format is smaller and needs no parsing. All numbers are in
+ * the machine's byte order:
+ *
+ * header | "BQLCOPY\n", the number of columns (uint16), and the DataType of
+ *        | each column (uint8)
+ * row    | a null bitmap of (ncols + 7) / 8 bytes, the bit (i % 8) of byte
+ *        | (i / 8) set when column i is NULL, followed by the value of each
+ *        | column that isn't: 1 byte for TINYINT and BOOL, 2 for SMALLINT, 4
+ *        | for INT, 8 for BIGINT, and a uint16 length followed by the
+ *        | characters for CHAR and VARCHAR
+ */
+
+#ifndef COPY_H
+#define COPY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "parser/parsetree.h"
+#include "storage/table.h"
+#include "buffer/bufmgr.h"
+
+bool copy_literal_to_datum(Column* col, Literal* l, Datum* value, bool* isnull);
+
+bool copy_insert_batch(BufMgr* buf, TableDesc* td, Record* records, uint16_t* recordLens, int numRecords);
+bool copy_from(BufMgr* buf, TableDesc* td, char* filename);
+bool copy_to(BufMgr* buf, TableDesc* td, char* filename, bool binary);
+
+#endif /* COPY_H */
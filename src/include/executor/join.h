@@ -0,0 +1,66 @@
+/**
+ * @file join.h
+ * @brief Inner equi-join of two tables (`FROM a JOIN b ON a.x = b.y`)
+ *
+ * The join is a hash join. The table with fewer pages is the build side: it
+ * is read first and its rows are hashed on the join column. A bloom filter
+ * of those hashes is added to the scan of the other table, the probe side,
+ * so the probe rows that can't have a match are dropped before they're
+ * materialized. Each table is read once, so a join costs about the size of
+ * both tables rather than their product.
+ *
+ * The join stays within about WORK_MEM. The build rows are hashed as
+ * the scan hands them over. If they fit in WORK_MEM, the probe rows are
+ * joined with them as their own scan hands them over, a batch at a time.
+ * Otherwise the rows of both sides are written to temporary files, one per
+ * partition of their hash, whenever they outgrow WORK_MEM (a Grace hash
+ * join), and the partitions are read back and joined one pair at a time.
+ * Either way, the build rows are split into partitions whose hash tables are
+ * small enough to stay in the CPU cache while the probe rows of that
+ * partition go through them. The joined rows are handed on as they're made,
+ * so an aggregation, a sort or a LIMIT consumes them without the join
+ * collecting them.
+ *
+ * The joined rows hold every column of the left (FROM) table, then every
+ * column of the right (JOIN) table, named `table.column`. The parts of the
+ * WHERE clause that only involve one of the tables are checked by that
+ * table's scan, the rest against the joined rows. Rows with a NULL join key
+ * never match.
+ */
+
+#ifndef JOIN_H
+#define JOIN_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "storage/table.h"
+#include "buffer/bufmgr.h"
+#include "resultset/recordset.h"
+#include "executor/qual.h"
+#include "access/tableam.h"
+
+/**
+ * left     | the FROM table
+ * right    | the JOIN table
+ * rd       | the joined rows
+ * leftKey  | join column of `left`, points into its RecordDescriptor
+ * rightKey | join column of `right`
+ */
+typedef struct Join {
+  TableDesc* left;
+  TableDesc* right;
+  RecordDescriptor* rd;
+  Column* leftKey;
+  Column* rightKey;
+} Join;
+
+Join* join_create(TableDesc* left, TableDesc* right);
+void free_join(Join* join);
+
+char* join_resolve_column(Join* join, char* name);
+bool join_set_keys(Join* join, char* lhs, char* rhs);
+
+bool join_execute(BufMgr* buf, Join* join, Qual* qual, TableamRowFunc fn, void* arg);
+
+#endif /* JOIN_H */
@@ -0,0 +1,74 @@
+/**
+ * @file prepare.h
+ * @brief Prepared statements: `PREPARE name AS ...`, `EXECUTE name(...)` and
+ * `DEALLOCATE name`
+ *
+ * PREPARE parses and analyzes a SELECT or INSERT once: its tables are looked
+ * up in the catalog, its column names are resolved, and a SELECT's access
+ * path (the index that answers its WHERE clause, if any) is picked. The
+ * first page and the indexes of each table are cached in its TableDesc. All
+ * of that is kept with the statement, so an EXECUTE binds its values to the
+ * parameters and runs it without looking any of it up again. What changes
+ * with every insert is still read from the catalog: the table's last page
+ * and its zone map.
+ *
+ * The parameters $1, $2, ... stand in for literals: the values of a WHERE
+ * comparison and of the rows of an INSERT. Each one is a Literal of the
+ * cached parse tree, and EXECUTE copies its n-th value into every Literal
+ * of $n. EXECUTE needs a value for each parameter up to the highest one.
+ *
+ * A plan goes stale when an index is created on one of its tables; its
+ * access path is picked and its tables' catalog cached again by the next
+ * EXECUTE.
+ */
+
+#ifndef PREPARE_H
+#define PREPARE_H
+
+#include <stdbool.h>
+
+#include "parser/parsetree.h"
+#include "storage/table.h"
+#include "executor/join.h"
+
+/**
+ * name      | the name given to PREPARE
+ * stmt      | the analyzed SELECT or INSERT
+ * params    | every parameter Literal of `stmt`
+ * numRefs   | the length of `params`
+ * numParams | the highest n of the $n in `stmt`
+ * td        | the table the statement reads or inserts into
+ * joinTd    | the JOIN table of a SELECT, NULL if there is none
+ * join      | the join of `td` and `joinTd`, NULL if there is none
+ * idx       | the index that answers the WHERE clause of a SELECT, NULL if
+ *           | the table is scanned
+ * planned   | false once `idx` has to be picked again
+ */
+typedef struct PreparedStmt {
+  char* name;
+  Node* stmt;
+  Literal** params;
+  int numRefs;
+  int numParams;
+  TableDesc* td;
+  TableDesc* joinTd;
+  Join* join;
+  IndexDesc* idx;
+  bool planned;
+} PreparedStmt;
+
+int prepare_collect_params(Node* n, Literal** params);
+
+PreparedStmt* new_preparedstmt(char* name, Node* stmt);
+void free_preparedstmt(PreparedStmt* p);
+
+bool prepare_add(PreparedStmt* p);
+PreparedStmt* prepare_find(char* name);
+bool prepare_drop(char* name);
+void prepare_drop_all();
+
+void prepare_invalidate(char* tablename);
+
+bool prepare_bind(PreparedStmt* p, ParseList* values);
+
+#endif /* PREPARE_H */
@@ -0,0 +1,107 @@
+/**
+ * @file qual.h
+ * @brief Evaluates WHERE clauses a batch of records at a time
+ *
+ * A WHERE clause is compiled into a tree of Quals: comparisons between a
+ * column and a literal at the leaves, AND and OR above them. The tree is
+ * then evaluated against an array of records (e.g. every record on a page)
+ * straight from their on-page format. Each comparison decodes just its own
+ * column for the whole batch into an array, then compares the array to the
+ * literal in a single loop that the compiler can vectorize. Only the records
+ * that pass get materialized afterwards.
+ *
+ * A comparison with NULL, or with a literal of the wrong type, is never
+ * true, and neither is a comparison on a column that is NULL. There is no
+ * NOT, so treating "unknown" as false gives the same rows as SQL does.
+ *
+ * A QUAL_BLOOM node keeps the records whose column value may be in a bloom
+ * filter. A hash join builds one from the join keys of one side and pushes it
+ * into the scan of the other side, so most rows without a match are dropped
+ * before they're ever materialized.
+ */
+
+#ifndef QUAL_H
+#define QUAL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "parser/parsetree.h"
+#include "storage/record.h"
+
+typedef enum QualType {
+  QUAL_COMPARE,
+  QUAL_AND,
+  QUAL_OR,
+  QUAL_BLOOM
+} QualType;
+
+/**
+ * @brief A node of a compiled WHERE clause
+ *
+ * col        | column compared by a QUAL_COMPARE or tested by a QUAL_BLOOM, points
+ *              into the RecordDescriptor
+ * op         | comparison operator
+ * neverTrue  | the literal can't match anything: it's NULL
+ * intVal     | literal for integer and BOOL columns
+ * str        | literal for CHAR and VARCHAR columns, points into the parse tree
+ * strLen     | length of `str`
+ * lhs, rhs   | operands of a QUAL_AND or QUAL_OR
+ * bloom      | bits of a QUAL_BLOOM
+ * bloomMask  | number of bits in `bloom` - 1, a power of two - 1
+ */
+typedef struct Qual {
+  QualType type;
+  Column* col;
+  ExprOp op;
+  bool neverTrue;
+  int64_t intVal;
+  char* str;
+  size_t strLen;
+  struct Qual* lhs;
+  struct Qual* rhs;
+  uint8_t* bloom;
+  uint32_t bloomMask;
+} Qual;
+
+/**
+ * @brief Working memory for qual_eval_batch, so evaluating a batch doesn't
+ * allocate anything. A scan keeps one for all of its pages and grows it with
+ * qual_scratch_reserve to fit its largest page.
+ *
+ * maxRecords | number of records every array has room for
+ * numLevels  | number of AND/OR levels that need a selection array of their own
+ * isnull     | NULL flags of the column being decoded
+ * values     | decoded integer column
+ * data, lens | decoded string column
+ * sels       | `numLevels` selection arrays, one after the other
+ */
+typedef struct QualScratch {
+  size_t maxRecords;
+  int numLevels;
+  uint8_t* isnull;
+  int64_t* values;
+  char** data;
+  uint16_t* lens;
+  uint8_t* sels;
+} QualScratch;
+
+Qual* qual_compile(RecordDescriptor* rd, Node* expr);
+Qual* qual_and(Qual* lhs, Qual* rhs);
+void free_qual(Qual* q);
+
+QualScratch* qual_new_scratch(Qual* q);
+void qual_scratch_reserve(QualScratch* scratch, size_t numRecords);
+void free_qual_scratch(QualScratch* scratch);
+
+void qual_eval_batch(Qual* q, RecordDescriptor* rd, Record* records, int numRecords, uint8_t* sel, QualScratch* scratch);
+bool qual_eval_row(Qual* q, Datum* values, bool* isnull);
+
+uint64_t qual_hash_int(int64_t v);
+uint64_t qual_hash_string(char* str, size_t len);
+
+Qual* qual_new_bloom(Column* col, uint32_t numValues);
+void qual_bloom_add(Qual* q, uint64_t hash);
+
+#endif /* QUAL_H */
@@ -0,0 +1,76 @@
+/**
+ * @file scheduler.h
+ * @brief Work-stealing thread pool that runs the parallel parts of a query
+ *
+ * An operator splits its work into morsels, small units of about the same
+ * size (e.g. 64 pages of a table), and hands them to scheduler_run as
+ * tasks. The tasks are dealt out round-robin onto the deques of the
+ * workers, one deque per worker. A worker takes tasks from the bottom of
+ * its own deque, and when that's empty it steals from the top of another
+ * worker's deque, so a worker that got the cheap morsels helps out with the
+ * expensive ones instead of going idle.
+ *
+ * The thread that calls scheduler_run is worker 0 and works through the
+ * tasks along with the pool threads, it only returns once every task has
+ * finished. The pool has WORKER_THREADS workers in all. Tasks must not call
+ * scheduler_run themselves, or touch anything that isn't thread-safe (e.g.
+ * the buffer manager) without a lock of their own.
+ */
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+/**
+ * @brief A task, called with its argument and the id of the worker that
+ * runs it, from 0 to scheduler->numWorkers - 1
+ */
+typedef void (*SchedTaskFunc)(void* arg, int workerId);
+
+typedef struct SchedTask {
+  SchedTaskFunc fn;
+  void* arg;
+} SchedTask;
+
+/**
+ * @brief The tasks of one worker. The worker itself pops from the bottom
+ * (`tail`), thieves take from the top (`head`).
+ */
+typedef struct SchedDeque {
+  pthread_mutex_t lock;
+  SchedTask* tasks;
+  int head;
+  int tail;
+  int capacity;
+} SchedDeque;
+
+/**
+ * numWorkers | worker 0 is the thread that calls scheduler_run
+ * threads    | the pool threads, workers 1 and up
+ * lock       | protects `queued`, `pending` and `shutdown`
+ * wake       | signaled when tasks are queued or the pool shuts down
+ * done       | signaled when the last task of a run finishes
+ * queued     | tasks sitting in the deques
+ * pending    | tasks of the current run that haven't finished
+ */
+typedef struct Scheduler {
+  int numWorkers;
+  pthread_t* threads;
+  SchedDeque* deques;
+  pthread_mutex_t lock;
+  pthread_cond_t wake;
+  pthread_cond_t done;
+  int queued;
+  int pending;
+  bool shutdown;
+} Scheduler;
+
+Scheduler* scheduler_create(int numWorkers);
+void scheduler_destroy(Scheduler* sched);
+
+void scheduler_run(Scheduler* sched, SchedTaskFunc fn, void* args, size_t argSize, int numTasks);
+
+#endif /* SCHEDULER_H */
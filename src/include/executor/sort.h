@@ -0,0 +1,72 @@
+/**
+ * @file sort.h
+ * @brief ORDER BY and LIMIT
+ *
+ * Each row gets a normalized key: its ORDER BY values encoded into a fixed
+ * number of bytes, so that comparing two keys with memcmp puts the rows in
+ * the right order. Integers are stored big-endian with the sign bit flipped,
+ * strings are zero-padded to the column's length, and every byte of a DESC
+ * column is inverted. NULLs sort last with ASC and first with DESC. The keys
+ * are sorted with an MSD radix sort, one byte at a time, which hands small
+ * buckets over to insertion sort.
+ *
+ * When the rows being sorted no longer fit in WORK_MEM, they're sorted and
+ * written to a temporary file as a run. The runs are merged at the end with
+ * a heap of the first row of every run.
+ *
+ * ORDER BY ... LIMIT n only keeps the n smallest rows seen so far, in a
+ * max-heap of n entries, so it never holds more than n rows whatever the
+ * input size. That's only done while n rows fit in WORK_MEM; a larger n
+ * falls back to the external sort, whose runs and merge stop after n rows.
+ * LIMIT without ORDER BY just keeps the first n rows, and asks for no more
+ * once it has them. LIMIT 0 asks for no rows at all.
+ *
+ * The rows are added one at a time, as the scan that produces them reads
+ * them (sort_begin, sort_add_row, sort_end), so the input never has to be
+ * collected first.
+ */
+
+#ifndef SORT_H
+#define SORT_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "parser/parsetree.h"
+#include "storage/record.h"
+#include "resultset/recordset.h"
+
+typedef struct SortKey {
+  Column* col;
+  bool descending;
+} SortKey;
+
+typedef struct Sort {
+  RecordDescriptor* rd;     /* rows being sorted */
+  int numKeys;              /* 0 if there's only a LIMIT */
+  SortKey* keys;
+  uint32_t keyWidth;        /* bytes in a normalized key */
+  int64_t limit;            /* negative if there is no LIMIT */
+  struct SortItem** items;  /* rows in memory, from sort_begin to sort_end */
+  size_t numItems;
+  size_t maxItems;
+  size_t memUsed;           /* bytes the rows in memory take up */
+  struct SortItem* spare;   /* ORDER BY ... LIMIT: key of the row coming in */
+  bool topN;                /* ORDER BY ... LIMIT still keeps its rows in a heap */
+  FILE** runs;              /* sorted runs spilled so far */
+  int numRuns;
+  bool failed;              /* a spill failed, rows are dropped from then on */
+} Sort;
+
+Sort* sort_create(RecordDescriptor* rd, ParseList* sortClause, int64_t limit);
+void free_sort(Sort* sort);
+
+void sort_begin(Sort* sort);
+bool sort_add_row(void* sort, RecordSetRow* row);
+bool sort_end(Sort* sort, RecordSet* rs);
+
+bool sort_execute(Sort* sort, RecordSet* rs);
+
+#endif /* SORT_H */
@@ -7,6 +7,10 @@ typedef enum ConfigParameter {
   CONF_DATA_FILE,
   CONF_PAGE_SIZE,
   CONF_BUFPOOL_SIZE,
+  CONF_MMAP_MODE,
+  CONF_DIRECT_IO,
+  CONF_WORK_MEM,
+  CONF_WORKER_THREADS,
   CONF_UNRECOGNIZED
 } ConfigParameter;
 
@@ -14,8 +18,18 @@ typedef struct Config {
   char* dataFile;
   int pageSize;
   int bufpoolSize;
+  bool mmapMode;      /* read-only scans use pages straight from a mapping of the data file */
+  bool directIO;      /* bypass the OS page cache when reading and writing data pages */
+  int workMem;        /* kilobytes a query operator may use before it spills to disk */
+  int workerThreads;  /* threads that run the parallel parts of a query, see scheduler.h */
 } Config;
 
+#define DEFAULT_WORK_MEM  4096
+#define MIN_WORK_MEM      64
+
+/* one worker thread per core */
+#define DEFAULT_WORKER_THREADS  0
+
 Config* new_config();
 void free_config(Config* conf);
 
@@ -1,8 +1,31 @@
 #ifndef PARSE_H
 #define PARSE_H
 
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+
 #include "parsetree.h"
 
-Node* parse_sql();
+/**
+ * @brief One scanner and its input for a whole run of statements, from a
+ * FILE or from a buffer in memory. The scanner carries what it read ahead
+ * over from one statement to the next, so it's only set up once.
+ * 
+ * scanner | the reentrant flex scanner (a yyscan_t)
+ * buffer  | the scanner's copy of the buffer, NULL when reading a FILE
+ * atEnd   | the input has no statements left
+ */
+typedef struct ParseSession {
+  void* scanner;
+  void* buffer;
+  bool atEnd;
+} ParseSession;
+
+ParseSession* parse_session_from_file(FILE* fp);
+ParseSession* parse_session_from_bytes(const char* data, size_t len);
+void parse_session_destroy(ParseSession* ps);
+
+Node* parse_session_next(ParseSession* ps);
 
-#endif /* PARSE_H */
\ No newline at end of file
+#endif /* PARSE_H */
@@ -21,7 +21,17 @@ typedef enum NodeTag {
   T_SelectStmt,
   T_ParseList,
   T_ResTarget,
-  T_Literal
+  T_Literal,
+  T_CreateIndexStmt,
+  T_ColumnRef,
+  T_BinaryExpr,
+  T_BoolExpr,
+  T_SortBy,
+  T_JoinExpr,
+  T_CopyStmt,
+  T_PrepareStmt,
+  T_ExecuteStmt,
+  T_DeallocateStmt
 } NodeTag;
 
 typedef struct Node {
@@ -46,25 +56,130 @@ typedef struct SysCmd {
 
 typedef struct InsertStmt {
   NodeTag type;
-  ParseList* values;
+  char* tablename;    /* NULL for the default table */
+  ParseList* rows;    /* a ParseList of Literals for each row */
 } InsertStmt;
 
 typedef struct ResTarget {
   NodeTag type;
-  char* name;
+  char* name;         /* column name, NULL for COUNT(*) */
+  char* funcname;     /* aggregate function, NULL for a plain column */
 } ResTarget;
 
 typedef struct SelectStmt {
   NodeTag type;
   ParseList* targetList;
+  char* tablename;        /* NULL if there is no FROM clause */
+  struct JoinExpr* join;  /* NULL if there is no JOIN */
+  Node* whereClause;      /* NULL if there is no WHERE clause */
+  ParseList* groupClause; /* ColumnRefs from GROUP BY, NULL if there is none */
+  ParseList* sortClause;  /* SortBys from ORDER BY, NULL if there is none */
+  int64_t limitCount;     /* negative if there is no LIMIT */
 } SelectStmt;
 
+/**
+ * @brief `JOIN tablename ON lhs = rhs`
+ */
+typedef struct JoinExpr {
+  NodeTag type;
+  char* tablename;
+  Node* lhs;    /* ColumnRef */
+  Node* rhs;    /* ColumnRef */
+} JoinExpr;
+
+typedef struct SortBy {
+  NodeTag type;
+  ResTarget* target;  /* a column, or an aggregate of the target list */
+  bool descending;
+} SortBy;
+
+typedef struct CreateIndexStmt {
+  NodeTag type;
+  char* indexname;
+  char* tablename;
+  char* method;       /* NULL unless USING was given */
+  bool clustered;
+  char* colname;
+  ParseList* includeList;   /* ColumnRefs from INCLUDE, NULL if there were none */
+} CreateIndexStmt;
+
+/**
+ * @brief `COPY tablename FROM 'filename'` or `COPY tablename TO 'filename' [BINARY]`
+ */
+typedef struct CopyStmt {
+  NodeTag type;
+  char* tablename;
+  char* filename;
+  bool isFrom;        /* false for COPY TO */
+  bool binary;        /* write the binary format instead of CSV, only for COPY TO */
+} CopyStmt;
+
+/**
+ * @brief `PREPARE name AS stmt`, where stmt is a SELECT or an INSERT that
+ * may use the parameters $1, $2, ... in place of literals
+ */
+typedef struct PrepareStmt {
+  NodeTag type;
+  char* name;
+  Node* stmt;         /* NULL once it has been handed to the prepared statement */
+} PrepareStmt;
+
+/**
+ * @brief `EXECUTE name` or `EXECUTE name(value, ...)`
+ */
+typedef struct ExecuteStmt {
+  NodeTag type;
+  char* name;
+  ParseList* params;  /* Literals for $1, $2, ..., NULL if there are none */
+} ExecuteStmt;
+
+/**
+ * @brief `DEALLOCATE name`
+ */
+typedef struct DeallocateStmt {
+  NodeTag type;
+  char* name;
+} DeallocateStmt;
+
+typedef struct ColumnRef {
+  NodeTag type;
+  char* name;
+} ColumnRef;
+
+typedef enum ExprOp {
+  EXPR_EQ,
+  EXPR_LT,
+  EXPR_LE,
+  EXPR_GT,
+  EXPR_GE
+} ExprOp;
+
+typedef struct BinaryExpr {
+  NodeTag type;
+  ExprOp op;
+  Node* lhs;
+  Node* rhs;
+} BinaryExpr;
+
+typedef enum BoolExprType {
+  BOOL_AND,
+  BOOL_OR
+} BoolExprType;
+
+typedef struct BoolExpr {
+  NodeTag type;
+  BoolExprType boolop;
+  Node* lhs;
+  Node* rhs;
+} BoolExpr;
+
 typedef struct Literal {
   NodeTag type;
   bool isNull;
   int64_t intVal;
   char* str;
   bool boolVal;
+  int paramNum;       /* n for the parameter $n, 0 for a constant */
 } Literal;
 
 
@@ -90,6 +205,7 @@ void free_node(Node* n);
 void print_node(Node* n);
 
 char* str_strip_quotes(char* str);
+char* str_qualify(char* tablename, char* colname);
 
 ParseList* new_parselist(ParseCell li);
 void free_parselist(ParseList* l);
@@ -1,6 +1,9 @@
 #ifndef RECORDSET_H
 #define RECORDSET_H
 
+#include <stdio.h>
+#include <stddef.h>
+
 #include "storage/record.h"
 #include "utility/linkedlist.h"
 
@@ -17,6 +20,11 @@ RecordSet* new_recordset();
 void free_recordset(RecordSet* rs, RecordDescriptor* rd);
 
 RecordSetRow* new_recordset_row(LinkedList* rows, int ncols);
+bool recordset_append_row(void* rs, RecordSetRow* row);
 void free_recordset_row(RecordSetRow* row, RecordDescriptor* rd);
 
+size_t recordset_row_size(RecordSetRow* row, RecordDescriptor* rd);
+bool recordset_row_write(FILE* fp, RecordSetRow* row, RecordDescriptor* rd);
+RecordSetRow* recordset_row_read(FILE* fp, RecordDescriptor* rd);
+
 #endif /* RECORDSET_H */
\ No newline at end of file
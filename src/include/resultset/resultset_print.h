@@ -3,6 +3,38 @@
 
 #include "resultset/recordset.h"
 
+/**
+ * How result sets are printed, switched with `\format <name>`:
+ * 
+ * aligned | a table with every column padded to its widest value, which
+ *         | takes a pass over the rows to find the widths before printing
+ * csv     | the column names, then a line per row in the CSV format of COPY
+ *         | (see copy.h). Also called "unaligned".
+ * json    | a JSON object per line for each row, keyed by column name
+ * binary  | a uint32 column count, then each column's DataType (uint8) and
+ *         | name (uint16 length and the characters). Each row follows as a
+ *         | uint32 length and that many bytes: a null bitmap and the values
+ *         | of the columns that aren't NULL, as in COPY's binary format.
+ *         | A length of RESULT_BINARY_END ends the result set.
+ * 
+ * All but the aligned format are written in a single pass over the rows,
+ * and leave out the row count banners. Numbers are in the machine's byte
+ * order.
+ */
+typedef enum ResultFormat {
+  RESULT_FORMAT_ALIGNED,
+  RESULT_FORMAT_CSV,
+  RESULT_FORMAT_JSON,
+  RESULT_FORMAT_BINARY
+} ResultFormat;
+
+#define RESULT_BINARY_END 0xFFFFFFFF
+
+bool resultset_parse_format(const char* name, ResultFormat* f);
+const char* resultset_format_name(ResultFormat f);
+ResultFormat resultset_get_format();
+void resultset_set_format(ResultFormat f);
+
 void resultset_print(RecordDescriptor* rd, RecordSet* rs, RecordDescriptor* targets);
 
-#endif /* RESULTSET_PRINT_H */
\ No newline at end of file
+#endif /* RESULTSET_PRINT_H */
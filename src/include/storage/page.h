@@ -9,12 +9,20 @@
 
 typedef char* Page;
 
+/* pages are aligned in memory so they can be used for O_DIRECT I/O */
+#define PAGE_ALIGNMENT 4096
+
+/* supported page sizes, the page size must also be a power of two */
+#define MIN_PAGE_SIZE 4096
+#define MAX_PAGE_SIZE 262144
+
 /**
- * @brief the 20-byte data page header structure
+ * @brief the 28-byte data page header structure
  * 
  * pageId     | one-based page identifier, numbered sequentially from the beginning of
  *              the file to the end. Gaps are not allowed
- * pageType   | 0=data page, 1=index page
+ * pageType   | 0=data page, 1=B+tree index page, 2=hash index page,
+ *              3=visibility map page, 4=zone map page
  * indexLevel | level of the page in a B+tree index. 0=leaf level (or heap page)
  * prevPageId | pointer to the previous page in the current table or index at the
  *              same index level
@@ -24,6 +32,9 @@ typedef char* Page;
  * freeBytes  | number of free bytes on the page
  * freeData   | number of continuous free bytes between the last record and the
  *              beginning of the slot array
+ * checksum   | CRC-32C of the entire page (excluding this field), set every time
+ *              the page is written to disk and verified every time it is read.
+ *              Unused pages (all zeros) have no checksum
  * 
  */
 #pragma pack(push, 1) /* disabling memory alignment because I don't want to deal with it */
@@ -34,25 +45,56 @@ typedef struct PageHeader {
   uint32_t prevPageId;
   uint32_t nextPageId;
   uint16_t numRecords;
-  uint16_t freeBytes;
-  uint16_t freeData;
+  uint32_t freeBytes;
+  uint32_t freeData;
+  uint32_t checksum;
 } PageHeader;
 
+/**
+ * @brief the 6-byte slot array entry. Records are never longer than 64KB, but
+ * pages can be up to MAX_PAGE_SIZE, so the offset needs more than 16 bits.
+ */
 typedef struct SlotPointer {
-  uint16_t offset;
+  uint32_t offset;
   uint16_t length;
 } SlotPointer;
 
+/**
+ * @brief Physical location of a record: the page it lives on and the
+ * (zero-based) position of its SlotPointer in the page's slot array
+ */
+typedef struct RecordId {
+  uint32_t pageId;
+  uint16_t slotId;
+} RecordId;
+#pragma pack(pop)
+
 Page new_page();
 void free_page(Page pg);
 
 void page_zero(Page pg);
 void pageheader_init_datapage(Page pg);
+void pageheader_init_indexpage(Page pg, uint8_t indexLevel);
+void pageheader_init_hashpage(Page pg);
+void pageheader_init_vismappage(Page pg);
+void pageheader_init_zonemappage(Page pg);
 
 void pageheader_set_pageid(Page pg, uint32_t pageId);
 void pageheader_set_prevpageid(Page pg, uint32_t pageId);
 void pageheader_set_nextpageid(Page pg, uint32_t pageId);
 
 bool page_insert(Page pg, Record data, uint16_t length);
+bool page_insert_at(Page pg, Record data, uint16_t length, int slotId);
+
+SlotPointer* page_get_slot(Page pg, int slotId);
+Record page_get_record(Page pg, int slotId);
+
+int page_get_split_slotid(Page pg);
+int page_get_records_size(Page pg, int slotId);
+void page_truncate(Page pg, int numRecords);
+bool page_move_records(Page src, Page dst, int slotId);
+
+void page_set_checksum(Page pg);
+bool page_verify_checksum(Page pg);
 
 #endif /* PAGE_H */
\ No newline at end of file
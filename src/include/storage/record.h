@@ -39,6 +39,7 @@ typedef struct Column {
   int len;
   bool isNotNull;
 } Column;
+#pragma pack(pop)
 
 /**
  * This is the 12-byte record header that is present on every single data record.
@@ -62,6 +63,7 @@ typedef struct RecordDescriptor {
   bool hasNullableColumns;
   Column cols[];
 } RecordDescriptor;
+#pragma pack(pop)
 
 Record record_init(uint16_t recordLen);
 void free_record(Record r);
@@ -72,6 +74,10 @@ void construct_column_desc(Column* col, char* colname, DataType type, int colnum
 
 void fill_record(RecordDescriptor* rd, Record r, Datum* fixed, Datum* varlen, bool* fixedNull, bool* varlenNull, uint8_t* nullBitmap);
 void defill_record(RecordDescriptor* rd, Record r, Datum* values, bool* isnull);
+Record record_serialize(RecordDescriptor* rd, Datum* values, bool* isnull, uint16_t* recordLen);
+
+void record_decode_int_column(RecordDescriptor* rd, Record* records, int numRecords, int colnum, int64_t* values, uint8_t* isnull);
+void record_decode_string_column(RecordDescriptor* rd, Record* records, int numRecords, int colnum, char** data, uint16_t* lens, uint8_t* isnull);
 
 int compute_null_bitmap_length(RecordDescriptor* rd);
 int compute_record_length(
@@ -2,14 +2,56 @@
 #define TABLE_H
 
 #include "storage/record.h"
+#include "utility/linkedlist.h"
 
+/**
+ * @brief Describes a table
+ *
+ * tablename   | name of the table
+ * rd          | descriptor of the table rows
+ * firstPageId | the table's first page, cached from `_tables`. 0 if it isn't
+ *               cached, and then it's looked up whenever it's needed
+ * indexes     | the table's indexes (IndexDescs), cached from `_indexes`. NULL
+ *               if they aren't cached
+ */
 typedef struct TableDesc {
   char* tablename;
   RecordDescriptor* rd;
+  int32_t firstPageId;
+  LinkedList* indexes;
 } TableDesc;
 
+/**
+ * @brief Describes an index on a table
+ * 
+ * objectId     | the index's objectId
+ * indexname    | name of the index
+ * colnum       | colnum of the table column the index is keyed on
+ * type         | 'b' for a B+tree, 'h' for a hash index, 'c' for a clustered
+ *                B+tree whose leaf pages hold the table rows
+ * rootPageId   | pageId of the root page (the meta page for hash indexes). It
+ *                never changes once the index is built
+ * includedCols | (B+trees only) bitmask of the INCLUDE columns, bit n is set
+ *                for colnum n. Their values are copied into the leaf entries
+ * rd           | (clustered indexes only) descriptor of the table rows, borrowed
+ *                from the table's TableDesc. NULL otherwise
+ */
+typedef struct IndexDesc {
+  int64_t objectId;
+  char* indexname;
+  int colnum;
+  char type;
+  int32_t rootPageId;
+  uint64_t includedCols;
+  RecordDescriptor* rd;
+} IndexDesc;
+
 TableDesc* new_tabledesc(char* tablename);
 
 void free_tabledesc(TableDesc* td);
 
+IndexDesc* new_indexdesc(int64_t objectId, char* indexname, int colnum, char type, int32_t rootPageId, uint64_t includedCols);
+
+void free_indexdesc(IndexDesc* idx);
+
 #endif /* TABLE_H */
\ No newline at end of file
@@ -17,7 +17,11 @@
  * major_version            0             2
  * minor_version            2             4
  * patch_num                6             4
- * page_size                10            2
+ * page_size                10            4
+ * vismap_page_id           14            4
+ * 
+ * `vismap_page_id` is the first page of the visibility map, or 0 until the
+ * map is created. Unlike the fields above, it's written after initdb.
  */
 
 #define BOOT_PAGE_ID 1
@@ -33,11 +37,16 @@
 #define MINOR_VERSION_BYTE_POS 2
 #define PATCH_NUM_BYTE_POS 6
 #define PAGE_SIZE_BYTE_POS 10
+#define VISMAP_PAGE_ID_BYTE_POS 14
 
 #define MAJOR_VERSION_BYTE_SIZE 2
 #define MINOR_VERSION_BYTE_SIZE 4
 #define PATCH_NUM_BYTE_SIZE 4
-#define PAGE_SIZE_BYTE_SIZE 2
+#define PAGE_SIZE_BYTE_SIZE 4
+#define VISMAP_PAGE_ID_BYTE_SIZE 4
+
+/* number of bytes at the start of the boot page that hold the fields above */
+#define BOOT_FIELDS_BYTE_SIZE 18
 
 bool init_boot_page(BufMgr* buf, BufTag* tag);
 
@@ -52,12 +61,17 @@ bool init_boot_page(BufMgr* buf, BufTag* tag);
 void set_major_version(BufMgr* buf, int32_t bufId, uint16_t val);
 void set_minor_version(BufMgr* buf, int32_t bufId, uint32_t val);
 void set_patch_num(BufMgr* buf, int32_t bufId, uint32_t val);
-void set_page_size(BufMgr* buf, int32_t bufId, uint16_t val);
+void set_page_size(BufMgr* buf, int32_t bufId, uint32_t val);
 
 uint16_t get_major_version(BufMgr* buf);
 uint32_t get_minor_version(BufMgr* buf);
 uint32_t get_patch_num(BufMgr* buf);
-uint16_t get_page_size(BufMgr* buf);
+uint32_t get_page_size(BufMgr* buf);
+
+uint32_t get_vismap_page_id(BufMgr* buf);
+void set_vismap_page_id(BufMgr* buf, uint32_t val);
+
+bool boot_read_page_size(char* dataFile, int* pageSize);
 
 void flush_boot_page(BufMgr* buf);
 
@@ -23,6 +23,9 @@ typedef enum CliSysCmd {
   SYSCMD_SYS_TABLE_TABLES,
   SYSCMD_SYS_TABLE_COLUMNS,
   SYSCMD_SYS_TABLE_SEQUENCES,
+  SYSCMD_SYS_TABLE_EXTENTS,
+  SYSCMD_SYS_TABLE_INDEXES,
+  SYSCMD_FORMAT,
   SYSCMD_UNRECOGNIZED
 } CliSysCmd;
 
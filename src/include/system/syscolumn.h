@@ -22,4 +22,6 @@ RecordDescriptor* syscolumn_get_record_desc();
 
 bool syscolumninit_insert_record(BufMgr* buf, SysColumn* c);
 
+RecordDescriptor* syscolumn_get_table_record_desc(BufMgr* buf, int64_t tableId);
+
 #endif /* SYSCOLUMN_H */
\ No newline at end of file
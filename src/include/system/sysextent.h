@@ -0,0 +1,29 @@
+#ifndef SYSEXTENT_H
+#define SYSEXTENT_H
+
+#include <stdint.h>
+
+#include "buffer/bufmgr.h"
+#include "storage/record.h"
+
+/**
+ * The `_extents` system table tracks which extent of EXTENT_SIZE contiguous
+ * pages belongs to which table or index. `table_id` holds the objectId of
+ * either one. An object owns every page in the
+ * extents listed for it.
+ */
+typedef struct SysExtent {
+  int64_t tableId;
+  int32_t firstPageId;
+  int32_t pageCount;
+} SysExtent;
+
+RecordDescriptor* sysextent_get_record_desc();
+
+bool sysextentinit_insert_record(BufMgr* buf, SysExtent* e);
+
+bool sysextent_track_page(BufMgr* buf, char* tablename, int32_t pageId);
+bool sysextent_track_object_page(BufMgr* buf, int64_t objectId, int32_t pageId);
+int32_t sysextent_get_last_extent(BufMgr* buf, int64_t objectId);
+
+#endif /* SYSEXTENT_H */
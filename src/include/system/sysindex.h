@@ -0,0 +1,33 @@
+#ifndef SYSINDEX_H
+#define SYSINDEX_H
+
+#include <stdint.h>
+
+#include "buffer/bufmgr.h"
+#include "storage/record.h"
+#include "storage/table.h"
+#include "utility/linkedlist.h"
+
+/**
+ * The `_indexes` system table has one row per index. Indexes are not listed
+ * in `_tables`, they are reached through the table they belong to.
+ */
+typedef struct SysIndex {
+  int64_t objectId;
+  int64_t tableId;
+  char* name;
+  uint8_t colnum;       /* colnum of the indexed column in the table */
+  char* type;           /* 'b' for B+tree, 'h' for hash, 'c' for clustered */
+  int32_t rootPageId;
+  uint64_t includedCols;  /* bitmask of the INCLUDE columns, bit n is set for colnum n */
+} SysIndex;
+
+RecordDescriptor* sysindex_get_record_desc();
+
+bool sysindexinit_insert_record(BufMgr* buf, SysIndex* idx);
+
+LinkedList* sysindex_get_table_indexes(BufMgr* buf, int64_t tableId);
+IndexDesc* sysindex_get_clustered_index(BufMgr* buf, int64_t tableId);
+void sysindex_free_index_list(LinkedList* indexes);
+
+#endif /* SYSINDEX_H */
\ No newline at end of file
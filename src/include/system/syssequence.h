@@ -19,4 +19,6 @@ RecordDescriptor* syssequence_get_record_desc();
 
 bool syssequenceinit_insert_record(BufMgr* buf, SysSequence* s);
 
+int64_t syssequence_next_value(BufMgr* buf, char* name);
+
 #endif /* SYSSEQUENCE_H */
\ No newline at end of file
@@ -14,6 +14,7 @@ typedef struct SysTable {
   char* type;           /* 's' for system | 'u' for user */
   int32_t firstPageId;
   int32_t lastPageId;
+  int32_t zonemapPageId;  /* first page of the table's zone map, 0 if it has none */
 } SysTable;
 
 RecordDescriptor* systable_get_record_desc();
@@ -23,8 +24,10 @@ bool systableinit_insert_record(BufMgr* buf, SysTable* t);
 int64_t systable_get_objectId(BufMgr* buf, char* tablename);
 int32_t systable_get_first_pageid(BufMgr* buf, char* tablename);
 int32_t systable_get_last_pageid(BufMgr* buf, char* tablename);
+int32_t systable_get_zonemap_pageid(BufMgr* buf, char* tablename);
 
 bool systable_set_first_pageid(BufMgr* buf, char* tablename, int32_t firstPageId);
 bool systable_set_last_pageid(BufMgr* buf, char* tablename, int32_t lastPageId);
+bool systable_set_zonemap_pageid(BufMgr* buf, char* tablename, int32_t zonemapPageId);
 
 #endif /* SYSTABLE_H */
\ No newline at end of file
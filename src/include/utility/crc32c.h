@@ -0,0 +1,24 @@
+#ifndef CRC32C_H
+#define CRC32C_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/**
+ * CRC-32C (Castagnoli) checksums. Uses the SSE4.2 or ARMv8 CRC32 instructions
+ * when the CPU has them and a table-driven implementation otherwise.
+ * 
+ * `crc32c_extend` continues a checksum over another chunk of data, so a
+ * buffer can be checksummed in pieces. Start with `CRC32C_INIT` and finish
+ * with `crc32c_finish`.
+ */
+
+#define CRC32C_INIT 0xFFFFFFFF
+
+uint32_t crc32c_extend(uint32_t crc, const char* data, size_t len);
+bool crc32c_use_hardware(bool hardware);
+
+#define crc32c_finish(crc)   ((crc) ^ 0xFFFFFFFF)
+
+#endif /* CRC32C_H */
@@ -13,11 +13,13 @@ typedef struct LinkedList {
   ListItem* head;
   ListItem* tail;
 } LinkedList;
+#pragma pack(pop)
 
 LinkedList* new_linkedlist();
 void free_linkedlist(LinkedList* l, void (*cleanup)(void*));
 
 void linkedlist_append(LinkedList* l, void* ptr);
+void linkedlist_concat(LinkedList* l, LinkedList* other);
 ListItem* linkedlist_search(LinkedList* l, void* ptr, bool (*comparison)(void*, void*));
 
 #endif /* LINKEDLIST_H */
\ No newline at end of file
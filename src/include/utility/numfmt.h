@@ -0,0 +1,21 @@
+#ifndef NUMFMT_H
+#define NUMFMT_H
+
+#include <stdint.h>
+
+/**
+ * Integer to decimal text conversion, for the places that format a lot of
+ * numbers (printing result sets, COPY TO). Unlike sprintf, nothing is
+ * parsed and nothing is null-terminated: the digits are written straight
+ * into the caller's buffer, two at a time from a table of "00" to "99".
+ * 
+ * The buffer must have room for NUMFMT_MAX_LEN characters.
+ */
+
+#define NUMFMT_MAX_LEN 20   /* "-9223372036854775808" */
+
+int numfmt_digits(uint64_t v);
+int numfmt_len(int64_t v);
+int numfmt_int64(char* dst, int64_t v);
+
+#endif /* NUMFMT_H */
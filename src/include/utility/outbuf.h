@@ -0,0 +1,40 @@
+#ifndef OUTBUF_H
+#define OUTBUF_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * An output buffer for code that writes a lot of small pieces, e.g. the
+ * cells of a result set. The pieces are copied into one big buffer that
+ * goes out with a single fwrite when it's full or when outbuf_flush is
+ * called, instead of a printf per piece. Since it goes through the FILE,
+ * the output still comes out in order with plain printf calls as long as
+ * the buffer is flushed before them.
+ * 
+ * fp   | where the output goes
+ * data | buffered output
+ * len  | bytes in `data`
+ * cap  | size of `data`
+ */
+typedef struct OutBuf {
+  FILE* fp;
+  char* data;
+  size_t len;
+  size_t cap;
+} OutBuf;
+
+#define OUTBUF_SIZE 65536
+
+OutBuf* new_outbuf(FILE* fp, size_t cap);
+void free_outbuf(OutBuf* ob);
+void outbuf_flush(OutBuf* ob);
+
+void outbuf_write(OutBuf* ob, const char* data, size_t len);
+void outbuf_puts(OutBuf* ob, const char* str);
+void outbuf_putc(OutBuf* ob, char c);
+void outbuf_fill(OutBuf* ob, char c, int n);
+void outbuf_int64(OutBuf* ob, int64_t v);
+
+#endif /* OUTBUF_H */
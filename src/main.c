@@ -3,6 +3,7 @@
 #include <stdbool.h>
 #include <string.h>
 #include <strings.h>
+#include <unistd.h>
 
 #include "gram.tab.h"
 #include "parser/parsetree.h"
@@ -15,59 +16,51 @@
 #include "resultset/recordset.h"
 #include "resultset/resultset_print.h"
 #include "access/tableam.h"
+#include "access/indexam.h"
+#include "access/visibilitymap.h"
+#include "executor/qual.h"
+#include "executor/agg.h"
+#include "executor/sort.h"
+#include "executor/join.h"
+#include "executor/scheduler.h"
+#include "executor/copy.h"
+#include "executor/prepare.h"
 #include "utility/linkedlist.h"
 #include "system/syscmd.h"
 #include "system/initdb.h"
+#include "system/systable.h"
+#include "system/syscolumn.h"
+#include "system/sysindex.h"
 
 Config* conf;
+Scheduler* sched;
 
 /* TEMPORARY CODE SECTION */
 
-#define RECORD_LEN  48
-#define BUFPOOL_SLOTS  1
+/* INSERT, and SELECT without a FROM clause, run against this table */
+#define DEFAULT_TABLE_NAME  "person"
 
-static void populate_datum_array(Datum* fixed, Datum* varlen, bool* fixedNull, bool* varlenNull, ParseList* values) {
-  Literal* personId = (Literal*)values->elements[0].ptr;
-  Literal* firstName = (Literal*)values->elements[1].ptr;
-  Literal* lastName = (Literal*)values->elements[2].ptr;
-  Literal* age = (Literal*)values->elements[3].ptr;
+static TableDesc* get_tabledesc(BufMgr* buf, char* tablename) {
+  int64_t tableId = systable_get_objectId(buf, tablename);
+  if (tableId < 0) return NULL;
 
-  fixed[0] = int32GetDatum(personId->intVal);
-  fixedNull[0] = false;
+  TableDesc* td = new_tabledesc(tablename);
+  td->rd = syscolumn_get_table_record_desc(buf, tableId);
 
-  if (age->isNull) {
-    fixed[1] = (Datum)NULL;
-    fixedNull[1] = true;
-  } else {
-    fixed[1] = int32GetDatum(age->intVal);
-    fixedNull[1] = false;
-  }
-  
-  if (firstName->isNull) {
-    varlen[0] = (Datum)NULL;
-    varlenNull[0] = true;
-  } else {
-    varlen[0] = charGetDatum(firstName->str);
-    varlenNull[0] = false;
+  if (td->rd == NULL) {
+    free_tabledesc(td);
+    return NULL;
   }
-  
-  varlen[1] = charGetDatum(lastName->str);
-  varlenNull[1] = false;
-}
 
-static RecordDescriptor* construct_record_descriptor() {
-  RecordDescriptor* rd = malloc(sizeof(RecordDescriptor) + (4 * sizeof(Column)));
-  rd->ncols = 4;
-  rd->nfixed = 2;
-
-  construct_column_desc(&rd->cols[0], "person_id", DT_INT, 0, 4, true);
-  construct_column_desc(&rd->cols[1], "first_name", DT_VARCHAR, 1, 20, false);
-  construct_column_desc(&rd->cols[2], "last_name", DT_VARCHAR, 2, 20, true);
-  construct_column_desc(&rd->cols[3], "age", DT_INT, 3, 4, false);
+  return td;
+}
 
-  rd->hasNullableColumns = true;
+static Column* get_column(RecordDescriptor* rd, char* colname) {
+  for (int i = 0; i < rd->ncols; i++) {
+    if (strcasecmp(rd->cols[i].colname, colname) == 0) return &rd->cols[i];
+  }
 
-  return rd;
+  return NULL;
 }
 
 static RecordDescriptor* construct_record_descriptor_from_target_list(ParseList* targetList) {
@@ -84,134 +77,723 @@ static RecordDescriptor* construct_record_descriptor_from_target_list(ParseList*
   return rd;
 }
 
-void free_record_desc(RecordDescriptor* rd) {
-  for (int i = 0; i < rd->ncols; i++) {
-    if (rd->cols[i].colname != NULL) {
-      free(rd->cols[i].colname);
-    }
+/**
+ * @brief Computes the range of keys that satisfy `col <op> value`. Returns
+ * false if no key can, e.g. `col < INT64_MIN`.
+ */
+static bool where_clause_key_range(ExprOp op, int64_t value, int64_t* lowKey, int64_t* highKey) {
+  *lowKey = INT64_MIN;
+  *highKey = INT64_MAX;
+
+  switch (op) {
+    case EXPR_EQ:
+      *lowKey = value;
+      *highKey = value;
+      return true;
+    case EXPR_LT:
+      if (value == INT64_MIN) return false;
+      *highKey = value - 1;
+      return true;
+    case EXPR_LE:
+      *highKey = value;
+      return true;
+    case EXPR_GT:
+      if (value == INT64_MAX) return false;
+      *lowKey = value + 1;
+      return true;
+    case EXPR_GE:
+      *lowKey = value;
+      return true;
+  }
+
+  return false;
+}
+
+static uint64_t get_expr_columns(TableDesc* td, Node* expr) {
+  if (expr->type == T_BoolExpr) {
+    return get_expr_columns(td, ((BoolExpr*)expr)->lhs) | get_expr_columns(td, ((BoolExpr*)expr)->rhs);
+  }
+
+  Column* col = get_column(td->rd, ((ColumnRef*)((BinaryExpr*)expr)->lhs)->name);
+  return col->colnum < 64 ? 1ULL << col->colnum : UINT64_MAX;
+}
+
+/**
+ * @brief Returns a bitmask of every column the SELECT reads, bit n for colnum n
+ */
+static uint64_t get_needed_columns(TableDesc* td, SelectStmt* s) {
+  uint64_t needed = 0;
+
+  for (int i = 0; i < s->targetList->length; i++) {
+    char* name = ((ResTarget*)s->targetList->elements[i].ptr)->name;
+    if (name == NULL) continue;
+
+    Column* col = get_column(td->rd, name);
+    needed |= col->colnum < 64 ? 1ULL << col->colnum : UINT64_MAX;
+  }
+
+  for (int i = 0; s->groupClause != NULL && i < s->groupClause->length; i++) {
+    Column* col = get_column(td->rd, ((ColumnRef*)s->groupClause->elements[i].ptr)->name);
+    needed |= col->colnum < 64 ? 1ULL << col->colnum : UINT64_MAX;
+  }
+
+  for (int i = 0; s->sortClause != NULL && i < s->sortClause->length; i++) {
+    ResTarget* r = ((SortBy*)s->sortClause->elements[i].ptr)->target;
+    Column* col = r->funcname == NULL ? get_column(td->rd, r->name) : NULL;
+    if (col != NULL) needed |= col->colnum < 64 ? 1ULL << col->colnum : UINT64_MAX;
   }
-  free(rd);
+
+  if (s->whereClause != NULL) needed |= get_expr_columns(td, s->whereClause);
+
+  return needed;
+}
+
+/**
+ * @brief Picks the access path of a SELECT on one table: a WHERE clause
+ * that is a single comparison on an indexed integer column is answered with
+ * an index lookup, preferably of an index that covers every column the query
+ * reads. A parameter counts as an integer here, EXECUTE checks its value.
+ *
+ * @return IndexDesc* the index to look up, NULL if the table is scanned
+ */
+static IndexDesc* plan_selectstmt(BufMgr* buf, TableDesc* td, Join* join, SelectStmt* s) {
+  if (join != NULL || s->whereClause == NULL || s->whereClause->type != T_BinaryExpr) return NULL;
+
+  BinaryExpr* e = (BinaryExpr*)s->whereClause;
+  Column* col = get_column(td->rd, ((ColumnRef*)e->lhs)->name);
+  Literal* l = (Literal*)e->rhs;
+
+  if (!indexam_is_indexable(col->dataType) || col->dataType == DT_BOOL) return NULL;
+  if (l->paramNum == 0 && (l->isNull || l->str != NULL)) return NULL;
+
+  return indexam_find_index(buf, td, col->colnum, e->op != EXPR_EQ, get_needed_columns(td, s));
 }
 
-static void serialize_data(RecordDescriptor* rd, Record r, ParseList* values) {
-  Datum* fixed = malloc(rd->nfixed * sizeof(Datum));
-  Datum* varlen = malloc((rd->ncols - rd->nfixed) * sizeof(Datum));
-  bool* fixedNull = malloc(rd->nfixed * sizeof(bool));
-  bool* varlenNull = malloc((rd->ncols - rd->nfixed) * sizeof(bool));
+/**
+ * @brief Runs a SELECT. With an index picked by plan_selectstmt, the WHERE
+ * clause is answered with an index lookup. When the index covers every
+ * column the query reads, the lookup doesn't touch the table at all.
+ * Everything else scans the table, skipping the page ranges its zone map
+ * rules out and checking the WHERE clause a page of records at a time.
+ * A JOIN is a hash join of the two tables instead (see join.h).
+ * Aggregates and GROUP BY are computed over the rows that come out of that,
+ * then ORDER BY and LIMIT over the result. A table scan or a join hands
+ * its rows straight to the aggregation (or, without one, the sort) as it
+ * makes them, without collecting them.
+ */
+static void execute_selectstmt(BufMgr* buf, TableDesc* td, Join* join, IndexDesc* idx, SelectStmt* s) {
+  RecordDescriptor* rd = join == NULL ? td->rd : join->rd;
+  Agg* agg = NULL;
+  Sort* sort = NULL;
+
+  if (agg_is_needed(s)) {
+    agg = agg_create(rd, s->targetList, s->groupClause);
+    if (agg == NULL) return;
+  }
+
+  if (s->sortClause != NULL || s->limitCount >= 0) {
+    sort = sort_create(agg == NULL ? rd : agg->outRd, s->sortClause, s->limitCount);
+    if (sort == NULL) {
+      free_agg(agg);
+      return;
+    }
+  }
+
+  RecordSet* rs = new_recordset();
+  RecordSet* out = NULL;
+  bool streamed = false;  /* the scan fed its rows to the Agg or Sort itself */
+  bool sorted = true;
+  bool joined = true;
 
-  populate_datum_array(fixed, varlen, fixedNull, varlenNull, values);
+  if (idx != NULL) {
+    BinaryExpr* e = (BinaryExpr*)s->whereClause;
+    Literal* l = (Literal*)e->rhs;
+
+    /* a parameter can be bound to a value the index can't look up */
+    if (l->isNull || l->str != NULL) idx = NULL;
+  }
 
-  int nullOffset = sizeof(RecordHeader) + compute_record_fixed_length(rd, fixedNull);
-  ((RecordHeader*)r)->nullOffset = nullOffset;
+  if (idx != NULL) {
+    BinaryExpr* e = (BinaryExpr*)s->whereClause;
+    int64_t lowKey, highKey;
 
-  uint8_t* nullBitmap = r + nullOffset;
-  fill_record(rd, r + sizeof(RecordHeader), fixed, varlen, fixedNull, varlenNull, nullBitmap);
+    if (where_clause_key_range(e->op, ((Literal*)e->rhs)->intVal, &lowKey, &highKey)) {
+      indexam_lookup(buf, td, idx, lowKey, highKey, get_needed_columns(td, s), rs);
+    }
+  } else {
+    Qual* qual = s->whereClause == NULL ? NULL : qual_compile(rd, s->whereClause);
+
+    /* qual_compile already said what's wrong with the WHERE clause */
+    if (s->whereClause != NULL && qual == NULL) {
+      free_recordset(rs, rd);
+      free_agg(agg);
+      free_sort(sort);
+      return;
+    }
 
-  free(fixed);
-  free(varlen);
-  free(fixedNull);
-  free(varlenNull);
+    TableamRowFunc fn = recordset_append_row;
+    void* arg = rs;
+
+    if (agg != NULL) {
+      agg_begin(agg);
+      fn = agg_add_row;
+      arg = agg;
+    } else if (sort != NULL) {
+      sort_begin(sort);
+      fn = sort_add_row;
+      arg = sort;
+    }
+
+    if (join != NULL) {
+      joined = join_execute(buf, join, qual, fn, arg);
+    } else {
+      tableam_scan_rows(buf, td, qual, fn, arg);
+      free_qual(qual);
+    }
+
+    if (agg != NULL) {
+      out = agg_end(agg);
+    } else if (sort != NULL) {
+      sorted = sort_end(sort, rs);
+    }
+    streamed = true;
+  }
+
+  if (agg != NULL) {
+    if (!streamed) out = agg_execute(agg, rs);
+    /* a failed join already said what went wrong */
+    if (joined && out != NULL && (sort == NULL || sort_execute(sort, out))) {
+      resultset_print(agg->outRd, out, agg->outRd);
+    }
+
+    free_recordset(out, agg->outRd);
+  } else {
+    RecordDescriptor* targets = construct_record_descriptor_from_target_list(s->targetList);
+    if (!streamed) sorted = sort == NULL || sort_execute(sort, rs);
+    if (joined && sorted) resultset_print(rd, rs, targets);
+    free_record_desc(targets);
+  }
+
+  free_recordset(rs, rd);
+  free_agg(agg);
+  free_sort(sort);
 }
 
-// static int compute_record_length(RecordDescriptor* rd, ParseList* values) {
-//   int len = 12; // start with the 12-byte header
-//   len += compute_null_bitmap_length(rd);
+/**
+ * @brief Rewrites a column name of the SELECT into the name of the column it
+ * means in the rows the SELECT reads: `table.column` with a JOIN (see
+ * join_resolve_column), the bare column name otherwise
+ */
+static bool resolve_column_name(TableDesc* td, Join* join, char** name) {
+  char* resolved;
+
+  if (*name == NULL) return true;
 
-//   len += 4; // person_id
+  if (join != NULL) {
+    resolved = join_resolve_column(join, *name);
+  } else {
+    char* dot = strchr(*name, '.');
+    if (dot == NULL) return true;
 
-//   Literal* firstName = (Literal*)values->elements[1].ptr;
-//   Literal* lastName = (Literal*)values->elements[2].ptr;
-//   Literal* age = (Literal*)values->elements[3].ptr;
+    int tablenameLen = dot - *name;
+    if (tablenameLen != (int)strlen(td->tablename) || strncasecmp(*name, td->tablename, tablenameLen) != 0) {
+      printf("Table %.*s is not in the FROM clause\n", tablenameLen, *name);
+      return false;
+    }
 
-//   /* for the varlen columns, we default to their max length if the values
-//      we're trying to insert would overflow them (they'll get truncated later) */
-//   if (firstName->isNull) {
-//     len += 0; // Nulls do not consume any space
-//   } else if (strlen(firstName->str) > rd->cols[1].len) {
-//     len += (rd->cols[1].len + 2);
-//   } else {
-//     len += (strlen(firstName->str) + 2);
-//   }
+    resolved = strdup(dot + 1);
+  }
 
-//   // We don't need a null check because this column is constrained to be Not Null
-//   if (strlen(lastName->str) > rd->cols[2].len) {
-//     len += (rd->cols[2].len + 2);
-//   } else {
-//     len += (strlen(lastName->str) + 2);
-//   }
+  if (resolved == NULL) return false;
+
+  free(*name);
+  *name = resolved;
+
+  return true;
+}
 
-//   if (age->isNull) {
-//     len += 0; // Nulls do not consume any space
-//   } else {
-//     len += 4; // age
-//   }
+static bool resolve_expr(TableDesc* td, Join* join, Node* expr) {
+  if (expr->type == T_BoolExpr) {
+    return resolve_expr(td, join, ((BoolExpr*)expr)->lhs) && resolve_expr(td, join, ((BoolExpr*)expr)->rhs);
+  }
 
-//   return len;
-// }
+  return resolve_column_name(td, join, &((ColumnRef*)((BinaryExpr*)expr)->lhs)->name);
+}
 
-// static bool insert_record(BufMgr* buf, ParseList* values) {
-//   RecordDescriptor* rd = construct_record_descriptor();
+/**
+ * @brief Resolves every column name of the SELECT (see resolve_column_name)
+ * and the columns the JOIN is on
+ */
+static bool resolve_selectstmt(TableDesc* td, Join* join, SelectStmt* s) {
+  for (int i = 0; i < s->targetList->length; i++) {
+    if (!resolve_column_name(td, join, &((ResTarget*)s->targetList->elements[i].ptr)->name)) return false;
+  }
 
-//   int recordLength = compute_record_length(rd, values);
-//   Record r = record_init(recordLength);
+  if (s->whereClause != NULL && !resolve_expr(td, join, s->whereClause)) return false;
 
-//   serialize_data(rd, r, values);
+  for (int i = 0; s->groupClause != NULL && i < s->groupClause->length; i++) {
+    if (!resolve_column_name(td, join, &((ColumnRef*)s->groupClause->elements[i].ptr)->name)) return false;
+  }
 
-//   bool insertSuccessful = tableam_insert(buf, NULL, r, recordLength);
+  for (int i = 0; s->sortClause != NULL && i < s->sortClause->length; i++) {
+    if (!resolve_column_name(td, join, &((SortBy*)s->sortClause->elements[i].ptr)->target->name)) return false;
+  }
 
-//   free_record_desc(rd);
-//   free(r);
-  
-//   return insertSuccessful;
-// }
+  if (join == NULL) return true;
 
-static bool analyze_selectstmt(SelectStmt* s) {
+  ColumnRef* lhs = (ColumnRef*)s->join->lhs;
+  ColumnRef* rhs = (ColumnRef*)s->join->rhs;
+
+  return resolve_column_name(td, join, &lhs->name)
+    && resolve_column_name(td, join, &rhs->name)
+    && join_set_keys(join, lhs->name, rhs->name);
+}
+
+static bool analyze_expr(RecordDescriptor* rd, Node* expr) {
+  if (expr->type == T_BoolExpr) {
+    return analyze_expr(rd, ((BoolExpr*)expr)->lhs) && analyze_expr(rd, ((BoolExpr*)expr)->rhs);
+  }
+
+  return get_column(rd, ((ColumnRef*)((BinaryExpr*)expr)->lhs)->name) != NULL;
+}
+
+static bool analyze_selectstmt(RecordDescriptor* rd, SelectStmt* s) {
   for (int i = 0; i < s->targetList->length; i++) {
     ResTarget* r = (ResTarget*)s->targetList->elements[i].ptr;
-    if (
-      !(
-        strcasecmp(r->name, "person_id") == 0 ||
-        strcasecmp(r->name, "first_name") == 0 ||
-        strcasecmp(r->name, "last_name") == 0 ||
-        strcasecmp(r->name, "age") == 0
-      )
-    ) {
+    if (r->name != NULL && get_column(rd, r->name) == NULL) {
       return false;
     }
   }
+
+  for (int i = 0; s->groupClause != NULL && i < s->groupClause->length; i++) {
+    if (get_column(rd, ((ColumnRef*)s->groupClause->elements[i].ptr)->name) == NULL) {
+      return false;
+    }
+  }
+
+  if (s->whereClause != NULL && !analyze_expr(rd, s->whereClause)) {
+    return false;
+  }
+
   return true;
 }
 
-static bool analyze_insertstmt(InsertStmt* i) {
-  Literal* personId = (Literal*)i->values->elements[0].ptr;
-  Literal* lastName = (Literal*)i->values->elements[2].ptr;
+static bool analyze_insert_row_widths(TableDesc* td, InsertStmt* i) {
+  for (int r = 0; r < i->rows->length; r++) {
+    ParseList* row = (ParseList*)i->rows->elements[r].ptr;
 
-  if (personId->isNull) return false;
-  if (lastName->isNull) return false;
+    if (row->length != td->rd->ncols) {
+      printf("Table %s has %d columns, row %d has %d values\n", td->tablename, td->rd->ncols, r + 1, row->length);
+      return false;
+    }
+  }
 
   return true;
 }
 
-static bool analyze_node(Node* n) {
-  switch (n->type) {
-    case T_SelectStmt:
-      return analyze_selectstmt((SelectStmt*)n);
-    case T_InsertStmt:
-      return analyze_insertstmt((InsertStmt*)n);
-    default:
-      printf("analyze_node() | unhandled node type");
+/**
+ * @brief Checks every row of the INSERT against the table's columns and
+ * serializes them, so that a bad row keeps the whole statement out
+ *
+ * @param td
+ * @param i
+ * @param records returns one record per row
+ * @param recordLens
+ * @return true
+ * @return false if any row doesn't fit the table. No records are returned.
+ */
+static bool analyze_insertstmt(TableDesc* td, InsertStmt* i, Record* records, uint16_t* recordLens) {
+  RecordDescriptor* rd = td->rd;
+  Datum* values = malloc(sizeof(Datum) * rd->ncols);
+  bool* isnull = malloc(sizeof(bool) * rd->ncols);
+  int numRecords = 0;
+  bool success = analyze_insert_row_widths(td, i);
+
+  for (int r = 0; r < i->rows->length && success; r++) {
+    ParseList* row = (ParseList*)i->rows->elements[r].ptr;
+
+    for (int c = 0; c < rd->ncols && success; c++) {
+      Column* col = &rd->cols[c];
+      success = copy_literal_to_datum(col, (Literal*)row->elements[c].ptr, &values[col->colnum], &isnull[col->colnum]);
+    }
+
+    if (success) {
+      records[numRecords] = record_serialize(rd, values, isnull, &recordLens[numRecords]);
+      numRecords++;
+    }
+  }
+
+  if (!success) {
+    for (int r = 0; r < numRecords; r++) free(records[r]);
+  }
+
+  free(values);
+  free(isnull);
+
+  return success;
+}
+
+/**
+ * @brief Looks up the tables of a SELECT and checks its columns against
+ * them. On success, the caller owns `td`, `joinTd` and `join`.
+ */
+static bool analyze_select(BufMgr* buf, SelectStmt* s, TableDesc** td, TableDesc** joinTd, Join** join) {
+  *td = get_tabledesc(buf, s->tablename != NULL ? s->tablename : DEFAULT_TABLE_NAME);
+  *joinTd = s->join == NULL ? NULL : get_tabledesc(buf, s->join->tablename);
+  *join = *td == NULL || *joinTd == NULL ? NULL : join_create(*td, *joinTd);
+
+  if (*td == NULL && s->tablename != NULL) {
+    printf("Table %s does not exist\n", s->tablename);
+  } else if (s->join != NULL && *joinTd == NULL) {
+    printf("Table %s does not exist\n", s->join->tablename);
+  } else if (*td == NULL || !resolve_selectstmt(*td, *join, s) || !analyze_selectstmt(*join == NULL ? (*td)->rd : (*join)->rd, s)) {
+    printf("Semantic analysis failed\n");
+  } else {
+    return true;
+  }
+
+  free_join(*join);
+  free_tabledesc(*joinTd);
+  free_tabledesc(*td);
+  *join = NULL;
+  *joinTd = NULL;
+  *td = NULL;
+
+  return false;
+}
+
+static TableDesc* get_insert_tabledesc(BufMgr* buf, InsertStmt* i) {
+  TableDesc* td = get_tabledesc(buf, i->tablename != NULL ? i->tablename : DEFAULT_TABLE_NAME);
+
+  if (td == NULL && i->tablename != NULL) {
+    printf("Table %s does not exist\n", i->tablename);
+  } else if (td == NULL) {
+    printf("Semantic analysis failed\n");
+  }
+
+  return td;
+}
+
+static void execute_insertstmt(BufMgr* buf, TableDesc* td, InsertStmt* i) {
+  Record* records = malloc(sizeof(Record) * i->rows->length);
+  uint16_t* recordLens = malloc(sizeof(uint16_t) * i->rows->length);
+
+  if (!analyze_insertstmt(td, i, records, recordLens)) {
+    printf("Semantic analysis failed\n");
+  } else {
+    if (!copy_insert_batch(buf, td, records, recordLens, i->rows->length)) {
+      printf("Unable to insert record\n");
+    }
+    for (int r = 0; r < i->rows->length; r++) free(records[r]);
   }
 
+  free(records);
+  free(recordLens);
+}
+
+/**
+ * @brief Statements outside of PREPARE can't have parameters
+ */
+static bool analyze_no_params(Node* n) {
+  Literal* param;
+
+  if (prepare_collect_params(n, NULL) == 0) return true;
+
+  prepare_collect_params(n, &param);
+  printf("There is no parameter $%d outside of PREPARE\n", param->paramNum);
+
   return false;
 }
 
+/**
+ * @brief Caches the table's first page and its indexes in its TableDesc, so
+ * a prepared statement's scans and inserts don't look them up in the catalog
+ * on every EXECUTE. Neither changes until an index is created on the table,
+ * which makes the statement plan again. A table without pages gets its first
+ * page on its first insert, so that's only cached once there is one.
+ */
+static void cache_table_catalog(BufMgr* buf, TableDesc* td) {
+  int32_t firstPageId = systable_get_first_pageid(buf, td->tablename);
+  td->firstPageId = firstPageId > 0 ? firstPageId : 0;
+
+  if (td->indexes != NULL) sysindex_free_index_list(td->indexes);
+  td->indexes = sysindex_get_table_indexes(buf, systable_get_objectId(buf, td->tablename));
+}
+
+/**
+ * @brief Looks up the tables of a prepared statement, checks it against
+ * them and picks its access path. When the plan has only gone stale, just
+ * the access path is picked again: the tables themselves can't change.
+ */
+static bool plan_prepared(BufMgr* buf, PreparedStmt* p) {
+  if (p->td == NULL) {
+    if (p->stmt->type == T_SelectStmt) {
+      if (!analyze_select(buf, (SelectStmt*)p->stmt, &p->td, &p->joinTd, &p->join)) return false;
+    } else {
+      p->td = get_insert_tabledesc(buf, (InsertStmt*)p->stmt);
+      if (p->td == NULL || !analyze_insert_row_widths(p->td, (InsertStmt*)p->stmt)) return false;
+    }
+  }
+
+  if (p->stmt->type == T_SelectStmt) {
+    free_indexdesc(p->idx);
+    p->idx = plan_selectstmt(buf, p->td, p->join, (SelectStmt*)p->stmt);
+  }
+
+  cache_table_catalog(buf, p->td);
+  if (p->joinTd != NULL) cache_table_catalog(buf, p->joinTd);
+
+  p->planned = true;
+
+  return true;
+}
+
+static void run_prepare(BufMgr* buf, PrepareStmt* ps) {
+  if (prepare_find(ps->name) != NULL) {
+    printf("Prepared statement %s already exists\n", ps->name);
+    return;
+  }
+
+  PreparedStmt* p = new_preparedstmt(strdup(ps->name), ps->stmt);
+  ps->stmt = NULL;
+
+  if (!plan_prepared(buf, p)) {
+    free_preparedstmt(p);
+    return;
+  }
+
+  prepare_add(p);
+}
+
+static void run_execute(BufMgr* buf, ExecuteStmt* e) {
+  PreparedStmt* p = prepare_find(e->name);
+
+  if (p == NULL) {
+    printf("Prepared statement %s does not exist\n", e->name);
+    return;
+  }
+
+  if (!analyze_no_params((Node*)e) || !prepare_bind(p, e->params)) return;
+  if (!p->planned && !plan_prepared(buf, p)) return;
+
+  if (p->stmt->type == T_SelectStmt) {
+    execute_selectstmt(buf, p->td, p->join, p->idx, (SelectStmt*)p->stmt);
+  } else {
+    execute_insertstmt(buf, p->td, (InsertStmt*)p->stmt);
+  }
+}
+
 /* END TEMPORARY CODE */
 
 static void print_prompt() {
   printf("bql > ");
 }
 
+/**
+ * @brief Runs a parsed statement
+ * 
+ * @return true 
+ * @return false if it's `\quit`
+ */
+static bool run_statement(BufMgr* buf, Node* n) {
+  switch (n->type) {
+    case T_SysCmd:
+      if (parse_syscmd(((SysCmd*)n)->cmd) == SYSCMD_QUIT) return false;
+      run_syscmd(((SysCmd*)n)->cmd, buf);
+      break;
+    case T_InsertStmt: {
+      if (!analyze_no_params(n)) break;
+
+      TableDesc* td = get_insert_tabledesc(buf, (InsertStmt*)n);
+      if (td != NULL) execute_insertstmt(buf, td, (InsertStmt*)n);
+      free_tabledesc(td);
+      break;
+    }
+    case T_CopyStmt: {
+      CopyStmt* c = (CopyStmt*)n;
+      TableDesc* td = get_tabledesc(buf, c->tablename);
+      if (td == NULL) {
+        printf("Table %s does not exist\n", c->tablename);
+      } else if (c->isFrom) {
+        copy_from(buf, td, c->filename);
+      } else {
+        copy_to(buf, td, c->filename, c->binary);
+      }
+      free_tabledesc(td);
+      break;
+    }
+    case T_SelectStmt: {
+      SelectStmt* s = (SelectStmt*)n;
+      TableDesc* td;
+      TableDesc* joinTd;
+      Join* join;
+
+      if (analyze_no_params(n) && analyze_select(buf, s, &td, &joinTd, &join)) {
+        IndexDesc* idx = plan_selectstmt(buf, td, join, s);
+        execute_selectstmt(buf, td, join, idx, s);
+        free_indexdesc(idx);
+        free_join(join);
+        free_tabledesc(joinTd);
+        free_tabledesc(td);
+      }
+      break;
+    }
+    case T_PrepareStmt:
+      run_prepare(buf, (PrepareStmt*)n);
+      break;
+    case T_ExecuteStmt:
+      run_execute(buf, (ExecuteStmt*)n);
+      break;
+    case T_DeallocateStmt:
+      if (!prepare_drop(((DeallocateStmt*)n)->name)) {
+        printf("Prepared statement %s does not exist\n", ((DeallocateStmt*)n)->name);
+      }
+      break;
+    case T_CreateIndexStmt: {
+      CreateIndexStmt* c = (CreateIndexStmt*)n;
+      TableDesc* td = get_tabledesc(buf, c->tablename);
+      if (td == NULL) {
+        printf("Table %s does not exist\n", c->tablename);
+      } else {
+        int numIncluded = c->includeList == NULL ? 0 : c->includeList->length;
+        char** includeNames = malloc(sizeof(char*) * (numIncluded + 1));
+        for (int i = 0; i < numIncluded; i++) {
+          includeNames[i] = ((ColumnRef*)c->includeList->elements[i].ptr)->name;
+        }
+
+        if (!indexam_create(buf, td, c->indexname, c->colname, c->method, c->clustered, includeNames, numIncluded)) {
+          printf("Unable to create index\n");
+        } else {
+          prepare_invalidate(c->tablename);
+        }
+        free(includeNames);
+      }
+      free_tabledesc(td);
+      break;
+    }
+    default:
+      printf("Unsupported statement\n");
+      break;
+  }
+
+
+  return true;
+}
+
+static void shutdown_db(BufMgr* buf, bool quiet) {
+  if (!quiet) printf("Shutting down...\n");
+  prepare_drop_all();
+  bufmgr_flush_all(buf);
+  bufmgr_destroy(buf);
+  scheduler_destroy(sched);
+}
+
+/**
+ * @brief Runs the statements of `ps` until `\quit` or the end of them,
+ * without prompts or echoing the statements. Stops at the first statement
+ * that can't be parsed.
+ * 
+ * @return int the exit code
+ */
+static int run_batch(BufMgr* buf, ParseSession* ps) {
+  int numStatements = 0;
+
+  while (true) {
+    Node* n = parse_session_next(ps);
+
+    if (n == NULL) {
+      if (ps->atEnd) return EXIT_SUCCESS;
+
+      printf("Stopped at statement %d\n", numStatements + 1);
+      return EXIT_FAILURE;
+    }
+
+    numStatements++;
+    bool more = run_statement(buf, n);
+    free_node(n);
+
+    if (!more) return EXIT_SUCCESS;
+  }
+}
+
+/**
+ * @brief Reads all of `fp` into memory, so that the scanner can work
+ * straight from the buffer
+ */
+static char* read_whole_file(FILE* fp, size_t* len) {
+  size_t cap = 65536;
+  char* data = malloc(cap);
+  size_t n;
+
+  *len = 0;
+  while ((n = fread(data + *len, 1, cap - *len, fp)) > 0) {
+    *len += n;
+
+    if (*len == cap) {
+      cap *= 2;
+      data = realloc(data, cap);
+    }
+  }
+
+  return data;
+}
+
+static void print_usage(char* prog) {
+  printf("Usage: %s [-f FILE | -c STATEMENTS]\n", prog);
+  printf("  -f FILE        run the statements of FILE (- for stdin) and exit\n");
+  printf("  -c STATEMENTS  run the statements given on the command line and exit\n");
+  printf("Without either, statements are read interactively.\n");
+}
+
 int main(int argc, char** argv) {
+  char* scriptFile = NULL;
+  char* statements = NULL;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "f:c:h")) != -1) {
+    switch (opt) {
+      case 'f':
+        scriptFile = optarg;
+        break;
+      case 'c':
+        statements = optarg;
+        break;
+      default:
+        print_usage(argv[0]);
+        return opt == 'h' ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+  }
+
+  if (optind < argc || (scriptFile != NULL && statements != NULL)) {
+    print_usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  bool batch = scriptFile != NULL || statements != NULL;
+  ParseSession* ps;
+
+  if (scriptFile != NULL && strcmp(scriptFile, "-") != 0) {
+    FILE* fp = fopen(scriptFile, "r");
+
+    if (fp == NULL) {
+      printf("Unable to open %s\n", scriptFile);
+      return EXIT_FAILURE;
+    }
+
+    size_t len;
+    char* script = read_whole_file(fp, &len);
+    fclose(fp);
+
+    ps = parse_session_from_bytes(script, len);
+    free(script);
+  } else if (statements != NULL) {
+    ps = parse_session_from_bytes(statements, strlen(statements));
+  } else {
+    ps = parse_session_from_file(stdin);
+  }
+
+  if (ps == NULL) return EXIT_FAILURE;
+
   // initialize global config
   conf = new_config();
 
@@ -220,70 +802,44 @@ int main(int argc, char** argv) {
   }
 
   // print config
-  print_config(conf);
+  if (!batch) print_config(conf);
 
+  sched = scheduler_create(conf->workerThreads);
   BufMgr* buf = bufmgr_init();
 
   if (!initdb(buf)) {
     printf("initdb failed\n");
-    printf("Shutting down...\n");
-    bufmgr_flush_all(buf);
-    bufmgr_destroy(buf);
+    parse_session_destroy(ps);
+    shutdown_db(buf, false);
     return EXIT_SUCCESS;
   }
 
+  if (batch) {
+    int exitCode = run_batch(buf, ps);
+    parse_session_destroy(ps);
+    shutdown_db(buf, true);
+    return exitCode;
+  }
+
   while(true) {
     print_prompt();
-    Node* n = parse_sql();
+    Node* n = parse_session_next(ps);
 
-    if (n == NULL) continue;
+    if (n == NULL) {
+      if (ps->atEnd) break;
+      continue;
+    }
 
     print_node(n);
 
-    switch (n->type) {
-      case T_SysCmd:
-        if (parse_syscmd(((SysCmd*)n)->cmd) == SYSCMD_QUIT) {
-          free_node(n);
-          printf("Shutting down...\n");
-          bufmgr_flush_all(buf);
-          bufmgr_destroy(buf);
-          return EXIT_SUCCESS;
-        } else {
-          run_syscmd(((SysCmd*)n)->cmd, buf);
-        }
-        break;
-      case T_InsertStmt: {
-        // if (!analyze_node(n)) {
-        //   printf("Semantic analysis failed\n");
-        // } else {
-        //   InsertStmt* i = (InsertStmt*)n;
-        //   if (!insert_record(buf, i->values)) {
-        //     printf("Unable to insert record\n");
-        //   }
-        // }
-        break;
-      }
-      case T_SelectStmt:
-        if (!analyze_node(n)) {
-          printf("Semantic analysis failed\n");
-        } else {
-          TableDesc* td = new_tabledesc("person");
-          td->rd = construct_record_descriptor();
-          RecordSet* rs = new_recordset();
-          RecordDescriptor* targets = construct_record_descriptor_from_target_list(((SelectStmt*)n)->targetList);
-          
-          tableam_fullscan(buf, td, rs);
-          resultset_print(td->rd, rs, targets);
-
-          free_recordset(rs, td->rd);
-          free_tabledesc(td);
-          free_record_desc(targets);
-        }
-        break;
-    }
-
+    bool more = run_statement(buf, n);
     free_node(n);
+
+    if (!more) break;
   }
 
+  parse_session_destroy(ps);
+  shutdown_db(buf, false);
+
   return EXIT_SUCCESS;
-}
\ No newline at end of file
+}
@@ -7,6 +7,9 @@
 #include <stdarg.h>
 #include "include/parser/parsetree.h"
 
+/* a pure parser reports its errors with its parse-params first */
+void yyerror(struct Node** n, void* scanner, const char* s, ...);
+
 %}
 
 %union {
@@ -24,22 +27,68 @@
 
 %token <str> SYS_CMD STRING IDENT
 
-%token <numval> NUMBER
+%token <numval> NUMBER PARAM
+
+/* multi-character operators */
+%token LESS_EQUALS GREATER_EQUALS
 
 /* reserved keywords in alphabetical order */
-%token KW_FALSE
+%token AND AS ASC
+
+%token BINARY BY
+
+%token CLUSTERED COPY CREATE
+
+%token DEALLOCATE DESC
+
+%token EXECUTE
+
+%token KW_FALSE FROM
+
+%token GROUP
+
+%token INCLUDE INDEX INSERT INTO
 
-%token INSERT
+%token JOIN
 
 %token KW_NULL
 
+%token LIMIT
+
+%token ON OR ORDER
+
+%token PREPARE
+
 %token SELECT
 
-%token KW_TRUE
+%token TO KW_TRUE
+
+%token USING
+
+%token VALUES
+
+%token WHERE
+
+%type <node> cmd stmt sys_cmd select_stmt insert_stmt create_index_stmt copy_stmt target literal
+%type <node> prepare_stmt preparable_stmt execute_stmt deallocate_stmt
+%type <node> where_clause expr column_ref sort_by opt_join
+
+%type <list> target_list literal_values_list opt_include column_list opt_group_by
+%type <list> opt_order_by sort_list values_list literal_list opt_params
 
-%type <node> cmd stmt sys_cmd select_stmt insert_stmt target literal
+%type <str> index_method opt_from column_name
 
-%type <list> target_list literal_values_list
+%type <i> opt_clustered opt_binary comparison_op opt_sort_dir
+
+%type <numval> opt_limit
+
+/* values thrown away while recovering from a syntax error */
+%destructor { free($$); } <str>
+%destructor { free_node($$); } <node>
+%destructor { free_parselist($$); free($$); } <list>
+
+%left OR
+%left AND
 
 %start query
 
@@ -49,6 +98,16 @@ query: cmd  {
       *n = $1;
       YYACCEPT;
     }
+  | %empty {
+      /* the end of the input */
+      *n = NULL;
+      YYACCEPT;
+    }
+  | error ';' {
+      /* the rest of a bad statement is skipped, so the next one starts clean */
+      *n = NULL;
+      YYABORT;
+    }
   ;
 
 cmd: stmt ';'
@@ -66,15 +125,119 @@ sys_cmd: SYS_CMD {
 
 stmt: select_stmt
   | insert_stmt
+  | create_index_stmt
+  | copy_stmt
+  | prepare_stmt
+  | execute_stmt
+  | deallocate_stmt
   ;
 
-select_stmt: SELECT target_list {
+select_stmt: SELECT target_list opt_from opt_join where_clause opt_group_by opt_order_by opt_limit {
       SelectStmt* s = create_node(SelectStmt);
       s->targetList = $2;
+      s->tablename = $3;
+      s->join = (JoinExpr*)$4;
+      s->whereClause = $5;
+      s->groupClause = $6;
+      s->sortClause = $7;
+      s->limitCount = $8;
       $$ = (Node*)s;
     }
   ;
 
+opt_from: %empty { $$ = NULL; }
+  | FROM IDENT { $$ = $2; }
+  ;
+
+opt_join: %empty { $$ = NULL; }
+  | JOIN IDENT ON column_ref '=' column_ref {
+      JoinExpr* j = create_node(JoinExpr);
+      j->tablename = $2;
+      j->lhs = $4;
+      j->rhs = $6;
+      $$ = (Node*)j;
+    }
+  ;
+
+opt_group_by: %empty { $$ = NULL; }
+  | GROUP BY column_list { $$ = $3; }
+  ;
+
+opt_order_by: %empty { $$ = NULL; }
+  | ORDER BY sort_list { $$ = $3; }
+  ;
+
+sort_list: sort_by {
+      $$ = create_parselist($1);
+    }
+  | sort_list ',' sort_by {
+      $$ = parselist_append($1, $3);
+    }
+  ;
+
+sort_by: target opt_sort_dir {
+      SortBy* sb = create_node(SortBy);
+      sb->target = (ResTarget*)$1;
+      sb->descending = $2;
+      $$ = (Node*)sb;
+    }
+  ;
+
+opt_sort_dir: %empty { $$ = false; }
+  | ASC { $$ = false; }
+  | DESC { $$ = true; }
+  ;
+
+opt_limit: %empty { $$ = -1; }
+  | LIMIT NUMBER { $$ = $2; }
+  ;
+
+where_clause: %empty { $$ = NULL; }
+  | WHERE expr { $$ = $2; }
+  ;
+
+expr: column_ref comparison_op literal {
+      BinaryExpr* e = create_node(BinaryExpr);
+      e->op = $2;
+      e->lhs = $1;
+      e->rhs = $3;
+      $$ = (Node*)e;
+    }
+  | expr AND expr {
+      BoolExpr* e = create_node(BoolExpr);
+      e->boolop = BOOL_AND;
+      e->lhs = $1;
+      e->rhs = $3;
+      $$ = (Node*)e;
+    }
+  | expr OR expr {
+      BoolExpr* e = create_node(BoolExpr);
+      e->boolop = BOOL_OR;
+      e->lhs = $1;
+      e->rhs = $3;
+      $$ = (Node*)e;
+    }
+  | '(' expr ')' { $$ = $2; }
+  ;
+
+comparison_op: '=' { $$ = EXPR_EQ; }
+  | '<' { $$ = EXPR_LT; }
+  | LESS_EQUALS { $$ = EXPR_LE; }
+  | '>' { $$ = EXPR_GT; }
+  | GREATER_EQUALS { $$ = EXPR_GE; }
+  ;
+
+column_ref: column_name {
+      ColumnRef* c = create_node(ColumnRef);
+      c->name = $1;
+      $$ = (Node*)c;
+    }
+  ;
+
+column_name: IDENT { $$ = $1; }
+  | IDENT '.' IDENT { $$ = str_qualify($1, $3); }
+  ;
+
 target_list: target {
       $$ = create_parselist($1);
     }
@@ -83,19 +246,147 @@ target_list: target {
     }
   ;
 
-target: IDENT {
+target: column_name {
       ResTarget* r = create_node(ResTarget);
       r->name = $1;
+      r->funcname = NULL;
+      $$ = (Node*)r;
+    }
+  | IDENT '(' column_name ')' {
+      ResTarget* r = create_node(ResTarget);
+      r->name = $3;
+      r->funcname = $1;
+      $$ = (Node*)r;
+    }
+  | IDENT '(' '*' ')' {
+      ResTarget* r = create_node(ResTarget);
+      r->name = NULL;
+      r->funcname = $1;
       $$ = (Node*)r;
     }
   ;
 
 insert_stmt: INSERT literal_values_list  {
       InsertStmt* ins = create_node(InsertStmt);
-      ins->values = $2;
+      ins->tablename = NULL;
+      ins->rows = create_parselist($2);
       
       $$ = (Node*)ins;
     }
+  | INSERT INTO IDENT VALUES values_list {
+      InsertStmt* ins = create_node(InsertStmt);
+      ins->tablename = $3;
+      ins->rows = $5;
+
+      $$ = (Node*)ins;
+    }
+  ;
+
+values_list: '(' literal_list ')' {
+      $$ = create_parselist($2);
+    }
+  | values_list ',' '(' literal_list ')' {
+      $$ = parselist_append($1, $4);
+    }
+  ;
+
+literal_list: literal {
+      $$ = create_parselist($1);
+    }
+  | literal_list ',' literal {
+      $$ = parselist_append($1, $3);
+    }
+  ;
+
+copy_stmt: COPY IDENT FROM STRING {
+      CopyStmt* c = create_node(CopyStmt);
+      c->tablename = $2;
+      c->filename = str_strip_quotes($4);
+      c->isFrom = true;
+      c->binary = false;
+
+      $$ = (Node*)c;
+    }
+  | COPY IDENT TO STRING opt_binary {
+      CopyStmt* c = create_node(CopyStmt);
+      c->tablename = $2;
+      c->filename = str_strip_quotes($4);
+      c->isFrom = false;
+      c->binary = $5;
+
+      $$ = (Node*)c;
+    }
+  ;
+
+opt_binary: %empty { $$ = false; }
+  | BINARY { $$ = true; }
+  ;
+
+prepare_stmt: PREPARE IDENT AS preparable_stmt {
+      PrepareStmt* p = create_node(PrepareStmt);
+      p->name = $2;
+      p->stmt = $4;
+
+      $$ = (Node*)p;
+    }
+  ;
+
+preparable_stmt: select_stmt
+  | insert_stmt
+  ;
+
+execute_stmt: EXECUTE IDENT opt_params {
+      ExecuteStmt* e = create_node(ExecuteStmt);
+      e->name = $2;
+      e->params = $3;
+
+      $$ = (Node*)e;
+    }
+  ;
+
+opt_params: %empty { $$ = NULL; }
+  | '(' literal_list ')' { $$ = $2; }
+  ;
+
+deallocate_stmt: DEALLOCATE IDENT {
+      DeallocateStmt* d = create_node(DeallocateStmt);
+      d->name = $2;
+
+      $$ = (Node*)d;
+    }
+  ;
+
+create_index_stmt: CREATE opt_clustered INDEX IDENT ON IDENT index_method '(' IDENT ')' opt_include {
+      CreateIndexStmt* c = create_node(CreateIndexStmt);
+      c->clustered = $2;
+      c->indexname = $4;
+      c->tablename = $6;
+      c->method = $7;
+      c->colname = $9;
+      c->includeList = $11;
+
+      $$ = (Node*)c;
+    }
+  ;
+
+opt_clustered: %empty { $$ = false; }
+  | CLUSTERED { $$ = true; }
+  ;
+
+index_method: %empty { $$ = NULL; }
+  | USING IDENT { $$ = $2; }
+  ;
+
+opt_include: %empty { $$ = NULL; }
+  | INCLUDE '(' column_list ')' { $$ = $3; }
+  ;
+
+column_list: column_ref {
+      $$ = create_parselist($1);
+    }
+  | column_list ',' column_ref {
+      $$ = parselist_append($1, $3);
+    }
   ;
 
 literal_values_list: literal {
@@ -110,37 +401,65 @@ literal: NUMBER {
       Literal* l = create_node(Literal);
       l->str = NULL;
       l->intVal = $1;
+      l->boolVal = $1 != 0;
       l->isNull = false;
+      l->paramNum = 0;
       
       $$ = (Node*)l;
     }
   | STRING {
       Literal* l = create_node(Literal);
       l->str = str_strip_quotes($1);
+      l->intVal = 0;
+      l->boolVal = false;
       l->isNull = false;
+      l->paramNum = 0;
 
       $$ = (Node*)l;
     }
   | KW_NULL {
       Literal* l = create_node(Literal);
       l->str = NULL;
+      l->intVal = 0;
+      l->boolVal = false;
       l->isNull = true;
+      l->paramNum = 0;
 
       $$ = (Node*)l;
     }
   | KW_FALSE {
       Literal* l = create_node(Literal);
       l->str = NULL;
+      l->intVal = 0;
       l->boolVal = false;
       l->isNull = false;
+      l->paramNum = 0;
 
       $$ = (Node*)l;
     }
   | KW_TRUE {
       Literal* l = create_node(Literal);
       l->str = NULL;
+      l->intVal = 1;
       l->boolVal = true;
       l->isNull = false;
+      l->paramNum = 0;
+
+      $$ = (Node*)l;
+    }
+  | PARAM {
+      if ($1 < 1 || $1 > INT32_MAX) {
+        yyerror(n, scanner, "there is no parameter $%lld", $1);
+        YYERROR;
+      }
+
+      /* NULL until EXECUTE binds a value to it */
+      Literal* l = create_node(Literal);
+      l->str = NULL;
+      l->intVal = 0;
+      l->boolVal = false;
+      l->isNull = true;
+      l->paramNum = $1;
 
       $$ = (Node*)l;
     }
@@ -148,11 +467,16 @@ literal: NUMBER {
 
 %%
 
-void yyerror(char* s, ...) {
+void yyerror(struct Node** n, void* scanner, const char* s, ...) {
+  (void)n;
+  (void)scanner;
+
   va_list ap;
   va_start(ap, s);
 
   fprintf(stderr, "error: ");
   vfprintf(stderr, s, ap);
   fprintf(stderr, "\n");
+
+  va_end(ap);
 }
@@ -1,23 +1,81 @@
 #include <stdio.h>
+#include <stdlib.h>
 
 #include "gram.tab.h"
 #include "scan.lex.h"
-#include "parser/parsetree.h"
+#include "parser/parse.h"
 
-Node* parse_sql() {
-  Node* n;
-  yyscan_t scanner;
+static ParseSession* parse_session_create() {
+  ParseSession* ps = malloc(sizeof(ParseSession));
+  ps->buffer = NULL;
+  ps->atEnd = false;
 
-  if (yylex_init(&scanner) != 0) {
+  if (yylex_init((yyscan_t*)&ps->scanner) != 0) {
     printf("scan init failed\n");
+    free(ps);
     return NULL;
   }
 
-  int e = yyparse(&n, scanner);
+  return ps;
+}
 
-  yylex_destroy(scanner);
+/**
+ * @brief Starts parsing the statements of `fp`
+ * 
+ * @param fp 
+ * @return ParseSession* NULL if the scanner can't be set up
+ */
+ParseSession* parse_session_from_file(FILE* fp) {
+  ParseSession* ps = parse_session_create();
+  if (ps != NULL) yyset_in(fp, ps->scanner);
 
-  if (e != 0) printf("Parse error\n");
+  return ps;
+}
+
+/**
+ * @brief Starts parsing the statements in `data`. The scanner works on a
+ * copy of it.
+ * 
+ * @param data 
+ * @param len 
+ * @return ParseSession* NULL if the scanner can't be set up
+ */
+ParseSession* parse_session_from_bytes(const char* data, size_t len) {
+  ParseSession* ps = parse_session_create();
+  if (ps != NULL) ps->buffer = yy_scan_bytes(data, len, ps->scanner);
+
+  return ps;
+}
+
+void parse_session_destroy(ParseSession* ps) {
+  if (ps == NULL) return;
+
+  if (ps->buffer != NULL) yy_delete_buffer(ps->buffer, ps->scanner);
+  yylex_destroy(ps->scanner);
+  free(ps);
+}
+
+/**
+ * @brief Parses the next statement
+ * 
+ * @param ps 
+ * @return Node* NULL if the statement can't be parsed, in which case the
+ * rest of it up to the next ';' is skipped, or at the end of the input
+ * (see ps->atEnd)
+ */
+Node* parse_session_next(ParseSession* ps) {
+  Node* n = NULL;
+
+  if (ps->atEnd) return NULL;
+
+  int e = yyparse(&n, ps->scanner);
+
+  if (e != 0) {
+    printf("Parse error\n");
+    return NULL;
+  }
+
+  if (n == NULL) ps->atEnd = true;
 
   return n;
-}
\ No newline at end of file
+}
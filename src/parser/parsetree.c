@@ -14,8 +14,34 @@ static void free_syscmd(SysCmd* sc) {
 static void free_insert_stmt(InsertStmt* ins) {
   if (ins == NULL) return;
 
-  free_parselist(ins->values);
-  free(ins->values);
+  if (ins->tablename != NULL) free(ins->tablename);
+  free_parselist(ins->rows);
+  free(ins->rows);
+}
+
+static void free_copystmt(CopyStmt* c) {
+  if (c == NULL) return;
+
+  if (c->tablename != NULL) free(c->tablename);
+  if (c->filename != NULL) free(c->filename);
+}
+
+static void free_preparestmt(PrepareStmt* p) {
+  if (p == NULL) return;
+
+  if (p->name != NULL) free(p->name);
+  free_node(p->stmt);
+}
+
+static void free_executestmt(ExecuteStmt* e) {
+  if (e == NULL) return;
+
+  if (e->name != NULL) free(e->name);
+
+  if (e->params != NULL) {
+    free_parselist(e->params);
+    free(e->params);
+  }
 }
 
 static void free_selectstmt(SelectStmt* s) {
@@ -25,12 +51,76 @@ static void free_selectstmt(SelectStmt* s) {
     free_parselist(s->targetList);
     free(s->targetList);
   }
+
+  if (s->tablename != NULL) free(s->tablename);
+
+  free_node((Node*)s->join);
+  free_node(s->whereClause);
+
+  if (s->groupClause != NULL) {
+    free_parselist(s->groupClause);
+    free(s->groupClause);
+  }
+
+  if (s->sortClause != NULL) {
+    free_parselist(s->sortClause);
+    free(s->sortClause);
+  }
+}
+
+static void free_createindexstmt(CreateIndexStmt* c) {
+  if (c == NULL) return;
+
+  if (c->indexname != NULL) free(c->indexname);
+  if (c->tablename != NULL) free(c->tablename);
+  if (c->method != NULL) free(c->method);
+  if (c->colname != NULL) free(c->colname);
+
+  if (c->includeList != NULL) {
+    free_parselist(c->includeList);
+    free(c->includeList);
+  }
+}
+
+static void free_columnref(ColumnRef* c) {
+  if (c == NULL) return;
+
+  if (c->name != NULL) free(c->name);
+}
+
+static void free_binaryexpr(BinaryExpr* e) {
+  if (e == NULL) return;
+
+  free_node(e->lhs);
+  free_node(e->rhs);
+}
+
+static void free_boolexpr(BoolExpr* e) {
+  if (e == NULL) return;
+
+  free_node(e->lhs);
+  free_node(e->rhs);
 }
 
 static void free_restarget(ResTarget* r) {
   if (r == NULL) return;
 
   if (r->name != NULL) free(r->name);
+  if (r->funcname != NULL) free(r->funcname);
+}
+
+static void free_joinexpr(JoinExpr* j) {
+  if (j == NULL) return;
+
+  if (j->tablename != NULL) free(j->tablename);
+  free_node(j->lhs);
+  free_node(j->rhs);
+}
+
+static void free_sortby(SortBy* sb) {
+  if (sb == NULL) return;
+
+  free_node((Node*)sb->target);
 }
 
 static void free_literal(Literal* l) {
@@ -49,9 +139,21 @@ void free_node(Node* n) {
     case T_InsertStmt:
       free_insert_stmt((InsertStmt*)n);
       break;
+    case T_CopyStmt:
+      free_copystmt((CopyStmt*)n);
+      break;
     case T_SelectStmt:
       free_selectstmt((SelectStmt*)n);
       break;
+    case T_PrepareStmt:
+      free_preparestmt((PrepareStmt*)n);
+      break;
+    case T_ExecuteStmt:
+      free_executestmt((ExecuteStmt*)n);
+      break;
+    case T_DeallocateStmt:
+      free(((DeallocateStmt*)n)->name);
+      break;
     case T_ParseList:
       free_parselist((ParseList*)n);
       break;
@@ -61,6 +163,24 @@ void free_node(Node* n) {
     case T_Literal:
       free_literal((Literal*)n);
       break;
+    case T_CreateIndexStmt:
+      free_createindexstmt((CreateIndexStmt*)n);
+      break;
+    case T_ColumnRef:
+      free_columnref((ColumnRef*)n);
+      break;
+    case T_BinaryExpr:
+      free_binaryexpr((BinaryExpr*)n);
+      break;
+    case T_BoolExpr:
+      free_boolexpr((BoolExpr*)n);
+      break;
+    case T_SortBy:
+      free_sortby((SortBy*)n);
+      break;
+    case T_JoinExpr:
+      free_joinexpr((JoinExpr*)n);
+      break;
     default:
       printf("Unknown node type\n");
   }
@@ -69,7 +189,66 @@ void free_node(Node* n) {
 }
 
 static void print_restarget(ResTarget* r) {
-  printf("%s", r->name);
+  if (r->funcname != NULL) {
+    printf("%s(%s)", r->funcname, r->name == NULL ? "*" : r->name);
+  } else {
+    printf("%s", r->name);
+  }
+}
+
+static void print_expr(Node* n) {
+  switch (n->type) {
+    case T_ColumnRef:
+      printf("%s", ((ColumnRef*)n)->name);
+      break;
+    case T_Literal: {
+      Literal* l = (Literal*)n;
+      if (l->paramNum > 0) {
+        printf("$%d", l->paramNum);
+      } else if (l->isNull) {
+        printf("NULL");
+      } else if (l->str != NULL) {
+        printf("'%s'", l->str);
+      } else {
+        printf("%ld", l->intVal);
+      }
+      break;
+    }
+    case T_BinaryExpr: {
+      BinaryExpr* e = (BinaryExpr*)n;
+      print_expr(e->lhs);
+      switch (e->op) {
+        case EXPR_EQ:
+          printf(" = ");
+          break;
+        case EXPR_LT:
+          printf(" < ");
+          break;
+        case EXPR_LE:
+          printf(" <= ");
+          break;
+        case EXPR_GT:
+          printf(" > ");
+          break;
+        case EXPR_GE:
+          printf(" >= ");
+          break;
+      }
+      print_expr(e->rhs);
+      break;
+    }
+    case T_BoolExpr: {
+      BoolExpr* e = (BoolExpr*)n;
+      printf("(");
+      print_expr(e->lhs);
+      printf(e->boolop == BOOL_AND ? " AND " : " OR ");
+      print_expr(e->rhs);
+      printf(")");
+      break;
+    }
+    default:
+      printf("?");
+  }
 }
 
 static void print_selectstmt(SelectStmt* s) {
@@ -86,6 +265,61 @@ static void print_selectstmt(SelectStmt* s) {
     print_restarget((ResTarget*)s->targetList->elements[i].ptr);
     printf("\n");
   }
+
+  if (s->tablename != NULL) {
+    printf("=  From: %s\n", s->tablename);
+  }
+
+  if (s->join != NULL) {
+    printf("=  Join: %s ON ", s->join->tablename);
+    print_expr(s->join->lhs);
+    printf(" = ");
+    print_expr(s->join->rhs);
+    printf("\n");
+  }
+
+  if (s->whereClause != NULL) {
+    printf("=  Where:\n");
+    printf("=    ");
+    print_expr(s->whereClause);
+    printf("\n");
+  }
+
+  if (s->groupClause != NULL) {
+    printf("=  Group By:\n");
+    for (int i = 0; i < s->groupClause->length; i++) {
+      printf("=    %s\n", ((ColumnRef*)s->groupClause->elements[i].ptr)->name);
+    }
+  }
+
+  if (s->sortClause != NULL) {
+    printf("=  Order By:\n");
+    for (int i = 0; i < s->sortClause->length; i++) {
+      SortBy* sb = (SortBy*)s->sortClause->elements[i].ptr;
+      printf("=    ");
+      print_restarget(sb->target);
+      printf(sb->descending ? " DESC\n" : "\n");
+    }
+  }
+
+  if (s->limitCount >= 0) {
+    printf("=  Limit: %ld\n", s->limitCount);
+  }
+}
+
+static void print_createindexstmt(CreateIndexStmt* c) {
+  printf("=  Type: Create %sIndex\n", c->clustered ? "Clustered " : "");
+  printf("=  Index: %s\n", c->indexname);
+  printf("=  Table: %s\n", c->tablename);
+  printf("=  Method: %s\n", c->method == NULL ? "btree" : c->method);
+  printf("=  Column: %s\n", c->colname);
+
+  if (c->includeList != NULL) {
+    printf("=  Include:\n");
+    for (int i = 0; i < c->includeList->length; i++) {
+      printf("=    %s\n", ((ColumnRef*)c->includeList->elements[i].ptr)->name);
+    }
+  }
 }
 
 // Probably a temporary function
@@ -122,15 +356,53 @@ void print_node(Node* n) {
     case T_InsertStmt: {
       InsertStmt* i = (InsertStmt*)n;
       printf("=  Type: Insert\n");
-      print_insertstmt_literal((Literal*)i->values->elements[0].ptr, "person_id", DT_INT);
-      print_insertstmt_literal((Literal*)i->values->elements[1].ptr, "first_name", DT_VARCHAR);
-      print_insertstmt_literal((Literal*)i->values->elements[2].ptr, "last_name", DT_VARCHAR);
-      print_insertstmt_literal((Literal*)i->values->elements[3].ptr, "age", DT_INT);
+      if (i->tablename != NULL) {
+        printf("=  Table: %s\n", i->tablename);
+        printf("=  Rows: %d\n", i->rows->length);
+        break;
+      }
+
+      ParseList* values = i->rows->elements[0].ptr;
+      if (values->length == 4) {
+        print_insertstmt_literal((Literal*)values->elements[0].ptr, "person_id", DT_INT);
+        print_insertstmt_literal((Literal*)values->elements[1].ptr, "first_name", DT_VARCHAR);
+        print_insertstmt_literal((Literal*)values->elements[2].ptr, "last_name", DT_VARCHAR);
+        print_insertstmt_literal((Literal*)values->elements[3].ptr, "age", DT_INT);
+      }
+      break;
+    }
+    case T_CopyStmt: {
+      CopyStmt* c = (CopyStmt*)n;
+      printf("=  Type: Copy\n");
+      printf("=  Table: %s\n", c->tablename);
+      printf("=  %s: %s\n", c->isFrom ? "From" : "To", c->filename);
+      printf("=  Format: %s\n", c->binary ? "binary" : "CSV");
       break;
     }
     case T_SelectStmt:
       print_selectstmt((SelectStmt*)n);
       break;
+    case T_CreateIndexStmt:
+      print_createindexstmt((CreateIndexStmt*)n);
+      break;
+    case T_PrepareStmt: {
+      PrepareStmt* p = (PrepareStmt*)n;
+      printf("=  Type: Prepare\n");
+      printf("=  Name: %s\n", p->name);
+      printf("=  Statement: %s\n", p->stmt->type == T_SelectStmt ? "Select" : "Insert");
+      break;
+    }
+    case T_ExecuteStmt: {
+      ExecuteStmt* e = (ExecuteStmt*)n;
+      printf("=  Type: Execute\n");
+      printf("=  Name: %s\n", e->name);
+      printf("=  Params: %d\n", e->params == NULL ? 0 : e->params->length);
+      break;
+    }
+    case T_DeallocateStmt:
+      printf("=  Type: Deallocate\n");
+      printf("=  Name: %s\n", ((DeallocateStmt*)n)->name);
+      break;
     default:
       printf("print_node() | unknown node type\n");
   }
@@ -145,6 +417,18 @@ char* str_strip_quotes(char* str) {
   return finalStr;
 }
 
+/**
+ * @brief Joins `tablename.colname` into a new string, freeing both parts
+ */
+char* str_qualify(char* tablename, char* colname) {
+  size_t length = strlen(tablename) + strlen(colname) + 2;
+  char* finalStr = malloc(length);
+  snprintf(finalStr, length, "%s.%s", tablename, colname);
+  free(tablename);
+  free(colname);
+  return finalStr;
+}
+
 ParseList* new_parselist(ParseCell li) {
   ParseList* l = malloc(sizeof(ParseList));
   ParseCell* elements = malloc(sizeof(ParseCell));
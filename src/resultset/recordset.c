@@ -1,4 +1,6 @@
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "resultset/recordset.h"
 #include "utility/linkedlist.h"
@@ -15,11 +17,20 @@ RecordSetRow* new_recordset_row(LinkedList* rows, int ncols) {
   row->values = malloc(ncols * sizeof(Datum));
   row->isnull = malloc(ncols * sizeof(bool));
 
-  linkedlist_append(rows, row);
+  if (rows != NULL) linkedlist_append(rows, row);
 
   return row;
 }
 
+/**
+ * @brief Appends a row to the RecordSet `rs`, which owns it from then on.
+ * Has the shape of a TableamRowFunc, so a scan can fill a RecordSet.
+ */
+bool recordset_append_row(void* rs, RecordSetRow* row) {
+  linkedlist_append(((RecordSet*)rs)->rows, row);
+  return true;
+}
+
 static void free_recordset_row_columns(RecordSetRow* row, RecordDescriptor* rd) {
   for (int i = 0; i < rd->ncols; i++) {
     if (rd->cols[i].dataType == DT_CHAR || rd->cols[i].dataType == DT_VARCHAR) {
@@ -55,4 +66,85 @@ void free_recordset_row(RecordSetRow* row, RecordDescriptor* rd) {
     free(row->isnull);
   }
   free(row);
-}
\ No newline at end of file
+}
+static bool recordset_is_string(DataType dataType) {
+  return dataType == DT_CHAR || dataType == DT_VARCHAR;
+}
+
+/**
+ * @brief Rough number of bytes a row takes up in memory
+ */
+size_t recordset_row_size(RecordSetRow* row, RecordDescriptor* rd) {
+  size_t size = sizeof(RecordSetRow) + rd->ncols * (sizeof(Datum) + sizeof(bool));
+
+  for (int i = 0; i < rd->ncols; i++) {
+    if (recordset_is_string(rd->cols[i].dataType) && !row->isnull[i] && row->values[i] != 0) {
+      size += strlen(datumGetString(row->values[i])) + 1;
+    }
+  }
+
+  return size;
+}
+
+/**
+ * @brief Writes a row to a temporary file: every column as a NULL flag
+ * followed by the value. Strings are a 2-byte length and the characters.
+ *
+ * @return false if the write failed
+ */
+bool recordset_row_write(FILE* fp, RecordSetRow* row, RecordDescriptor* rd) {
+  bool success = true;
+
+  for (int i = 0; i < rd->ncols && success; i++) {
+    success = fwrite(&row->isnull[i], sizeof(bool), 1, fp) == 1;
+    if (!success || row->isnull[i]) continue;
+
+    if (recordset_is_string(rd->cols[i].dataType)) {
+      char* str = datumGetString(row->values[i]);
+      uint16_t strLen = str == NULL ? 0 : strlen(str);
+      success = fwrite(&strLen, sizeof(uint16_t), 1, fp) == 1 && fwrite(str, 1, strLen, fp) == strLen;
+    } else {
+      success = fwrite(&row->values[i], sizeof(Datum), 1, fp) == 1;
+    }
+  }
+
+  return success;
+}
+
+/**
+ * @brief Reads back a row written by recordset_row_write. The row isn't in
+ * any RecordSet yet.
+ *
+ * @return RecordSetRow* NULL if the read failed
+ */
+RecordSetRow* recordset_row_read(FILE* fp, RecordDescriptor* rd) {
+  RecordSetRow* row = malloc(sizeof(RecordSetRow));
+  row->values = calloc(rd->ncols, sizeof(Datum));
+  row->isnull = calloc(rd->ncols, sizeof(bool));
+
+  bool success = true;
+  for (int i = 0; i < rd->ncols && success; i++) {
+    success = fread(&row->isnull[i], sizeof(bool), 1, fp) == 1;
+    if (!success || row->isnull[i]) continue;
+
+    if (recordset_is_string(rd->cols[i].dataType)) {
+      uint16_t strLen;
+      success = fread(&strLen, sizeof(uint16_t), 1, fp) == 1;
+      if (!success) continue;
+
+      char* str = malloc(strLen + 1);
+      success = fread(str, 1, strLen, fp) == strLen;
+      str[strLen] = '\0';
+      row->values[i] = charGetDatum(str);
+    } else {
+      success = fread(&row->values[i], sizeof(Datum), 1, fp) == 1;
+    }
+  }
+
+  if (!success) {
+    free_recordset_row(row, rd);
+    return NULL;
+  }
+
+  return row;
+}
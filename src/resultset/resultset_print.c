@@ -6,11 +6,28 @@
 
 #include "resultset/resultset_print.h"
 #include "storage/datum.h"
+#include "utility/numfmt.h"
+#include "utility/outbuf.h"
 
-static int num_digits(int64_t num) {
-  if (num < 0) return num_digits(-num) + 1; // extra '1' is to account for the negative sign in the display
-  if (num < 10) return 1;
-  return 1 + num_digits(num / 10);
+/* reused by every call, so printing a result set allocates nothing per cell */
+static OutBuf* out = NULL;
+
+static ResultFormat format = RESULT_FORMAT_ALIGNED;
+
+static const char* formatNames[] = { "aligned", "csv", "json", "binary" };
+
+static int64_t datum_get_int(DataType dt, Datum d) {
+  switch (dt) {
+    case DT_BOOL:
+    case DT_TINYINT:
+      return datumGetUInt8(d);
+    case DT_SMALLINT:
+      return datumGetInt16(d);
+    case DT_INT:
+      return datumGetInt32(d);
+    default:
+      return datumGetInt64(d);
+  }
 }
 
 static void compute_column_widths(RecordDescriptor* rd, RecordSet* rs, int* widths) {
@@ -31,16 +48,10 @@ static void compute_column_widths(RecordDescriptor* rd, RecordSet* rs, int* widt
         switch (col->dataType) {
           case DT_BOOL:
           case DT_TINYINT:
-            len = num_digits(datumGetUInt8(data->values[i]));
-            break;
           case DT_SMALLINT:
-            len = num_digits(datumGetInt16(data->values[i]));
-            break;
           case DT_INT:
-            len = num_digits(datumGetInt32(data->values[i]));
-            break;
           case DT_BIGINT:
-            len = num_digits(datumGetInt64(data->values[i]));
+            len = numfmt_len(datum_get_int(col->dataType, data->values[i]));
             break;
           case DT_CHAR:
           case DT_VARCHAR:
@@ -67,96 +78,337 @@ static int get_col_index(RecordDescriptor* rd, char* name) {
   return -1;
 }
 
-static void print_cell_with_padding(char* cell, int cellWidth, bool isRightAligned) {
-  int padLen = cellWidth - strlen(cell);
+static void print_cell_with_padding(const char* cell, int cellLen, int cellWidth, bool isRightAligned) {
+  int padLen = cellWidth - cellLen;
 
   if (padLen < 0) {
-    printf("\npadLen: %d\ncellWidth: %d\n valWidth: %ld\n", padLen, cellWidth, strlen(cell));
+    outbuf_flush(out);
+    printf("\npadLen: %d\ncellWidth: %d\n valWidth: %d\n", padLen, cellWidth, cellLen);
     return;
   }
 
-  if (padLen == 0) {
-    printf("%s|", cell);
-  } else if (isRightAligned) {
-    printf("%*s%s|", padLen, " ", cell);
-  } else {
-    printf("%s%*s|", cell, padLen, " ");
-  }
+  if (isRightAligned) outbuf_fill(out, ' ', padLen);
+  outbuf_write(out, cell, cellLen);
+  if (!isRightAligned) outbuf_fill(out, ' ', padLen);
+  outbuf_putc(out, '|');
 }
 
 static void print_column_headers(RecordDescriptor* rd, RecordDescriptor* rs, int* widths) {
-  printf("|");
+  outbuf_putc(out, '|');
 
   int totalWidth = 1;
   for (int i = 0; i < rs->ncols; i++) {
     int colIndex = get_col_index(rd, rs->cols[i].colname);
-    print_cell_with_padding(rs->cols[i].colname, widths[colIndex], false);
+    print_cell_with_padding(rs->cols[i].colname, strlen(rs->cols[i].colname), widths[colIndex], false);
     totalWidth += (widths[colIndex] + 1);
   }
 
-  printf("\n");
+  outbuf_putc(out, '\n');
+  outbuf_fill(out, '-', totalWidth);
+  outbuf_putc(out, '\n');
+}
 
-  for (int i = 0; i < totalWidth; i++) {
-    printf("-");
+static void print_cell_num(DataType dt, Datum d, int width) {
+  char cell[NUMFMT_MAX_LEN];
+  int len = numfmt_int64(cell, datum_get_int(dt, d));
+
+  print_cell_with_padding(cell, len, width, true);
+}
+
+static bool is_string_type(DataType dt) {
+  return dt == DT_CHAR || dt == DT_VARCHAR;
+}
+
+/**
+ * @brief Writes a CSV field, quoted only if it has to be (see copy.h)
+ */
+static void print_csv_string(const char* str) {
+  size_t len = strlen(str);
+
+  if (len > 0 && strpbrk(str, ",\"\n\r") == NULL) {
+    outbuf_write(out, str, len);
+    return;
+  }
+
+  outbuf_putc(out, '"');
+  for (size_t i = 0; i < len; i++) {
+    if (str[i] == '"') outbuf_putc(out, '"');
+    outbuf_putc(out, str[i]);
   }
-  printf("\n");
+  outbuf_putc(out, '"');
 }
 
-static void print_cell_num(DataType dt, Datum d, int width) {
-  int numDigits;
-  char* cell;
+static void print_json_string(const char* str) {
+  outbuf_putc(out, '"');
 
-  switch (dt) {
-    case DT_BOOL:
-    case DT_TINYINT:
-      numDigits = num_digits(datumGetUInt8(d));
-      cell = malloc(numDigits + 1);
-      sprintf(cell, "%u", datumGetUInt8(d));
-      break;
-    case DT_SMALLINT:
-      numDigits = num_digits(datumGetInt16(d));
-      cell = malloc(numDigits + 1);
-      sprintf(cell, "%d", datumGetInt16(d));
-      break;
-    case DT_INT:
-      numDigits = num_digits(datumGetInt32(d));
-      cell = malloc(numDigits + 1);
-      sprintf(cell, "%d", datumGetInt32(d));
-      break;
-    case DT_BIGINT:
-      numDigits = num_digits(datumGetInt64(d));
-      cell = malloc(numDigits + 1);
-      sprintf(cell, "%ld", datumGetInt64(d));
-      break;
+  for (const char* c = str; *c != '\0'; c++) {
+    switch (*c) {
+      case '"':
+        outbuf_puts(out, "\\\"");
+        break;
+      case '\\':
+        outbuf_puts(out, "\\\\");
+        break;
+      case '\n':
+        outbuf_puts(out, "\\n");
+        break;
+      case '\r':
+        outbuf_puts(out, "\\r");
+        break;
+      case '\t':
+        outbuf_puts(out, "\\t");
+        break;
+      default:
+        if ((unsigned char)*c < 0x20) {
+          char escaped[7];
+          snprintf(escaped, sizeof(escaped), "\\u%04x", *c);
+          outbuf_write(out, escaped, 6);
+        } else {
+          outbuf_putc(out, *c);
+        }
+    }
+  }
+
+  outbuf_putc(out, '"');
+}
+
+/**
+ * @brief Column names on the first line, then a line per row. NULLs are
+ * empty fields.
+ */
+static void print_csv(RecordDescriptor* rd, RecordSet* rs, RecordDescriptor* targets, int* colIndexes) {
+  for (int i = 0; i < targets->ncols; i++) {
+    if (i > 0) outbuf_putc(out, ',');
+    print_csv_string(targets->cols[i].colname);
+  }
+  outbuf_putc(out, '\n');
+
+  for (ListItem* row = rs->rows->head; row != NULL; row = row->next) {
+    RecordSetRow* data = (RecordSetRow*)row->ptr;
+
+    for (int i = 0; i < targets->ncols; i++) {
+      int colIndex = colIndexes[i];
+      DataType dt = rd->cols[colIndex].dataType;
+
+      if (i > 0) outbuf_putc(out, ',');
+      if (data->isnull[colIndex]) continue;
+
+      if (is_string_type(dt)) {
+        print_csv_string(datumGetString(data->values[colIndex]));
+      } else {
+        outbuf_int64(out, datum_get_int(dt, data->values[colIndex]));
+      }
+    }
+
+    outbuf_putc(out, '\n');
+  }
+}
+
+/**
+ * @brief A JSON object per row, keyed by column name
+ */
+static void print_json(RecordDescriptor* rd, RecordSet* rs, RecordDescriptor* targets, int* colIndexes) {
+  for (ListItem* row = rs->rows->head; row != NULL; row = row->next) {
+    RecordSetRow* data = (RecordSetRow*)row->ptr;
+
+    outbuf_putc(out, '{');
+
+    for (int i = 0; i < targets->ncols; i++) {
+      int colIndex = colIndexes[i];
+      DataType dt = rd->cols[colIndex].dataType;
+
+      if (i > 0) outbuf_putc(out, ',');
+      print_json_string(targets->cols[i].colname);
+      outbuf_putc(out, ':');
+
+      if (data->isnull[colIndex]) {
+        outbuf_puts(out, "null");
+      } else if (is_string_type(dt)) {
+        print_json_string(datumGetString(data->values[colIndex]));
+      } else if (dt == DT_BOOL) {
+        outbuf_puts(out, datumGetUInt8(data->values[colIndex]) ? "true" : "false");
+      } else {
+        outbuf_int64(out, datum_get_int(dt, data->values[colIndex]));
+      }
+    }
+
+    outbuf_puts(out, "}\n");
+  }
+}
+
+static void print_binary_uint32(uint32_t v) {
+  outbuf_write(out, (char*)&v, sizeof(v));
+}
+
+/**
+ * @brief The header, a length-prefixed record per row and the end marker
+ * (see resultset_print.h)
+ */
+static void print_binary(RecordDescriptor* rd, RecordSet* rs, RecordDescriptor* targets, int* colIndexes) {
+  int bitmapLen = (targets->ncols + 7) / 8;
+  uint8_t bitmap[bitmapLen];
+
+  print_binary_uint32(targets->ncols);
+  for (int i = 0; i < targets->ncols; i++) {
+    uint8_t dataType = rd->cols[colIndexes[i]].dataType;
+    uint16_t nameLen = strlen(targets->cols[i].colname);
+
+    outbuf_write(out, (char*)&dataType, sizeof(dataType));
+    outbuf_write(out, (char*)&nameLen, sizeof(nameLen));
+    outbuf_write(out, targets->cols[i].colname, nameLen);
+  }
+
+  for (ListItem* row = rs->rows->head; row != NULL; row = row->next) {
+    RecordSetRow* data = (RecordSetRow*)row->ptr;
+    uint32_t rowLen = bitmapLen;
+
+    memset(bitmap, 0, bitmapLen);
+
+    for (int i = 0; i < targets->ncols; i++) {
+      int colIndex = colIndexes[i];
+      DataType dt = rd->cols[colIndex].dataType;
+
+      if (data->isnull[colIndex]) {
+        bitmap[i / 8] |= 1 << (i % 8);
+      } else if (is_string_type(dt)) {
+        rowLen += sizeof(uint16_t) + strlen(datumGetString(data->values[colIndex]));
+      } else {
+        rowLen += dt == DT_BIGINT ? 8 : dt == DT_INT ? 4 : dt == DT_SMALLINT ? 2 : 1;
+      }
+    }
+
+    print_binary_uint32(rowLen);
+    outbuf_write(out, (char*)bitmap, bitmapLen);
+
+    for (int i = 0; i < targets->ncols; i++) {
+      int colIndex = colIndexes[i];
+      if (data->isnull[colIndex]) continue;
+
+      Datum d = data->values[colIndex];
+
+      switch (rd->cols[colIndex].dataType) {
+        case DT_BOOL:
+        case DT_TINYINT: {
+          uint8_t v = datumGetUInt8(d);
+          outbuf_write(out, (char*)&v, sizeof(v));
+          break;
+        }
+        case DT_SMALLINT: {
+          int16_t v = datumGetInt16(d);
+          outbuf_write(out, (char*)&v, sizeof(v));
+          break;
+        }
+        case DT_INT: {
+          int32_t v = datumGetInt32(d);
+          outbuf_write(out, (char*)&v, sizeof(v));
+          break;
+        }
+        case DT_BIGINT: {
+          int64_t v = datumGetInt64(d);
+          outbuf_write(out, (char*)&v, sizeof(v));
+          break;
+        }
+        default: {
+          char* str = datumGetString(d);
+          uint16_t len = strlen(str);
+          outbuf_write(out, (char*)&len, sizeof(len));
+          outbuf_write(out, str, len);
+        }
+      }
+    }
+  }
+
+  print_binary_uint32(RESULT_BINARY_END);
+}
+
+/**
+ * @brief Parses the name of an output format, "unaligned" being another
+ * name for CSV. Returns false if there's no such format.
+ */
+bool resultset_parse_format(const char* name, ResultFormat* f) {
+  for (int i = 0; i < (int)(sizeof(formatNames) / sizeof(formatNames[0])); i++) {
+    if (strcasecmp(name, formatNames[i]) == 0) {
+      *f = (ResultFormat)i;
+      return true;
+    }
   }
 
-  cell[numDigits] = '\0';
-  print_cell_with_padding(cell, width, true);
+  if (strcasecmp(name, "unaligned") == 0) {
+    *f = RESULT_FORMAT_CSV;
+    return true;
+  }
 
-  if (cell != NULL) free(cell);
+  return false;
 }
 
+const char* resultset_format_name(ResultFormat f) {
+  return formatNames[f];
+}
+
+ResultFormat resultset_get_format() {
+  return format;
+}
+
+void resultset_set_format(ResultFormat f) {
+  format = f;
+}
+
+/**
+ * @brief Prints the `targets` columns of every row, in the current output
+ * format (see resultset_print.h)
+ * 
+ * @param rd describes the rows of `rs`
+ * @param rs 
+ * @param targets the columns to print, in order
+ */
 void resultset_print(RecordDescriptor* rd, RecordSet* rs, RecordDescriptor* targets) {
+  if (format != RESULT_FORMAT_ALIGNED) {
+    if (out == NULL) out = new_outbuf(stdout, OUTBUF_SIZE);
+
+    int* colIndexes = malloc(sizeof(int) * targets->ncols);
+    for (int i = 0; i < targets->ncols; i++) colIndexes[i] = get_col_index(rd, targets->cols[i].colname);
+
+    switch (format) {
+      case RESULT_FORMAT_CSV:
+        print_csv(rd, rs, targets, colIndexes);
+        break;
+      case RESULT_FORMAT_JSON:
+        print_json(rd, rs, targets, colIndexes);
+        break;
+      default:
+        print_binary(rd, rs, targets, colIndexes);
+    }
+
+    outbuf_flush(out);
+    free(colIndexes);
+    return;
+  }
+
   printf("--------\n");
   printf("*** Rows: %d\n", rs->rows->numItems);
   printf("--------\n");
 
   if (rs->rows->numItems == 0) return;
 
+  if (out == NULL) out = new_outbuf(stdout, OUTBUF_SIZE);
+
   int* widths = malloc(sizeof(int) * rd->ncols);
   compute_column_widths(rd, rs, widths);
   print_column_headers(rd, targets, widths);
 
+  int* colIndexes = malloc(sizeof(int) * targets->ncols);
+  for (int i = 0; i < targets->ncols; i++) colIndexes[i] = get_col_index(rd, targets->cols[i].colname);
+
   ListItem* row = rs->rows->head;
   while (row != NULL) {
-    printf("|");
+    outbuf_putc(out, '|');
     Datum* values = (Datum*)(((RecordSetRow*)row->ptr)->values);
     bool* isnull = (bool*)(((RecordSetRow*)row->ptr)->isnull);
     for (int i = 0; i < targets->ncols; i++) {
-      int colIndex = get_col_index(rd, targets->cols[i].colname);
+      int colIndex = colIndexes[i];
 
       if (isnull[colIndex] == true) {
-        print_cell_with_padding("NULL", widths[colIndex], false);
+        print_cell_with_padding("NULL", 4, widths[colIndex], false);
       } else {
         Column* col = &rd->cols[colIndex];
       
@@ -169,19 +421,23 @@ void resultset_print(RecordDescriptor* rd, RecordSet* rs, RecordDescriptor* targ
             print_cell_num(col->dataType, values[colIndex], widths[colIndex]);
             break;
           case DT_CHAR:
-          case DT_VARCHAR:
-            print_cell_with_padding(datumGetString(values[colIndex]), widths[colIndex], false);
+          case DT_VARCHAR: {
+            char* str = datumGetString(values[colIndex]);
+            print_cell_with_padding(str, strlen(str), widths[colIndex], false);
             break;
+          }
           default:
-            printf("resultset_print() | Unknown data type\n");
+            outbuf_puts(out, "resultset_print() | Unknown data type\n");
         }
       }
     }
-    printf("\n");
+    outbuf_putc(out, '\n');
     row = row->next;
   }
 
+  outbuf_flush(out);
   printf("(Rows: %d)\n\n", rs->rows->numItems);
 
+  free(colIndexes);
   free(widths);
 }
\ No newline at end of file
@@ -1,15 +1,18 @@
 #include <stdlib.h>
+#include <stddef.h>
 #include <string.h>
 #include <stdio.h>
 #include <unistd.h>
 
 #include "global/config.h"
 #include "storage/page.h"
+#include "utility/crc32c.h"
 
 extern Config* conf;
 
 Page new_page() {
-  Page pg = malloc(conf->pageSize);
+  Page pg;
+  if (posix_memalign((void**)&pg, PAGE_ALIGNMENT, conf->pageSize) != 0) return NULL;
   memset(pg, 0, conf->pageSize);
   return pg;
 }
@@ -30,6 +33,34 @@ void pageheader_init_datapage(Page pg) {
   pgHdr->freeData = conf->pageSize - sizeof(PageHeader);
 }
 
+void pageheader_init_indexpage(Page pg, uint8_t indexLevel) {
+  pageheader_init_datapage(pg);
+  PageHeader* pgHdr = (PageHeader*)pg;
+  pgHdr->pageType = 1;
+  pgHdr->indexLevel = indexLevel;
+}
+
+void pageheader_init_hashpage(Page pg) {
+  pageheader_init_datapage(pg);
+  PageHeader* pgHdr = (PageHeader*)pg;
+  pgHdr->pageType = 2;
+}
+
+/* visibility map pages are a bitmap after the header, not slotted pages */
+void pageheader_init_vismappage(Page pg) {
+  pageheader_init_datapage(pg);
+  PageHeader* pgHdr = (PageHeader*)pg;
+  pgHdr->pageType = 3;
+  pgHdr->freeBytes = 0;
+  pgHdr->freeData = 0;
+}
+
+void pageheader_init_zonemappage(Page pg) {
+  pageheader_init_datapage(pg);
+  PageHeader* pgHdr = (PageHeader*)pg;
+  pgHdr->pageType = 4;
+}
+
 void pageheader_set_pageid(Page pg, uint32_t pageId) {
   PageHeader* pgHdr = (PageHeader*)pg;
   pgHdr->pageId = pageId;
@@ -53,7 +84,7 @@ static bool page_has_space(Page pg, int length) {
 /**
  * In order to insert a record on a page, we first need to determine
  * if there is enough continuous space on the page. For that, we simply
- * need to compare the length parameter (+ 4-bytes for the new SlotPointer)
+ * need to compare the length parameter (+ 6-bytes for the new SlotPointer)
  * against the `freeData` header field.
  * 
  * If there is sufficient space, we can `memcpy` the data parameter to the
@@ -66,11 +97,25 @@ static bool page_has_space(Page pg, int length) {
  * If any of the above is not possible, we return false.
  */
 bool page_insert(Page pg, Record data, uint16_t length) {
+  return page_insert_at(pg, data, length, ((PageHeader*)pg)->numRecords);
+}
+
+/**
+ * Same as `page_insert`, except the new SlotPointer is placed at position
+ * `slotId` in the slot array instead of at the end. Every slot from `slotId`
+ * onward moves one position toward the middle of the page. Pages that keep
+ * their records sorted (e.g. index pages) use this to keep the slot array in
+ * key order - the records themselves stay wherever they were written.
+ */
+bool page_insert_at(Page pg, Record data, uint16_t length, int slotId) {
   int spaceRequired = length + sizeof(SlotPointer);
   if (!page_has_space(pg, spaceRequired)) {
     return false;
   }
 
+  PageHeader* pgHdr = (PageHeader*)pg;
+  if (slotId < 0 || slotId > pgHdr->numRecords) return false;
+
   SlotPointer* sp = malloc(sizeof(SlotPointer));
   sp->length = length;
 
@@ -80,18 +125,21 @@ bool page_insert(Page pg, Record data, uint16_t length) {
    * SLOT_ARRAY_SIZE -
    * `freeData`
    */
-  int slotArraySize = ((PageHeader*)pg)->numRecords * sizeof(SlotPointer);
-  sp->offset = conf->pageSize - slotArraySize - ((PageHeader*)pg)->freeData;
+  int slotArraySize = pgHdr->numRecords * sizeof(SlotPointer);
+  sp->offset = conf->pageSize - slotArraySize - pgHdr->freeData;
 
   /* copy the record data to the correct spot on the page */
   memcpy(pg + sp->offset, data, length);
 
-  /* prepend the new slot pointer to the slot array */
-  int newSlotOffset = conf->pageSize - slotArraySize - sizeof(SlotPointer);
+  /* shift slots [slotId, numRecords) down to make room for the new one */
+  int slotArrayStart = conf->pageSize - slotArraySize;
+  int numShifted = pgHdr->numRecords - slotId;
+  memmove(pg + slotArrayStart - sizeof(SlotPointer), pg + slotArrayStart, numShifted * sizeof(SlotPointer));
+
+  int newSlotOffset = conf->pageSize - ((slotId + 1) * sizeof(SlotPointer));
   memcpy(pg + newSlotOffset, sp, sizeof(SlotPointer));
 
   /* update header fields */
-  PageHeader* pgHdr = (PageHeader*)pg;
   pgHdr->numRecords++;
   pgHdr->freeBytes -= spaceRequired;
   pgHdr->freeData = conf->pageSize - (slotArraySize + sizeof(SlotPointer)) - (sp->offset + length);
@@ -99,4 +147,131 @@ bool page_insert(Page pg, Record data, uint16_t length) {
   free(sp);
 
   return true;
+}
+
+SlotPointer* page_get_slot(Page pg, int slotId) {
+  return (SlotPointer*)(pg + conf->pageSize - (sizeof(SlotPointer) * (slotId + 1)));
+}
+
+Record page_get_record(Page pg, int slotId) {
+  return pg + page_get_slot(pg, slotId)->offset;
+}
+
+/**
+ * Returns the first slot of the upper half of the page, splitting it so that
+ * both halves hold roughly the same number of record bytes. Both halves get at
+ * least one record as long as the page holds two or more.
+ */
+int page_get_split_slotid(Page pg) {
+  PageHeader* pgHdr = (PageHeader*)pg;
+  int numRecords = pgHdr->numRecords;
+  if (numRecords < 2) return numRecords;
+
+  int totalBytes = 0;
+  for (int i = 0; i < numRecords; i++) {
+    totalBytes += page_get_slot(pg, i)->length;
+  }
+
+  int lowerBytes = 0;
+  for (int i = 0; i < numRecords - 1; i++) {
+    lowerBytes += page_get_slot(pg, i)->length;
+    if (lowerBytes * 2 >= totalBytes) return i + 1;
+  }
+
+  return numRecords - 1;
+}
+
+/**
+ * Keeps the first `numRecords` records on the page and drops the rest. The
+ * remaining records are rewritten back to back, so all of the free space is
+ * continuous again.
+ */
+void page_truncate(Page pg, int numRecords) {
+  Page copy = new_page();
+  memcpy(copy, pg, conf->pageSize);
+
+  PageHeader* pgHdr = (PageHeader*)pg;
+  memset(pg + sizeof(PageHeader), 0, conf->pageSize - sizeof(PageHeader));
+  pgHdr->numRecords = 0;
+  pgHdr->freeBytes = conf->pageSize - sizeof(PageHeader);
+  pgHdr->freeData = conf->pageSize - sizeof(PageHeader);
+
+  for (int i = 0; i < numRecords; i++) {
+    page_insert(pg, page_get_record(copy, i), page_get_slot(copy, i)->length);
+  }
+
+  free_page(copy);
+}
+
+/**
+ * Returns the space the records in slots [slotId, numRecords) take up on a
+ * page, slot pointers included.
+ */
+int page_get_records_size(Page pg, int slotId) {
+  int numRecords = ((PageHeader*)pg)->numRecords;
+  int size = 0;
+
+  for (int i = slotId; i < numRecords; i++) {
+    size += page_get_slot(pg, i)->length + sizeof(SlotPointer);
+  }
+
+  return size;
+}
+
+/**
+ * Moves the records in slots [slotId, numRecords) of `src` to the end of `dst`
+ * and compacts `src`. Both pages keep the records in slot order, so a page
+ * that was sorted splits into two sorted pages. Either all of the records
+ * move or none do: if `dst` doesn't have the continuous space for all of
+ * them, neither page is touched and false is returned.
+ */
+bool page_move_records(Page src, Page dst, int slotId) {
+  int numRecords = ((PageHeader*)src)->numRecords;
+
+  if (slotId < 0 || slotId > numRecords) return false;
+  if (page_get_records_size(src, slotId) > (int)((PageHeader*)dst)->freeData) return false;
+
+  /* every record is appended to the continuous free space, so they all fit */
+  for (int i = slotId; i < numRecords; i++) {
+    page_insert(dst, page_get_record(src, i), page_get_slot(src, i)->length);
+  }
+
+  page_truncate(src, slotId);
+
+  return true;
+}
+
+static uint32_t page_compute_checksum(Page pg) {
+  size_t fieldOffset = offsetof(PageHeader, checksum);
+  size_t restOffset = fieldOffset + sizeof(uint32_t);
+
+  uint32_t crc = crc32c_extend(CRC32C_INIT, pg, fieldOffset);
+  crc = crc32c_extend(crc, pg + restOffset, conf->pageSize - restOffset);
+
+  return crc32c_finish(crc);
+}
+
+void page_set_checksum(Page pg) {
+  ((PageHeader*)pg)->checksum = page_compute_checksum(pg);
+}
+
+/**
+ * Pages that have been preallocated in an extent but never written are all
+ * zeros, so they don't have a checksum to verify yet.
+ */
+static bool page_is_unused(Page pg) {
+  PageHeader* pgHdr = (PageHeader*)pg;
+  if (pgHdr->pageId != 0 || pgHdr->checksum != 0) return false;
+
+  for (int i = 0; i < conf->pageSize; i++) {
+    if (pg[i] != 0) return false;
+  }
+
+  return true;
+}
+
+bool page_verify_checksum(Page pg) {
+  if (page_is_unused(pg)) return true;
+
+  return ((PageHeader*)pg)->checksum == page_compute_checksum(pg);
 }
\ No newline at end of file
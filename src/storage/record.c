@@ -28,6 +28,15 @@ void construct_column_desc(Column* col, char* colname, DataType type, int colnum
   col->isNotNull = isNotNull;
 }
 
+void free_record_desc(RecordDescriptor* rd) {
+  for (int i = 0; i < rd->ncols; i++) {
+    if (rd->cols[i].colname != NULL) {
+      free(rd->cols[i].colname);
+    }
+  }
+  free(rd);
+}
+
 static Column* get_nth_col(RecordDescriptor* rd, bool isFixed, int n) {
   int nCol = 0;
 
@@ -317,6 +326,57 @@ void fill_record(RecordDescriptor* rd, Record r, Datum* fixed, Datum* varlen, bo
   }
 }
 
+/**
+ * @brief Serializes a row into a brand new Record. Unlike fill_record, the
+ * values don't need to be split into fixed and variable-length arrays first:
+ * `values` and `isnull` are indexed by each column's colnum, so `rd` may
+ * describe any subset of a table's columns. Caller is responsible for freeing
+ * the Record.
+ * 
+ * @param rd 
+ * @param values 
+ * @param isnull 
+ * @param recordLen returns the length of the Record
+ * @return Record 
+ */
+Record record_serialize(RecordDescriptor* rd, Datum* values, bool* isnull, uint16_t* recordLen) {
+  int nvarlen = rd->ncols - rd->nfixed;
+  Datum* fixed = malloc(sizeof(Datum) * (rd->nfixed + 1));
+  bool* fixedNull = malloc(sizeof(bool) * (rd->nfixed + 1));
+  Datum* varlen = malloc(sizeof(Datum) * (nvarlen + 1));
+  bool* varlenNull = malloc(sizeof(bool) * (nvarlen + 1));
+
+  int nFixed = 0;
+  int nVarlen = 0;
+  for (int i = 0; i < rd->ncols; i++) {
+    Column* col = &rd->cols[i];
+
+    if (col->dataType == DT_VARCHAR) {
+      varlen[nVarlen] = values[col->colnum];
+      varlenNull[nVarlen++] = isnull[col->colnum];
+    } else {
+      fixed[nFixed] = values[col->colnum];
+      fixedNull[nFixed++] = isnull[col->colnum];
+    }
+  }
+
+  *recordLen = compute_record_length(rd, fixed, fixedNull, varlen, varlenNull);
+  Record r = record_init(*recordLen);
+
+  int nullOffset = sizeof(RecordHeader) + compute_record_fixed_length(rd, fixedNull);
+  ((RecordHeader*)r)->nullOffset = nullOffset;
+
+  uint8_t* nullBitmap = rd->hasNullableColumns ? (uint8_t*)(r + nullOffset) : NULL;
+  fill_record(rd, r + sizeof(RecordHeader), fixed, varlen, fixedNull, varlenNull, nullBitmap);
+
+  free(fixed);
+  free(fixedNull);
+  free(varlen);
+  free(varlenNull);
+
+  return r;
+}
+
 static Datum record_get_tinyint(Record r, int* offset) {
   uint8_t tinyintVal;
   memcpy(&tinyintVal, r + *offset, 1);
@@ -433,4 +493,172 @@ void free_datum_array(RecordDescriptor* rd, Datum* values) {
   }
 
   free(values);
-}
\ No newline at end of file
+}
+
+static int64_t record_read_int(DataType dataType, char* data) {
+  switch (dataType) {
+    case DT_BOOL:
+    case DT_TINYINT:
+      return *(uint8_t*)data;
+    case DT_SMALLINT: {
+      int16_t v;
+      memcpy(&v, data, 2);
+      return v;
+    }
+    case DT_INT: {
+      int32_t v;
+      memcpy(&v, data, 4);
+      return v;
+    }
+    case DT_BIGINT: {
+      int64_t v;
+      memcpy(&v, data, 8);
+      return v;
+    }
+    default:
+      return 0;
+  }
+}
+
+#define RECORD_DECODE_COLUMN(ctype) \
+  for (int n = 0; n < numRecords; n++) { \
+    ctype v = 0; \
+    if (!isnull[n]) memcpy(&v, records[n] + offset, sizeof(ctype)); \
+    values[n] = v; \
+  }
+
+/**
+ * @brief Decodes a fixed-length integer column that is at the same `offset`
+ * in every record. The null bits of the whole batch are expanded first, then
+ * the values are read in a loop specialized for the data type. `nullPos` is
+ * the column's position in the null bitmap, -1 if the records have none.
+ */
+static void record_decode_same_shape(Record* records, int numRecords, int offset, DataType dataType, int nullPos, int64_t* values, uint8_t* isnull) {
+  if (nullPos < 0) {
+    memset(isnull, 0, numRecords);
+  } else {
+    int nullByte = nullPos >> 3;
+    uint8_t nullMask = 1 << (nullPos & 0x07);
+
+    for (int n = 0; n < numRecords; n++) {
+      uint8_t* nullBitmap = (uint8_t*)(records[n] + ((RecordHeader*)records[n])->nullOffset);
+      isnull[n] = !(nullBitmap[nullByte] & nullMask);
+    }
+  }
+
+  switch (dataType) {
+    case DT_BOOL:
+    case DT_TINYINT:
+      RECORD_DECODE_COLUMN(uint8_t)
+      break;
+    case DT_SMALLINT:
+      RECORD_DECODE_COLUMN(int16_t)
+      break;
+    case DT_INT:
+      RECORD_DECODE_COLUMN(int32_t)
+      break;
+    case DT_BIGINT:
+      RECORD_DECODE_COLUMN(int64_t)
+      break;
+    default:
+      break;
+  }
+}
+
+/**
+ * @brief Decodes the integer (or BOOL) column `colnum` of every record in
+ * `records`. Unlike defill_record, nothing but that one column is read and
+ * nothing is allocated, so a predicate can be checked against a whole page
+ * of records before any of them gets materialized.
+ * 
+ * @details Fixed-length columns come first and NULLs take no space, so when
+ * none of the columns before `colnum` is nullable, all the records share the
+ * same shape up to it: the column is at the same offset in every one, and
+ * the whole batch is decoded with a few loops that don't branch per record.
+ * Otherwise, every record's null bitmap has to be walked to find the column.
+ * 
+ * @param rd 
+ * @param records 
+ * @param numRecords 
+ * @param colnum 
+ * @param values returns the value of each record, 0 if it's NULL
+ * @param isnull returns 1 for each record where the column is NULL, 0 otherwise
+ */
+void record_decode_int_column(RecordDescriptor* rd, Record* records, int numRecords, int colnum, int64_t* values, uint8_t* isnull) {
+  int pos = record_get_col_pos(rd, colnum);
+  DataType dataType = get_nth_col(rd, true, pos)->dataType;
+  int nullPos = rd->hasNullableColumns ? pos : -1;
+
+  int colLens[pos + 1];
+  int offset = sizeof(RecordHeader);
+  bool sameShape = true;
+  for (int i = 0; i < pos; i++) {
+    Column* col = get_nth_col(rd, true, i);
+    colLens[i] = record_get_col_len(col, NULL, 0);
+    offset += colLens[i];
+    if (!col->isNotNull && rd->hasNullableColumns) sameShape = false;
+  }
+
+  if (sameShape) {
+    record_decode_same_shape(records, numRecords, offset, dataType, nullPos, values, isnull);
+    return;
+  }
+
+  for (int n = 0; n < numRecords; n++) {
+    Record r = records[n];
+    uint8_t* nullBitmap = (uint8_t*)(r + ((RecordHeader*)r)->nullOffset);
+
+    isnull[n] = col_isnull(pos, nullBitmap);
+    if (isnull[n]) {
+      values[n] = 0;
+      continue;
+    }
+
+    int colOffset = sizeof(RecordHeader);
+    for (int i = 0; i < pos; i++) {
+      if (!col_isnull(i, nullBitmap)) colOffset += colLens[i];
+    }
+
+    values[n] = record_read_int(dataType, r + colOffset);
+  }
+}
+
+/**
+ * @brief Finds the CHAR or VARCHAR column `colnum` of every record in
+ * `records`, without copying it. The strings are not null-terminated, use
+ * `lens` instead.
+ * 
+ * @param rd 
+ * @param records 
+ * @param numRecords 
+ * @param colnum 
+ * @param data returns a pointer to the string inside each record, NULL if it's NULL
+ * @param lens returns the length of each string
+ * @param isnull returns 1 for each record where the column is NULL, 0 otherwise
+ */
+void record_decode_string_column(RecordDescriptor* rd, Record* records, int numRecords, int colnum, char** data, uint16_t* lens, uint8_t* isnull) {
+  int pos = record_get_col_pos(rd, colnum);
+  Column* col = pos < rd->nfixed ? get_nth_col(rd, true, pos) : get_nth_col(rd, false, pos - rd->nfixed);
+
+  for (int n = 0; n < numRecords; n++) {
+    Record r = records[n];
+
+    isnull[n] = rd->hasNullableColumns && col_isnull(pos, (uint8_t*)(r + ((RecordHeader*)r)->nullOffset));
+    if (isnull[n]) {
+      data[n] = NULL;
+      lens[n] = 0;
+      continue;
+    }
+
+    int offset = compute_offset_to_column(rd, r, colnum);
+
+    if (col->dataType == DT_VARCHAR) {
+      data[n] = r + offset + 2;
+      lens[n] = record_get_varchar_len(r, offset) - 2;
+    } else {
+      /* CHARs are padded with zeroes, like defill_record we stop at the first one */
+      data[n] = r + offset;
+      lens[n] = strnlen(data[n], col->len);
+    }
+  }
+}
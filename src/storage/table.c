@@ -1,4 +1,5 @@
 #include <stdlib.h>
+#include <string.h>
 
 #include "storage/table.h"
 
@@ -6,14 +7,41 @@ TableDesc* new_tabledesc(char* tablename) {
   TableDesc* td = malloc(sizeof(TableDesc));
   td->tablename = tablename;
   td->rd = NULL;
+  td->firstPageId = 0;
+  td->indexes = NULL;
 
   return td;
 }
 
+static void free_indexdesc_item(void* ptr) {
+  free_indexdesc((IndexDesc*)ptr);
+}
+
 void free_tabledesc(TableDesc* td) {
   if (td == NULL) return;
 
   // if (td->tablename != NULL) free(td->tablename);
   if (td->rd != NULL) free_record_desc(td->rd);
+  if (td->indexes != NULL) free_linkedlist(td->indexes, free_indexdesc_item);
   free(td);
+}
+
+IndexDesc* new_indexdesc(int64_t objectId, char* indexname, int colnum, char type, int32_t rootPageId, uint64_t includedCols) {
+  IndexDesc* idx = malloc(sizeof(IndexDesc));
+  idx->objectId = objectId;
+  idx->indexname = strdup(indexname);
+  idx->colnum = colnum;
+  idx->type = type;
+  idx->rootPageId = rootPageId;
+  idx->includedCols = includedCols;
+  idx->rd = NULL;
+
+  return idx;
+}
+
+void free_indexdesc(IndexDesc* idx) {
+  if (idx == NULL) return;
+
+  if (idx->indexname != NULL) free(idx->indexname);
+  free(idx);
 }
\ No newline at end of file
@@ -1,5 +1,7 @@
 #include <string.h>
 #include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 #include "system/boot.h"
 #include "global/config.h"
@@ -12,8 +14,8 @@ bool init_boot_page(BufMgr* buf, BufTag* tag) {
   
   int32_t bufId = bufmgr_request_bufId(buf, tag);
   if (bufId < 0) {
-    bufId = bufmgr_allocate_new_page(buf, FILE_DATA);
-    if (buf->bd->descArr[bufId]->tag->pageId != BOOT_PAGE_ID) {
+    bufId = bufmgr_allocate_new_extent(buf, FILE_DATA);
+    if (bufId < 0 || buf->bd->descArr[bufId]->tag->pageId != BOOT_PAGE_ID) {
       printf("Allocated page is not the boot page\n");
       return false;
     }
@@ -50,7 +52,7 @@ void set_patch_num(BufMgr* buf, int32_t bufId, uint32_t val) {
   memcpy(buf->bp->pages[bufId] + PATCH_NUM_BYTE_POS, &val, PATCH_NUM_BYTE_SIZE);
 }
 
-void set_page_size(BufMgr* buf, int32_t bufId, uint16_t val) {
+void set_page_size(BufMgr* buf, int32_t bufId, uint32_t val) {
   memcpy(buf->bp->pages[bufId] + PAGE_SIZE_BYTE_POS, &val, PAGE_SIZE_BYTE_SIZE);
 }
 
@@ -84,16 +86,50 @@ uint32_t get_patch_num(BufMgr* buf) {
   return patchNum;
 }
 
-uint16_t get_page_size(BufMgr* buf) {
+uint32_t get_page_size(BufMgr* buf) {
   int32_t bufId = get_boot_page_bufid(buf);
 
-  uint16_t pageSize;
+  uint32_t pageSize;
 
   memcpy(&pageSize, buf->bp->pages[bufId] + PAGE_SIZE_BYTE_POS, PAGE_SIZE_BYTE_SIZE);
 
   return pageSize;
 }
 
+/**
+ * @brief Returns the first page of the visibility map, 0 if there is none yet
+ * 
+ * @details This one is read for every heap page an index-only scan visits,
+ * so unlike the getters above it unpins the boot page again.
+ * 
+ * @param buf 
+ * @return uint32_t 
+ */
+uint32_t get_vismap_page_id(BufMgr* buf) {
+  BufTag* tag = bufdesc_new_buftag(FILE_DATA, BOOT_PAGE_ID);
+  int32_t bufId = bufmgr_request_bufId_readonly(buf, tag);
+  bufdesc_free_buftag(tag);
+
+  if (bufId < 0) return 0;
+
+  uint32_t pageId;
+  memcpy(&pageId, buf->bp->pages[bufId] + VISMAP_PAGE_ID_BYTE_POS, VISMAP_PAGE_ID_BYTE_SIZE);
+  bufmgr_release_bufId(buf, bufId);
+
+  return pageId;
+}
+
+void set_vismap_page_id(BufMgr* buf, uint32_t val) {
+  BufTag* tag = bufdesc_new_buftag(FILE_DATA, BOOT_PAGE_ID);
+  int32_t bufId = bufmgr_request_bufId(buf, tag);
+  bufdesc_free_buftag(tag);
+
+  if (bufId < 0) return;
+
+  memcpy(buf->bp->pages[bufId] + VISMAP_PAGE_ID_BYTE_POS, &val, VISMAP_PAGE_ID_BYTE_SIZE);
+  bufdesc_set_dirty(buf->bd->descArr[bufId]);
+  bufmgr_release_bufId(buf, bufId);
+}
 
 void flush_boot_page(BufMgr* buf) {
   BufTag* tag = malloc(sizeof(BufTag));
@@ -101,4 +137,39 @@ void flush_boot_page(BufMgr* buf) {
   tag->pageId = BOOT_PAGE_ID;
   bufmgr_flush_page(buf, tag);
   free(tag);
+}
+
+/**
+ * @brief Reads the page size an existing database was initialized with
+ * straight from the start of the data file. We can't go through the buffer
+ * manager for this because it needs to know the page size before it can
+ * allocate any buffers.
+ * 
+ * Returns false if the data file does not exist or has not been initialized,
+ * in which case `pageSize` is left alone.
+ * 
+ * @param dataFile 
+ * @param pageSize 
+ * @return true 
+ * @return false 
+ */
+bool boot_read_page_size(char* dataFile, int* pageSize) {
+  int fd = open(dataFile, O_RDONLY);
+  if (fd < 0) return false;
+
+  char fields[BOOT_FIELDS_BYTE_SIZE];
+  ssize_t bytesRead = pread(fd, fields, BOOT_FIELDS_BYTE_SIZE, 0);
+  close(fd);
+
+  if (bytesRead != BOOT_FIELDS_BYTE_SIZE) return false;
+
+  uint16_t majorVersion;
+  memcpy(&majorVersion, fields + MAJOR_VERSION_BYTE_POS, MAJOR_VERSION_BYTE_SIZE);
+  if (majorVersion == 0) return false;
+
+  uint32_t bootPageSize;
+  memcpy(&bootPageSize, fields + PAGE_SIZE_BYTE_POS, PAGE_SIZE_BYTE_SIZE);
+  *pageSize = bootPageSize;
+
+  return true;
 }
\ No newline at end of file
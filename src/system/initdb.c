@@ -6,6 +6,8 @@
 #include "system/systable.h"
 #include "system/syscolumn.h"
 #include "system/syssequence.h"
+#include "system/sysextent.h"
+#include "system/sysindex.h"
 
 extern Config* conf;
 
@@ -16,6 +18,7 @@ static bool init_table(BufMgr* buf, int64_t objectId, char* name, char* type, in
   t->type = type;
   t->firstPageId = firstPageId;
   t->lastPageId = lastPageId;
+  t->zonemapPageId = 0;
 
   bool success = systableinit_insert_record(buf, t);
   free(t);
@@ -27,6 +30,11 @@ static bool init_tables(BufMgr* buf) {
   if (!init_table(buf, 1, "_tables", "s", SYSTABLE_FIRST_PAGE_ID, SYSTABLE_FIRST_PAGE_ID)) return false;
   if (!init_table(buf, 2, "_columns", "s", 0, 0)) return false;
   if (!init_table(buf, 3, "_sequences", "s", 0, 0)) return false;
+  if (!init_table(buf, 4, "_extents", "s", 0, 0)) return false;
+  if (!init_table(buf, 5, "_indexes", "s", 0, 0)) return false;
+
+  /* the hard-coded `person` table lives in the catalog until we support CREATE TABLE */
+  if (!init_table(buf, 35, "person", "u", 0, 0)) return false;
 
   return true;
 }
@@ -61,27 +69,45 @@ static bool init_column(
 }
 
 static bool init_columns(BufMgr* buf) {
-  if (!init_column(buf, 4, 1, "object_id", DT_BIGINT, 8, 0, 0, 0, 1)) return false;
-  if (!init_column(buf, 5, 1, "name", DT_VARCHAR, 50, 0, 0, 1, 1)) return false;
-  if (!init_column(buf, 6, 1, "type", DT_CHAR, 1, 0, 0, 2, 1)) return false;
-  if (!init_column(buf, 7, 1, "first_page_id", DT_INT, 4, 0, 0, 3, 1)) return false;
-  if (!init_column(buf, 8, 1, "last_page_id", DT_INT, 4, 0, 0, 4, 1)) return false;
-
-  if (!init_column(buf, 9, 2, "object_id", DT_BIGINT, 8, 0, 0, 0, 1)) return false;
-  if (!init_column(buf, 10, 2, "table_id", DT_BIGINT, 8, 0, 0, 1, 1)) return false;
-  if (!init_column(buf, 11, 2, "name", DT_VARCHAR, 50, 0, 0, 2, 1)) return false;
-  if (!init_column(buf, 12, 2, "data_type", DT_TINYINT, 1, 0, 0, 3, 1)) return false;
-  if (!init_column(buf, 13, 2, "max_length", DT_SMALLINT, 2, 0, 0, 4, 1)) return false;
-  if (!init_column(buf, 14, 2, "precision", DT_TINYINT, 1, 0, 0, 5, 1)) return false;
-  if (!init_column(buf, 15, 2, "scale", DT_TINYINT, 1, 0, 0, 6, 1)) return false;
-  if (!init_column(buf, 16, 2, "colnum", DT_TINYINT, 1, 0, 0, 7, 1)) return false;
-  if (!init_column(buf, 17, 2, "is_not_null", DT_TINYINT, 1, 0, 0, 8, 1)) return false;
-
-  if (!init_column(buf, 18, 3, "object_id", DT_BIGINT, 8, 0, 0, 0, 1)) return false;
-  if (!init_column(buf, 19, 3, "name", DT_VARCHAR, 50, 0, 0, 1, 1)) return false;
-  if (!init_column(buf, 20, 3, "column_id", DT_BIGINT, 8, 0, 0, 2, 1)) return false;
-  if (!init_column(buf, 21, 3, "next_value", DT_BIGINT, 8, 0, 0, 3, 1)) return false;
-  if (!init_column(buf, 22, 3, "increment", DT_BIGINT, 8, 0, 0, 4, 1)) return false;
+  if (!init_column(buf, 6, 1, "object_id", DT_BIGINT, 8, 0, 0, 0, 1)) return false;
+  if (!init_column(buf, 7, 1, "name", DT_VARCHAR, 50, 0, 0, 1, 1)) return false;
+  if (!init_column(buf, 8, 1, "type", DT_CHAR, 1, 0, 0, 2, 1)) return false;
+  if (!init_column(buf, 9, 1, "first_page_id", DT_INT, 4, 0, 0, 3, 1)) return false;
+  if (!init_column(buf, 10, 1, "last_page_id", DT_INT, 4, 0, 0, 4, 1)) return false;
+  if (!init_column(buf, 41, 1, "zonemap_page_id", DT_INT, 4, 0, 0, 5, 1)) return false;
+
+  if (!init_column(buf, 11, 2, "object_id", DT_BIGINT, 8, 0, 0, 0, 1)) return false;
+  if (!init_column(buf, 12, 2, "table_id", DT_BIGINT, 8, 0, 0, 1, 1)) return false;
+  if (!init_column(buf, 13, 2, "name", DT_VARCHAR, 50, 0, 0, 2, 1)) return false;
+  if (!init_column(buf, 14, 2, "data_type", DT_TINYINT, 1, 0, 0, 3, 1)) return false;
+  if (!init_column(buf, 15, 2, "max_length", DT_SMALLINT, 2, 0, 0, 4, 1)) return false;
+  if (!init_column(buf, 16, 2, "precision", DT_TINYINT, 1, 0, 0, 5, 1)) return false;
+  if (!init_column(buf, 17, 2, "scale", DT_TINYINT, 1, 0, 0, 6, 1)) return false;
+  if (!init_column(buf, 18, 2, "colnum", DT_TINYINT, 1, 0, 0, 7, 1)) return false;
+  if (!init_column(buf, 19, 2, "is_not_null", DT_TINYINT, 1, 0, 0, 8, 1)) return false;
+
+  if (!init_column(buf, 20, 3, "object_id", DT_BIGINT, 8, 0, 0, 0, 1)) return false;
+  if (!init_column(buf, 21, 3, "name", DT_VARCHAR, 50, 0, 0, 1, 1)) return false;
+  if (!init_column(buf, 22, 3, "column_id", DT_BIGINT, 8, 0, 0, 2, 1)) return false;
+  if (!init_column(buf, 23, 3, "next_value", DT_BIGINT, 8, 0, 0, 3, 1)) return false;
+  if (!init_column(buf, 24, 3, "increment", DT_BIGINT, 8, 0, 0, 4, 1)) return false;
+
+  if (!init_column(buf, 25, 4, "table_id", DT_BIGINT, 8, 0, 0, 0, 1)) return false;
+  if (!init_column(buf, 26, 4, "first_page_id", DT_INT, 4, 0, 0, 1, 1)) return false;
+  if (!init_column(buf, 27, 4, "page_count", DT_INT, 4, 0, 0, 2, 1)) return false;
+
+  if (!init_column(buf, 28, 5, "object_id", DT_BIGINT, 8, 0, 0, 0, 1)) return false;
+  if (!init_column(buf, 29, 5, "table_id", DT_BIGINT, 8, 0, 0, 1, 1)) return false;
+  if (!init_column(buf, 30, 5, "name", DT_VARCHAR, 50, 0, 0, 2, 1)) return false;
+  if (!init_column(buf, 31, 5, "colnum", DT_TINYINT, 1, 0, 0, 3, 1)) return false;
+  if (!init_column(buf, 32, 5, "type", DT_CHAR, 1, 0, 0, 4, 1)) return false;
+  if (!init_column(buf, 33, 5, "root_page_id", DT_INT, 4, 0, 0, 5, 1)) return false;
+  if (!init_column(buf, 40, 5, "included_cols", DT_BIGINT, 8, 0, 0, 6, 1)) return false;
+
+  if (!init_column(buf, 36, 35, "person_id", DT_INT, 4, 0, 0, 0, 1)) return false;
+  if (!init_column(buf, 37, 35, "first_name", DT_VARCHAR, 20, 0, 0, 1, 0)) return false;
+  if (!init_column(buf, 38, 35, "last_name", DT_VARCHAR, 20, 0, 0, 2, 1)) return false;
+  if (!init_column(buf, 39, 35, "age", DT_INT, 4, 0, 0, 3, 0)) return false;
 
   return true;
 }
@@ -110,11 +136,32 @@ static bool init_sequence(
 }
 
 static bool init_sequences(BufMgr* buf) {
-  if (!init_sequence(buf, 23, "sys_object_id", "s", 0, 24, 1)) return false;
+  if (!init_sequence(buf, 34, "sys_object_id", "s", 0, 42, 1)) return false;
 
   return true;
 }
 
+/**
+ * @brief The boot page and the `_tables` system table share the first
+ * extent in the file. It was claimed before `_extents` existed, so we
+ * record it by hand.
+ * 
+ * @param buf 
+ * @return true 
+ * @return false 
+ */
+static bool init_extents(BufMgr* buf) {
+  SysExtent* e = malloc(sizeof(SysExtent));
+  e->tableId = 1;
+  e->firstPageId = BOOT_PAGE_ID;
+  e->pageCount = EXTENT_SIZE;
+
+  bool success = sysextentinit_insert_record(buf, e);
+  free(e);
+
+  return success;
+}
+
 /**
  * @brief initializes the database boot and system pages if necessary
  * 
@@ -122,9 +169,9 @@ static bool init_sequences(BufMgr* buf) {
  * how many pages it will consume, we defer updating the `first_page_id` and
  * `last_page_id` columns until the end of the initialization process.
  * 
- * @todo eventually use this process to read the first 128-byte chunk of the file
- * and set conf->pageSize from the boot page value. Everything after this will read
- * data in `pageSize` chunks
+ * The page size of an existing database has already been read from its boot
+ * page by `boot_read_page_size` at startup, so `conf->pageSize` is only used
+ * to pick the page size of a brand new database.
  * 
  * @param buf 
  */
@@ -152,6 +199,7 @@ bool initdb(BufMgr* buf) {
 
   // if (!init_objects(buf)) return false;
   if (!init_tables(buf)) return false;
+  if (!init_extents(buf)) return false;
   if (!init_columns(buf)) return false;
   if (!init_sequences(buf)) return false;
 
@@ -4,18 +4,31 @@
 #include "system/systable.h"
 #include "system/syscolumn.h"
 #include "system/syssequence.h"
+#include "system/sysextent.h"
+#include "system/sysindex.h"
 #include "access/tableam.h"
 #include "resultset/recordset.h"
 #include "resultset/resultset_print.h"
 
+/**
+ * @brief Checks the first word of a system command, the rest is its argument
+ */
+static bool syscmd_is(const char* cmd, const char* name) {
+  size_t len = strcspn(cmd, " \t");
+  return len == strlen(name) && strncmp(cmd, name, len) == 0;
+}
+
 CliSysCmd parse_syscmd(const char* cmd) {
-  if (strcmp(cmd, "quit") == 0) return SYSCMD_QUIT;
-  if (strcmp(cmd, "buf") == 0) return SYSCMD_BUFFER_SUMMARY;
-  if (strcmp(cmd, "bufd") == 0) return SYSCMD_BUFFER_DETAILS;
-  if (strcmp(cmd, "file") == 0) return SYSCMD_BUFFILE_SUMMARY;
-  if (strcmp(cmd, "t") == 0) return SYSCMD_SYS_TABLE_TABLES;
-  if (strcmp(cmd, "c") == 0) return SYSCMD_SYS_TABLE_COLUMNS;
-  if (strcmp(cmd, "s") == 0) return SYSCMD_SYS_TABLE_SEQUENCES;
+  if (syscmd_is(cmd, "quit")) return SYSCMD_QUIT;
+  if (syscmd_is(cmd, "buf")) return SYSCMD_BUFFER_SUMMARY;
+  if (syscmd_is(cmd, "bufd")) return SYSCMD_BUFFER_DETAILS;
+  if (syscmd_is(cmd, "file")) return SYSCMD_BUFFILE_SUMMARY;
+  if (syscmd_is(cmd, "t")) return SYSCMD_SYS_TABLE_TABLES;
+  if (syscmd_is(cmd, "c")) return SYSCMD_SYS_TABLE_COLUMNS;
+  if (syscmd_is(cmd, "s")) return SYSCMD_SYS_TABLE_SEQUENCES;
+  if (syscmd_is(cmd, "e")) return SYSCMD_SYS_TABLE_EXTENTS;
+  if (syscmd_is(cmd, "i")) return SYSCMD_SYS_TABLE_INDEXES;
+  if (syscmd_is(cmd, "format")) return SYSCMD_FORMAT;
 
   return SYSCMD_UNRECOGNIZED;
 }
@@ -56,7 +69,51 @@ static void syscmd_sys_table_sequences(BufMgr* buf) {
   free_tabledesc(td);
 }
 
+static void syscmd_sys_table_extents(BufMgr* buf) {
+  TableDesc* td = new_tabledesc("_extents");
+  td->rd = sysextent_get_record_desc();
+  RecordSet* rs = new_recordset();
+
+  tableam_fullscan(buf, td, rs);
+  resultset_print(td->rd, rs, td->rd);
+
+  free_recordset(rs, td->rd);
+  free_tabledesc(td);
+}
+
+static void syscmd_sys_table_indexes(BufMgr* buf) {
+  TableDesc* td = new_tabledesc("_indexes");
+  td->rd = sysindex_get_record_desc();
+  RecordSet* rs = new_recordset();
+
+  tableam_fullscan(buf, td, rs);
+  resultset_print(td->rd, rs, td->rd);
+
+  free_recordset(rs, td->rd);
+  free_tabledesc(td);
+}
+
+/**
+ * @brief `\format` prints the output format of result sets, `\format <name>`
+ * switches to another one (see resultset_print.h)
+ */
+static void syscmd_format(const char* arg) {
+  ResultFormat f;
+
+  if (*arg == '\0') {
+    printf("Output format is %s\n", resultset_format_name(resultset_get_format()));
+  } else if (resultset_parse_format(arg, &f)) {
+    resultset_set_format(f);
+    printf("Output format is %s\n", resultset_format_name(f));
+  } else {
+    printf("Unknown output format %s, use aligned, csv (or unaligned), json or binary\n", arg);
+  }
+}
+
 void run_syscmd(const char* cmd, BufMgr* buf) {
+  const char* arg = cmd + strcspn(cmd, " \t");
+  arg += strspn(arg, " \t");
+
   switch (parse_syscmd(cmd)) {
     case SYSCMD_BUFFER_SUMMARY:
       bufmgr_diag_summary(buf);
@@ -76,6 +133,15 @@ void run_syscmd(const char* cmd, BufMgr* buf) {
     case SYSCMD_SYS_TABLE_SEQUENCES:
       syscmd_sys_table_sequences(buf);
       break;
+    case SYSCMD_SYS_TABLE_EXTENTS:
+      syscmd_sys_table_extents(buf);
+      break;
+    case SYSCMD_SYS_TABLE_INDEXES:
+      syscmd_sys_table_indexes(buf);
+      break;
+    case SYSCMD_FORMAT:
+      syscmd_format(arg);
+      break;
     case SYSCMD_UNRECOGNIZED:
       printf("Unrecognized system command\n");
   }
@@ -2,6 +2,9 @@
 
 #include "system/syscolumn.h"
 #include "system/systable.h"
+#include "system/sysextent.h"
+#include "access/tableam.h"
+#include "resultset/recordset.h"
 
 RecordDescriptor* syscolumn_get_record_desc() {
   RecordDescriptor* rd = malloc(sizeof(RecordDescriptor) + (9 * sizeof(Column)));
@@ -78,7 +81,7 @@ bool syscolumninit_insert_record(BufMgr* buf, SysColumn* c) {
   BufTag* tag = bufdesc_new_buftag(FILE_DATA, 0);
 
   if (lastPageId <= 0) {
-    bufId = bufmgr_allocate_new_page(buf, FILE_DATA);
+    bufId = bufmgr_allocate_new_extent(buf, FILE_DATA);
     if (bufId < 0) {
       printf("Unable to allocate new page syscolumn\n");
       return false;
@@ -87,6 +90,7 @@ bool syscolumninit_insert_record(BufMgr* buf, SysColumn* c) {
     int32_t firstPageId = buf->bd->descArr[bufId]->tag->pageId;
     systable_set_first_pageid(buf, "_columns", firstPageId);
     systable_set_last_pageid(buf, "_columns", firstPageId);
+    sysextent_track_page(buf, "_columns", firstPageId);
   } else {
     tag->pageId = lastPageId;
     bufId = bufmgr_request_bufId(buf, tag);
@@ -103,16 +107,19 @@ bool syscolumninit_insert_record(BufMgr* buf, SysColumn* c) {
     int32_t oldBufId = bufId;
 
     if (nextPageId == 0) {
+      /* bufmgr_page_split releases the old page */
       bufId = bufmgr_page_split(buf, bufId);
+      if (bufId < 0) break;
 
       /* update `last_page_id` field in the _tables system table */
-      systable_set_last_pageid(buf, "_columns", buf->bd->descArr[bufId]->tag->pageId);
+      int32_t newPageId = buf->bd->descArr[bufId]->tag->pageId;
+      systable_set_last_pageid(buf, "_columns", newPageId);
+      sysextent_track_page(buf, "_columns", newPageId);
     } else {
       tag->pageId = nextPageId;
       bufId = bufmgr_request_bufId(buf, tag);
+      bufmgr_release_bufId(buf, oldBufId);
     }
-
-    bufmgr_release_bufId(buf, oldBufId);
   }
 
   bufdesc_free_buftag(tag);
@@ -124,4 +131,67 @@ bool syscolumninit_insert_record(BufMgr* buf, SysColumn* c) {
   free(r);
 
   return true;
+}
+
+/**
+ * @brief Builds the RecordDescriptor of a table from its rows in the
+ * `_columns` system table. Columns are ordered by `colnum`.
+ * 
+ * @param buf 
+ * @param tableId 
+ * @return RecordDescriptor* or NULL if the table has no columns
+ */
+RecordDescriptor* syscolumn_get_table_record_desc(BufMgr* buf, int64_t tableId) {
+  TableDesc* td = new_tabledesc("_columns");
+  td->rd = syscolumn_get_record_desc();
+  RecordSet* rs = new_recordset();
+
+  tableam_fullscan(buf, td, rs);
+
+  int ncols = 0;
+  ListItem* li = rs->rows->head;
+  while (li != NULL) {
+    RecordSetRow* row = li->ptr;
+    if (datumGetInt64(row->values[1]) == tableId) ncols++;
+    li = li->next;
+  }
+
+  RecordDescriptor* rd = NULL;
+
+  if (ncols > 0) {
+    rd = malloc(sizeof(RecordDescriptor) + (ncols * sizeof(Column)));
+    rd->ncols = ncols;
+    rd->nfixed = 0;
+    rd->hasNullableColumns = false;
+
+    li = rs->rows->head;
+    while (li != NULL) {
+      RecordSetRow* row = li->ptr;
+      int colnum = datumGetUInt8(row->values[7]);
+
+      if (datumGetInt64(row->values[1]) == tableId && colnum < ncols) {
+        DataType dataType = datumGetUInt8(row->values[3]);
+        bool isNotNull = datumGetUInt8(row->values[8]);
+
+        construct_column_desc(
+          &rd->cols[colnum],
+          datumGetString(row->values[2]),
+          dataType,
+          colnum,
+          datumGetInt16(row->values[4]),
+          isNotNull
+        );
+
+        if (dataType != DT_VARCHAR) rd->nfixed++;
+        if (!isNotNull) rd->hasNullableColumns = true;
+      }
+
+      li = li->next;
+    }
+  }
+
+  free_recordset(rs, td->rd);
+  free_tabledesc(td);
+
+  return rd;
 }
\ No newline at end of file
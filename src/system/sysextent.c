@@ -0,0 +1,176 @@
+#include <stdlib.h>
+
+#include "system/sysextent.h"
+#include "system/systable.h"
+#include "access/tableam.h"
+
+RecordDescriptor* sysextent_get_record_desc() {
+  RecordDescriptor* rd = malloc(sizeof(RecordDescriptor) + (3 * sizeof(Column)));
+  rd->ncols = 3;
+  rd->nfixed = 3;
+  rd->hasNullableColumns = false;
+
+  construct_column_desc(&rd->cols[0], "table_id", DT_BIGINT, 0, 8, true);
+  construct_column_desc(&rd->cols[1], "first_page_id", DT_INT, 1, 4, true);
+  construct_column_desc(&rd->cols[2], "page_count", DT_INT, 2, 4, true);
+
+  return rd;
+}
+
+static void sysextent_populate_values_arrays(
+  Datum* fixed,
+  bool* fixedNull,
+  SysExtent* e
+) {
+  fixed[0] = int64GetDatum(e->tableId);
+  fixedNull[0] = false;
+  fixed[1] = int32GetDatum(e->firstPageId);
+  fixedNull[1] = false;
+  fixed[2] = int32GetDatum(e->pageCount);
+  fixedNull[2] = false;
+}
+
+bool sysextentinit_insert_record(BufMgr* buf, SysExtent* e) {
+  RecordDescriptor* rd = sysextent_get_record_desc();
+
+  Datum* fixed = malloc(sizeof(Datum) * rd->nfixed);
+  bool* fixedNull = malloc(sizeof(bool) * rd->nfixed);
+
+  sysextent_populate_values_arrays(fixed, fixedNull, e);
+
+  uint16_t recordLen = compute_record_length(rd, fixed, fixedNull, NULL, NULL);
+  Record r = record_init(recordLen);
+  fill_record(rd, r + sizeof(RecordHeader), fixed, NULL, fixedNull, NULL, NULL);
+
+  int32_t lastPageId = systable_get_last_pageid(buf, "_extents");
+  int32_t bufId;
+  BufTag* tag = bufdesc_new_buftag(FILE_DATA, 0);
+
+  if (lastPageId <= 0) {
+    bufId = bufmgr_allocate_new_extent(buf, FILE_DATA);
+    if (bufId < 0) {
+      printf("Unable to allocate new page sysextent\n");
+    } else {
+      pageheader_init_datapage(buf->bp->pages[bufId]);
+      int32_t firstPageId = buf->bd->descArr[bufId]->tag->pageId;
+      systable_set_first_pageid(buf, "_extents", firstPageId);
+      systable_set_last_pageid(buf, "_extents", firstPageId);
+
+      /* the `_extents` table's own first extent gets tracked like any other */
+      sysextent_track_page(buf, "_extents", firstPageId);
+    }
+  } else {
+    tag->pageId = lastPageId;
+    bufId = bufmgr_request_bufId(buf, tag);
+  }
+
+  while (bufId >= 0) {
+    if (page_insert(buf->bp->pages[bufId], r, recordLen)) {
+      bufdesc_set_dirty(buf->bd->descArr[bufId]);
+      bufmgr_release_bufId(buf, bufId);
+      break;
+    }
+
+    int32_t nextPageId = ((PageHeader*)buf->bp->pages[bufId])->nextPageId;
+    int32_t oldBufId = bufId;
+
+    if (nextPageId == 0) {
+      /* bufmgr_page_split releases the old page */
+      bufId = bufmgr_page_split(buf, bufId);
+      if (bufId < 0) break;
+
+      /* update `last_page_id` field in the _tables system table */
+      int32_t newPageId = buf->bd->descArr[bufId]->tag->pageId;
+      systable_set_last_pageid(buf, "_extents", newPageId);
+      sysextent_track_page(buf, "_extents", newPageId);
+    } else {
+      tag->pageId = nextPageId;
+      bufId = bufmgr_request_bufId(buf, tag);
+      bufmgr_release_bufId(buf, oldBufId);
+    }
+  }
+
+  /* the loop only leaves bufId negative when no page took the record */
+  bool inserted = bufId >= 0;
+
+  bufdesc_free_buftag(tag);
+  free_record_desc(rd);
+  free(fixed);
+  free(fixedNull);
+  free(r);
+
+  return inserted;
+}
+
+/**
+ * @brief Records a new extent for `tablename` in `_extents` if `pageId` is
+ * the first page of an extent. Callers invoke this for every page they
+ * allocate, so only the first page of each extent results in a new record.
+ * 
+ * @param buf 
+ * @param tablename 
+ * @param pageId 
+ * @return true 
+ * @return false 
+ */
+bool sysextent_track_page(BufMgr* buf, char* tablename, int32_t pageId) {
+  if (!is_extent_first_pageid(pageId)) return true;
+
+  return sysextent_track_object_page(buf, systable_get_objectId(buf, tablename), pageId);
+}
+
+/**
+ * @brief Same as sysextent_track_page, but for objects that are identified
+ * by their objectId rather than an entry in `_tables` (e.g. indexes)
+ * 
+ * @param buf 
+ * @param objectId 
+ * @param pageId 
+ * @return true 
+ * @return false 
+ */
+bool sysextent_track_object_page(BufMgr* buf, int64_t objectId, int32_t pageId) {
+  if (!is_extent_first_pageid(pageId)) return true;
+
+  SysExtent* e = malloc(sizeof(SysExtent));
+  e->tableId = objectId;
+  e->firstPageId = pageId;
+  e->pageCount = EXTENT_SIZE;
+
+  bool success = sysextentinit_insert_record(buf, e);
+  free(e);
+
+  return success;
+}
+
+/**
+ * @brief Returns the first pageId of the newest (highest) extent owned by
+ * `objectId`, or 0 if the object has no extents
+ * 
+ * @param buf 
+ * @param objectId 
+ * @return int32_t 
+ */
+int32_t sysextent_get_last_extent(BufMgr* buf, int64_t objectId) {
+  TableDesc* td = new_tabledesc("_extents");
+  td->rd = sysextent_get_record_desc();
+  RecordSet* rs = new_recordset();
+
+  tableam_fullscan(buf, td, rs);
+
+  int32_t lastPageId = 0;
+  ListItem* li = rs->rows->head;
+  while (li != NULL) {
+    RecordSetRow* row = li->ptr;
+    if (datumGetInt64(row->values[0]) == objectId && datumGetInt32(row->values[1]) > lastPageId) {
+      lastPageId = datumGetInt32(row->values[1]);
+    }
+
+    li = li->next;
+  }
+
+  free_recordset(rs, td->rd);
+  free_tabledesc(td);
+
+  return lastPageId;
+}
\ No newline at end of file
@@ -0,0 +1,195 @@
+#include <stdlib.h>
+
+#include "system/sysindex.h"
+#include "system/systable.h"
+#include "system/sysextent.h"
+#include "access/tableam.h"
+#include "resultset/recordset.h"
+
+RecordDescriptor* sysindex_get_record_desc() {
+  RecordDescriptor* rd = malloc(sizeof(RecordDescriptor) + (7 * sizeof(Column)));
+  rd->ncols = 7;
+  rd->nfixed = 6;
+  rd->hasNullableColumns = false;
+
+  construct_column_desc(&rd->cols[0], "object_id", DT_BIGINT, 0, 8, true);
+  construct_column_desc(&rd->cols[1], "table_id", DT_BIGINT, 1, 8, true);
+  construct_column_desc(&rd->cols[2], "name", DT_VARCHAR, 2, 50, true);
+  construct_column_desc(&rd->cols[3], "colnum", DT_TINYINT, 3, 1, true);
+  construct_column_desc(&rd->cols[4], "type", DT_CHAR, 4, 1, true);
+  construct_column_desc(&rd->cols[5], "root_page_id", DT_INT, 5, 4, true);
+  construct_column_desc(&rd->cols[6], "included_cols", DT_BIGINT, 6, 8, true);
+
+  return rd;
+}
+
+static void sysindex_populate_values_arrays(
+  Datum* fixed,
+  bool* fixedNull,
+  Datum* varlen,
+  bool* varlenNull,
+  SysIndex* idx
+) {
+  fixed[0] = int64GetDatum(idx->objectId);
+  fixedNull[0] = false;
+  fixed[1] = int64GetDatum(idx->tableId);
+  fixedNull[1] = false;
+  fixed[2] = uint8GetDatum(idx->colnum);
+  fixedNull[2] = false;
+  fixed[3] = charGetDatum(idx->type);
+  fixedNull[3] = false;
+  fixed[4] = int32GetDatum(idx->rootPageId);
+  fixedNull[4] = false;
+  fixed[5] = int64GetDatum(idx->includedCols);
+  fixedNull[5] = false;
+
+  varlen[0] = charGetDatum(idx->name);
+  varlenNull[0] = false;
+}
+
+bool sysindexinit_insert_record(BufMgr* buf, SysIndex* idx) {
+  RecordDescriptor* rd = sysindex_get_record_desc();
+
+  Datum* fixed = malloc(sizeof(Datum) * rd->nfixed);
+  bool* fixedNull = malloc(sizeof(bool) * rd->nfixed);
+  Datum* varlen = malloc(sizeof(Datum) * (rd->ncols - rd->nfixed));
+  bool* varlenNull = malloc(sizeof(bool) * (rd->ncols - rd->nfixed));
+
+  sysindex_populate_values_arrays(fixed, fixedNull, varlen, varlenNull, idx);
+
+  uint16_t recordLen = compute_record_length(rd, fixed, fixedNull, varlen, varlenNull);
+  Record r = record_init(recordLen);
+  fill_record(rd, r + sizeof(RecordHeader), fixed, varlen, fixedNull, varlenNull, NULL);
+
+  int32_t lastPageId = systable_get_last_pageid(buf, "_indexes");
+  int32_t bufId;
+  BufTag* tag = bufdesc_new_buftag(FILE_DATA, 0);
+
+  if (lastPageId <= 0) {
+    bufId = bufmgr_allocate_new_extent(buf, FILE_DATA);
+    if (bufId < 0) {
+      printf("Unable to allocate new page sysindex\n");
+      return false;
+    }
+    pageheader_init_datapage(buf->bp->pages[bufId]);
+    int32_t firstPageId = buf->bd->descArr[bufId]->tag->pageId;
+    systable_set_first_pageid(buf, "_indexes", firstPageId);
+    systable_set_last_pageid(buf, "_indexes", firstPageId);
+    sysextent_track_page(buf, "_indexes", firstPageId);
+  } else {
+    tag->pageId = lastPageId;
+    bufId = bufmgr_request_bufId(buf, tag);
+  }
+
+  while (bufId >= 0) {
+    if (page_insert(buf->bp->pages[bufId], r, recordLen)) {
+      bufdesc_set_dirty(buf->bd->descArr[bufId]);
+      bufmgr_release_bufId(buf, bufId);
+      break;
+    }
+
+    int32_t nextPageId = ((PageHeader*)buf->bp->pages[bufId])->nextPageId;
+    int32_t oldBufId = bufId;
+
+    if (nextPageId == 0) {
+      /* bufmgr_page_split releases the old page */
+      bufId = bufmgr_page_split(buf, bufId);
+      if (bufId < 0) break;
+
+      /* update `last_page_id` field in the _tables system table */
+      int32_t newPageId = buf->bd->descArr[bufId]->tag->pageId;
+      systable_set_last_pageid(buf, "_indexes", newPageId);
+      sysextent_track_page(buf, "_indexes", newPageId);
+    } else {
+      tag->pageId = nextPageId;
+      bufId = bufmgr_request_bufId(buf, tag);
+      bufmgr_release_bufId(buf, oldBufId);
+    }
+  }
+
+  bufdesc_free_buftag(tag);
+  free_record_desc(rd);
+  free(fixed);
+  free(fixedNull);
+  free(varlen);
+  free(varlenNull);
+  free(r);
+
+  return true;
+}
+
+static void free_indexdesc_item(void* ptr) {
+  free_indexdesc((IndexDesc*)ptr);
+}
+
+/**
+ * @brief Returns a LinkedList of IndexDesc* for every index on the table.
+ * The list is empty if the table has no indexes. Caller is responsible for
+ * freeing it with `sysindex_free_index_list`.
+ * 
+ * @param buf 
+ * @param tableId 
+ * @return LinkedList* 
+ */
+LinkedList* sysindex_get_table_indexes(BufMgr* buf, int64_t tableId) {
+  TableDesc* td = new_tabledesc("_indexes");
+  td->rd = sysindex_get_record_desc();
+  RecordSet* rs = new_recordset();
+
+  tableam_fullscan(buf, td, rs);
+
+  LinkedList* indexes = new_linkedlist();
+  ListItem* li = rs->rows->head;
+  while (li != NULL) {
+    RecordSetRow* row = li->ptr;
+    if (datumGetInt64(row->values[1]) == tableId) {
+      IndexDesc* idx = new_indexdesc(
+        datumGetInt64(row->values[0]),
+        datumGetString(row->values[2]),
+        datumGetUInt8(row->values[3]),
+        datumGetString(row->values[4])[0],
+        datumGetInt32(row->values[5]),
+        datumGetInt64(row->values[6])
+      );
+      linkedlist_append(indexes, idx);
+    }
+
+    li = li->next;
+  }
+
+  free_recordset(rs, td->rd);
+  free_tabledesc(td);
+
+  return indexes;
+}
+
+/**
+ * @brief Returns the clustered index of the table, or NULL if the table is a
+ * regular heap. Caller is responsible for freeing it.
+ * 
+ * @param buf 
+ * @param tableId 
+ * @return IndexDesc* 
+ */
+IndexDesc* sysindex_get_clustered_index(BufMgr* buf, int64_t tableId) {
+  LinkedList* indexes = sysindex_get_table_indexes(buf, tableId);
+
+  IndexDesc* found = NULL;
+  ListItem* li = indexes->head;
+  while (li != NULL) {
+    IndexDesc* idx = li->ptr;
+    if (idx->type == 'c') {
+      found = new_indexdesc(idx->objectId, idx->indexname, idx->colnum, idx->type, idx->rootPageId, idx->includedCols);
+      break;
+    }
+    li = li->next;
+  }
+
+  sysindex_free_index_list(indexes);
+
+  return found;
+}
+
+void sysindex_free_index_list(LinkedList* indexes) {
+  free_linkedlist(indexes, free_indexdesc_item);
+}
\ No newline at end of file
@@ -3,6 +3,10 @@
 
 #include "system/syssequence.h"
 #include "system/systable.h"
+#include "system/sysextent.h"
+#include "global/config.h"
+
+extern Config* conf;
 
 RecordDescriptor* syssequence_get_record_desc() {
   RecordDescriptor* rd = malloc(sizeof(RecordDescriptor) + (6 * sizeof(Column)));
@@ -71,7 +75,7 @@ bool syssequenceinit_insert_record(BufMgr* buf, SysSequence* s) {
   BufTag* tag = bufdesc_new_buftag(FILE_DATA, 0);
 
   if (lastPageId <= 0) {
-    bufId = bufmgr_allocate_new_page(buf, FILE_DATA);
+    bufId = bufmgr_allocate_new_extent(buf, FILE_DATA);
     if (bufId < 0) {
       printf("Unable to allocate new page syssequence\n");
       return false;
@@ -80,6 +84,7 @@ bool syssequenceinit_insert_record(BufMgr* buf, SysSequence* s) {
     int32_t firstPageId = buf->bd->descArr[bufId]->tag->pageId;
     systable_set_first_pageid(buf, "_sequences", firstPageId);
     systable_set_last_pageid(buf, "_sequences", firstPageId);
+    sysextent_track_page(buf, "_sequences", firstPageId);
   } else {
     tag->pageId = lastPageId;
     bufId = bufmgr_request_bufId(buf, tag);
@@ -96,16 +101,19 @@ bool syssequenceinit_insert_record(BufMgr* buf, SysSequence* s) {
     int32_t oldBufId = bufId;
 
     if (nextPageId == 0) {
+      /* bufmgr_page_split releases the old page */
       bufId = bufmgr_page_split(buf, bufId);
+      if (bufId < 0) break;
 
       /* update `last_page_id` field in the _tables system table */
-      systable_set_last_pageid(buf, "_sequences", buf->bd->descArr[bufId]->tag->pageId);
+      int32_t newPageId = buf->bd->descArr[bufId]->tag->pageId;
+      systable_set_last_pageid(buf, "_sequences", newPageId);
+      sysextent_track_page(buf, "_sequences", newPageId);
     } else {
       tag->pageId = nextPageId;
       bufId = bufmgr_request_bufId(buf, tag);
+      bufmgr_release_bufId(buf, oldBufId);
     }
-
-    bufmgr_release_bufId(buf, oldBufId);
   }
 
   bufdesc_free_buftag(tag);
@@ -117,4 +125,60 @@ bool syssequenceinit_insert_record(BufMgr* buf, SysSequence* s) {
   free(r);
 
   return true;
+}
+
+/**
+ * @brief Returns the current `next_value` of the named sequence and advances
+ * it by the sequence's `increment`. The update happens in place, the same way
+ * `systable_set_last_pageid` updates the `_tables` system table.
+ * 
+ * @param buf 
+ * @param name 
+ * @return int64_t the claimed value, or -1 if the sequence does not exist
+ */
+int64_t syssequence_next_value(BufMgr* buf, char* name) {
+  RecordDescriptor* rd = syssequence_get_record_desc();
+  int32_t firstPageId = systable_get_first_pageid(buf, "_sequences");
+  BufTag* tag = bufdesc_new_buftag(FILE_DATA, firstPageId);
+  int32_t bufId = bufmgr_request_bufId(buf, tag);
+
+  int64_t value = -1;
+
+  while (bufId >= 0 && value < 0) {
+    Page pg = buf->bp->pages[bufId];
+    PageHeader* pgHdr = (PageHeader*)pg;
+    int numRecords = pgHdr->numRecords;
+
+    for (int i = 0; i < numRecords && value < 0; i++) {
+      Record r = page_get_record(pg, i);
+
+      Datum* values = malloc(sizeof(Datum) * rd->ncols);
+      bool* isnull = malloc(sizeof(bool) * rd->ncols);
+
+      defill_record(rd, r, values, isnull);
+
+      if (strcmp(name, datumGetString(values[1])) == 0) {
+        value = datumGetInt64(values[4]);
+        int64_t nextValue = value + datumGetInt64(values[5]);
+        int offset = compute_offset_to_column(rd, r, 4);
+        memcpy(r + offset, &nextValue, sizeof(int64_t));
+        bufdesc_set_dirty(buf->bd->descArr[bufId]);
+      }
+
+      free_datum_array(rd, values);
+      free(isnull);
+    }
+
+    bufmgr_release_bufId(buf, bufId);
+
+    if (value < 0) {
+      tag->pageId = pgHdr->nextPageId;
+      bufId = bufmgr_request_bufId(buf, tag);
+    }
+  }
+
+  bufdesc_free_buftag(tag);
+  free_record_desc(rd);
+
+  return value;
 }
\ No newline at end of file
@@ -4,14 +4,16 @@
 
 #include "global/config.h"
 #include "system/systable.h"
+#include "system/sysextent.h"
+#include "system/boot.h"
 #include "resultset/recordset.h"
 
 extern Config* conf;
 
 RecordDescriptor* systable_get_record_desc() {
-  RecordDescriptor* rd = malloc(sizeof(RecordDescriptor) + (5 * sizeof(Column)));
-  rd->ncols = 5;
-  rd->nfixed = 4;
+  RecordDescriptor* rd = malloc(sizeof(RecordDescriptor) + (6 * sizeof(Column)));
+  rd->ncols = 6;
+  rd->nfixed = 5;
   rd->hasNullableColumns = false;
 
   construct_column_desc(&rd->cols[0], "object_id", DT_BIGINT, 0, 8, true);
@@ -19,6 +21,7 @@ RecordDescriptor* systable_get_record_desc() {
   construct_column_desc(&rd->cols[2], "type", DT_CHAR, 2, 1, true);
   construct_column_desc(&rd->cols[3], "first_page_id", DT_INT, 3, 4, true);
   construct_column_desc(&rd->cols[4], "last_page_id", DT_INT, 4, 4, true);
+  construct_column_desc(&rd->cols[5], "zonemap_page_id", DT_INT, 5, 4, true);
 
   return rd;
 }
@@ -38,6 +41,8 @@ static void systable_populate_values_arrays(
   fixedNull[2] = false;
   fixed[3] = int32GetDatum(t->lastPageId);
   fixedNull[3] = false;
+  fixed[4] = int32GetDatum(t->zonemapPageId);
+  fixedNull[4] = false;
 
   varlen[0] = charGetDatum(t->name);
   varlenNull[0] = false;
@@ -64,14 +69,19 @@ bool systableinit_insert_record(BufMgr* buf, SysTable* t) {
 
   /*
     The first time we insert a record to the system table, it will be the
-    `_tables` system table. So we simply allocate a brand new page and
-    manually set the [prev|next]PageId header fields because they are not
-    yet tracked by the system.
+    `_tables` system table. So we simply allocate the page following the
+    boot page (they share the first extent) and manually set the
+    [prev|next]PageId header fields because they are not yet tracked by
+    the system.
    */
   if (strcmp(t->name, "_tables") == 0) {
-    bufId = bufmgr_allocate_new_page(buf, FILE_DATA);
-    if (buf->bd->descArr[bufId]->tag->pageId != SYSTABLE_FIRST_PAGE_ID) return false;
+    tag->pageId = BOOT_PAGE_ID;
+    int32_t bootBufId = bufmgr_request_bufId(buf, tag);
+    if (bootBufId < 0) return false;
+    bufId = bufmgr_allocate_next_page(buf, bootBufId);
+    bufmgr_release_bufId(buf, bootBufId);
     if (bufId < 0) return false;
+    if (buf->bd->descArr[bufId]->tag->pageId != SYSTABLE_FIRST_PAGE_ID) return false;
     pageheader_init_datapage(buf->bp->pages[bufId]);
   } else {
     tag->pageId = systable_get_last_pageid(buf, "_tables");
@@ -89,16 +99,19 @@ bool systableinit_insert_record(BufMgr* buf, SysTable* t) {
     int32_t oldBufId = bufId;
 
     if (nextPageId == 0) {
+      /* bufmgr_page_split releases the old page */
       bufId = bufmgr_page_split(buf, bufId);
+      if (bufId < 0) break;
 
       /* update `last_page_id` field in the _tables system table */
-      systable_set_last_pageid(buf, "_tables", buf->bd->descArr[bufId]->tag->pageId);
+      int32_t newPageId = buf->bd->descArr[bufId]->tag->pageId;
+      systable_set_last_pageid(buf, "_tables", newPageId);
+      sysextent_track_page(buf, "_tables", newPageId);
     } else {
       tag->pageId = nextPageId;
       bufId = bufmgr_request_bufId(buf, tag);
+      bufmgr_release_bufId(buf, oldBufId);
     }
-
-    bufmgr_release_bufId(buf, oldBufId);
   }
 
   bufdesc_free_buftag(tag);
@@ -123,11 +136,12 @@ static void defill_systable(RecordDescriptor* rd, Record r, SysTable* t) {
   t->type = datumGetString(values[2]);
   t->firstPageId = datumGetInt32(values[3]);
   t->lastPageId = datumGetInt32(values[4]);
+  t->zonemapPageId = datumGetInt32(values[5]);
 }
 
 static void systable_scan(BufMgr* buf, RecordDescriptor* rd, LinkedList* rows) {
   BufTag* tag = bufdesc_new_buftag(FILE_DATA, SYSTABLE_FIRST_PAGE_ID);
-  int32_t bufId = bufmgr_request_bufId(buf, tag);
+  int32_t bufId = bufmgr_request_bufId_readonly(buf, tag);
 
   while (bufId >= 0) {
     Page pg = buf->bp->pages[bufId];
@@ -144,7 +158,7 @@ static void systable_scan(BufMgr* buf, RecordDescriptor* rd, LinkedList* rows) {
 
     tag->pageId = pgHdr->nextPageId;
     bufmgr_release_bufId(buf, bufId);
-    bufId = bufmgr_request_bufId(buf, tag);
+    bufId = bufmgr_request_bufId_readonly(buf, tag);
   }
 
   bufdesc_free_buftag(tag);
@@ -227,6 +241,30 @@ int32_t systable_get_last_pageid(BufMgr* buf, char* tablename) {
   return lastPageId;
 }
 
+int32_t systable_get_zonemap_pageid(BufMgr* buf, char* tablename) {
+  RecordDescriptor* rd = systable_get_record_desc();
+  RecordSet* rs = new_recordset();
+
+  systable_scan(buf, rd, rs->rows);
+
+  int32_t zonemapPageId = -1;
+  ListItem* li = rs->rows->head;
+  while (li != NULL) {
+    RecordSetRow* row = li->ptr;
+    if (strcmp(tablename, datumGetString(row->values[1])) == 0) {
+      zonemapPageId = datumGetInt32(row->values[5]);
+      break;
+    }
+
+    li = li->next;
+  }
+
+  free_recordset(rs, rd);
+  free_record_desc(rd);
+
+  return zonemapPageId;
+}
+
 /**
  * @brief Updates the `first_page_id` column for a given table in the
  * _tables system table. Currently duplicates the logic of scanning
@@ -340,5 +378,63 @@ bool systable_set_last_pageid(BufMgr* buf, char* tablename, int32_t lastPageId)
   bufdesc_free_buftag(tag);
   free_record_desc(rd);
 
+  return updateSuccess;
+}
+
+/**
+ * @brief Updates the `zonemap_page_id` column for a given table in the
+ * _tables system table. Currently duplicates the logic of scanning
+ * a table because I don't know how I'm going to implement an update
+ * operation yet.
+ * 
+ * @param buf 
+ * @param tablename 
+ * @param zonemapPageId 
+ * @return true 
+ * @return false 
+ */
+bool systable_set_zonemap_pageid(BufMgr* buf, char* tablename, int32_t zonemapPageId) {
+  RecordDescriptor* rd = systable_get_record_desc();
+  BufTag* tag = bufdesc_new_buftag(FILE_DATA, SYSTABLE_FIRST_PAGE_ID);
+  int32_t bufId = bufmgr_request_bufId(buf, tag);
+
+  bool updateSuccess = false;
+
+  while (bufId >= 0 && !updateSuccess) {
+    Page pg = buf->bp->pages[bufId];
+    PageHeader* pgHdr = (PageHeader*)pg;
+    int numRecords = pgHdr->numRecords;
+
+    for (int i = 0; i < numRecords; i++) {
+      int slotOffset = conf->pageSize - (sizeof(SlotPointer) * (i + 1));
+      SlotPointer* sp = (SlotPointer*)(pg + slotOffset);
+
+      Datum* values = malloc(sizeof(Datum) * rd->ncols);
+      bool* isnull = malloc(sizeof(bool) * rd->ncols);
+
+      defill_record(rd, pg + sp->offset, values, isnull);
+
+      if (strcmp(tablename, datumGetString(values[1])) == 0) {
+        int offset = compute_offset_to_column(rd, pg + sp->offset, 5);
+        memcpy(pg + sp->offset + offset, &zonemapPageId, sizeof(int32_t));
+        bufdesc_set_dirty(buf->bd->descArr[bufId]);
+        bufmgr_release_bufId(buf, bufId);
+        updateSuccess = true;
+      }
+
+      free_datum_array(rd, values);
+      free(isnull);
+    }
+
+    if (!updateSuccess) {
+      bufmgr_release_bufId(buf, bufId);
+      tag->pageId = pgHdr->nextPageId;
+      bufId = bufmgr_request_bufId(buf, tag);
+    }
+  }
+
+  bufdesc_free_buftag(tag);
+  free_record_desc(rd);
+
   return updateSuccess;
 }
\ No newline at end of file
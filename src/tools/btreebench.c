@@ -0,0 +1,239 @@
+/**
+ * @file btreebench.c
+ * @brief B+tree point lookups and inserts against full table scans
+ *
+ * Loads the `person` table with NUM_ROWS rows, then:
+ *
+ * - times single-row inserts into the table while it has no index
+ * - answers NUM_SCANS `person_id = k` lookups with tableam_fullscan, checking
+ *   every row of the result
+ * - builds a B+tree on person_id (CREATE INDEX)
+ * - times single-row inserts with random keys again, now also going into
+ *   the B+tree
+ * - answers NUM_LOOKUPS `person_id = k` lookups with indexam_lookup
+ *
+ * Every lookup must find exactly the one row with its key.
+ *
+ * Usage: btreebench DATA_FILE [NUM_ROWS] [NUM_LOOKUPS] [NUM_SCANS] [NUM_INSERTS]
+ *
+ * DATA_FILE is created from scratch. Exits with 1 if a lookup doesn't find
+ * its row.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "global/config.h"
+#include "buffer/bufmgr.h"
+#include "access/tableam.h"
+#include "access/indexam.h"
+#include "executor/scheduler.h"
+#include "system/initdb.h"
+#include "system/systable.h"
+#include "system/syscolumn.h"
+
+#define LOAD_BATCH_ROWS 256
+
+Config* conf;
+Scheduler* sched;
+
+static double now_us() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static TableDesc* get_person(BufMgr* buf) {
+  int64_t tableId = systable_get_objectId(buf, "person");
+  if (tableId < 0) return NULL;
+
+  TableDesc* td = new_tabledesc("person");
+  td->rd = syscolumn_get_table_record_desc(buf, tableId);
+
+  return td;
+}
+
+static Record make_row(TableDesc* td, int32_t personId, uint16_t* recordLen) {
+  Datum values[4];
+  bool isnull[4] = { false, false, false, false };
+  char firstName[21], lastName[21];
+
+  snprintf(firstName, sizeof(firstName), "first%d", personId);
+  snprintf(lastName, sizeof(lastName), "last%d", personId);
+  values[0] = int32GetDatum(personId);
+  values[1] = charGetDatum(firstName);
+  values[2] = charGetDatum(lastName);
+  values[3] = int32GetDatum(personId % 100);
+
+  return record_serialize(td->rd, values, isnull, recordLen);
+}
+
+static bool load_rows(BufMgr* buf, TableDesc* td, int numRows) {
+  Record records[LOAD_BATCH_ROWS];
+  uint16_t recordLens[LOAD_BATCH_ROWS];
+  RecordId rids[LOAD_BATCH_ROWS];
+
+  for (int row = 0; row < numRows;) {
+    int n = 0;
+    for (; n < LOAD_BATCH_ROWS && row < numRows; n++, row++) records[n] = make_row(td, row, &recordLens[n]);
+
+    int inserted = tableam_insert_batch(buf, td, records, recordLens, n, rids);
+    for (int i = 0; i < n; i++) free(records[i]);
+    if (inserted != n) return false;
+  }
+
+  return true;
+}
+
+/**
+ * @brief Inserts `numInserts` rows one at a time, into the table and every
+ * index on it. The keys start at `firstKey` and are spread out at random
+ * over the key space, so B+tree inserts land all over the tree.
+ */
+static bool insert_rows(BufMgr* buf, TableDesc* td, int32_t firstKey, int numInserts) {
+  bool success = true;
+
+  for (int i = 0; i < numInserts && success; i++) {
+    int32_t key = firstKey + (int32_t)(((uint64_t)rand() * 7919 + i) % (INT32_MAX - firstKey));
+    uint16_t recordLen;
+    RecordId rid;
+    Record r = make_row(td, key, &recordLen);
+
+    success = tableam_insert(buf, td, r, recordLen, &rid) && indexam_insert(buf, td, r, &rid);
+    free(r);
+  }
+
+  return success;
+}
+
+/**
+ * @brief Returns true if `rs` has exactly one row with person_id `key`
+ */
+static bool has_one_row(RecordSet* rs, int32_t key) {
+  int matches = 0;
+
+  for (ListItem* li = rs->rows->head; li != NULL; li = li->next) {
+    RecordSetRow* row = li->ptr;
+    if (!row->isnull[0] && datumGetInt32(row->values[0]) == key) matches++;
+  }
+
+  return matches == 1;
+}
+
+static bool lookup_fullscan(BufMgr* buf, TableDesc* td, int numRows, int numScans) {
+  bool success = true;
+
+  for (int i = 0; i < numScans && success; i++) {
+    int32_t key = rand() % numRows;
+    RecordSet* rs = new_recordset();
+
+    tableam_fullscan(buf, td, rs);
+    success = has_one_row(rs, key);
+
+    free_recordset(rs, td->rd);
+  }
+
+  return success;
+}
+
+static bool lookup_btree(BufMgr* buf, TableDesc* td, IndexDesc* idx, int numRows, int numLookups) {
+  bool success = true;
+
+  for (int i = 0; i < numLookups && success; i++) {
+    int32_t key = rand() % numRows;
+    RecordSet* rs = new_recordset();
+
+    indexam_lookup(buf, td, idx, key, key, UINT64_MAX, rs);
+    success = rs->rows->numItems == 1 && has_one_row(rs, key);
+
+    free_recordset(rs, td->rd);
+  }
+
+  return success;
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    printf("Usage: %s DATA_FILE [NUM_ROWS] [NUM_LOOKUPS] [NUM_SCANS] [NUM_INSERTS]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  int numRows = argc > 2 ? atoi(argv[2]) : 100000;
+  int numLookups = argc > 3 ? atoi(argv[3]) : 100000;
+  int numScans = argc > 4 ? atoi(argv[4]) : 20;
+  int numInserts = argc > 5 ? atoi(argv[5]) : 20000;
+
+  conf = new_config();
+  conf->dataFile = strdup(argv[1]);
+  conf->pageSize = 8192;
+  conf->bufpoolSize = 256;
+  conf->workerThreads = 1;
+
+  if (numRows < 1 || numLookups < 1 || numScans < 1 || numInserts < 1) {
+    printf("NUM_ROWS, NUM_LOOKUPS, NUM_SCANS and NUM_INSERTS must be positive\n");
+    return EXIT_FAILURE;
+  }
+
+  unlink(conf->dataFile);
+  sched = scheduler_create(1);
+  BufMgr* buf = bufmgr_init();
+
+  if (!initdb(buf)) {
+    printf("initdb failed\n");
+    return EXIT_FAILURE;
+  }
+
+  srand(42);
+  TableDesc* td = get_person(buf);
+  IndexDesc* idx = NULL;
+  bool success = td != NULL && load_rows(buf, td, numRows);
+
+  printf("%d rows, page size %d, buffer pool %d pages\n\n", numRows, conf->pageSize, conf->bufpoolSize);
+
+  double start = now_us();
+  success = success && insert_rows(buf, td, numRows, numInserts);
+  double heapInsertUs = (now_us() - start) / numInserts;
+
+  start = now_us();
+  success = success && lookup_fullscan(buf, td, numRows, numScans);
+  double scanUs = (now_us() - start) / numScans;
+
+  start = now_us();
+  success = success && indexam_create(buf, td, "person_id_idx", "person_id", "btree", false, NULL, 0);
+  double buildUs = now_us() - start;
+
+  if (success) idx = indexam_find_index(buf, td, 0, false, UINT64_MAX);
+  success = success && idx != NULL;
+
+  start = now_us();
+  success = success && insert_rows(buf, td, numRows, numInserts);
+  double indexInsertUs = (now_us() - start) / numInserts;
+
+  start = now_us();
+  success = success && lookup_btree(buf, td, idx, numRows, numLookups);
+  double lookupUs = (now_us() - start) / numLookups;
+
+  if (success) {
+    printf("insert, no index      %10.2f us/row\n", heapInsertUs);
+    printf("insert, with B+tree   %10.2f us/row\n", indexInsertUs);
+    printf("B+tree build          %10.2f ms\n", buildUs / 1000);
+    printf("lookup, full scan     %10.2f us/lookup\n", scanUs);
+    printf("lookup, B+tree        %10.2f us/lookup  (%.0fx faster)\n", lookupUs, scanUs / lookupUs);
+    printf("the B+tree pays for its build after %.0f lookups\n", buildUs / (scanUs - lookupUs));
+  }
+
+  printf("%s\n", success ? "PASSED" : "FAILED");
+
+  if (idx != NULL) free_indexdesc(idx);
+  free_tabledesc(td);
+  bufmgr_flush_all(buf);
+  bufmgr_destroy(buf);
+  scheduler_destroy(sched);
+  free_config(conf);
+
+  return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
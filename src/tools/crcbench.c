@@ -0,0 +1,219 @@
+/**
+ * @file crcbench.c
+ * @brief Cost of the page checksums, with and without the CRC32 instructions
+ *
+ * Loads the `person` table with NUM_ROWS rows, then for the hardware CRC-32C
+ * (when the CPU has it) and the table-driven one:
+ *
+ * - times page_verify_checksum alone on a page of the table, over and over
+ * - times full scans of the table through a buffer pool smaller than the
+ *   table, so every page is read from the file and verified again
+ *
+ * and prints how much of the time a scan spends on a page goes into its
+ * checksum.
+ *
+ * Usage: crcbench DATA_FILE [NUM_ROWS] [PAGE_SIZE] [PASSES]
+ *
+ * DATA_FILE is created from scratch. Exits with 1 if a checksum doesn't
+ * verify or a scan doesn't see every row.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "global/config.h"
+#include "buffer/bufmgr.h"
+#include "access/tableam.h"
+#include "executor/scheduler.h"
+#include "system/initdb.h"
+#include "system/systable.h"
+#include "system/syscolumn.h"
+#include "utility/crc32c.h"
+
+#define LOAD_BATCH_ROWS 256
+
+/* page_verify_checksum calls timed per implementation */
+#define VERIFY_ITERATIONS 20000
+
+Config* conf;
+Scheduler* sched;
+
+static double now_us() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static TableDesc* get_person(BufMgr* buf) {
+  int64_t tableId = systable_get_objectId(buf, "person");
+  if (tableId < 0) return NULL;
+
+  TableDesc* td = new_tabledesc("person");
+  td->rd = syscolumn_get_table_record_desc(buf, tableId);
+
+  return td;
+}
+
+static bool load_rows(BufMgr* buf, TableDesc* td, int numRows) {
+  Record records[LOAD_BATCH_ROWS];
+  uint16_t recordLens[LOAD_BATCH_ROWS];
+  RecordId rids[LOAD_BATCH_ROWS];
+  Datum values[4];
+  bool isnull[4] = { false, false, false, false };
+  char firstName[21], lastName[21];
+
+  for (int row = 0; row < numRows;) {
+    int n = 0;
+
+    for (; n < LOAD_BATCH_ROWS && row < numRows; n++, row++) {
+      snprintf(firstName, sizeof(firstName), "first%d", row);
+      snprintf(lastName, sizeof(lastName), "last%d", row);
+      values[0] = int32GetDatum(row);
+      values[1] = charGetDatum(firstName);
+      values[2] = charGetDatum(lastName);
+      values[3] = int32GetDatum(row % 100);
+      records[n] = record_serialize(td->rd, values, isnull, &recordLens[n]);
+    }
+
+    int inserted = tableam_insert_batch(buf, td, records, recordLens, n, rids);
+    for (int i = 0; i < n; i++) free(records[i]);
+    if (inserted != n) return false;
+  }
+
+  return true;
+}
+
+static void count_page(void* arg, Record* records, int numRecords) {
+  (void)records;
+  *(uint64_t*)arg += numRecords;
+}
+
+/**
+ * @brief Times page_verify_checksum on a copy of the table's first page.
+ * Returns the nanoseconds per page, or a negative number if the checksum
+ * doesn't verify.
+ */
+static double time_verify(BufMgr* buf, TableDesc* td) {
+  BufTag* tag = bufdesc_new_buftag(FILE_DATA, systable_get_first_pageid(buf, td->tablename));
+  int32_t bufId = bufmgr_request_bufId_readonly(buf, tag);
+  bufdesc_free_buftag(tag);
+  if (bufId < 0) return -1;
+
+  /* the checksum of a page in the buffer pool is only set when it's written out */
+  Page pg = new_page();
+  memcpy(pg, buf->bp->pages[bufId], conf->pageSize);
+  bufmgr_release_bufId(buf, bufId);
+  page_set_checksum(pg);
+
+  bool verified = true;
+  double start = now_us();
+  for (int i = 0; i < VERIFY_ITERATIONS; i++) verified &= page_verify_checksum(pg);
+  double us = now_us() - start;
+
+  free_page(pg);
+
+  return verified ? us * 1000 / VERIFY_ITERATIONS : -1;
+}
+
+/**
+ * @brief Times `passes` full scans and returns the best nanoseconds per
+ * page, or a negative number if a scan misses rows
+ */
+static double time_scans(BufMgr* buf, TableDesc* td, int numRows, int passes) {
+  uint32_t numPages = tableam_count_pages(buf, td);
+  double bestUs = 0;
+
+  for (int p = 0; p < passes; p++) {
+    uint64_t numRecords = 0;
+
+    double start = now_us();
+    tableam_scan_pages(buf, td, count_page, &numRecords);
+    double us = now_us() - start;
+
+    if (numRecords != (uint64_t)numRows) {
+      printf("Scan saw %lu rows, expected %d\n", numRecords, numRows);
+      return -1;
+    }
+
+    if (p == 0 || us < bestUs) bestUs = us;
+  }
+
+  return bestUs * 1000 / numPages;
+}
+
+static bool run_impl(bool hardware, int numRows, int passes) {
+  if (!crc32c_use_hardware(hardware)) {
+    printf("%-8s  not available on this CPU\n", "hardware");
+    return true;
+  }
+
+  BufMgr* buf = bufmgr_init();
+  TableDesc* td = get_person(buf);
+  double verifyNs = td == NULL ? -1 : time_verify(buf, td);
+  double scanNs = verifyNs < 0 ? -1 : time_scans(buf, td, numRows, passes);
+
+  if (scanNs >= 0) {
+    printf("%-8s  verify %8.0f ns/page %7.2f GB/s   scan %8.0f ns/page   checksum %5.1f%% of the scan\n",
+      hardware ? "hardware" : "software", verifyNs, conf->pageSize / verifyNs,
+      scanNs, 100 * verifyNs / scanNs);
+  } else if (verifyNs < 0) {
+    printf("Checksum of the first page doesn't verify\n");
+  }
+
+  free_tabledesc(td);
+  bufmgr_destroy(buf);
+
+  return scanNs >= 0;
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    printf("Usage: %s DATA_FILE [NUM_ROWS] [PAGE_SIZE] [PASSES]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  int numRows = argc > 2 ? atoi(argv[2]) : 200000;
+  int passes = argc > 4 ? atoi(argv[4]) : 5;
+
+  conf = new_config();
+  conf->dataFile = strdup(argv[1]);
+  conf->pageSize = argc > 3 ? atoi(argv[3]) : 8192;
+  conf->bufpoolSize = 64;
+  conf->workerThreads = 1;
+
+  if (numRows < 1 || passes < 1) {
+    printf("NUM_ROWS and PASSES must be positive\n");
+    return EXIT_FAILURE;
+  }
+
+  unlink(conf->dataFile);
+  sched = scheduler_create(1);
+  BufMgr* buf = bufmgr_init();
+
+  if (!initdb(buf)) {
+    printf("initdb failed\n");
+    return EXIT_FAILURE;
+  }
+
+  TableDesc* td = get_person(buf);
+  bool success = td != NULL && load_rows(buf, td, numRows);
+  printf("%d rows, page size %d, buffer pool %d pages\n", numRows, conf->pageSize, conf->bufpoolSize);
+
+  free_tabledesc(td);
+  bufmgr_flush_all(buf);
+  bufmgr_destroy(buf);
+
+  success = success && run_impl(true, numRows, passes);
+  success = success && run_impl(false, numRows, passes);
+
+  printf("%s\n", success ? "PASSED" : "FAILED");
+
+  scheduler_destroy(sched);
+  free_config(conf);
+
+  return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
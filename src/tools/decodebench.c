@@ -0,0 +1,191 @@
+/**
+ * @file decodebench.c
+ * @brief ns/row of decoding an integer column of a page of records
+ *
+ * Fills a page with `person` rows (every 7th one with a NULL age) and
+ * decodes the age column of all of them, ITERATIONS times, three ways:
+ *
+ * - defill_record, a row at a time, the way rows are materialized
+ * - record_decode_int_column when the records share the same shape up to
+ *   the column (no nullable fixed column before it), which decodes the batch
+ *   with a couple of loops specialized for the data type
+ * - record_decode_int_column when they don't, which walks every record's
+ *   null bitmap to find the column. The same records are used, with
+ *   person_id described as nullable.
+ *
+ * All three must come up with the same values. The Makefile builds it like
+ * the rest, without optimizations; build the sources with -O2 as well to
+ * compare.
+ *
+ * Usage: decodebench [NUM_RECORDS] [ITERATIONS]
+ *
+ * Exits with 1 if the decoders disagree.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "global/config.h"
+#include "storage/page.h"
+#include "storage/record.h"
+#include "executor/scheduler.h"
+
+Config* conf;
+Scheduler* sched;
+
+static double now_us() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+/**
+ * @brief The `person` table's columns, the way initdb defines them, except
+ * that person_id is nullable if `nullableId`
+ */
+static RecordDescriptor* person_record_desc(bool nullableId) {
+  RecordDescriptor* rd = malloc(sizeof(RecordDescriptor) + (4 * sizeof(Column)));
+  rd->ncols = 4;
+  rd->nfixed = 2;
+  rd->hasNullableColumns = true;
+
+  construct_column_desc(&rd->cols[0], "person_id", DT_INT, 0, 4, !nullableId);
+  construct_column_desc(&rd->cols[1], "first_name", DT_VARCHAR, 1, 20, false);
+  construct_column_desc(&rd->cols[2], "last_name", DT_VARCHAR, 2, 20, true);
+  construct_column_desc(&rd->cols[3], "age", DT_INT, 3, 4, false);
+
+  return rd;
+}
+
+/**
+ * @brief Inserts up to `numRecords` person rows into `pg` and points
+ * `records` at them. Returns how many fit.
+ */
+static int fill_page(Page pg, RecordDescriptor* rd, int numRecords, Record* records) {
+  Datum values[4];
+  bool isnull[4] = { false, false, false, false };
+  char firstName[21], lastName[21];
+  int n = 0;
+
+  pageheader_init_datapage(pg);
+
+  for (; n < numRecords; n++) {
+    snprintf(firstName, sizeof(firstName), "first%d", n);
+    snprintf(lastName, sizeof(lastName), "last%d", n);
+    values[0] = int32GetDatum(n);
+    values[1] = charGetDatum(firstName);
+    values[2] = charGetDatum(lastName);
+    values[3] = int32GetDatum(n % 100);
+    isnull[3] = n % 7 == 0;
+
+    uint16_t recordLen;
+    Record r = record_serialize(rd, values, isnull, &recordLen);
+    bool fits = page_insert(pg, r, recordLen);
+    free(r);
+
+    if (!fits) break;
+  }
+
+  for (int i = 0; i < n; i++) records[i] = page_get_record(pg, i);
+
+  return n;
+}
+
+static double time_defill(RecordDescriptor* rd, Record* records, int numRecords, int iterations, int64_t* ages, uint8_t* agesNull) {
+  Datum values[4];
+  bool isnull[4];
+
+  double start = now_us();
+
+  for (int it = 0; it < iterations; it++) {
+    for (int n = 0; n < numRecords; n++) {
+      defill_record(rd, records[n], values, isnull);
+
+      ages[n] = isnull[3] ? 0 : datumGetInt32(values[3]);
+      agesNull[n] = isnull[3];
+
+      if (!isnull[1]) free(datumGetString(values[1]));
+      if (!isnull[2]) free(datumGetString(values[2]));
+    }
+  }
+
+  return (now_us() - start) * 1000 / ((double)iterations * numRecords);
+}
+
+static double time_decode(RecordDescriptor* rd, Record* records, int numRecords, int iterations, int64_t* ages, uint8_t* agesNull) {
+  double start = now_us();
+
+  for (int it = 0; it < iterations; it++) {
+    record_decode_int_column(rd, records, numRecords, 3, ages, agesNull);
+  }
+
+  return (now_us() - start) * 1000 / ((double)iterations * numRecords);
+}
+
+static bool same_ages(int64_t* a, uint8_t* aNull, int64_t* b, uint8_t* bNull, int numRecords) {
+  for (int n = 0; n < numRecords; n++) {
+    if (aNull[n] != bNull[n] || a[n] != b[n]) {
+      printf("Record %d: age %ld (null %d) vs %ld (null %d)\n", n, a[n], aNull[n], b[n], bNull[n]);
+      return false;
+    }
+  }
+
+  return true;
+}
+
+int main(int argc, char** argv) {
+  int numRecords = argc > 1 ? atoi(argv[1]) : 128;
+  int iterations = argc > 2 ? atoi(argv[2]) : 100000;
+
+  if (numRecords < 1 || iterations < 1) {
+    printf("Usage: %s [NUM_RECORDS] [ITERATIONS]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  conf = new_config();
+  conf->dataFile = NULL;
+  conf->pageSize = 8192;
+
+  RecordDescriptor* rd = person_record_desc(false);
+  RecordDescriptor* rdNullableId = person_record_desc(true);
+  Page pg = new_page();
+  Record* records = malloc(sizeof(Record) * numRecords);
+  int64_t* expected = malloc(sizeof(int64_t) * numRecords);
+  uint8_t* expectedNull = malloc(numRecords);
+  int64_t* ages = malloc(sizeof(int64_t) * numRecords);
+  uint8_t* agesNull = malloc(numRecords);
+
+  int filled = fill_page(pg, rd, numRecords, records);
+  if (filled < numRecords) printf("Only %d records fit on a %d-byte page\n", filled, conf->pageSize);
+  numRecords = filled;
+
+  printf("%d records, %d iterations\n\n", numRecords, iterations);
+
+  double defillNs = time_defill(rd, records, numRecords, iterations, expected, expectedNull);
+
+  double walkNs = time_decode(rdNullableId, records, numRecords, iterations, ages, agesNull);
+  bool success = same_ages(expected, expectedNull, ages, agesNull, numRecords);
+
+  double sameShapeNs = time_decode(rd, records, numRecords, iterations, ages, agesNull);
+  success = success && same_ages(expected, expectedNull, ages, agesNull, numRecords);
+
+  printf("defill_record (row at a time)     %6.2f ns/row\n", defillNs);
+  printf("column decode, null bitmap walk   %6.2f ns/row\n", walkNs);
+  printf("column decode, same shape         %6.2f ns/row\n", sameShapeNs);
+  printf("%s\n", success ? "PASSED" : "FAILED");
+
+  free(records);
+  free(expected);
+  free(expectedNull);
+  free(ages);
+  free(agesNull);
+  free_page(pg);
+  free_record_desc(rd);
+  free_record_desc(rdNullableId);
+  free_config(conf);
+
+  return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,202 @@
+/**
+ * @file pagesizebench.c
+ * @brief Point operations and full scans for every page size from 4KB to 256KB
+ *
+ * For each page size, creates a new data file and:
+ *
+ * - inserts NUM_ROWS `person` rows one at a time (tableam_insert)
+ * - fetches NUM_FETCHES of them by RecordId, in random order (tableam_fetch)
+ * - scans the whole table PASSES times (tableam_scan_pages)
+ *
+ * Every page size gets the same amount of buffer pool memory, BUFPOOL_KB,
+ * so larger pages mean fewer buffers. Random fetches mostly miss the buffer
+ * pool once the table is larger than it, and then pay for reading a whole
+ * page to get one row.
+ *
+ * Usage: pagesizebench DATA_FILE [NUM_ROWS] [NUM_FETCHES] [BUFPOOL_KB] [PASSES]
+ *
+ * DATA_FILE is created from scratch for every page size. Exits with 1 if a
+ * fetch or a scan doesn't find the rows it should.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "global/config.h"
+#include "buffer/bufmgr.h"
+#include "storage/page.h"
+#include "access/tableam.h"
+#include "executor/scheduler.h"
+#include "system/initdb.h"
+#include "system/systable.h"
+#include "system/syscolumn.h"
+
+Config* conf;
+Scheduler* sched;
+
+/**
+ * @brief Results for one page size
+ *
+ * insertUs | microseconds per single-row insert
+ * fetchUs  | microseconds per fetch by RecordId
+ * scanUs   | best time of a full scan
+ * numPages | pages the table takes up
+ */
+typedef struct PageSizeResult {
+  double insertUs;
+  double fetchUs;
+  double scanUs;
+  uint32_t numPages;
+} PageSizeResult;
+
+static double now_us() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static TableDesc* get_person(BufMgr* buf) {
+  int64_t tableId = systable_get_objectId(buf, "person");
+  if (tableId < 0) return NULL;
+
+  TableDesc* td = new_tabledesc("person");
+  td->rd = syscolumn_get_table_record_desc(buf, tableId);
+
+  return td;
+}
+
+static bool insert_rows(BufMgr* buf, TableDesc* td, int numRows, RecordId* rids) {
+  Datum values[4];
+  bool isnull[4] = { false, false, false, false };
+  char firstName[21], lastName[21];
+  bool success = true;
+
+  for (int row = 0; row < numRows && success; row++) {
+    snprintf(firstName, sizeof(firstName), "first%d", row);
+    snprintf(lastName, sizeof(lastName), "last%d", row);
+    values[0] = int32GetDatum(row);
+    values[1] = charGetDatum(firstName);
+    values[2] = charGetDatum(lastName);
+    values[3] = int32GetDatum(row % 100);
+
+    uint16_t recordLen;
+    Record r = record_serialize(td->rd, values, isnull, &recordLen);
+    success = tableam_insert(buf, td, r, recordLen, &rids[row]);
+    free(r);
+  }
+
+  return success;
+}
+
+static bool fetch_rows(BufMgr* buf, TableDesc* td, RecordId* rids, int numRows, int numFetches) {
+  RecordSet* rs = new_recordset();
+  bool success = true;
+
+  srand(42);
+  for (int i = 0; i < numFetches && success; i++) {
+    success = tableam_fetch(buf, td, &rids[rand() % numRows], rs);
+  }
+
+  free_recordset(rs, td->rd);
+
+  return success;
+}
+
+static void count_page(void* arg, Record* records, int numRecords) {
+  (void)records;
+  *(uint64_t*)arg += numRecords;
+}
+
+static bool run_page_size(int numRows, int numFetches, int bufpoolKb, int passes, PageSizeResult* res) {
+  conf->bufpoolSize = bufpoolKb * 1024 / conf->pageSize;
+  if (conf->bufpoolSize < 8) conf->bufpoolSize = 8;
+
+  unlink(conf->dataFile);
+  BufMgr* buf = bufmgr_init();
+
+  if (!initdb(buf)) {
+    printf("initdb failed\n");
+    bufmgr_destroy(buf);
+    return false;
+  }
+
+  TableDesc* td = get_person(buf);
+  RecordId* rids = malloc(sizeof(RecordId) * numRows);
+  bool success = td != NULL;
+
+  double start = now_us();
+  success = success && insert_rows(buf, td, numRows, rids);
+  res->insertUs = (now_us() - start) / numRows;
+
+  start = now_us();
+  success = success && fetch_rows(buf, td, rids, numRows, numFetches);
+  res->fetchUs = (now_us() - start) / numFetches;
+
+  res->numPages = success ? tableam_count_pages(buf, td) : 0;
+
+  for (int p = 0; p < passes && success; p++) {
+    uint64_t numRecords = 0;
+
+    start = now_us();
+    tableam_scan_pages(buf, td, count_page, &numRecords);
+    double us = now_us() - start;
+
+    if (p == 0 || us < res->scanUs) res->scanUs = us;
+    success = numRecords == (uint64_t)numRows;
+  }
+
+  free(rids);
+  free_tabledesc(td);
+  bufmgr_destroy(buf);
+
+  return success;
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    printf("Usage: %s DATA_FILE [NUM_ROWS] [NUM_FETCHES] [BUFPOOL_KB] [PASSES]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  int numRows = argc > 2 ? atoi(argv[2]) : 100000;
+  int numFetches = argc > 3 ? atoi(argv[3]) : 100000;
+  int bufpoolKb = argc > 4 ? atoi(argv[4]) : 2048;
+  int passes = argc > 5 ? atoi(argv[5]) : 5;
+
+  if (numRows < 1 || numFetches < 1 || bufpoolKb < 1 || passes < 1) {
+    printf("NUM_ROWS, NUM_FETCHES, BUFPOOL_KB and PASSES must be positive\n");
+    return EXIT_FAILURE;
+  }
+
+  conf = new_config();
+  conf->dataFile = strdup(argv[1]);
+  conf->workerThreads = 1;
+  sched = scheduler_create(1);
+
+  bool success = true;
+
+  printf("%d rows, %d random fetches, %d KB of buffer pool\n\n", numRows, numFetches, bufpoolKb);
+  printf("page size  buffers  pages  insert us/row  fetch us/row  scan ms  scan MB/s\n");
+
+  for (int pageSize = MIN_PAGE_SIZE; pageSize <= MAX_PAGE_SIZE && success; pageSize *= 2) {
+    PageSizeResult res = { 0, 0, 0, 0 };
+    conf->pageSize = pageSize;
+
+    success = run_page_size(numRows, numFetches, bufpoolKb, passes, &res);
+
+    printf("%8dK  %7d  %5u  %13.2f  %12.2f  %7.2f  %9.1f\n",
+      conf->pageSize / 1024, conf->bufpoolSize, res.numPages, res.insertUs, res.fetchUs,
+      res.scanUs / 1000, (double)res.numPages * conf->pageSize / (1024 * 1024) / (res.scanUs / 1e6));
+  }
+
+  printf("%s\n", success ? "PASSED" : "FAILED");
+
+  scheduler_destroy(sched);
+  free_config(conf);
+
+  return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
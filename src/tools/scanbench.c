@@ -0,0 +1,191 @@
+/**
+ * @file scanbench.c
+ * @brief Full scan throughput with MMAP_MODE off and on
+ *
+ * Loads the `person` table with NUM_ROWS rows, then scans it front to back
+ * PASSES times with pages read into the buffer pool with read(), and
+ * PASSES times with pages served from the file mapping (see buffile_map).
+ * The buffer pool is kept small, so the table doesn't fit in it and every
+ * pass goes back to the file. The file stays in the OS page cache after the
+ * load; drop the cache between runs for cold numbers.
+ *
+ * Usage: scanbench DATA_FILE [NUM_ROWS] [PASSES] [BUFPOOL_PAGES]
+ *
+ * DATA_FILE is created from scratch. Exits with 1 if a scan doesn't see
+ * every row.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "global/config.h"
+#include "buffer/bufmgr.h"
+#include "access/tableam.h"
+#include "executor/scheduler.h"
+#include "system/initdb.h"
+#include "system/systable.h"
+#include "system/syscolumn.h"
+
+#define LOAD_BATCH_ROWS 256
+
+Config* conf;
+Scheduler* sched;
+
+/**
+ * @brief What a scan pass saw. `checksum` sums a byte of every record, so
+ * the pages are really read and not just pinned.
+ */
+typedef struct ScanCount {
+  uint64_t numRecords;
+  uint64_t numPages;
+  uint64_t checksum;
+} ScanCount;
+
+static double now_us() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static TableDesc* get_person(BufMgr* buf) {
+  int64_t tableId = systable_get_objectId(buf, "person");
+  if (tableId < 0) return NULL;
+
+  TableDesc* td = new_tabledesc("person");
+  td->rd = syscolumn_get_table_record_desc(buf, tableId);
+
+  return td;
+}
+
+static bool load_rows(BufMgr* buf, TableDesc* td, int numRows) {
+  Record records[LOAD_BATCH_ROWS];
+  uint16_t recordLens[LOAD_BATCH_ROWS];
+  RecordId rids[LOAD_BATCH_ROWS];
+  Datum values[4];
+  bool isnull[4] = { false, false, false, false };
+  char firstName[21], lastName[21];
+
+  for (int row = 0; row < numRows;) {
+    int n = 0;
+
+    for (; n < LOAD_BATCH_ROWS && row < numRows; n++, row++) {
+      snprintf(firstName, sizeof(firstName), "first%d", row);
+      snprintf(lastName, sizeof(lastName), "last%d", row);
+      values[0] = int32GetDatum(row);
+      values[1] = charGetDatum(firstName);
+      values[2] = charGetDatum(lastName);
+      values[3] = int32GetDatum(row % 100);
+      records[n] = record_serialize(td->rd, values, isnull, &recordLens[n]);
+    }
+
+    int inserted = tableam_insert_batch(buf, td, records, recordLens, n, rids);
+    for (int i = 0; i < n; i++) free(records[i]);
+    if (inserted != n) return false;
+  }
+
+  return true;
+}
+
+static void count_page(void* arg, Record* records, int numRecords) {
+  ScanCount* c = arg;
+
+  for (int i = 0; i < numRecords; i++) c->checksum += (uint8_t)records[i][sizeof(RecordHeader)];
+  c->numRecords += numRecords;
+  c->numPages++;
+}
+
+/**
+ * @brief Opens the data file with `mmapMode` and scans the table `passes`
+ * times. Returns false if a pass misses rows.
+ */
+static bool run_scans(bool mmapMode, int numRows, int passes) {
+  conf->mmapMode = mmapMode;
+  BufMgr* buf = bufmgr_init();
+  TableDesc* td = get_person(buf);
+  bool success = td != NULL && td->rd != NULL;
+  double bestUs = 0, totalUs = 0;
+  ScanCount c = { 0, 0, 0 };
+
+  for (int p = 0; p < passes && success; p++) {
+    memset(&c, 0, sizeof(ScanCount));
+
+    double start = now_us();
+    tableam_scan_pages(buf, td, count_page, &c);
+    double us = now_us() - start;
+
+    totalUs += us;
+    if (p == 0 || us < bestUs) bestUs = us;
+
+    if (c.numRecords != (uint64_t)numRows) {
+      printf("Scan saw %lu rows, expected %d\n", c.numRecords, numRows);
+      success = false;
+    }
+  }
+
+  if (success) {
+    double mb = (double)c.numPages * conf->pageSize / (1024 * 1024);
+    printf("%-5s  %7lu pages  best %8.2f ms  avg %8.2f ms  %8.1f MB/s  %6.1f Mrows/s\n",
+      mmapMode ? "mmap" : "read", c.numPages, bestUs / 1000, totalUs / passes / 1000,
+      mb / (bestUs / 1e6), numRows / bestUs);
+  }
+
+  free_tabledesc(td);
+  bufmgr_destroy(buf);
+
+  return success;
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    printf("Usage: %s DATA_FILE [NUM_ROWS] [PASSES] [BUFPOOL_PAGES]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  int numRows = argc > 2 ? atoi(argv[2]) : 200000;
+  int passes = argc > 3 ? atoi(argv[3]) : 5;
+
+  conf = new_config();
+  conf->dataFile = strdup(argv[1]);
+  conf->pageSize = 8192;
+  conf->bufpoolSize = argc > 4 ? atoi(argv[4]) : 64;
+  conf->workerThreads = 1;
+
+  if (numRows < 1 || passes < 1 || conf->bufpoolSize < 8) {
+    printf("NUM_ROWS and PASSES must be positive, BUFPOOL_PAGES at least 8\n");
+    return EXIT_FAILURE;
+  }
+
+  unlink(conf->dataFile);
+  sched = scheduler_create(1);
+  BufMgr* buf = bufmgr_init();
+
+  if (!initdb(buf)) {
+    printf("initdb failed\n");
+    return EXIT_FAILURE;
+  }
+
+  TableDesc* td = get_person(buf);
+  double start = now_us();
+  bool success = td != NULL && load_rows(buf, td, numRows);
+  printf("loaded %d rows in %.0f ms, page size %d, buffer pool %d pages\n",
+    numRows, (now_us() - start) / 1000, conf->pageSize, conf->bufpoolSize);
+
+  free_tabledesc(td);
+  bufmgr_flush_all(buf);
+  bufmgr_destroy(buf);
+
+  /* a new BufMgr for each mode, so that mmap mode maps the whole loaded file */
+  success = success && run_scans(false, numRows, passes);
+  success = success && run_scans(true, numRows, passes);
+
+  printf("%s\n", success ? "PASSED" : "FAILED");
+
+  scheduler_destroy(sched);
+  free_config(conf);
+
+  return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,371 @@
+/**
+ * @file splitstress.c
+ * @brief Stress test for insert page splits (bufmgr_page_split_insert)
+ *
+ * Builds a sorted chain of data pages that are 100% full, then inserts keys
+ * in between the existing ones in random order. Nearly every insert lands on
+ * a full page in the middle of the chain and has to split it. Along the way
+ * it times the splits, and at the end it walks the chain and checks that
+ * every key is there exactly once, in order, with the prev/next links of
+ * every page pointing at its neighbors.
+ *
+ * It also checks that page_move_records is all-or-nothing: a move into a
+ * page that is too full must leave both pages untouched.
+ *
+ * Usage: splitstress DATA_FILE [NUM_KEYS] [PAGE_SIZE] [RECORD_LEN]
+ *
+ * DATA_FILE is created from scratch. Exits with 1 if any check fails.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "global/config.h"
+#include "buffer/bufmgr.h"
+#include "storage/page.h"
+#include "executor/scheduler.h"
+#include "system/initdb.h"
+
+Config* conf;
+Scheduler* sched;
+
+/**
+ * @brief The pages of the chain in order, with the smallest key each one
+ * may hold (its fence). The first page takes everything below the second
+ * page's fence.
+ */
+typedef struct Chain {
+  uint32_t* pageIds;
+  int64_t* fences;
+  int numPages;
+  int maxPages;
+} Chain;
+
+static double now_us() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static int64_t record_key(Page pg, int slotId) {
+  int64_t key;
+  memcpy(&key, page_get_record(pg, slotId), sizeof(int64_t));
+  return key;
+}
+
+static int32_t request_page(BufMgr* buf, uint32_t pageId) {
+  BufTag* tag = bufdesc_new_buftag(FILE_DATA, pageId);
+  int32_t bufId = bufmgr_request_bufId(buf, tag);
+  bufdesc_free_buftag(tag);
+  return bufId;
+}
+
+static void chain_insert_page(Chain* c, int pos, uint32_t pageId, int64_t fence) {
+  if (c->numPages == c->maxPages) {
+    c->maxPages *= 2;
+    c->pageIds = realloc(c->pageIds, sizeof(uint32_t) * c->maxPages);
+    c->fences = realloc(c->fences, sizeof(int64_t) * c->maxPages);
+  }
+
+  memmove(&c->pageIds[pos + 1], &c->pageIds[pos], sizeof(uint32_t) * (c->numPages - pos));
+  memmove(&c->fences[pos + 1], &c->fences[pos], sizeof(int64_t) * (c->numPages - pos));
+  c->pageIds[pos] = pageId;
+  c->fences[pos] = fence;
+  c->numPages++;
+}
+
+/**
+ * @brief Returns the position of the page in the chain that `key` belongs on
+ */
+static int chain_find_page(Chain* c, int64_t key) {
+  int lo = 0, hi = c->numPages - 1;
+
+  while (lo < hi) {
+    int mid = (lo + hi + 1) / 2;
+    if (c->fences[mid] <= key) {
+      lo = mid;
+    } else {
+      hi = mid - 1;
+    }
+  }
+
+  return lo;
+}
+
+static int page_find_slot(Page pg, int64_t key) {
+  int lo = 0, hi = ((PageHeader*)pg)->numRecords;
+
+  while (lo < hi) {
+    int mid = (lo + hi) / 2;
+    if (record_key(pg, mid) < key) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+
+  return lo;
+}
+
+/**
+ * @brief Phase 1: appends the even keys to the end of the chain, filling
+ * every page completely before the next one is allocated
+ */
+static bool load_sequential(BufMgr* buf, Chain* c, char* rec, int recordLen, int numKeys) {
+  int32_t bufId = bufmgr_allocate_new_extent(buf, FILE_DATA);
+  if (bufId < 0) return false;
+
+  pageheader_init_datapage(buf->bp->pages[bufId]);
+  chain_insert_page(c, 0, buf->bd->descArr[bufId]->tag->pageId, INT64_MIN);
+
+  for (int64_t key = 0; key < 2 * (int64_t)numKeys; key += 2) {
+    memcpy(rec, &key, sizeof(int64_t));
+
+    if (!page_insert(buf->bp->pages[bufId], rec, recordLen)) {
+      int32_t newBufId = bufmgr_page_split(buf, bufId);
+      if (newBufId < 0) return false;
+
+      bufId = newBufId;
+      chain_insert_page(c, c->numPages, buf->bd->descArr[bufId]->tag->pageId, key);
+      page_insert(buf->bp->pages[bufId], rec, recordLen);
+    }
+
+    bufdesc_set_dirty(buf->bd->descArr[bufId]);
+  }
+
+  bufmgr_release_bufId(buf, bufId);
+
+  return true;
+}
+
+/**
+ * @brief Phase 2: inserts the odd keys in random order, splitting the full
+ * pages they land on
+ */
+static bool insert_random(BufMgr* buf, Chain* c, char* rec, int recordLen, int numKeys, int* numSplits, double* splitUs) {
+  int64_t* keys = malloc(sizeof(int64_t) * numKeys);
+  for (int i = 0; i < numKeys; i++) keys[i] = 2 * (int64_t)i + 1;
+
+  srand(42);
+  for (int i = numKeys - 1; i > 0; i--) {
+    int j = rand() % (i + 1);
+    int64_t tmp = keys[i];
+    keys[i] = keys[j];
+    keys[j] = tmp;
+  }
+
+  bool success = true;
+
+  for (int i = 0; i < numKeys && success; i++) {
+    int64_t key = keys[i];
+    memcpy(rec, &key, sizeof(int64_t));
+
+    int pos = chain_find_page(c, key);
+    int32_t bufId = request_page(buf, c->pageIds[pos]);
+    if (bufId < 0) {
+      success = false;
+      break;
+    }
+
+    Page pg = buf->bp->pages[bufId];
+
+    if (!page_insert_at(pg, rec, recordLen, page_find_slot(pg, key))) {
+      double start = now_us();
+      int32_t rightBufId = bufmgr_page_split_insert(buf, bufId, 0);
+      *splitUs += now_us() - start;
+      (*numSplits)++;
+
+      if (rightBufId < 0) {
+        bufmgr_release_bufId(buf, bufId);
+        success = false;
+        break;
+      }
+
+      Page right = buf->bp->pages[rightBufId];
+      int64_t fence = record_key(right, 0);
+      chain_insert_page(c, pos + 1, buf->bd->descArr[rightBufId]->tag->pageId, fence);
+
+      Page target = key < fence ? pg : right;
+      success = page_insert_at(target, rec, recordLen, page_find_slot(target, key));
+      if (!success) printf("Key %ld doesn't fit after the split\n", key);
+
+      bufmgr_release_bufId(buf, rightBufId);
+    }
+
+    bufdesc_set_dirty(buf->bd->descArr[bufId]);
+    bufmgr_release_bufId(buf, bufId);
+  }
+
+  free(keys);
+
+  return success;
+}
+
+/**
+ * @brief Walks the chain from its first page and checks the links, the key
+ * order and the number of keys
+ */
+static bool verify_chain(BufMgr* buf, Chain* c, int numKeys, double* fillPct) {
+  uint32_t pageId = c->pageIds[0];
+  uint32_t prevPageId = 0;
+  int64_t expected = 0;
+  int numPages = 0;
+  uint64_t usedBytes = 0;
+
+  while (pageId != 0) {
+    int32_t bufId = request_page(buf, pageId);
+    if (bufId < 0) return false;
+
+    Page pg = buf->bp->pages[bufId];
+    PageHeader* pgHdr = (PageHeader*)pg;
+
+    if (numPages >= c->numPages || c->pageIds[numPages] != pageId) {
+      printf("Page %u is not where the chain should have it\n", pageId);
+      bufmgr_release_bufId(buf, bufId);
+      return false;
+    }
+
+    if (pgHdr->prevPageId != prevPageId) {
+      printf("Page %u has prevPageId %u, expected %u\n", pageId, pgHdr->prevPageId, prevPageId);
+      bufmgr_release_bufId(buf, bufId);
+      return false;
+    }
+
+    for (int i = 0; i < pgHdr->numRecords; i++) {
+      if (record_key(pg, i) != expected) {
+        printf("Page %u slot %d has key %ld, expected %ld\n", pageId, i, record_key(pg, i), expected);
+        bufmgr_release_bufId(buf, bufId);
+        return false;
+      }
+      expected++;
+    }
+
+    usedBytes += conf->pageSize - sizeof(PageHeader) - pgHdr->freeBytes;
+    numPages++;
+    prevPageId = pageId;
+    pageId = pgHdr->nextPageId;
+    bufmgr_release_bufId(buf, bufId);
+  }
+
+  if (expected != 2 * (int64_t)numKeys || numPages != c->numPages) {
+    printf("Found %ld keys on %d pages, expected %d keys on %d pages\n", expected, numPages, 2 * numKeys, c->numPages);
+    return false;
+  }
+
+  *fillPct = 100.0 * usedBytes / ((double)numPages * (conf->pageSize - sizeof(PageHeader)));
+
+  return true;
+}
+
+/**
+ * @brief A move into a page without room for all of the records must not
+ * change either page
+ */
+static bool check_move_all_or_nothing(int recordLen) {
+  Page src = new_page();
+  Page dst = new_page();
+  Page srcCopy = new_page();
+  Page dstCopy = new_page();
+  char* rec = calloc(1, recordLen);
+  bool success;
+
+  pageheader_init_datapage(src);
+  pageheader_init_datapage(dst);
+
+  for (int64_t key = 0; page_insert(src, rec, recordLen); key++) memcpy(rec, &key, sizeof(int64_t));
+  for (int64_t key = 0; page_insert(dst, rec, recordLen); key++) memcpy(rec, &key, sizeof(int64_t));
+
+  /* make room for a single record on `dst`, then try to move two */
+  page_truncate(dst, ((PageHeader*)dst)->numRecords - 1);
+  int slotId = ((PageHeader*)src)->numRecords - 2;
+
+  memcpy(srcCopy, src, conf->pageSize);
+  memcpy(dstCopy, dst, conf->pageSize);
+
+  success = !page_move_records(src, dst, slotId)
+    && memcmp(src, srcCopy, conf->pageSize) == 0
+    && memcmp(dst, dstCopy, conf->pageSize) == 0;
+
+  /* and one record does fit */
+  success = success && page_move_records(src, dst, slotId + 1)
+    && ((PageHeader*)src)->numRecords == ((PageHeader*)srcCopy)->numRecords - 1
+    && ((PageHeader*)dst)->numRecords == ((PageHeader*)dstCopy)->numRecords + 1;
+
+  free(rec);
+  free_page(src);
+  free_page(dst);
+  free_page(srcCopy);
+  free_page(dstCopy);
+
+  return success;
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    printf("Usage: %s DATA_FILE [NUM_KEYS] [PAGE_SIZE] [RECORD_LEN]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  int numKeys = argc > 2 ? atoi(argv[2]) : 50000;
+  int recordLen = argc > 4 ? atoi(argv[4]) : 64;
+
+  conf = new_config();
+  conf->dataFile = strdup(argv[1]);
+  conf->pageSize = argc > 3 ? atoi(argv[3]) : 4096;
+  conf->bufpoolSize = 64;
+  conf->workerThreads = 1;
+
+  if (numKeys < 1 || recordLen < (int)sizeof(int64_t) || recordLen > conf->pageSize / 4) {
+    printf("NUM_KEYS must be positive and RECORD_LEN between %d and PAGE_SIZE / 4\n", (int)sizeof(int64_t));
+    return EXIT_FAILURE;
+  }
+
+  unlink(conf->dataFile);
+  sched = scheduler_create(1);
+  BufMgr* buf = bufmgr_init();
+
+  if (!initdb(buf)) {
+    printf("initdb failed\n");
+    return EXIT_FAILURE;
+  }
+
+  Chain c = { malloc(sizeof(uint32_t) * 64), malloc(sizeof(int64_t) * 64), 0, 64 };
+  char* rec = calloc(1, recordLen);
+  int numSplits = 0;
+  double splitUs = 0, fillPct = 0;
+  bool success = check_move_all_or_nothing(recordLen);
+
+  printf("page_move_records all-or-nothing: %s\n", success ? "ok" : "FAILED");
+
+  double start = now_us();
+  success = success && load_sequential(buf, &c, rec, recordLen, numKeys);
+  int loadedPages = c.numPages;
+  double loadUs = now_us() - start;
+
+  start = now_us();
+  success = success && insert_random(buf, &c, rec, recordLen, numKeys, &numSplits, &splitUs);
+  double insertUs = now_us() - start;
+
+  success = success && verify_chain(buf, &c, numKeys, &fillPct);
+
+  printf("page size %d, record length %d\n", conf->pageSize, recordLen);
+  printf("sequential load: %d keys on %d pages in %.0f ms\n", numKeys, loadedPages, loadUs / 1000);
+  printf("random inserts:  %d keys in %.0f ms, %d splits, %.1f us per split\n",
+    numKeys, insertUs / 1000, numSplits, numSplits == 0 ? 0 : splitUs / numSplits);
+  printf("final chain:     %d pages, %.1f%% full\n", c.numPages, fillPct);
+  printf("%s\n", success ? "PASSED" : "FAILED");
+
+  free(rec);
+  free(c.pageIds);
+  free(c.fences);
+  bufmgr_flush_all(buf);
+  bufmgr_destroy(buf);
+  scheduler_destroy(sched);
+  free_config(conf);
+
+  return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
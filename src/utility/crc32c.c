@@ -0,0 +1,174 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "utility/crc32c.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <nmmintrin.h>
+#define CRC32C_HW_X86
+#elif defined(__aarch64__) && defined(__linux__)
+#include <arm_acle.h>
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#define CRC32C_HW_ARM
+#endif
+
+#define CRC32C_POLY 0x82F63B78  /* reversed Castagnoli polynomial */
+
+typedef uint32_t (*Crc32cFunc)(uint32_t crc, const char* data, size_t len);
+
+static uint32_t crc32c_table[8][256];
+
+static void crc32c_init_table() {
+  for (uint32_t i = 0; i < 256; i++) {
+    uint32_t crc = i;
+    for (int j = 0; j < 8; j++) {
+      crc = (crc & 1) ? (crc >> 1) ^ CRC32C_POLY : crc >> 1;
+    }
+    crc32c_table[0][i] = crc;
+  }
+
+  for (uint32_t i = 0; i < 256; i++) {
+    for (int t = 1; t < 8; t++) {
+      uint32_t prev = crc32c_table[t - 1][i];
+      crc32c_table[t][i] = (prev >> 8) ^ crc32c_table[0][prev & 0xFF];
+    }
+  }
+}
+
+/**
+ * @brief Portable "slicing-by-8" implementation. Processes 8 bytes per
+ * iteration using eight 256-entry lookup tables.
+ */
+static uint32_t crc32c_sw(uint32_t crc, const char* data, size_t len) {
+  const uint8_t* p = (const uint8_t*)data;
+
+  while (len >= 8) {
+    uint32_t lo;
+    uint32_t hi;
+    memcpy(&lo, p, 4);
+    memcpy(&hi, p + 4, 4);
+    lo ^= crc;
+
+    crc = crc32c_table[7][lo & 0xFF] ^
+          crc32c_table[6][(lo >> 8) & 0xFF] ^
+          crc32c_table[5][(lo >> 16) & 0xFF] ^
+          crc32c_table[4][lo >> 24] ^
+          crc32c_table[3][hi & 0xFF] ^
+          crc32c_table[2][(hi >> 8) & 0xFF] ^
+          crc32c_table[1][(hi >> 16) & 0xFF] ^
+          crc32c_table[0][hi >> 24];
+
+    p += 8;
+    len -= 8;
+  }
+
+  while (len > 0) {
+    crc = (crc >> 8) ^ crc32c_table[0][(crc ^ *p) & 0xFF];
+    p++;
+    len--;
+  }
+
+  return crc;
+}
+
+#ifdef CRC32C_HW_X86
+__attribute__((target("sse4.2")))
+static uint32_t crc32c_hw(uint32_t crc, const char* data, size_t len) {
+  const uint8_t* p = (const uint8_t*)data;
+
+#ifdef __x86_64__
+  uint64_t crc64 = crc;
+  while (len >= 8) {
+    uint64_t chunk;
+    memcpy(&chunk, p, 8);
+    crc64 = _mm_crc32_u64(crc64, chunk);
+    p += 8;
+    len -= 8;
+  }
+  crc = (uint32_t)crc64;
+#endif
+
+  while (len > 0) {
+    crc = _mm_crc32_u8(crc, *p);
+    p++;
+    len--;
+  }
+
+  return crc;
+}
+
+static bool crc32c_hw_available() {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("sse4.2");
+}
+#endif
+
+#ifdef CRC32C_HW_ARM
+__attribute__((target("+crc")))
+static uint32_t crc32c_hw(uint32_t crc, const char* data, size_t len) {
+  const uint8_t* p = (const uint8_t*)data;
+
+  while (len >= 8) {
+    uint64_t chunk;
+    memcpy(&chunk, p, 8);
+    crc = __crc32cd(crc, chunk);
+    p += 8;
+    len -= 8;
+  }
+
+  while (len > 0) {
+    crc = __crc32cb(crc, *p);
+    p++;
+    len--;
+  }
+
+  return crc;
+}
+
+static bool crc32c_hw_available() {
+  return (getauxval(AT_HWCAP) & HWCAP_CRC32) != 0;
+}
+#endif
+
+static Crc32cFunc crc32c_impl = NULL;
+
+static Crc32cFunc crc32c_choose_impl() {
+#if defined(CRC32C_HW_X86) || defined(CRC32C_HW_ARM)
+  if (crc32c_hw_available()) return crc32c_hw;
+#endif
+
+  crc32c_init_table();
+  return crc32c_sw;
+}
+
+uint32_t crc32c_extend(uint32_t crc, const char* data, size_t len) {
+  if (crc32c_impl == NULL) crc32c_impl = crc32c_choose_impl();
+
+  return crc32c_impl(crc, data, len);
+}
+
+/**
+ * @brief Switches between the CRC32 instructions and the table-driven
+ * implementation, so the two can be compared (see tools/crcbench.c)
+ *
+ * @param hardware
+ * @return true
+ * @return false if `hardware` was asked for and the CPU doesn't have the
+ * instructions, the table-driven implementation is used then
+ */
+bool crc32c_use_hardware(bool hardware) {
+#if defined(CRC32C_HW_X86) || defined(CRC32C_HW_ARM)
+  if (hardware && crc32c_hw_available()) {
+    crc32c_impl = crc32c_hw;
+    return true;
+  }
+#endif
+
+  crc32c_init_table();
+  crc32c_impl = crc32c_sw;
+
+  return !hardware;
+}
@@ -63,4 +63,22 @@ ListItem* linkedlist_search(LinkedList* l, void* ptr, bool (*comparison)(void*,
   }
 
   return NULL;
-}
\ No newline at end of file
+}
+/**
+ * @brief Moves every item of `other` to the end of `l` and frees `other`
+ */
+void linkedlist_concat(LinkedList* l, LinkedList* other) {
+  if (other->numItems > 0) {
+    if (l->numItems == 0) {
+      l->head = other->head;
+    } else {
+      l->tail->next = other->head;
+      other->head->prev = l->tail;
+    }
+
+    l->tail = other->tail;
+    l->numItems += other->numItems;
+  }
+
+  free(other);
+}
@@ -0,0 +1,75 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "utility/numfmt.h"
+
+static const uint64_t numfmt_pow10[20] = {
+  1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL, 100000000ULL,
+  1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL, 10000000000000ULL,
+  100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL, 100000000000000000ULL,
+  1000000000000000000ULL, 10000000000000000000ULL
+};
+
+static const char numfmt_pairs[200] =
+  "00010203040506070809"
+  "10111213141516171819"
+  "20212223242526272829"
+  "30313233343536373839"
+  "40414243444546474849"
+  "50515253545556575859"
+  "60616263646566676869"
+  "70717273747576777879"
+  "80818283848586878889"
+  "90919293949596979899";
+
+/**
+ * @brief Returns the number of decimal digits of `v`, 1 for 0
+ * 
+ * @details The number of bits gives an estimate that's at most one digit
+ * short (1233 / 4096 is just under log10(2)), a single comparison against
+ * the next power of 10 fixes it up. `v | 1` has as many digits as `v`, and
+ * keeps the bit count of 0 at 1.
+ */
+int numfmt_digits(uint64_t v) {
+  v |= 1;
+  int estimate = ((64 - __builtin_clzll(v)) * 1233) >> 12;
+  return estimate + (estimate < 20 && v >= numfmt_pow10[estimate]);
+}
+
+/**
+ * @brief Returns the number of characters numfmt_int64 writes for `v`
+ */
+int numfmt_len(int64_t v) {
+  uint64_t u = v < 0 ? -(uint64_t)v : (uint64_t)v;
+  return numfmt_digits(u) + (v < 0);
+}
+
+/**
+ * @brief Writes `v` in decimal to `dst`, without a terminating zero
+ * 
+ * @param dst room for NUMFMT_MAX_LEN characters
+ * @param v 
+ * @return int the number of characters written
+ */
+int numfmt_int64(char* dst, int64_t v) {
+  uint64_t u = v < 0 ? -(uint64_t)v : (uint64_t)v;
+  int len = numfmt_digits(u) + (v < 0);
+  char* p = dst + len;
+
+  if (v < 0) dst[0] = '-';
+
+  while (u >= 100) {
+    p -= 2;
+    memcpy(p, &numfmt_pairs[(u % 100) * 2], 2);
+    u /= 100;
+  }
+
+  if (u >= 10) {
+    p -= 2;
+    memcpy(p, &numfmt_pairs[u * 2], 2);
+  } else {
+    *--p = '0' + u;
+  }
+
+  return len;
+}
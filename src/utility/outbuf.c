@@ -0,0 +1,79 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "utility/outbuf.h"
+#include "utility/numfmt.h"
+
+/**
+ * @brief 
+ * 
+ * @param fp 
+ * @param cap size of the buffer, at least NUMFMT_MAX_LEN
+ * @return OutBuf* 
+ */
+OutBuf* new_outbuf(FILE* fp, size_t cap) {
+  OutBuf* ob = malloc(sizeof(OutBuf));
+  ob->fp = fp;
+  ob->cap = cap < NUMFMT_MAX_LEN ? NUMFMT_MAX_LEN : cap;
+  ob->data = malloc(ob->cap);
+  ob->len = 0;
+
+  return ob;
+}
+
+void free_outbuf(OutBuf* ob) {
+  if (ob == NULL) return;
+
+  outbuf_flush(ob);
+  free(ob->data);
+  free(ob);
+}
+
+void outbuf_flush(OutBuf* ob) {
+  if (ob->len > 0) fwrite(ob->data, 1, ob->len, ob->fp);
+  ob->len = 0;
+  fflush(ob->fp);
+}
+
+void outbuf_write(OutBuf* ob, const char* data, size_t len) {
+  if (ob->len + len > ob->cap) {
+    outbuf_flush(ob);
+
+    /* too big to be worth copying */
+    if (len > ob->cap) {
+      fwrite(data, 1, len, ob->fp);
+      return;
+    }
+  }
+
+  memcpy(ob->data + ob->len, data, len);
+  ob->len += len;
+}
+
+void outbuf_puts(OutBuf* ob, const char* str) {
+  outbuf_write(ob, str, strlen(str));
+}
+
+void outbuf_putc(OutBuf* ob, char c) {
+  if (ob->len == ob->cap) outbuf_flush(ob);
+  ob->data[ob->len++] = c;
+}
+
+/**
+ * @brief Writes `c` `n` times, e.g. the padding of a cell
+ */
+void outbuf_fill(OutBuf* ob, char c, int n) {
+  while (n > 0) {
+    if (ob->len == ob->cap) outbuf_flush(ob);
+
+    size_t chunk = ob->cap - ob->len < (size_t)n ? ob->cap - ob->len : (size_t)n;
+    memset(ob->data + ob->len, c, chunk);
+    ob->len += chunk;
+    n -= chunk;
+  }
+}
+
+void outbuf_int64(OutBuf* ob, int64_t v) {
+  if (ob->len + NUMFMT_MAX_LEN > ob->cap) outbuf_flush(ob);
+  ob->len += numfmt_int64(ob->data + ob->len, v);
+}